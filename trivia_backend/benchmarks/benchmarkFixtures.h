@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "utils/responses/responses.h"
+#include "managers/game.h"
+
+using Json = nlohmann::json;
+
+// payloads sized like a busy server: 50 rooms in the lobby, 50 questions per game, full high scores table
+constexpr unsigned int FIXTURE_ROOMS_COUNT = 50;
+constexpr unsigned int FIXTURE_PLAYERS_PER_ROOM = 8;
+constexpr unsigned int FIXTURE_QUESTIONS_COUNT = 50;
+constexpr unsigned int FIXTURE_TIME_PER_QUESTION = 15;
+
+inline QuestionDb makeQuestionDb(unsigned int index) {
+    const auto number = std::to_string(index);
+    return QuestionDb("Which of the following is the capital city of the country number " + number + "?",
+                      "Correct answer " + number, "First wrong answer " + number,
+                      "Second wrong answer " + number, "Third wrong answer " + number);
+}
+
+inline std::vector<Question> makeQuestions(unsigned int count) {
+    std::vector<Question> questions;
+    for (unsigned int i = 0; i < count; i++)
+        questions.emplace_back(makeQuestionDb(i));
+    return questions;
+}
+
+inline std::vector<Player> makePlayers(unsigned int count) {
+    std::vector<Player> players;
+    for (unsigned int i = 0; i < count; i++)
+        players.push_back({"player" + std::to_string(i), "Blue", 1000 + i * 7});
+    return players;
+}
+
+inline GetRoomsResponse makeGetRoomsResponse() {
+    GetRoomsResponse response{true, {}};
+    for (unsigned int i = 0; i < FIXTURE_ROOMS_COUNT; i++) {
+        const RoomData roomData{"6f1c2a4e-9b1d-4f5e-8a7c-" + std::to_string(100000000000 + i), "Room number " + std::to_string(i),
+                                FIXTURE_PLAYERS_PER_ROOM, 10, FIXTURE_TIME_PER_QUESTION, i % 3 == 0};
+        response.rooms.push_back({roomData, false, makePlayers(FIXTURE_PLAYERS_PER_ROOM)});
+    }
+    response.totalCount = FIXTURE_ROOMS_COUNT;
+    return response;
+}
+
+// a finished game where every player answered, half of the answers correct
+inline GameData makeGameData() {
+    GameData gameData(makeQuestions(FIXTURE_QUESTIONS_COUNT), FIXTURE_TIME_PER_QUESTION);
+    for (unsigned int i = 0; i < FIXTURE_QUESTIONS_COUNT; i++) {
+        const auto correctAnswer = gameData.answers[i].first.getCorrectAnswerIndex();
+        gameData.submitAnswer(i % 2 == 0 ? correctAnswer : (correctAnswer + 1) % 4, i, 1 + i % FIXTURE_TIME_PER_QUESTION);
+    }
+    return gameData;
+}
+
+inline GetGameResultsResponse makeGetGameResultsResponse() {
+    GetGameResultsResponse response{true, makeGameData().answers, {}};
+    for (unsigned int i = 0; i < FIXTURE_PLAYERS_PER_ROOM; i++)
+        response.players.push_back({"player" + std::to_string(i), "Green", i % 2 == 0, 120 - static_cast<int>(i) * 10,
+                                    25, 25, 7});
+    return response;
+}
+
+inline std::vector<unsigned char> toBuffer(const Json &json) {
+    const auto dumped = json.dump();
+    return {dumped.begin(), dumped.end()};
+}
+
+inline std::vector<unsigned char> toRawBuffer(const std::string &text) {
+    return {text.begin(), text.end()};
+}
@@ -0,0 +1,49 @@
+#include <benchmark/benchmark.h>
+#include "benchmarkFixtures.h"
+#include "utils/marshaling/jsonDeserializer.h"
+
+template<typename Deserialize>
+static void BM_DeserializeRequest(benchmark::State &state, Deserialize deserialize,
+                                  const std::vector<unsigned char> &buffer) {
+    for (auto _: state) {
+        auto result = deserialize(buffer);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * buffer.size()));
+}
+
+BENCHMARK_CAPTURE(BM_DeserializeRequest, LoginRequest, &JsonDeserializer::deserializeLoginRequest,
+                  toBuffer(Json{{"username", "player0"}, {"password", "Passw0rd!"}}));
+BENCHMARK_CAPTURE(BM_DeserializeRequest, SignupRequest, &JsonDeserializer::deserializeSignupRequest,
+                  toBuffer(Json{{"username", "player0"}, {"password", "Passw0rd!"}, {"email", "player0@trivia.test"},
+                                {"address", "Herzl, 12, Tel Aviv"}, {"phoneNumber", "0501234567"}, {"birthday", "1.1.2000"}}));
+BENCHMARK_CAPTURE(BM_DeserializeRequest, GetRoomsRequest, &JsonDeserializer::deserializeGetRoomsRequest,
+                  toBuffer(Json{{"offset", 20}, {"limit", 20}, {"notActive", true}, {"notFull", true}}));
+BENCHMARK_CAPTURE(BM_DeserializeRequest, GetPlayersInRoomRequest, &JsonDeserializer::deserializeGetPlayersInRoomRequest,
+                  toBuffer(Json{{"roomId", "6f1c2a4e-9b1d-4f5e-8a7c-100000000000"}}));
+BENCHMARK_CAPTURE(BM_DeserializeRequest, JoinRoomRequest, &JsonDeserializer::deserializeJoinRoomRequest,
+                  toBuffer(Json{{"roomId", "6f1c2a4e-9b1d-4f5e-8a7c-100000000000"}}));
+BENCHMARK_CAPTURE(BM_DeserializeRequest, CreateRoomRequest, &JsonDeserializer::deserializeCreateRoomRequest,
+                  toBuffer(Json{{"name", "Room number 0"}, {"maxPlayers", 8}, {"questionCount", 10},
+                                {"timePerQuestion", 15}}));
+BENCHMARK_CAPTURE(BM_DeserializeRequest, UpdateUserDataRequest, &JsonDeserializer::deserializeUpdateUserDataRequest,
+                  toBuffer(Json{{"password", nullptr}, {"address", "Herzl, 12, Tel Aviv"}, {"phoneNumber", "0501234567"},
+                                {"avatarColor", "Blue"}}));
+BENCHMARK_CAPTURE(BM_DeserializeRequest, SubmitAnswerRequest, &JsonDeserializer::deserializeSubmitAnswerRequest,
+                  toBuffer(Json{{"answerId", 2}, {"questionId", 7}}));
+BENCHMARK_CAPTURE(BM_DeserializeRequest, SubmitVerificationCodeRequest,
+                  &JsonDeserializer::deserializeSubmitVerificationCodeRequest, toBuffer(Json{{"code", "123456"}}));
+BENCHMARK_CAPTURE(BM_DeserializeRequest, ForgotPasswordRequest, &JsonDeserializer::deserializeForgotPasswordRequest,
+                  toBuffer(Json{{"email", "player0@trivia.test"}}));
+BENCHMARK_CAPTURE(BM_DeserializeRequest, ResetPasswordRequest, &JsonDeserializer::deserializeResetPasswordRequest,
+                  toBuffer(Json{{"email", "player0@trivia.test"}, {"resetCode", "a1B2c3D4e5"},
+                                {"password", "Password#1"}}));
+BENCHMARK_CAPTURE(BM_DeserializeRequest, ClientHelloRequest, &JsonDeserializer::deserializeClientHelloRequest,
+                  toBuffer(Json{{"encodings", {"msgpack", "cbor", "json"}}}));
+BENCHMARK_CAPTURE(BM_DeserializeRequest, ResumeSessionRequest, &JsonDeserializer::deserializeResumeSessionRequest,
+                  toBuffer(Json{{"sessionToken", std::string(64, 'a')}}));
+BENCHMARK_CAPTURE(BM_DeserializeRequest, PingRequest, &JsonDeserializer::deserializePingRequest,
+                  toBuffer(Json{{"lastRttUs", 18250}}));
+// the common failure path, a body that is not JSON at all
+BENCHMARK_CAPTURE(BM_DeserializeRequest, LoginRequest_InvalidJson, &JsonDeserializer::deserializeLoginRequest,
+                  toRawBuffer("{\"username\": \"player0\""));
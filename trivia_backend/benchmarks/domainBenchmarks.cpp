@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+#include "benchmarkFixtures.h"
+#include "utils/validator/validator.h"
+
+// seeds std::random_device and shuffles the four answers, done for every question of every new game
+static void BM_QuestionConstruction(benchmark::State &state) {
+    const auto questionDb = makeQuestionDb(0);
+    for (auto _: state) {
+        Question question(questionDb);
+        benchmark::DoNotOptimize(question);
+    }
+}
+BENCHMARK(BM_QuestionConstruction);
+
+static void BM_GameDataConstruction(benchmark::State &state) {
+    const auto questions = makeQuestions(static_cast<unsigned int>(state.range(0)));
+    for (auto _: state) {
+        GameData gameData(questions, FIXTURE_TIME_PER_QUESTION);
+        benchmark::DoNotOptimize(gameData);
+    }
+}
+BENCHMARK(BM_GameDataConstruction)->Arg(10)->Arg(FIXTURE_QUESTIONS_COUNT);
+
+static void BM_GameDataScoreChange(benchmark::State &state) {
+    const auto gameData = makeGameData();
+    for (auto _: state)
+        benchmark::DoNotOptimize(gameData.scoreChange());
+}
+BENCHMARK(BM_GameDataScoreChange);
+
+// every GET_QUESTION_REQUEST after the first one of a question only hands out the shared frame
+static void BM_GameCurrentQuestionFrame(benchmark::State &state) {
+    const Game game(makeQuestions(FIXTURE_QUESTIONS_COUNT), {LoggedUser{"player0"}}, "benchmark", FIXTURE_TIME_PER_QUESTION);
+    for (auto _: state)
+        benchmark::DoNotOptimize(game.getCurrentQuestionFrame());
+}
+BENCHMARK(BM_GameCurrentQuestionFrame);
+
+static void BM_ValidateUsername(benchmark::State &state) {
+    for (auto _: state)
+        benchmark::DoNotOptimize(Validator::isValidUsername("player0"));
+}
+BENCHMARK(BM_ValidateUsername);
+
+static void BM_ValidatePassword(benchmark::State &state) {
+    for (auto _: state)
+        benchmark::DoNotOptimize(Validator::isValidPassword("Passw0rd!"));
+}
+BENCHMARK(BM_ValidatePassword);
+
+static void BM_ValidateEmail(benchmark::State &state) {
+    for (auto _: state)
+        benchmark::DoNotOptimize(Validator::isValidEmail("player0@trivia.test"));
+}
+BENCHMARK(BM_ValidateEmail);
+
+static void BM_ValidateAddress(benchmark::State &state) {
+    for (auto _: state)
+        benchmark::DoNotOptimize(Validator::isValidAddress("Herzl, 12, Tel Aviv"));
+}
+BENCHMARK(BM_ValidateAddress);
+
+static void BM_ValidatePhoneNumber(benchmark::State &state) {
+    for (auto _: state)
+        benchmark::DoNotOptimize(Validator::isValidPhoneNumber("0501234567"));
+}
+BENCHMARK(BM_ValidatePhoneNumber);
+
+static void BM_ValidateBirthday(benchmark::State &state) {
+    for (auto _: state)
+        benchmark::DoNotOptimize(Validator::isValidBirthday("1.1.2000"));
+}
+BENCHMARK(BM_ValidateBirthday);
+
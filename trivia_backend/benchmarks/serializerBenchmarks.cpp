@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+#include "benchmarkFixtures.h"
+#include "utils/marshaling/jsonSerializer.h"
+#include "utils/marshaling/payloadEncoding.h"
+
+template<typename Response>
+static void BM_SerializeResponse(benchmark::State &state, const Response &response) {
+    std::size_t bytes = 0;
+    for (auto _: state) {
+        auto buffer = JsonSerializer::serializeResponse(response);
+        bytes += buffer.size();
+        benchmark::DoNotOptimize(buffer);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+
+// same as above, on a connection that negotiated a binary payload encoding
+template<typename Response>
+static void BM_SerializeResponseEncoded(benchmark::State &state, const Response &response, PayloadEncoding encoding) {
+    PayloadCodec::setEncoding(encoding);
+    BM_SerializeResponse(state, response);
+    PayloadCodec::setEncoding(PayloadEncoding::JSON);
+}
+
+BENCHMARK_CAPTURE(BM_SerializeResponse, LoginResponse, LoginResponse{false, "Password does not match"});
+BENCHMARK_CAPTURE(BM_SerializeResponse, SignupResponse, SignupResponse{true, ""});
+BENCHMARK_CAPTURE(BM_SerializeResponse, ErrorResponse, ErrorResponse{"Request is not relevant"});
+BENCHMARK_CAPTURE(BM_SerializeResponse, LogoutResponse, LogoutResponse{true});
+BENCHMARK_CAPTURE(BM_SerializeResponse, GetRoomsResponse_50Rooms, makeGetRoomsResponse());
+BENCHMARK_CAPTURE(BM_SerializeResponse, GetPlayersInRoomResponse,
+                  GetPlayersInRoomResponse{true, makePlayers(FIXTURE_PLAYERS_PER_ROOM)});
+BENCHMARK_CAPTURE(BM_SerializeResponse, GetHighScoresResponse,
+                  GetHighScoresResponse{true, makePlayers(NUM_OF_TOP_PLAYERS)});
+BENCHMARK_CAPTURE(BM_SerializeResponse, GetPersonalStatsResponse,
+                  GetPersonalStatsResponse{true, UserStatistics(7, 120, 80, 20, 2400)});
+BENCHMARK_CAPTURE(BM_SerializeResponse, JoinRoomResponse, JoinRoomResponse{true});
+BENCHMARK_CAPTURE(BM_SerializeResponse, CreateRoomResponse, CreateRoomResponse{true});
+BENCHMARK_CAPTURE(BM_SerializeResponse, GetUserDataResponse,
+                  GetUserDataResponse{true, UserData{"player0", "player0@trivia.test", "Herzl, 12, Tel Aviv",
+                                                     "0501234567", "1.1.2000", "Blue", 1700000000},
+                                      UserStatistics(7, 120, 80, 20, 2400)});
+BENCHMARK_CAPTURE(BM_SerializeResponse, UpdateUserDataResponse, UpdateUserDataResponse{true, ""});
+BENCHMARK_CAPTURE(BM_SerializeResponse, CloseRoomResponse, CloseRoomResponse{true});
+BENCHMARK_CAPTURE(BM_SerializeResponse, StartGameResponse, StartGameResponse{true});
+BENCHMARK_CAPTURE(BM_SerializeResponse, GetRoomStateResponse,
+                  GetRoomStateResponse{true, false, makePlayers(FIXTURE_PLAYERS_PER_ROOM), 10,
+                                       FIXTURE_TIME_PER_QUESTION, FIXTURE_PLAYERS_PER_ROOM, false, 12});
+BENCHMARK_CAPTURE(BM_SerializeResponse, RoomStateNotModifiedResponse, RoomStateNotModifiedResponse{true, 12});
+BENCHMARK_CAPTURE(BM_SerializeResponse, LeaveRoomResponse, LeaveRoomResponse{true});
+BENCHMARK_CAPTURE(BM_SerializeResponse, GetQuestionResponse,
+                  GetQuestionResponse{true, 3, makeQuestionDb(3).question,
+                                      {{0, "Correct answer 3"}, {1, "First wrong answer 3"},
+                                       {2, "Second wrong answer 3"}, {3, "Third wrong answer 3"}}});
+BENCHMARK_CAPTURE(BM_SerializeResponse, SubmitAnswerResponse, SubmitAnswerResponse{true, 2});
+BENCHMARK_CAPTURE(BM_SerializeResponse, GetGameResultsResponse_50Questions, makeGetGameResultsResponse());
+BENCHMARK_CAPTURE(BM_SerializeResponse, LeaveGameResponse, LeaveGameResponse{true});
+BENCHMARK_CAPTURE(BM_SerializeResponse, SubmitVerificationCodeResponse, SubmitVerificationCodeResponse{true, true});
+BENCHMARK_CAPTURE(BM_SerializeResponse, ResendVerificationCodeResponse, ResendVerificationCodeResponse{true});
+BENCHMARK_CAPTURE(BM_SerializeResponse, ForgotPasswordResponse, ForgotPasswordResponse{true});
+BENCHMARK_CAPTURE(BM_SerializeResponse, ResetPasswordResponse, ResetPasswordResponse{true, "Password changed"});
+BENCHMARK_CAPTURE(BM_SerializeResponse, ClientHelloResponse, ClientHelloResponse{true, "msgpack"});
+BENCHMARK_CAPTURE(BM_SerializeResponse, ResumeSessionResponse,
+                  ResumeSessionResponse{true, "", "room", "6f1c2a4e-9b1d-4f5e-8a7c-100000000000"});
+BENCHMARK_CAPTURE(BM_SerializeResponse, RetryLaterResponse, RetryLaterResponse{false, 200});
+BENCHMARK_CAPTURE(BM_SerializeResponse, PongResponse, PongResponse{true});
+
+BENCHMARK_CAPTURE(BM_SerializeResponseEncoded, GetRoomsResponse_50Rooms_MessagePack, makeGetRoomsResponse(),
+                  PayloadEncoding::MESSAGE_PACK);
+BENCHMARK_CAPTURE(BM_SerializeResponseEncoded, GetRoomsResponse_50Rooms_Cbor, makeGetRoomsResponse(),
+                  PayloadEncoding::CBOR);
+BENCHMARK_CAPTURE(BM_SerializeResponseEncoded, GetQuestionResponse_MessagePack,
+                  GetQuestionResponse{true, 3, makeQuestionDb(3).question,
+                                      {{0, "Correct answer 3"}, {1, "First wrong answer 3"},
+                                       {2, "Second wrong answer 3"}, {3, "Third wrong answer 3"}}},
+                  PayloadEncoding::MESSAGE_PACK);
+BENCHMARK_CAPTURE(BM_SerializeResponseEncoded, GetGameResultsResponse_50Questions_MessagePack,
+                  makeGetGameResultsResponse(), PayloadEncoding::MESSAGE_PACK);
+BENCHMARK_CAPTURE(BM_SerializeResponseEncoded, GetGameResultsResponse_50Questions_Cbor,
+                  makeGetGameResultsResponse(), PayloadEncoding::CBOR);
@@ -1,9 +1,14 @@
 #pragma once
+#include <cstddef>
+
 constexpr auto DEFAULT_PORT = 8826;
 constexpr auto DEFAULT_IP = "0.0.0.0";
 
 // DB Related constants
 constexpr auto DATABASE_FILE_PATH = "trivia_db.sqlite";
+constexpr auto STAND_IN_DATABASE_FILE_PATH = "trivia_db.standin.sqlite";  // with "standIns", the real one is untouched
+// how long a write waits for the other server's during a handoff, when both have the database open
+constexpr unsigned int DATABASE_BUSY_TIMEOUT_MS = 5000;
 constexpr auto LOG_FILE_PATH = "trivia.log";
 constexpr const char* MAIL_JET_API_URL = "https://api.mailjet.com";
 constexpr const char* MAIL_JET_SEND_PATH = "/v3.1/send";
@@ -11,9 +16,94 @@ constexpr auto MIN_QUESTIONS_COUNT = 50;
 
 constexpr auto CONFIG_FILE_PATH = "config.json";
 
+// tracing related constants
+constexpr auto TRACE_FILE_PATH = "trivia_trace.json";
+constexpr std::size_t TRACE_BUFFER_CAPACITY = 1 << 16;   // spans kept per thread before the oldest are overwritten
+constexpr std::size_t TRACE_MAX_EXITED_BUFFERS = 64;    // of closed connections kept for the next dump, the oldest go
+
+// traffic capture related constants
+constexpr auto CAPTURE_FILE_PATH = "trivia_capture.bin";
+constexpr const char* CAPTURE_MAGIC = "TRIVCAP1";
+constexpr auto CAPTURE_REDACTED_PASSWORD = "Captured#1";   // still valid for signup, so replays can recreate the accounts
+constexpr auto CAPTURE_REDACTED_SECRET = "redacted";    // session tokens, reset and verification codes
+
 // questions fetching API related constants
 constexpr auto OPENTDB_BASE_URL = R"(https://opentdb.com)";
 
+// longest a GET_ROOM_STATE_REQUEST with lastSeenVersion is held waiting for the room to change
+constexpr unsigned int MAX_ROOM_STATE_WAIT_MS = 30000;
+
+// admission control related constants, the defaults can be overridden from the config file
+constexpr unsigned int DEFAULT_MAX_CONNECTIONS = 8192;
+constexpr unsigned int DEFAULT_MAX_CONNECTIONS_PER_IP = 512;
+constexpr unsigned int DEFAULT_MAX_FRAME_SIZE = 16 * 1024;
+constexpr unsigned int DEFAULT_MAX_CONNECTION_BYTES = 64 * 1024;
+constexpr unsigned int MAX_EMPTY_REQUEST_SIZE = 256;     // requests without fields
+constexpr unsigned int MAX_SMALL_REQUEST_SIZE = 1024;    // requests with a few short fields (login, join room, ...)
+
+// how long the state of a dropped connection waits for RESUME_SESSION_REQUEST before the user is logged out
+constexpr unsigned int SESSION_RESUME_GRACE_PERIOD_MS = 30000;
+
+// password hashing related constants, overridable from the config file
+constexpr unsigned int DEFAULT_PASSWORD_HASH_COST = 15;          // scrypt N = 2^15, 32MB per hash
+constexpr unsigned int DEFAULT_PASSWORD_HASH_QUEUE_LIMIT = 256;  // logins waiting for a hashing thread
+
+// password reset related constants. forgot password mails a single use code, the password changes once it is sent back
+constexpr std::size_t PASSWORD_RESET_CODE_LENGTH = 10;           // letters and digits
+constexpr unsigned int PASSWORD_RESET_CODE_TTL_SECONDS = 15 * 60;
+constexpr unsigned int PASSWORD_RESET_RESEND_SECONDS = 60;       // between two codes mailed to the same address
+constexpr unsigned int PASSWORD_RESET_MAX_ATTEMPTS = 5;          // wrong codes before the code is dropped
+constexpr std::size_t MAX_PENDING_PASSWORD_RESETS = 4096;
+
+// request scheduling related constants, overridable from the config file
+constexpr unsigned int DEFAULT_SCHEDULER_CONCURRENCY = 16;   // scheduled requests handled at once
+constexpr unsigned int DEFAULT_SHED_AFTER_MS = 200;          // longest a lobby request waits for a slot
+
+// per connection rate limits of every request class (see RequestPriority), overridable from the config file.
+// a connection can make burst requests of a class at once, then requestsPerSecond
+constexpr unsigned int DEFAULT_GAME_REQUESTS_PER_SECOND = 20;
+constexpr unsigned int DEFAULT_GAME_REQUESTS_BURST = 40;
+constexpr unsigned int DEFAULT_ROOM_REQUESTS_PER_SECOND = 10;
+constexpr unsigned int DEFAULT_ROOM_REQUESTS_BURST = 30;
+constexpr unsigned int DEFAULT_LOBBY_REQUESTS_PER_SECOND = 5;
+constexpr unsigned int DEFAULT_LOBBY_REQUESTS_BURST = 20;
+constexpr unsigned int DEFAULT_OTHER_REQUESTS_PER_SECOND = 10;
+constexpr unsigned int DEFAULT_OTHER_REQUESTS_BURST = 30;
+constexpr std::size_t MAX_TRACKED_RATE_LIMITED_ADDRESSES = 4096; // the next offenders are only counted in total
+
+// how long a connection may wait for its next request in each state before it is closed (and its session parked),
+// overridable from the config file. a room member polls the room, a player asks for the next question
+constexpr unsigned int DEFAULT_LOGIN_IDLE_TIMEOUT_SECONDS = 120;
+constexpr unsigned int DEFAULT_MENU_IDLE_TIMEOUT_SECONDS = 600;
+constexpr unsigned int DEFAULT_ROOM_IDLE_TIMEOUT_SECONDS = 300;
+constexpr unsigned int DEFAULT_GAME_IDLE_TIMEOUT_SECONDS = 120;
+constexpr unsigned int TRY_SEND_TIMEOUT_MS = 50;  // Windows only, see SocketHelper::trySendData
+
+// shutdown related constants, the deadline is overridable from the config file
+constexpr unsigned int DEFAULT_SHUTDOWN_DEADLINE_SECONDS = 90;
+constexpr unsigned int SHUTDOWN_CLOSING_SECONDS = 10;   // the end of the deadline, for closing the last connections
+constexpr unsigned int SHUTDOWN_POLL_INTERVAL_MS = 100;
+
+// game journal related constants, the sync interval is overridable from the config file
+constexpr auto GAME_JOURNAL_FILE_PATH = "trivia_games.journal";
+constexpr auto GAME_JOURNAL_DRAINING_SUFFIX = ".draining";   // the journal of a server draining after a handoff
+constexpr const char* JOURNAL_MAGIC = "TRIVJRN1";
+constexpr unsigned int DEFAULT_JOURNAL_SYNC_INTERVAL_MS = 50;
+constexpr std::size_t JOURNAL_MAX_BATCH_BYTES = 64 * 1024;   // queued bytes that wake the writer before the interval
+constexpr std::size_t JOURNAL_COMPACT_SIZE = 4 * 1024 * 1024;  // emptied past this size once no journaled game runs
+
+// unix socket a restarted server waits on for the running server's sockets and state
+constexpr auto HANDOFF_SOCKET_PATH = "trivia_handoff.sock";
+constexpr std::size_t HANDOFF_MAX_MESSAGE_SIZE = 256 * 1024 * 1024;    // the snapshot of the rooms and games
+// how long the connections get to finish their request before the snapshot, the later ones go over when they finish
+constexpr unsigned int HANDOFF_COLLECT_MS = 2000;
+// connections made to the listening socket to wake the accepting thread when it stops accepting
+constexpr unsigned int ACCEPT_WAKE_ATTEMPTS = 5;
+constexpr unsigned int ACCEPT_WAKE_RETRY_INTERVAL_MS = 100;
+
+// stand-ins for the external services, enabled by "standIns": true in the config file
+constexpr auto STAND_IN_VERIFICATION_CODE = "000000";
+
 // statistics related constants
 constexpr auto NUM_OF_TOP_PLAYERS = 50;
 constexpr unsigned int CORRECT_ANSWER_POINTS = 30;
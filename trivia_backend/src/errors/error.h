@@ -21,7 +21,8 @@ enum class ErrorType {
     NotImplemented,
     HttpError,
     RoomIsFull,
-    NotEnoughPlayers
+    NotEnoughPlayers,
+    ServerBusy
 };
 
 struct Error {
@@ -77,6 +78,9 @@ struct Error {
             case ErrorType::NotEnoughPlayers:
                 message = "Not enough players in room";
                 break;
+            case ErrorType::ServerBusy:
+                message = "Server is busy, try again later";
+                break;
             default:
                 message = "Unknown error";
                 break;
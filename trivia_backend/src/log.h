@@ -8,13 +8,13 @@
 #include <fmt/color.h>
 #include <cxxabi.h> // For __cxa_demangle
 #include <typeinfo> // For typeid
-#include <mutex>
 #include "utils/communicator/endpoint.h"
 #include "constants.h"
+#include "utils/lockProfiler/lockProfiler.h"
 #include <iostream>
 
 constexpr auto timeFormat = "%A %e %B %I:%M:%S %p";
-static std::mutex logMutex;
+inline ProfiledMutex logMutex{"logMutex"};
 
 std::string getClassName(const char *mangledName);
 
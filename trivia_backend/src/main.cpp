@@ -1,17 +1,81 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include "utils/configLoader/configLoader.h"
 #include "constants.h"
 #include "server.h"
+#include "utils/email_sender/emailSender.h"
+#include "utils/questionsFetcher/questionsFetcher.h"
+#include "utils/passwordHasher/passwordHasher.h"
+#include "utils/admissionControl/admissionController.h"
+#include "utils/requestScheduler/requestScheduler.h"
+#include "utils/rateLimiter/rateLimiter.h"
+#include "utils/connectionMonitor/connectionMonitor.h"
+#include "utils/gameJournal/gameJournal.h"
+
+// usage: trivia [--takeover [handoff socket path]]
+int main(int argc, char *argv[]) {
+    // a restart: take the listening socket of the server running on the same endpoint instead of binding it
+    const bool isTakingOver = argc > 1 && std::strcmp(argv[1], "--takeover") == 0;
+    const std::string handoffPath = argc > 2 ? argv[2] : HANDOFF_SOCKET_PATH;
 
-int main() {
     // clear log file trivia.log
     std::ofstream(LOG_FILE_PATH).close();
 
     // Load config file, if it doesn't exist, use default values
-    Endpoint serverAddress = ConfigLoader::loadConfig(CONFIG_FILE_PATH);
+    const ServerConfig config = ConfigLoader::loadConfig(CONFIG_FILE_PATH);
+
+    // must be set before the server is created, the database fetches questions on construction
+    if (config.useStandIns) {
+        logServerProgress<ConfigLoader>(__func__, "Replacing email and OpenTDB with local stand-ins...");
+        EmailSender::setUseStandIn(true);
+        QuestionsFetcher::setUseStandIn(true);
+        logServerResult(true);
+    }
+
+    logServerProgress<ConfigLoader>(__func__, "Starting " + std::to_string(config.passwordHashing.workers) +
+                                              " password hashing threads...");
+    PasswordHasher::start(config.passwordHashing);
+    logServerResult(true);
+
+    AdmissionController::configure(config.admissionLimits);
+    RequestScheduler::configure(config.scheduler);
+    RateLimiter::configure(config.rateLimits);
+    ConnectionMonitor::start(config.idleTimeouts);
 
     // Start server
-    Server server(serverAddress);
-    server.run();
+    // the stand-ins' questions and accounts never reach the real database
+    Server server(config.endpoint, std::chrono::seconds(config.shutdownDeadlineSeconds),
+                  config.useStandIns ? STAND_IN_DATABASE_FILE_PATH : DATABASE_FILE_PATH);
+    if (isTakingOver && !server.takeOver(handoffPath)) {
+        ConnectionMonitor::stop();
+        PasswordHasher::stop();
+        return EXIT_FAILURE;
+    }
+
+    // after the takeover, the server handing over moves its journal aside first
+    logServerProgress<GameJournal>(__func__, "Reading the game journal...");
+    const auto journalError = GameJournal::start(GAME_JOURNAL_FILE_PATH,
+                                                 std::chrono::milliseconds(config.journalSyncIntervalMs),
+                                                 isTakingOver);
+    logServerResult(!journalError.has_value(), false);
+    if (journalError.has_value()) {
+        logError<GameJournal>(__func__, journalError.value().message, config.endpoint);
+        ConnectionMonitor::stop();
+        PasswordHasher::stop();
+        return EXIT_FAILURE;
+    }
+
+    const bool isDrained = server.run();
+
+    ConnectionMonitor::stop();
+    PasswordHasher::stop();
+    GameJournal::stop();
+    std::fflush(stdout);
+
+    // the threads of the connections left still use the server, exit without destroying it under them
+    if (!isDrained)
+        std::_Exit(EXIT_FAILURE);
 
     return 0;
 }
@@ -1,5 +1,7 @@
 #include <thread>
 #include "game.h"
+#include "../utils/marshaling/jsonSerializer.h"
+#include "../utils/gameJournal/gameJournal.h"
 
 Result<unsigned int>
 Game::submitAnswer(const LoggedUser &user, unsigned int answerIndex, unsigned int questionIndex) {
@@ -19,12 +21,19 @@ Game::submitAnswer(const LoggedUser &user, unsigned int answerIndex, unsigned in
     if (timeSinceGameStart.count() >= currQuestionReleaseTime)
         return Error("Answer already released"); // answer already released, player submit answer after release.
 
+    // kept before waiting for the question to close, so a handoff meanwhile carries the answer to the new server
+    const auto &answerTimeInSeconds = _timePerQuestion - (currQuestionReleaseTime - timeSinceGameStart.count());
+    {
+        std::unique_lock lock(_playersMutex);
+        _players.at(user).submitAnswer(answerIndex, questionIndex, static_cast<unsigned int>(answerTimeInSeconds));
+    }
+    GameJournal::recordAnswer(_uuid, user.username, questionIndex, answerIndex,
+                              static_cast<unsigned int>(answerTimeInSeconds));
+
     // sleep until (game start time) + currQuestionReleaseTime
     const auto sleepUntilReleased = _gameStartTime + std::chrono::seconds(currQuestionReleaseTime);
     std::this_thread::sleep_until(sleepUntilReleased);
 
-    const auto &answerTimeInSeconds = _timePerQuestion - (currQuestionReleaseTime - timeSinceGameStart.count());
-    _players.at(user).submitAnswer(answerIndex, questionIndex, static_cast<unsigned int>(answerTimeInSeconds));
     return _questions[questionIndex].getCorrectAnswerIndex();
 }
 
@@ -36,13 +45,20 @@ void Game::removePlayer(const LoggedUser &user) {
 Game::Game(const std::vector<Question> &questions, std::vector<LoggedUser> players, std::string uuid,
            unsigned int timePerQuestion) :  _timePerQuestion(timePerQuestion),
                                            _uuid(std::move(uuid)), _questions(questions),
-                                           _onlinePlayers(players) {
+                                           _onlinePlayers(players), _questionFrames(questions.size()) {
 
     _gameStartTime = std::chrono::steady_clock::now();
     for (auto &player: players)
         _players.emplace(player, GameData(questions, timePerQuestion));
 }
 
+Game::Game(const std::vector<Question> &questions, std::map<LoggedUser, GameData> players,
+           std::vector<LoggedUser> onlinePlayers, std::string uuid, unsigned int timePerQuestion,
+           std::chrono::steady_clock::time_point startTime, std::size_t releasedQuestionsCount)
+        : _questions(questions), _onlinePlayers(std::move(onlinePlayers)), _players(std::move(players)),
+          _timePerQuestion(timePerQuestion), _uuid(std::move(uuid)), _questionFrames(questions.size()),
+          _releasedQuestionsCount(releasedQuestionsCount), _gameStartTime(startTime) {}
+
 bool Game::operator==(const Game &other) const {
     return _uuid == other._uuid;
 }
@@ -52,13 +68,77 @@ std::map<LoggedUser, GameData> Game::getPlayersResults() const {
     return _players;
 }
 
-std::pair<unsigned int, Question> Game::getCurrentQuestion() const {
+GameData Game::getPlayerGameData(const LoggedUser &user) const {
+    std::shared_lock lock(_playersMutex);
+    return _players.at(user);
+}
+
+Result<std::shared_ptr<const std::vector<PlayerResult>>> Game::getFinalResults(const PlayersResolver &resolvePlayers) const {
+    // held while resolving, so the other players wait for this result instead of querying the database too
+    std::lock_guard lock(_finalResultsMutex);
+    if (_finalResults != nullptr)
+        return _finalResults;
+
+    if (!isFinished())
+        return Error(ErrorType::InvalidRequest, "Game is not yet finished");
+
+    std::vector<LoggedUser> users;
+    std::shared_lock playersLock(_playersMutex);
+    users.reserve(_players.size());
+    for (const auto &player: _players)
+        users.push_back(player.first);
+    playersLock.unlock();
+
+    const auto players = resolvePlayers(users);
+    if (players.isError())
+        return players.error();
+
+    auto results = std::make_shared<std::vector<PlayerResult>>();
+    results->reserve(users.size());
+    playersLock.lock();
+    for (const auto &player: players.value()) {
+        const auto &gameData = _players.at(LoggedUser{player.username});
+        results->push_back(PlayerResult{player.username, player.avatar_color, false,
+                                        static_cast<int>(gameData.scoreChange()), gameData.getNumOfCorrectAnswers(),
+                                        gameData.getNumOfWrongAnswers(), gameData.getAverageAnswerTime()});
+    }
+
+    _finalResults = std::move(results);
+    return _finalResults;
+}
+
+std::shared_ptr<const std::vector<unsigned char>> Game::getCurrentQuestionFrame() const {
     const auto timeSinceGameStart = std::chrono::duration_cast<std::chrono::seconds>(
             std::chrono::steady_clock::now() - _gameStartTime
     );
     const auto currentQuestionIndex = static_cast<unsigned int>(timeSinceGameStart.count() /
                                                                         (_timePerQuestion + 5));
-    return std::make_pair(currentQuestionIndex, _questions[currentQuestionIndex]);
+    if (currentQuestionIndex >= _questions.size())
+        return nullptr;
+
+    std::lock_guard lock(_questionFramesMutex);
+    auto &frames = _questionFrames[currentQuestionIndex];
+    auto &frame = frames[static_cast<std::size_t>(PayloadCodec::getEncoding())];
+    if (frame == nullptr) {
+        // the first player asking for the question in any encoding, so a crash after it scores the question
+        if (std::all_of(frames.cbegin(), frames.cend(), [](const auto &other) { return other == nullptr; }))
+            GameJournal::recordQuestionReleased(_uuid, currentQuestionIndex);
+        _releasedQuestionsCount = std::max<std::size_t>(_releasedQuestionsCount, currentQuestionIndex + 1);
+
+        const auto &question = _questions[currentQuestionIndex];
+        std::map<unsigned int, std::string> answersMap;
+        for (unsigned int i = 0; i < question.getPossibleAnswers().size(); i++)
+            answersMap[i] = question.getPossibleAnswers()[i];
+
+        frame = std::make_shared<const std::vector<unsigned char>>(JsonSerializer::serializeResponse(
+                GetQuestionResponse{true, currentQuestionIndex, question.getQuestion(), answersMap}));
+    }
+    return frame;
+}
+
+std::size_t Game::getReleasedQuestionsCount() const {
+    std::lock_guard lock(_questionFramesMutex);
+    return _releasedQuestionsCount;
 }
 
 std::vector<LoggedUser> Game::getOnlinePlayers() const {
@@ -77,8 +157,9 @@ void Game::markUserResultsAsSubmittedToDB(const LoggedUser &user) {
 }
 
 bool Game::isFinished() const {
-    const auto timeSinceGameStart = std::chrono::duration_cast<std::chrono::seconds>(
-            std::chrono::steady_clock::now() - _gameStartTime
-    );
-    return timeSinceGameStart.count() >= _questions.size() * (_timePerQuestion + 5);
+    return std::chrono::steady_clock::now() >= getEndTime();
+}
+
+std::chrono::steady_clock::time_point Game::getEndTime() const {
+    return _gameStartTime + std::chrono::seconds(_questions.size() * (_timePerQuestion + 5));
 }
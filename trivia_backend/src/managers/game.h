@@ -1,6 +1,9 @@
 #pragma once
 
 
+#include <array>
+#include <functional>
+#include <memory>
 #include <utility>
 #include <vector>
 #include <map>
@@ -10,9 +13,14 @@
 #include "question.h"
 #include "loggedUser.h"
 #include "../errors/result.h"
+#include "../utils/lockProfiler/lockProfiler.h"
+#include "../utils/marshaling/payloadEncoding.h"
+#include "../utils/responses/responses.h"
 #include "../constants.h"
 
 struct GameData {
+    static constexpr unsigned int UNANSWERED_INDEX = 5;    // out of the possible answers, so it is never correct
+
     bool isScoreSubmittedToDB = false;
     bool isPunished = false;
     unsigned int timePerQuestion;
@@ -21,7 +29,7 @@ struct GameData {
     explicit GameData(const std::vector<Question>& questions, const unsigned int& timePerQuestion) : timePerQuestion(timePerQuestion) {
         for (auto &question : questions)
             // by default, the player is wrong, and answered at the max time
-            answers.emplace_back(question, std::make_pair(5, timePerQuestion));
+            answers.emplace_back(question, std::make_pair(UNANSWERED_INDEX, timePerQuestion));
     }
 
     [[nodiscard]] unsigned int getNumOfCorrectAnswers() const {
@@ -61,31 +69,58 @@ struct GameData {
 
 class Game {
 public:
+    // resolves the players' avatars, in the order of the given users
+    using PlayersResolver = std::function<Result<std::vector<Player>>(const std::vector<LoggedUser>&)>;
+
     Game(const std::vector<Question>& questions, std::vector<LoggedUser> players, std::string uuid, unsigned int timePerQuestion);
+    // a game handed over by the server this one took over from, as it was there
+    Game(const std::vector<Question>& questions, std::map<LoggedUser, GameData> players,
+         std::vector<LoggedUser> onlinePlayers, std::string uuid, unsigned int timePerQuestion,
+         std::chrono::steady_clock::time_point startTime, std::size_t releasedQuestionsCount);
     ~Game() = default;
 
 
-    std::pair<unsigned int, Question> getCurrentQuestion() const;
+    // the GET_QUESTION_RESPONSE frame of the current question in the calling connection's encoding, serialized by
+    // the first player asking for it and shared with the others. nullptr when the game is finished
+    std::shared_ptr<const std::vector<unsigned char>> getCurrentQuestionFrame() const;
     Result<unsigned int> submitAnswer(const LoggedUser& user, unsigned int answerIndex, unsigned int questionIndex);
     void removePlayer(const LoggedUser& user);
     std::map<LoggedUser, GameData> getPlayersResults() const;
+    GameData getPlayerGameData(const LoggedUser& user) const;
+    // the results section shared by all the players, computed by the first of them asking for it once the game is
+    // finished. isOnline is left false, it keeps changing as players leave
+    Result<std::shared_ptr<const std::vector<PlayerResult>>> getFinalResults(const PlayersResolver& resolvePlayers) const;
     std::vector<LoggedUser> getOnlinePlayers() const;
     bool operator==(const Game& other) const;
     void punishPlayer(const LoggedUser& user);
 
     std::string getUuid() const { return _uuid; }
     unsigned int getTimePerQuestion() const { return _timePerQuestion; }
+    const std::vector<Question> &getQuestions() const { return _questions; }
+    std::chrono::steady_clock::time_point getStartTime() const { return _gameStartTime; }
+    // the questions up to the last one sent to a player
+    std::size_t getReleasedQuestionsCount() const;
     void markUserResultsAsSubmittedToDB(const LoggedUser& user);
     bool isFinished() const;
+    // the end of the last question's break, when isFinished() turns true
+    std::chrono::steady_clock::time_point getEndTime() const;
 
 private:
     std::vector<Question> _questions;
     std::vector<LoggedUser> _onlinePlayers;
-    mutable std::shared_mutex _onlinePlayersMutex;
+    mutable ProfiledSharedMutex _onlinePlayersMutex{"Game::_onlinePlayersMutex"};
     std::map<LoggedUser, GameData> _players;
-    mutable std::shared_mutex _playersMutex;
+    mutable ProfiledSharedMutex _playersMutex{"Game::_playersMutex"};
     unsigned int _timePerQuestion;
     std::string _uuid;
 
+    using QuestionFrames = std::array<std::shared_ptr<const std::vector<unsigned char>>, PAYLOAD_ENCODINGS_COUNT>;
+    mutable std::vector<QuestionFrames> _questionFrames;   // per question, per encoding
+    mutable std::size_t _releasedQuestionsCount = 0;
+    mutable ProfiledMutex _questionFramesMutex{"Game::_questionFramesMutex"};
+
+    mutable std::shared_ptr<const std::vector<PlayerResult>> _finalResults;
+    mutable ProfiledMutex _finalResultsMutex{"Game::_finalResultsMutex"};
+
     std::chrono::steady_clock::time_point  _gameStartTime;
 };
\ No newline at end of file
@@ -1,19 +1,22 @@
+#include <algorithm>
 #include <thread>
 #include "gameManager.h"
+#include "../utils/gameJournal/gameJournal.h"
 
-Result<std::reference_wrapper<Game>> GameManager::createGame(const Room &room) {
+Result<GameHandle> GameManager::createGame(const Room &room) {
 
     const auto db_ptr = _database.lock();
     if (db_ptr == nullptr)
         return Error(ErrorType::Database, "Database Not Initialized");
 
-    const auto questionsDbRes = db_ptr->getQuestions(room.getMetadata().questionCount);
+    const auto roomState = room.getState();
+    const auto questionsDbRes = db_ptr->getQuestions(roomState->roomData.questionCount);
 
     if (questionsDbRes.isError())
         return questionsDbRes.error();
 
     const auto questionsDb = questionsDbRes.value();
-    if (questionsDb.size() != room.getMetadata().questionCount)
+    if (questionsDb.size() != roomState->roomData.questionCount)
         return Error(ErrorType::NotFound, "Not enough questions found");
 
     std::vector<Question> questions;
@@ -22,41 +25,72 @@ Result<std::reference_wrapper<Game>> GameManager::createGame(const Room &room) {
                        return Question(question);
                    });
 
+    auto game = std::make_shared<Game>(questions, roomState->users, roomState->roomData.uuid,
+                                       roomState->roomData.timePerQuestion);
+    _lobbyDirectory.setGameEndTime(roomState->roomData.uuid, game->getEndTime());
+    GameJournal::recordGameCreated(roomState->roomData.uuid, roomState->roomData.timePerQuestion, roomState->users,
+                                   questions);
+
+    return addGame(std::move(game));
+}
+
+GameHandle GameManager::addGame(std::shared_ptr<Game> game) {
+    const auto gameId = game->getUuid();
     std::lock_guard lock(_gamesMutex);
-    auto gamePtr = std::make_unique<Game>(questions, room.getAllUsers(), room.getMetadata().uuid,
-                                          room.getMetadata().timePerQuestion);
-    _games.push_back(std::move(gamePtr));
+    GameHandle handle;
+    if (_freeSlots.empty()) {
+        handle.index = static_cast<std::uint32_t>(_slots.size());
+        _slots.emplace_back();
+    } else {
+        handle.index = _freeSlots.back();
+        _freeSlots.pop_back();
+    }
+
+    auto &slot = _slots[handle.index];
+    slot.game = std::move(game);
+    handle.generation = slot.generation;
+    _handlesById[gameId] = handle;
 
-    return std::ref(*_games.back());
+    return handle;
 }
 
-std::optional<Error> GameManager::removePlayerFromGame(Game &game, const LoggedUser &user) {
+std::optional<Error> GameManager::removePlayerFromGame(GameHandle handle, const LoggedUser &user) {
     const auto db_ptr = _database.lock();
     if (db_ptr == nullptr)
         return Error(ErrorType::Database, "Database Not Initialized");
 
-    if (!game.isFinished())
+    const auto gameRes = getGame(handle);
+    if (gameRes.isError())
+        return gameRes.error();
+
+    auto &game = *gameRes.value();
+    // already submitted when the game was checkpointed on shutdown, the player didn't choose to leave
+    const bool isLeavingEarly = !game.isFinished() && !game.getPlayerGameData(user).isScoreSubmittedToDB;
+    if (isLeavingEarly)
         game.punishPlayer(user);
     game.removePlayer(user);
+    GameJournal::recordPlayerLeft(game.getUuid(), user.username, isLeavingEarly);
     std::optional<Error> submitResult;
 
     // update the db immediately if a player left during the game.
-    if (!game.isFinished()) {
+    if (isLeavingEarly) {
         game.markUserResultsAsSubmittedToDB(user);
-        const auto gameData = game.getPlayersResults().at(user);
-        submitResult = db_ptr->submitGameStatistics(gameData, user.username);
+        const auto gameData = game.getPlayerGameData(user);
+        submitResult = db_ptr->submitGameStatistics(gameData, game.getUuid(), user.username);
+        if (!submitResult.has_value()) {
+            GameJournal::recordStatsSubmitted(game.getUuid(), user.username);
+            _lobbyDirectory.refreshPlayers({user});
+        }
     }
 
     // submit all players stats to db whenever a user left,
     // the score won't be submitted twice as the gameData includes a boolean that
     // tells weather the score was already submitted.
     if (game.isFinished())
-        submitAllGameStatsToDB(game.getUuid());
+        submitAllGameStatsToDB(game);
 
-    if (game.getOnlinePlayers().empty()) {
-        std::lock_guard lock(_gamesMutex);
-        _games.erase(std::find_if(_games.begin(), _games.end(), [&game](const auto &ptr) { return *ptr == game; }));
-    }
+    if (game.getOnlinePlayers().empty())
+        removeGame(handle);
 
     if (submitResult.has_value())
         return submitResult.value();
@@ -64,37 +98,171 @@ std::optional<Error> GameManager::removePlayerFromGame(Game &game, const LoggedU
     return std::nullopt;
 }
 
+Result<std::shared_ptr<Game>> GameManager::getGame(GameHandle handle) const {
+    std::shared_lock lock(_gamesMutex);
+    if (handle.index >= _slots.size())
+        return Error(ErrorType::NotFound, "Game not found");
+
+    const auto &slot = _slots[handle.index];
+    if (slot.generation != handle.generation || slot.game == nullptr)
+        return Error(ErrorType::NotFound, "Game was already closed");
+
+    return slot.game;
+}
+
+Result<std::shared_ptr<Game>> GameManager::getGameById(const std::string &id) const {
+    const auto handle = getGameHandle(id);
+    if (handle.isError())
+        return handle.error();
 
-Game &GameManager::getGameById(const std::string &id) {
+    return getGame(handle.value());
+}
+
+Result<GameHandle> GameManager::getGameHandle(const std::string &id) const {
+    std::shared_lock lock(_gamesMutex);
+    const auto handle = _handlesById.find(id);
+    if (handle == _handlesById.end())
+        return Error(ErrorType::NotFound, "Game not found");
+
+    return handle->second;
+}
+
+std::size_t GameManager::getRunningGamesCount() const {
     std::shared_lock lock(_gamesMutex);
-    return *_games.at(
-            std::find_if(_games.cbegin(), _games.cend(), [&](const auto &game) { return game->getUuid() == id; }) -
-            _games.cbegin());
+    return static_cast<std::size_t>(std::count_if(_slots.cbegin(), _slots.cend(), [](const GameSlot &slot) {
+        return slot.game != nullptr && !slot.game->isFinished();
+    }));
 }
 
-void GameManager::submitAllGameStatsToDB(const std::string &gameId) {
+std::size_t GameManager::checkpointRunningGames() {
+    std::vector<std::shared_ptr<Game>> runningGames;
+    {
+        std::shared_lock lock(_gamesMutex);
+        for (const auto &slot: _slots) {
+            if (slot.game != nullptr && !slot.game->isFinished())
+                runningGames.push_back(slot.game);
+        }
+    }
+
+    // the database is written without holding the games lock
+    for (const auto &game: runningGames)
+        submitAllGameStatsToDB(*game);
+    return runningGames.size();
+}
+
+void GameManager::submitAllGameStatsToDB(Game &game) {
     const auto db_ptr = _database.lock();
     if (db_ptr == nullptr)
         return;
 
-    auto &game = getGameById(gameId);
-    std::shared_lock lock(_gamesMutex);
     const auto playersResults = game.getPlayersResults();
+    std::vector<LoggedUser> submittedUsers;
 
     for (const auto &player: playersResults) {
         const auto &gameData = player.second;
         if (gameData.isScoreSubmittedToDB)  // if the score of the user was already submitted, skip
             continue;
         game.markUserResultsAsSubmittedToDB(player.first);
-        const auto _ = db_ptr->submitGameStatistics(gameData, player.first.username);
         // we have nothing to do here if we failed to submit the game statistics, just ignore it
+        if (!db_ptr->submitGameStatistics(gameData, game.getUuid(), player.first.username).has_value()) {
+            GameJournal::recordStatsSubmitted(game.getUuid(), player.first.username);
+            submittedUsers.push_back(player.first);
+        }
     }
+
+    // the room's players are listed with their new scores
+    if (!submittedUsers.empty())
+        _lobbyDirectory.refreshPlayers(submittedUsers);
 }
 
-std::optional<Error> GameManager::removePlayerFromGame(const std::string &gameId, const LoggedUser &user) {
+std::size_t GameManager::finalizeJournaledGames() {
+    const auto db_ptr = _database.lock();
+    if (db_ptr == nullptr)
+        return 0;
+
+    const auto journaledGames = GameJournal::takeUnfinishedGames();
+    for (const auto &journaledGame: journaledGames) {
+        bool isEverySubmitted = true;
+        for (const auto &[username, gameData]: journaledGame.players) {
+            // the server crashed before the first question was asked, the game has nothing to count
+            if (gameData.answers.empty())
+                continue;
+            if (db_ptr->submitGameStatistics(gameData, journaledGame.gameId, username).has_value())
+                isEverySubmitted = false;
+            else
+                GameJournal::recordStatsSubmitted(journaledGame.gameId, username);
+        }
+
+        // the players who failed are submitted again on the next start
+        if (isEverySubmitted)
+            GameJournal::recordGameFinalized(journaledGame.gameId);
+    }
+    return journaledGames.size();
+}
+
+std::vector<std::shared_ptr<Game>> GameManager::getGames() const {
+    std::vector<std::shared_ptr<Game>> games;
     std::shared_lock lock(_gamesMutex);
-    auto &game = getGameById(gameId);
-    lock.unlock();
-    return removePlayerFromGame(game, user);
+    for (const auto &slot: _slots) {
+        if (slot.game != nullptr)
+            games.push_back(slot.game);
+    }
+    return games;
 }
 
+GameHandle GameManager::restoreGame(std::shared_ptr<Game> game) {
+    const auto gameId = game->getUuid();
+    _lobbyDirectory.setGameEndTime(gameId, game->getEndTime());
+
+    // the journal of the server handing over is left behind, so a crash of this one still scores the game
+    const auto players = game->getPlayersResults();
+    const auto onlinePlayers = game->getOnlinePlayers();
+    std::vector<LoggedUser> users;
+    for (const auto &player: players)
+        users.push_back(player.first);
+    GameJournal::recordGameCreated(gameId, game->getTimePerQuestion(), users, game->getQuestions());
+    if (game->getReleasedQuestionsCount() != 0)
+        GameJournal::recordQuestionReleased(gameId, game->getReleasedQuestionsCount() - 1);
+    for (const auto &[user, gameData]: players) {
+        for (unsigned int i = 0; i < gameData.answers.size(); i++) {
+            const auto &[answerIndex, answerTime] = gameData.answers[i].second;
+            if (answerIndex < GameData::UNANSWERED_INDEX)
+                GameJournal::recordAnswer(gameId, user.username, i, answerIndex, answerTime);
+        }
+        if (std::find(onlinePlayers.cbegin(), onlinePlayers.cend(), user) == onlinePlayers.cend())
+            GameJournal::recordPlayerLeft(gameId, user.username, gameData.isPunished);
+        if (gameData.isScoreSubmittedToDB)
+            GameJournal::recordStatsSubmitted(gameId, user.username);
+    }
+
+    return addGame(std::move(game));
+}
+
+void GameManager::removeGame(GameHandle handle) {
+    std::lock_guard lock(_gamesMutex);
+    // the last two players may leave together, only the first of them removes the game
+    if (handle.index >= _slots.size() || _slots[handle.index].generation != handle.generation)
+        return;
+
+    auto &slot = _slots[handle.index];
+    const auto gameId = slot.game->getUuid();
+    // a game closed by its last player is over too
+    _lobbyDirectory.setGameEndTime(gameId, std::min(slot.game->getEndTime(), std::chrono::steady_clock::now()));
+    // every player left, so each one's statistics were submitted on the way out
+    GameJournal::recordGameFinalized(gameId);
+    slot.game = nullptr;
+    slot.generation++;
+    _freeSlots.push_back(handle.index);
+
+    const auto idHandle = _handlesById.find(gameId);
+    if (idHandle != _handlesById.end() && idHandle->second == handle)
+        _handlesById.erase(idHandle);
+}
+
+std::optional<Error> GameManager::removePlayerFromGame(const std::string &gameId, const LoggedUser &user) {
+    const auto handle = getGameHandle(gameId);
+    if (handle.isError())
+        return handle.error();
+
+    return removePlayerFromGame(handle.value(), user);
+}
@@ -1,27 +1,72 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <unordered_map>
 #include "usersManager.h"
 #include "../utils/databaseAccess/IDatabasae.h"
 #include "game.h"
 #include "room.h"
+#include "lobbyDirectory.h"
+#include "../utils/lockProfiler/lockProfiler.h"
+
+// a game's slot in the GameManager, and the slot's generation when the game was put there.
+// once the game is removed the slot is reused with another generation, so an old handle can't reach the new game
+struct GameHandle {
+    std::uint32_t index = 0;
+    std::uint32_t generation = 0;
+
+    bool operator==(const GameHandle &other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const GameHandle &other) const { return !(*this == other); }
+};
 
 class GameManager
 {
 public:
-    explicit GameManager(const std::shared_ptr<IDatabase> &database) : _database(database) {};
+    explicit GameManager(const std::shared_ptr<IDatabase> &database, LobbyDirectory &lobbyDirectory)
+            : _database(database), _lobbyDirectory(lobbyDirectory) {};
     ~GameManager() = default;
 
-    Result<std::reference_wrapper<Game>> createGame(const Room& room);
-    std::optional<Error> removePlayerFromGame(Game& game, const LoggedUser& user);
+    Result<GameHandle> createGame(const Room& room);
+    std::optional<Error> removePlayerFromGame(GameHandle handle, const LoggedUser& user);
     std::optional<Error> removePlayerFromGame(const std::string& gameId, const LoggedUser& user);
-    Game& getGameById(const std::string& id);
 
-    void submitAllGameStatsToDB(const std::string& gameId);
+    // NotFound once the game was removed, the returned pointer keeps it alive until the caller is done with it
+    Result<std::shared_ptr<Game>> getGame(GameHandle handle) const;
+    Result<std::shared_ptr<Game>> getGameById(const std::string& id) const;
+    Result<GameHandle> getGameHandle(const std::string& id) const;
+
+    // games whose last question isn't over yet
+    std::size_t getRunningGamesCount() const;
+
+    // submits the statistics of the running games as they are now, when the server shuts down before they finish.
+    // the players leaving them afterwards are not punished. returns the number of games saved
+    std::size_t checkpointRunningGames();
+
+    // submits the statistics of the games the last run left unfinished in the GameJournal (it crashed or was killed),
+    // with the answers it journaled. the players who left early are punished as they were. returns the number of games
+    std::size_t finalizeJournaledGames();
+
+    // for a handoff: every game not removed yet, and a game of the server this one took over from, which is
+    // journaled again here
+    std::vector<std::shared_ptr<Game>> getGames() const;
+    GameHandle restoreGame(std::shared_ptr<Game> game);
+
 private:
+    struct GameSlot {
+        std::shared_ptr<Game> game;     // nullptr while the slot is free
+        std::uint32_t generation = 0;
+    };
+
+    GameHandle addGame(std::shared_ptr<Game> game);
+    void submitAllGameStatsToDB(Game& game);
+    void removeGame(GameHandle handle);
 
     std::weak_ptr<IDatabase> _database;
-    std::vector<std::unique_ptr<Game>> _games;
-    mutable std::shared_mutex _gamesMutex;
+    LobbyDirectory &_lobbyDirectory;
+    std::vector<GameSlot> _slots;
+    std::vector<std::uint32_t> _freeSlots;
+    std::unordered_map<std::string, GameHandle> _handlesById;  // game id (the room's uuid) -> handle
+    mutable ProfiledSharedMutex _gamesMutex{"GameManager::_gamesMutex"};
 
-};
\ No newline at end of file
+};
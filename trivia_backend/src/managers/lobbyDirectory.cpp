@@ -0,0 +1,153 @@
+#include "lobbyDirectory.h"
+#include <algorithm>
+
+std::vector<Player> LobbyDirectory::lookUpPlayers(const std::vector<LoggedUser> &users) const {
+    const auto db_ptr = _database.lock();
+    if (users.empty() || db_ptr == nullptr)
+        return {};
+
+    std::vector<std::string> usernames;
+    usernames.reserve(users.size());
+    for (const auto &user: users)
+        usernames.push_back(user.username);
+
+    const auto playersRes = db_ptr->getPlayersByNames(usernames);
+    if (playersRes.isError())
+        return {};
+    return playersRes.value();
+}
+
+void LobbyDirectory::updateRoom(const std::shared_ptr<const RoomState> &roomState,
+                                const std::vector<Player> &joiningPlayers) {
+    const auto &roomUuid = roomState->roomData.uuid;
+    if (roomState->isClosed) {
+        std::lock_guard lock(_writeMutex);
+        auto entries = std::make_shared<LobbyEntries>(*std::atomic_load(&_entries));
+        entries->erase(roomUuid);
+        publish(std::move(entries));
+        return;
+    }
+
+    auto entry = std::make_shared<LobbyEntry>();
+    entry->roomData = roomState->roomData;
+    entry->usersCount = roomState->users.size();
+    entry->version = roomState->version;
+
+    // the players are resolved from the current entry, so a refresh that came meanwhile isn't undone
+    std::lock_guard lock(_writeMutex);
+    auto entries = std::make_shared<LobbyEntries>(*std::atomic_load(&_entries));
+    auto &currentEntry = (*entries)[roomUuid];
+    if (currentEntry != nullptr) {
+        if (currentEntry->version >= entry->version)
+            return;
+        entry->gameEndTime = currentEntry->gameEndTime;
+    }
+    entry->players = resolvePlayers(*roomState, currentEntry.get(), joiningPlayers);
+    currentEntry = std::move(entry);
+    publish(std::move(entries));
+}
+
+void LobbyDirectory::setGameEndTime(const std::string &roomUuid, std::chrono::steady_clock::time_point endTime) {
+    std::lock_guard lock(_writeMutex);
+    const auto currentEntries = std::atomic_load(&_entries);
+    const auto currentEntry = currentEntries->find(roomUuid);
+    if (currentEntry == currentEntries->end())
+        return;
+
+    auto entry = std::make_shared<LobbyEntry>(*currentEntry->second);
+    entry->gameEndTime = endTime;
+    auto entries = std::make_shared<LobbyEntries>(*currentEntries);
+    (*entries)[roomUuid] = std::move(entry);
+    publish(std::move(entries));
+}
+
+void LobbyDirectory::refreshPlayers(const std::vector<LoggedUser> &users) {
+    const auto players = lookUpPlayers(users);
+    if (players.empty())
+        return;
+
+    std::lock_guard lock(_writeMutex);
+    const auto currentEntries = std::atomic_load(&_entries);
+    std::shared_ptr<LobbyEntries> entries;  // copied once a room lists one of the players
+    for (const auto &[roomUuid, currentEntry]: *currentEntries) {
+        std::shared_ptr<LobbyEntry> entry;
+        for (const auto &player: players) {
+            const auto &listedPlayers = entry != nullptr ? entry->players : currentEntry->players;
+            const auto listedPlayer = std::find_if(listedPlayers.begin(), listedPlayers.end(),
+                                                   [&player](const Player &listed) {
+                                                       return listed.username == player.username;
+                                                   });
+            if (listedPlayer == listedPlayers.end() ||
+                (listedPlayer->score == player.score && listedPlayer->avatar_color == player.avatar_color))
+                continue;
+
+            const auto index = listedPlayer - listedPlayers.begin();
+            if (entry == nullptr)
+                entry = std::make_shared<LobbyEntry>(*currentEntry);
+            entry->players[index] = player;
+        }
+
+        if (entry == nullptr)
+            continue;
+        if (entries == nullptr)
+            entries = std::make_shared<LobbyEntries>(*currentEntries);
+        (*entries)[roomUuid] = std::move(entry);
+    }
+
+    if (entries != nullptr)
+        publish(std::move(entries));
+}
+
+GetRoomsResponse LobbyDirectory::getRooms(const GetRoomsRequest &request) const {
+    const auto entries = std::atomic_load(&_entries);
+    const auto now = std::chrono::steady_clock::now();
+
+    GetRoomsResponse response{true, {}, 0};
+    for (const auto &[roomUuid, entry]: *entries) {
+        if (request.notActive && entry->roomData.isActive)
+            continue;
+        if (request.notFull && entry->usersCount >= entry->roomData.maxPlayers)
+            continue;
+
+        const unsigned int index = response.totalCount++;
+        if (index < request.offset || (request.limit != 0 && index - request.offset >= request.limit))
+            continue;
+
+        const bool isFinished = entry->roomData.isActive &&
+                                (!entry->gameEndTime.has_value() || now >= entry->gameEndTime.value());
+        response.rooms.push_back(RoomDataResponse{entry->roomData, isFinished, entry->players});
+    }
+    return response;
+}
+
+std::vector<Player> LobbyDirectory::resolvePlayers(const RoomState &roomState, const LobbyEntry *previousEntry,
+                                                   const std::vector<Player> &joiningPlayers) {
+    const auto findPlayer = [](const std::vector<Player> &players, const std::string &username) {
+        return std::find_if(players.begin(), players.end(), [&username](const Player &player) {
+            return player.username == username;
+        });
+    };
+
+    const std::vector<Player> noPlayers;
+    const auto &knownPlayers = previousEntry != nullptr ? previousEntry->players : noPlayers;
+
+    // in the room's order, like the members list of GET_ROOM_STATE_REQUEST
+    std::vector<Player> players;
+    players.reserve(roomState.users.size());
+    for (const auto &user: roomState.users) {
+        const auto knownPlayer = findPlayer(knownPlayers, user.username);
+        if (knownPlayer != knownPlayers.end()) {
+            players.push_back(*knownPlayer);
+            continue;
+        }
+
+        const auto joiningPlayer = findPlayer(joiningPlayers, user.username);
+        if (joiningPlayer != joiningPlayers.end())
+            players.push_back(*joiningPlayer);
+    }
+    return players;
+}
+
+void LobbyDirectory::publish(std::shared_ptr<const LobbyEntries> entries) {
+    std::atomic_store(&_entries, std::move(entries));
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "room.h"
+#include "../utils/databaseAccess/IDatabasae.h"
+#include "../utils/requests/requests.h"
+#include "../utils/responses/responses.h"
+#include "../utils/lockProfiler/lockProfiler.h"
+
+// the rooms list of GET_ROOMS_REQUEST, kept up to date by the rooms and the games as they change instead of being
+// rebuilt from the RoomManager, the GameManager and the database on every request.
+// like the RoomManager shards, the list is immutable and replaced as a whole, readers only load it
+class LobbyDirectory {
+public:
+    explicit LobbyDirectory(const std::shared_ptr<IDatabase> &database) : _database(database) {}
+
+    // the players of the users about to join a room, from the database. called before taking the room's write lock,
+    // a user whose lookup failed is left out
+    [[nodiscard]] std::vector<Player> lookUpPlayers(const std::vector<LoggedUser> &users) const;
+
+    // called by the room with every new state, under the room's write lock so a room's states come in order. never
+    // queries the database: the players are the previous state's and joiningPlayers, a closed room is removed
+    void updateRoom(const std::shared_ptr<const RoomState> &roomState, const std::vector<Player> &joiningPlayers = {});
+    // the room's game is over at endTime, set when the game is created and again if it is closed early
+    void setGameEndTime(const std::string &roomUuid, std::chrono::steady_clock::time_point endTime);
+    // reads the users' players again once their statistics changed, in every room listing them. avatars change from
+    // the menu only, out of any room, so the score is the only field that goes stale
+    void refreshPlayers(const std::vector<LoggedUser> &users);
+
+    // the rooms passing the request's filters, ordered by uuid so the list doesn't reshuffle between polls
+    [[nodiscard]] GetRoomsResponse getRooms(const GetRoomsRequest &request) const;
+
+private:
+    struct LobbyEntry {
+        RoomData roomData;
+        std::vector<Player> players;
+        std::size_t usersCount = 0;     // users whose lookup failed are counted too, without being listed
+        std::uint64_t version = 0;
+        std::optional<std::chrono::steady_clock::time_point> gameEndTime;
+    };
+
+    using LobbyEntries = std::map<std::string, std::shared_ptr<const LobbyEntry>>;
+
+    [[nodiscard]] static std::vector<Player> resolvePlayers(const RoomState &roomState, const LobbyEntry *previousEntry,
+                                                            const std::vector<Player> &joiningPlayers);
+    void publish(std::shared_ptr<const LobbyEntries> entries);
+
+    std::weak_ptr<IDatabase> _database;
+    std::shared_ptr<const LobbyEntries> _entries = std::make_shared<const LobbyEntries>();
+    ProfiledMutex _writeMutex{"LobbyDirectory::_writeMutex"};  // serializes the writers only
+};
@@ -1,12 +1,18 @@
 #include <algorithm>
 #include "loginManager.h"
+#include "../constants.h"
 #include "../utils/validator/validator.h"
 #include "../utils/email_sender/emailSender.h"
+#include "../utils/passwordHasher/passwordHasher.h"
 #include <random>
+#include <fmt/format.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
 
 Result<std::pair<bool, std::string>>
 LoginManager::signup(const std::string &username, const std::string &password, const std::string &email,
-                     const std::string &address, const std::string &phoneNumber, const std::string &birthday) {
+                     const std::string &address, const std::string &phoneNumber, const std::string &birthday,
+                     const Endpoint &endpoint) {
     const auto db_ptr = _database.lock();
     if (db_ptr == nullptr)
         return Error(ErrorType::Database);
@@ -16,9 +22,13 @@ LoginManager::signup(const std::string &username, const std::string &password, c
     if (!isValidSignupCredentialsRes.first)
         return std::make_pair(false, isValidSignupCredentialsRes.second);
 
+    const auto passwordHash = PasswordHasher::hash(password);
+    if (passwordHash.isError())
+        return passwordHash.error();
+
     const AvatarColor avatarColor = getRandomAvatarColor();
     // The addUser function checks and ensures that the User does not already exist
-    const auto addUser = db_ptr->addUser(username, password, email, address, phoneNumber, birthday, avatarColor);
+    const auto addUser = db_ptr->addUser(username, passwordHash.value(), email, address, phoneNumber, birthday, avatarColor);
     if (addUser.has_value())    // error
     {
         if (addUser.value().type != ErrorType::Database)
@@ -27,45 +37,49 @@ LoginManager::signup(const std::string &username, const std::string &password, c
         return addUser.value();
     }
 
-    return login(username, password);    // success. log him in
+    // success, log him in. the password was just hashed, verifying it again would only cost another hash. the
+    // session is opened once the email is verified
+    if (!_presenceRegistry.add(username, endpoint))
+        return std::make_pair(false, "User already logged in");
+
+    return std::make_pair(true, "");
 }
 
 
-Result<std::pair<bool, std::string>> LoginManager::login(const std::string &username, const std::string &password) {
+Result<std::pair<bool, std::string>> LoginManager::login(const std::string &username, const std::string &password,
+                                                         const Endpoint &endpoint) {
     const auto db_ptr = _database.lock();
     if (db_ptr == nullptr)
         return Error(ErrorType::Database, "Database Not Initialized");
 
-    const auto doesUserExist = db_ptr->doesUserExist(username);
-    if (doesUserExist.isError())
-        return doesUserExist.error();
-    if (!doesUserExist.value())
-        return std::make_pair(false, "User does not exist");
-
-    const auto doesPasswordMatch = db_ptr->doesPasswordMatch(username, password);
-    if (doesPasswordMatch.isError())
-        return doesPasswordMatch.error();
-    if (!doesPasswordMatch.value())
+    const auto credentials = db_ptr->getUserCredentials(username);
+    if (credentials.isError()) {
+        if (credentials.error().type == ErrorType::NotFound)
+            return std::make_pair(false, "User does not exist");
+        return credentials.error();
+    }
+    const auto passwordCheck = PasswordHasher::verify(password, credentials.value().password);
+    if (passwordCheck.isError())
+        return passwordCheck.error();
+    if (!passwordCheck.value().isMatch)
         return std::make_pair(false, "Password does not match");
 
-    // lock the logged users list
-    std::lock_guard guard(_loggedUsersMutex);
+    // plaintext rows and hashes of another cost are replaced on login, the only time the password is known.
+    // a failure leaves the old row, it is retried on the next login
+    if (passwordCheck.value().needsRehash) {
+        const auto passwordHash = PasswordHasher::hash(password);
+        if (!passwordHash.isError())
+            const auto _ = db_ptr->updateUserPassword(credentials.value().id, passwordHash.value());
+    }
 
-    const auto doesUserAlreadyLoggedIn = [username](const LoggedUser &user) { return user.username == username; };
-    if (std::any_of(_loggedUsers.cbegin(), _loggedUsers.cend(), doesUserAlreadyLoggedIn))
+    if (!_presenceRegistry.add(username, endpoint))
         return std::make_pair(false, "User already logged in");
 
-    _loggedUsers.push_back({username});
-
     return std::make_pair(true, "");    // success
 }
 
 void LoginManager::logout(const std::string &username) {
-    std::lock_guard guard(_loggedUsersMutex);
-
-    _loggedUsers.erase(std::remove_if(_loggedUsers.begin(), _loggedUsers.end(),
-                                      [username](const LoggedUser &user) { return user.username == username; }),
-                       _loggedUsers.end());
+    _presenceRegistry.remove(username);
 }
 
 std::pair<bool, std::string>
@@ -117,13 +131,107 @@ Result<bool> LoginManager::forgotPassword(const std::string &email) {
     if (db_ptr == nullptr)
         return Error(ErrorType::Database);
 
-    const auto password = db_ptr->getUserPasswordByEmail(email);
-    if (password.isError())
+    const auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard lock(_passwordResetsMutex);
+        const auto passwordReset = _passwordResets.find(email);
+        if (passwordReset != _passwordResets.end() &&
+            now - passwordReset->second.sentAt < std::chrono::seconds(PASSWORD_RESET_RESEND_SECONDS))
+            return false;
+    }
+
+    const auto emailExists = db_ptr->doesEmailExist(email);
+    if (emailExists.isError())
+        return emailExists.error();
+    if (!emailExists.value())
         return false;
 
-    const auto emailRes = EmailSender::sendEmailPasswordRecovery(email, password.value());
+    // the password isn't touched until the code comes back, so asking for a reset can't lock anyone out
+    const auto resetCode = EmailSender::generatePasswordResetCode();
+    {
+        std::lock_guard lock(_passwordResetsMutex);
+        if (_passwordResets.size() >= MAX_PENDING_PASSWORD_RESETS) {
+            for (auto passwordReset = _passwordResets.begin(); passwordReset != _passwordResets.end();) {
+                if (now - passwordReset->second.sentAt >= std::chrono::seconds(PASSWORD_RESET_CODE_TTL_SECONDS))
+                    passwordReset = _passwordResets.erase(passwordReset);
+                else
+                    ++passwordReset;
+            }
+            if (_passwordResets.size() >= MAX_PENDING_PASSWORD_RESETS)
+                return Error(ErrorType::ServerBusy);
+        }
+
+        // two requests racing past the resend check: only the first one mails a code
+        const auto passwordReset = _passwordResets.find(email);
+        if (passwordReset != _passwordResets.end() &&
+            now - passwordReset->second.sentAt < std::chrono::seconds(PASSWORD_RESET_RESEND_SECONDS))
+            return false;
+        _passwordResets[email] = PasswordReset{hashResetCode(resetCode), now, 0};
+    }
+
+    const auto emailRes = EmailSender::sendEmailPasswordRecovery(email, resetCode);
     if (emailRes.has_value())
         return emailRes.value();
 
     return true;
 }
+
+Result<std::pair<bool, std::string>> LoginManager::resetPassword(const std::string &email, const std::string &resetCode,
+                                                                 const std::string &newPassword) {
+    const auto db_ptr = _database.lock();
+    if (db_ptr == nullptr)
+        return Error(ErrorType::Database);
+
+    // checked before the code is used up, so a weak password can be retried with the same code
+    const auto isValidPassword = Validator::isValidPassword(newPassword);
+    if (!isValidPassword.first)
+        return std::make_pair(false, isValidPassword.second);
+
+    const auto codeHash = hashResetCode(resetCode);
+    {
+        std::lock_guard lock(_passwordResetsMutex);
+        const auto passwordReset = _passwordResets.find(email);
+        if (passwordReset == _passwordResets.end())
+            return std::make_pair(false, std::string("Invalid or expired reset code"));
+
+        if (std::chrono::steady_clock::now() - passwordReset->second.sentAt >=
+            std::chrono::seconds(PASSWORD_RESET_CODE_TTL_SECONDS)) {
+            _passwordResets.erase(passwordReset);
+            return std::make_pair(false, std::string("Invalid or expired reset code"));
+        }
+
+        const auto &expectedHash = passwordReset->second.codeHash;
+        if (CRYPTO_memcmp(codeHash.data(), expectedHash.data(), codeHash.size()) != 0) {
+            if (++passwordReset->second.failedAttempts >= PASSWORD_RESET_MAX_ATTEMPTS)
+                _passwordResets.erase(passwordReset);
+            return std::make_pair(false, std::string("Invalid or expired reset code"));
+        }
+
+        // single use
+        _passwordResets.erase(passwordReset);
+    }
+
+    const auto passwordHash = PasswordHasher::hash(newPassword);
+    if (passwordHash.isError())
+        return passwordHash.error();
+
+    const auto updatePassword = db_ptr->updateUserPasswordByEmail(email, passwordHash.value());
+    if (updatePassword.has_value())
+        return updatePassword.value();
+
+    return std::make_pair(true, std::string("Password changed"));
+}
+
+std::string LoginManager::hashResetCode(const std::string &resetCode) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestSize = 0;
+    // SHA-256 is enough, the codes are random and short lived unlike passwords
+    if (EVP_Digest(resetCode.data(), resetCode.size(), digest, &digestSize, EVP_sha256(), nullptr) != 1)
+        throw std::runtime_error("Failed to hash a password reset code");
+
+    std::string hash;
+    hash.reserve(digestSize * 2);
+    for (unsigned int i = 0; i < digestSize; i++)
+        hash += fmt::format("{:02x}", digest[i]);
+    return hash;
+}
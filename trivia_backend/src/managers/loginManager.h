@@ -1,12 +1,13 @@
 #pragma once
 
 #include "../utils/databaseAccess/IDatabasae.h"
-#include <vector>
+#include <chrono>
 #include <string>
 #include <memory>
-#include <mutex>
-#include <shared_mutex>
+#include <unordered_map>
 #include "loggedUser.h"
+#include "presenceRegistry.h"
+#include "../utils/lockProfiler/lockProfiler.h"
 
 class LoginManager {
 public:
@@ -16,21 +17,41 @@ public:
 
     Result<std::pair<bool, std::string>> signup(const std::string &username, const std::string &password, const std::string &email,
                                 const std::string &address, const std::string &phoneNumber,
-                                const std::string &birthday);
+                                const std::string &birthday, const Endpoint &endpoint);
 
-    Result<std::pair<bool, std::string>> login(const std::string &username, const std::string &password);
+    Result<std::pair<bool, std::string>> login(const std::string &username, const std::string &password,
+                                               const Endpoint &endpoint);
 
     void logout(const std::string &username);
 
+    // mails a single use reset code, the current password keeps working until resetPassword is called with it.
+    // false when no account has this email, or a code was mailed to it less than PASSWORD_RESET_RESEND_SECONDS ago
     Result<bool> forgotPassword(const std::string& email);
+
+    // <is the password changed, message>
+    Result<std::pair<bool, std::string>> resetPassword(const std::string &email, const std::string &resetCode,
+                                                       const std::string &newPassword);
+
+    PresenceRegistry &getPresenceRegistry() { return _presenceRegistry; }
 private:
     static std::pair<bool, std::string> isValidSignupCredentials(const std::string &username, const std::string &password, const std::string &email,
                                   const std::string &address, const std::string &phoneNumber, const std::string &birthday);
 
     static AvatarColor getRandomAvatarColor() ;
+
+    // only the codes' hashes are kept
+    static std::string hashResetCode(const std::string &resetCode);
+
+    struct PasswordReset {
+        std::string codeHash;
+        std::chrono::steady_clock::time_point sentAt;
+        unsigned int failedAttempts = 0;
+    };
+
     std::weak_ptr<IDatabase> _database;
-    std::vector<LoggedUser> _loggedUsers;
-    mutable std::shared_mutex _loggedUsersMutex;
+    PresenceRegistry _presenceRegistry;
+    std::unordered_map<std::string, PasswordReset> _passwordResets;    // email -> the code mailed last
+    ProfiledMutex _passwordResetsMutex{"LoginManager::_passwordResetsMutex"};
 };
 
 
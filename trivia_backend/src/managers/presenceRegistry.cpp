@@ -0,0 +1,98 @@
+#include "presenceRegistry.h"
+#include <mutex>
+#include <shared_mutex>
+
+bool PresenceRegistry::add(const std::string &username, const Endpoint &endpoint) {
+    auto &shard = getShard(username);
+    std::lock_guard lock(shard.mutex);
+    const auto added = shard.presences.emplace(
+            username, Presence{endpoint, PresenceLocation::MENU, "", std::chrono::system_clock::now()}).second;
+    if (!added)
+        return false;
+
+    _onlineCount.fetch_add(1, std::memory_order_relaxed);
+    _locationCounts[static_cast<std::size_t>(PresenceLocation::MENU)].fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool PresenceRegistry::remove(const std::string &username) {
+    auto &shard = getShard(username);
+    std::lock_guard lock(shard.mutex);
+    const auto presence = shard.presences.find(username);
+    if (presence == shard.presences.end())
+        return false;
+
+    _locationCounts[static_cast<std::size_t>(presence->second.location)].fetch_sub(1, std::memory_order_relaxed);
+    _onlineCount.fetch_sub(1, std::memory_order_relaxed);
+    shard.presences.erase(presence);
+    return true;
+}
+
+void PresenceRegistry::setLocation(const std::string &username, PresenceLocation location,
+                                   const std::string &locationId) {
+    auto &shard = getShard(username);
+    std::lock_guard lock(shard.mutex);
+    const auto presence = shard.presences.find(username);
+    if (presence == shard.presences.end())
+        return;
+
+    _locationCounts[static_cast<std::size_t>(presence->second.location)].fetch_sub(1, std::memory_order_relaxed);
+    _locationCounts[static_cast<std::size_t>(location)].fetch_add(1, std::memory_order_relaxed);
+    presence->second.location = location;
+    presence->second.locationId = locationId;
+}
+
+void PresenceRegistry::setEndpoint(const std::string &username, const Endpoint &endpoint) {
+    auto &shard = getShard(username);
+    std::lock_guard lock(shard.mutex);
+    const auto presence = shard.presences.find(username);
+    if (presence != shard.presences.end())
+        presence->second.endpoint = endpoint;
+}
+
+std::optional<Presence> PresenceRegistry::get(const std::string &username) const {
+    const auto &shard = getShard(username);
+    std::shared_lock lock(shard.mutex);
+    const auto presence = shard.presences.find(username);
+    if (presence == shard.presences.end())
+        return std::nullopt;
+
+    return presence->second;
+}
+
+bool PresenceRegistry::isOnline(const std::string &username) const {
+    const auto &shard = getShard(username);
+    std::shared_lock lock(shard.mutex);
+    return shard.presences.find(username) != shard.presences.end();
+}
+
+std::vector<std::pair<std::string, Presence>> PresenceRegistry::getAll() const {
+    std::vector<std::pair<std::string, Presence>> presences;
+    for (const auto &shard: _shards) {
+        std::shared_lock lock(shard.mutex);
+        presences.insert(presences.end(), shard.presences.cbegin(), shard.presences.cend());
+    }
+    return presences;
+}
+
+void PresenceRegistry::restore(const std::string &username, const Presence &presence) {
+    auto &shard = getShard(username);
+    std::lock_guard lock(shard.mutex);
+    if (!shard.presences.emplace(username, presence).second)
+        return;
+
+    _onlineCount.fetch_add(1, std::memory_order_relaxed);
+    _locationCounts[static_cast<std::size_t>(presence.location)].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::size_t PresenceRegistry::getOnlineCount(PresenceLocation location) const {
+    return _locationCounts[static_cast<std::size_t>(location)].load(std::memory_order_relaxed);
+}
+
+PresenceRegistry::PresenceShard &PresenceRegistry::getShard(const std::string &username) {
+    return _shards[std::hash<std::string>{}(username) % PRESENCE_SHARDS_COUNT];
+}
+
+const PresenceRegistry::PresenceShard &PresenceRegistry::getShard(const std::string &username) const {
+    return _shards[std::hash<std::string>{}(username) % PRESENCE_SHARDS_COUNT];
+}
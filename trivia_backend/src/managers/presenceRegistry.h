@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../utils/communicator/endpoint.h"
+#include "../utils/lockProfiler/lockProfiler.h"
+
+enum class PresenceLocation {
+    MENU,
+    ROOM,
+    GAME
+};
+
+constexpr std::size_t PRESENCE_LOCATIONS_COUNT = 3;
+
+inline const char *presenceLocationToString(PresenceLocation location) {
+    switch (location) {
+        case PresenceLocation::ROOM:
+            return "room";
+        case PresenceLocation::GAME:
+            return "game";
+        default:
+            return "menu";
+    }
+}
+
+// where a logged in user is and since when
+struct Presence {
+    Endpoint endpoint;      // the connection the user logged in from
+    PresenceLocation location = PresenceLocation::MENU;
+    std::string locationId;     // the room's uuid in a room or game, empty in the menu
+    std::chrono::system_clock::time_point loginTime;
+};
+
+// the logged in users, spread over shards by username hash. login, logout and lookups only lock one shard,
+// the online counts are kept aside so reading them locks nothing
+class PresenceRegistry {
+public:
+    // false when the user is already online
+    bool add(const std::string &username, const Endpoint &endpoint);
+    // false when the user wasn't online
+    bool remove(const std::string &username);
+    // ignored when the user isn't online (anymore)
+    void setLocation(const std::string &username, PresenceLocation location, const std::string &locationId = "");
+    // a resumed session continues on another connection
+    void setEndpoint(const std::string &username, const Endpoint &endpoint);
+
+    [[nodiscard]] std::optional<Presence> get(const std::string &username) const;
+    [[nodiscard]] bool isOnline(const std::string &username) const;
+
+    // for a handoff: every logged in user, and a user of the server this one took over from
+    [[nodiscard]] std::vector<std::pair<std::string, Presence>> getAll() const;
+    void restore(const std::string &username, const Presence &presence);
+
+    [[nodiscard]] std::size_t getOnlineCount() const { return _onlineCount.load(std::memory_order_relaxed); }
+    [[nodiscard]] std::size_t getOnlineCount(PresenceLocation location) const;
+
+private:
+    struct PresenceShard {
+        std::unordered_map<std::string, Presence> presences;
+        mutable ProfiledSharedMutex mutex{"PresenceRegistry::PresenceShard::mutex"};
+    };
+
+    static constexpr std::size_t PRESENCE_SHARDS_COUNT = 16;
+
+    PresenceShard &getShard(const std::string &username);
+    const PresenceShard &getShard(const std::string &username) const;
+
+    std::array<PresenceShard, PRESENCE_SHARDS_COUNT> _shards;
+    std::atomic<std::size_t> _onlineCount{0};
+    std::array<std::atomic<std::size_t>, PRESENCE_LOCATIONS_COUNT> _locationCounts{};
+};
@@ -13,9 +13,15 @@ private:
 
 public:
     explicit Question(const QuestionDb& questionDb);
-    [[nodiscard]] std::string getQuestion() const { return _question; }
+    // a question replayed from the game journal, which keeps only the index of the correct answer
+    explicit Question(unsigned int correctAnswerIndex) : _correctAnswerIndex(correctAnswerIndex) {}
+    // a question handed over by the server this one took over from, its answers already shuffled
+    Question(std::string question, std::vector<std::string> possibleAnswers, unsigned int correctAnswerIndex)
+            : _question(std::move(question)), _possibleAnswers(std::move(possibleAnswers)),
+              _correctAnswerIndex(correctAnswerIndex) {}
+    [[nodiscard]] const std::string &getQuestion() const { return _question; }
 
-    [[nodiscard]] std::vector<std::string> getPossibleAnswers() const { return _possibleAnswers; }
+    [[nodiscard]] const std::vector<std::string> &getPossibleAnswers() const { return _possibleAnswers; }
 
     [[nodiscard]] unsigned int getCorrectAnswerIndex() const { return _correctAnswerIndex; }
 
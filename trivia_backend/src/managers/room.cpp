@@ -1,26 +1,82 @@
 #include "room.h"
 #include <algorithm>
+#include "lobbyDirectory.h"
 
 std::optional<Error> Room::addUser(const LoggedUser &user) {
-    std::lock_guard lock(*_usersMutex);
-    if (_users.size() >= _metadata.maxPlayers)
+    // the database isn't queried while holding the write lock, the room's other writers would wait for it
+    const auto joiningPlayers = _lobbyDirectory.lookUpPlayers({user});
+    std::lock_guard lock(_writeMutex);
+    const auto state = getState();
+    // the last user left and the room is being removed
+    if (state->users.empty())
+        return Error(ErrorType::NotFound, "Room not found");
+
+    if (state->users.size() >= state->roomData.maxPlayers)
         return Error(ErrorType::RoomIsFull);
 
     // check if the User is already in the room
-    if (std::find(_users.begin(), _users.end(), user) != _users.end())
+    if (std::find(state->users.begin(), state->users.end(), user) != state->users.end())
         return Error(ErrorType::AlreadyExists, "User already in the room");
 
-    _users.push_back(user);
+    auto newState = std::make_shared<RoomState>(*state);
+    newState->users.push_back(user);
+    publish(std::move(newState), joiningPlayers);
     return std::nullopt;    // success
 }
 
-void Room::removeUser(const LoggedUser &user) {
-    std::lock_guard lock(*_usersMutex);
+std::size_t Room::removeUser(const LoggedUser &user) {
+    std::lock_guard lock(_writeMutex);
+    const auto state = getState();
+    if (std::find(state->users.begin(), state->users.end(), user) == state->users.end())
+        return state->users.size();
+
+    auto newState = std::make_shared<RoomState>(*state);
+    newState->users.erase(std::remove(newState->users.begin(), newState->users.end(), user), newState->users.end());
+    const auto usersLeft = newState->users.size();
+    publish(std::move(newState));
+    return usersLeft;
+}
+
+void Room::setIsActive(bool isActive) {
+    std::lock_guard lock(_writeMutex);
+    auto newState = std::make_shared<RoomState>(*getState());
+    newState->roomData.isActive = isActive;
+    publish(std::move(newState));
+}
+
+void Room::close() {
+    std::lock_guard lock(_writeMutex);
+    auto newState = std::make_shared<RoomState>(*getState());
+    newState->isClosed = true;
+    publish(std::move(newState));
+}
 
-    _users.erase(std::remove(_users.begin(), _users.end(), user), _users.end());
+std::shared_ptr<const RoomState> Room::waitForChange(std::uint64_t lastSeenVersion,
+                                                     std::chrono::milliseconds timeout) const {
+    std::unique_lock lock(_changeMutex);
+    const auto interruptions = _interruptions;
+    _changed.wait_for(lock, timeout, [this, lastSeenVersion, interruptions]() {
+        return getState()->version != lastSeenVersion || _interruptions != interruptions;
+    });
+    return getState();
 }
 
-std::vector<LoggedUser> Room::getAllUsers() const {
-    std::shared_lock sharedLock(*_usersMutex);
-    return _users;
+void Room::interruptWaits() const {
+    {
+        std::lock_guard lock(_changeMutex);
+        _interruptions++;
+    }
+    _changed.notify_all();
+}
+
+void Room::publish(std::shared_ptr<RoomState> state, const std::vector<Player> &joiningPlayers) {
+    state->version++;
+    const std::shared_ptr<const RoomState> newState(std::move(state));
+    std::atomic_store(&_state, newState);
+    _lobbyDirectory.updateRoom(newState, joiningPlayers);
+
+    // a waiter checks the version under _changeMutex, so after taking it here it either saw the new state
+    // or is already waiting and gets the notification
+    { std::lock_guard lock(_changeMutex); }
+    _changed.notify_all();
 }
@@ -1,27 +1,69 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
 #include <optional>
-#include <mutex>
-#include <shared_mutex>
 #include "roomData.h"
 #include "loggedUser.h"
 #include "../errors/error.h"
+#include "../utils/lockProfiler/lockProfiler.h"
+#include "../utils/responses/responses.h"
+
+class LobbyDirectory;
+
+// an immutable snapshot of a room, replaced as a whole on every change
+struct RoomState
+{
+    RoomData roomData;
+    std::vector<LoggedUser> users;
+    std::uint64_t version = 0;  // incremented by every change
+    bool isClosed = false;      // removed from the RoomManager, the last change of the room
+};
 
 class Room {
 public:
-    explicit Room(const LoggedUser& admin, RoomData metadata) : _metadata(std::move(metadata)), _usersMutex(std::make_shared<std::shared_mutex>()) {
-        _users.emplace_back(admin);
-    }
+    explicit Room(const LoggedUser& admin, RoomData metadata, LobbyDirectory& lobbyDirectory)
+            : _state(std::make_shared<const RoomState>(RoomState{std::move(metadata), {admin}, 0})),
+              _lobbyDirectory(lobbyDirectory) {}
+    // a room handed over by the server this one took over from, it keeps its version for the members' long polls
+    explicit Room(RoomState state, LobbyDirectory& lobbyDirectory)
+            : _state(std::make_shared<const RoomState>(std::move(state))), _lobbyDirectory(lobbyDirectory) {}
+
+    Room(const Room &) = delete;
+    Room &operator=(const Room &) = delete;
 
     std::optional<Error> addUser(const LoggedUser& user);
-    void removeUser(const LoggedUser& user);
-    [[nodiscard]] std::vector<LoggedUser> getAllUsers() const;
-    void setIsActive(bool isActive) { _metadata.isActive = isActive; }
-    [[nodiscard]] RoomData getMetadata() const { return _metadata; }
+    // returns how many users are left
+    std::size_t removeUser(const LoggedUser& user);
+    void setIsActive(bool isActive);
+    void close();
+
+    // blocks the calling thread until the version differs from lastSeenVersion or the timeout passes,
+    // returns the state it ended with
+    [[nodiscard]] std::shared_ptr<const RoomState> waitForChange(std::uint64_t lastSeenVersion,
+                                                                 std::chrono::milliseconds timeout) const;
+    // the waiting members get the state they have without waiting for their timeout, e.g. so they reach a request
+    // boundary for a handoff
+    void interruptWaits() const;
+
+    // readers don't wait for writers, they keep the snapshot they got even if it is replaced meanwhile
+    [[nodiscard]] std::shared_ptr<const RoomState> getState() const { return std::atomic_load(&_state); }
+    [[nodiscard]] std::vector<LoggedUser> getAllUsers() const { return getState()->users; }
+    [[nodiscard]] RoomData getMetadata() const { return getState()->roomData; }
 private:
-    mutable std::shared_ptr<std::shared_mutex> _usersMutex;
-    RoomData _metadata;
-    std::vector<LoggedUser> _users;
-};
\ No newline at end of file
+    // joiningPlayers are the users added by this state, looked up before taking the write lock
+    void publish(std::shared_ptr<RoomState> state, const std::vector<Player> &joiningPlayers = {});
+
+    std::shared_ptr<const RoomState> _state;
+    ProfiledMutex _writeMutex{"Room::_writeMutex"};    // serializes the writers only
+    LobbyDirectory &_lobbyDirectory;    // gets every state the room publishes
+    // only for waiting on changes, readers that don't wait never touch them
+    mutable std::mutex _changeMutex;
+    mutable std::condition_variable _changed;
+    mutable std::uint64_t _interruptions = 0;   // guarded by _changeMutex
+};
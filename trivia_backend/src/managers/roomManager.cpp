@@ -4,73 +4,111 @@
 #include <boost/uuid/uuid_io.hpp>
 #include "roomManager.h"
 
-Room& RoomManager::createRoom(const LoggedUser &admin, RoomData &roomData) {
+std::shared_ptr<Room> RoomManager::createRoom(const LoggedUser &admin, RoomData &roomData) {
     const auto roomUUID = generateRoomUUID();
     roomData.uuid = roomUUID;
-    std::lock_guard lock(_roomsMutex);
-    _rooms.emplace(roomUUID, Room(admin, roomData));
-    return _rooms.at(roomUUID);
+    auto room = std::make_shared<Room>(admin, roomData, _lobbyDirectory);
+    // listed before anyone can reach the room, its later states are pushed by the room itself
+    _lobbyDirectory.updateRoom(room->getState(), _lobbyDirectory.lookUpPlayers({admin}));
+
+    auto &shard = getShard(roomUUID);
+    std::lock_guard lock(shard.writeMutex);
+    auto rooms = std::make_shared<RoomsMap>(*std::atomic_load(&shard.rooms));
+    rooms->emplace(roomUUID, room);
+    std::atomic_store(&shard.rooms, std::shared_ptr<const RoomsMap>(std::move(rooms)));
+    return room;
 }
 
 void RoomManager::deleteRoom(const std::string &roomUUID) {
-    std::lock_guard lock(_roomsMutex);
-    _rooms.erase(roomUUID);
-}
+    auto &shard = getShard(roomUUID);
+    std::lock_guard lock(shard.writeMutex);
+    const auto currentRooms = std::atomic_load(&shard.rooms);
+    const auto room = currentRooms->find(roomUUID);
+    if (room == currentRooms->end())
+        return;
 
-std::vector<RoomData> RoomManager::getRooms() const {
-    std::vector<RoomData> rooms;
-    // lambda function to get the RoomData from the pair
-    const auto getRoomData = [](const std::pair<const std::string, Room> &room) { return room.second.getMetadata(); };
+    // wakes the members waiting for the room to change
+    room->second->close();
 
-    std::shared_lock sharedLock(_roomsMutex);
-    // transform the map into a vector of RoomData
-    std::transform(_rooms.cbegin(), _rooms.cend(), std::back_inserter(rooms), getRoomData);
-    return rooms;
+    auto rooms = std::make_shared<RoomsMap>(*currentRooms);
+    rooms->erase(roomUUID);
+    std::atomic_store(&shard.rooms, std::shared_ptr<const RoomsMap>(std::move(rooms)));
 }
 
-Result<std::reference_wrapper<Room>> RoomManager::getRoom(const std::string &roomUUID) {
-    std::shared_lock sharedLock(_roomsMutex);
-    if (_rooms.find(roomUUID) == _rooms.cend())
+Result<std::shared_ptr<Room>> RoomManager::getRoom(const std::string &roomUUID) const {
+    const auto rooms = std::atomic_load(&getShard(roomUUID).rooms);
+    const auto room = rooms->find(roomUUID);
+    if (room == rooms->cend())
         return Error(ErrorType::NotFound, "Room not found");
 
-    return _rooms.at(roomUUID); // maybe wrap with std::ref() in the future
+    return room->second;
 }
 
-std::string RoomManager::generateRoomUUID() {
+std::string RoomManager::generateRoomUUID() const {
     boost::uuids::uuid uuid{};
 
     // generate random uuid until it's unique, supposed to be in the first try.
     // there are  2^122, or 5.3×10^36 (5.3 undecillion) different uuids.
     // so it's not that big of a deal to just loop until it's unique
     // the chances of it not being unique are extremely low
-    std::shared_lock sharedLock(_roomsMutex);
     do {
         boost::uuids::random_generator gen;
         uuid = gen();
-    } while (_rooms.find(boost::uuids::to_string(uuid)) != _rooms.end());
-    sharedLock.unlock();
+    } while (!getRoom(boost::uuids::to_string(uuid)).isError());
 
     return boost::uuids::to_string(uuid);
 }
 
-std::optional<RoomState> RoomManager::getRoomState(const std::string &roomUUID) {
-    std::shared_lock sharedLock(_roomsMutex);
+std::shared_ptr<const RoomState> RoomManager::getRoomState(const std::string &roomUUID) const {
+    const auto room = getRoom(roomUUID);
+    if (room.isError())
+        return nullptr;
 
-    if (_rooms.find(roomUUID) == _rooms.cend())
-        return std::nullopt;
+    return room.value()->getState();
+}
 
-    const auto &room = _rooms.at(roomUUID);
-    const auto &roomData = room.getMetadata();
-    const auto &roomUsers = room.getAllUsers();
+void RoomManager::removePlayerFromRoom(const std::string &roomUUID, const LoggedUser &user) {
+    const auto room = getRoom(roomUUID);
+    if (room.isError())
+        return;
 
-    return RoomState{roomData, roomUsers};
+    // remove room if no players are left, an empty room also refuses new users
+    if (room.value()->removeUser(user) == 0)
+        deleteRoom(roomUUID);
 }
 
-void RoomManager::removePlayerFromRoom(const std::string &roomUUID, const LoggedUser &user) {
-    std::lock_guard lock(_roomsMutex);
-    _rooms.at(roomUUID).removeUser(user);
+std::vector<std::shared_ptr<const RoomState>> RoomManager::getRoomStates() const {
+    std::vector<std::shared_ptr<const RoomState>> roomStates;
+    for (const auto &shard: _shards) {
+        for (const auto &[roomUUID, room]: *std::atomic_load(&shard.rooms))
+            roomStates.push_back(room->getState());
+    }
+    return roomStates;
+}
+
+void RoomManager::restoreRoom(const RoomState &state) {
+    const auto &roomUUID = state.roomData.uuid;
+    auto room = std::make_shared<Room>(state, _lobbyDirectory);
+    _lobbyDirectory.updateRoom(room->getState(), _lobbyDirectory.lookUpPlayers(state.users));
+
+    auto &shard = getShard(roomUUID);
+    std::lock_guard lock(shard.writeMutex);
+    auto rooms = std::make_shared<RoomsMap>(*std::atomic_load(&shard.rooms));
+    rooms->emplace(roomUUID, std::move(room));
+    std::atomic_store(&shard.rooms, std::shared_ptr<const RoomsMap>(std::move(rooms)));
+}
+
+void RoomManager::interruptWaits() const {
+    for (const auto &shard: _shards) {
+        for (const auto &[roomUUID, room]: *std::atomic_load(&shard.rooms))
+            room->interruptWaits();
+    }
+}
+
+RoomManager::RoomsShard &RoomManager::getShard(const std::string &roomUUID) {
+    return _shards[std::hash<std::string>{}(roomUUID) % ROOMS_SHARDS_COUNT];
+}
 
-    // remove room if no players are left
-    if (_rooms.at(roomUUID).getAllUsers().empty())
-        _rooms.erase(roomUUID);
+const RoomManager::RoomsShard &RoomManager::getShard(const std::string &roomUUID) const {
+    return _shards[std::hash<std::string>{}(roomUUID) % ROOMS_SHARDS_COUNT];
 }
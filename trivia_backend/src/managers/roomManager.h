@@ -1,33 +1,49 @@
 #pragma once
 
-#include <map>
+#include <array>
+#include <memory>
+#include <unordered_map>
 #include <vector>
-#include <optional>
-#include <mutex>
-#include <shared_mutex>
 #include "loggedUser.h"
 #include "room.h"
+#include "lobbyDirectory.h"
 #include "../errors/result.h"
 #include "usersManager.h"
+#include "../utils/lockProfiler/lockProfiler.h"
 
-struct RoomState
-{
-    RoomData roomData;
-    std::vector<LoggedUser> users;
-};
-
+// rooms are spread over shards by uuid hash. every shard's map is immutable and replaced as a whole when a room is
+// created or deleted, so lookups and listing only load the maps and never wait for a writer
 class RoomManager {
 public:
-    Room& createRoom(const LoggedUser& admin, RoomData& roomData);
+    explicit RoomManager(LobbyDirectory &lobbyDirectory) : _lobbyDirectory(lobbyDirectory) {}
+
+    std::shared_ptr<Room> createRoom(const LoggedUser& admin, RoomData& roomData);
     void deleteRoom(const std::string& roomUUID);
-    [[nodiscard]] std::vector<RoomData> getRooms() const;
-    Result<std::reference_wrapper<Room>> getRoom(const std::string& roomUUID);
-    std::optional<RoomState> getRoomState(const std::string &roomUUID);
+    [[nodiscard]] Result<std::shared_ptr<Room>> getRoom(const std::string& roomUUID) const;
+    // nullptr when the room doesn't exist (anymore)
+    [[nodiscard]] std::shared_ptr<const RoomState> getRoomState(const std::string &roomUUID) const;
     void removePlayerFromRoom(const std::string& roomUUID, const LoggedUser& user);
 
+    // for a handoff: the states of every room, and a room of the server this one took over from
+    [[nodiscard]] std::vector<std::shared_ptr<const RoomState>> getRoomStates() const;
+    void restoreRoom(const RoomState &state);
+    // the members waiting for their room to change get it as it is, see Room::interruptWaits
+    void interruptWaits() const;
+
 private:
-    std::string generateRoomUUID();
+    using RoomsMap = std::unordered_map<std::string, std::shared_ptr<Room>>;
 
-    mutable std::shared_mutex _roomsMutex;
-    std::map<std::string, Room> _rooms;
-};
\ No newline at end of file
+    struct RoomsShard {
+        std::shared_ptr<const RoomsMap> rooms = std::make_shared<const RoomsMap>();
+        ProfiledMutex writeMutex{"RoomManager::RoomsShard::writeMutex"};   // serializes the writers only
+    };
+
+    static constexpr std::size_t ROOMS_SHARDS_COUNT = 16;
+
+    std::string generateRoomUUID() const;
+    RoomsShard &getShard(const std::string &roomUUID);
+    const RoomsShard &getShard(const std::string &roomUUID) const;
+
+    std::array<RoomsShard, ROOMS_SHARDS_COUNT> _shards;
+    LobbyDirectory &_lobbyDirectory;
+};
@@ -0,0 +1,212 @@
+#include "sessionRegistry.h"
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <fmt/format.h>
+#include <openssl/rand.h>
+#include "../utils/requests/requests.h"
+
+namespace {
+    constexpr std::size_t TOKEN_SIZE = 32;  // random bytes, sent as hex
+}
+
+SessionRegistry::SessionRegistry(std::chrono::milliseconds gracePeriod) : _gracePeriod(gracePeriod) {
+    _reaper = std::thread(&SessionRegistry::reaperLoop, this);
+}
+
+SessionRegistry::~SessionRegistry() {
+    {
+        std::lock_guard lock(_sessionsMutex);
+        _isStopping = true;
+    }
+    _deadlinesChanged.notify_all();
+    _reaper.join();
+}
+
+std::string SessionRegistry::open(const std::string &username) {
+    auto token = generateToken();
+
+    std::unique_ptr<IRequestHandler> previousHandler;     // destroyed once unlocked
+    std::lock_guard lock(_sessionsMutex);
+    // a user whose session is parked is still online, so the login is refused before getting here.
+    // the previous token is one that was left behind, e.g. by a logout
+    const auto previousToken = _userTokens.find(username);
+    if (previousToken != _userTokens.end())
+        previousHandler = eraseSession(_sessions.find(previousToken->second));
+
+    _sessions[token] = Session{username, nullptr, {}};
+    _userTokens[username] = token;
+    return token;
+}
+
+void SessionRegistry::close(const std::string &token) {
+    std::unique_ptr<IRequestHandler> parkedHandler;
+    {
+        std::lock_guard lock(_sessionsMutex);
+        const auto session = _sessions.find(token);
+        if (session == _sessions.end())
+            return;
+        parkedHandler = eraseSession(session);
+    }
+
+    // the state of a parked user is still in their room / game, the EXIT they skipped cleans it
+    if (parkedHandler != nullptr)
+        parkedHandler->handleRequest({RequestId::EXIT, {}});
+}
+
+void SessionRegistry::closeUser(const std::string &username) {
+    std::string token;
+    {
+        std::lock_guard lock(_sessionsMutex);
+        const auto userToken = _userTokens.find(username);
+        if (userToken == _userTokens.end())
+            return;
+        token = userToken->second;
+    }
+    close(token);
+}
+
+std::size_t SessionRegistry::closeAll() {
+    std::vector<std::unique_ptr<IRequestHandler>> parkedHandlers;
+    {
+        std::lock_guard lock(_sessionsMutex);
+        _isClosed = true;
+        while (!_deadlines.empty())
+            parkedHandlers.push_back(eraseSession(_sessions.find(_deadlines.begin()->second)));
+    }
+
+    for (const auto &parkedHandler: parkedHandlers)
+        parkedHandler->handleRequest({RequestId::EXIT, {}});
+    return parkedHandlers.size();
+}
+
+bool SessionRegistry::isConnected(const std::string &token) const {
+    std::lock_guard lock(_sessionsMutex);
+    const auto session = _sessions.find(token);
+    return session != _sessions.end() && session->second.parkedHandler == nullptr;
+}
+
+bool SessionRegistry::park(const std::string &token, std::unique_ptr<IRequestHandler> &handler) {
+    {
+        std::lock_guard lock(_sessionsMutex);
+        const auto session = _sessions.find(token);
+        if (_isStopping || _isClosed || session == _sessions.end() || session->second.parkedHandler != nullptr)
+            return false;
+
+        session->second.parkedHandler = std::move(handler);
+        session->second.expiresAt = std::chrono::steady_clock::now() + _gracePeriod;
+        _deadlines.emplace(session->second.expiresAt, token);
+    }
+    _deadlinesChanged.notify_one();
+    return true;
+}
+
+std::unique_ptr<IRequestHandler> SessionRegistry::resume(const std::string &token, std::string &username) {
+    std::lock_guard lock(_sessionsMutex);
+    const auto session = _sessions.find(token);
+    if (session == _sessions.end() || session->second.parkedHandler == nullptr)
+        return nullptr;
+
+    eraseDeadline(session->second.expiresAt, token);
+    username = session->second.username;
+    return std::move(session->second.parkedHandler);
+}
+
+std::size_t SessionRegistry::getParkedCount() const {
+    std::lock_guard lock(_sessionsMutex);
+    return _deadlines.size();
+}
+
+std::vector<std::pair<std::string, std::string>> SessionRegistry::getSessions() const {
+    std::vector<std::pair<std::string, std::string>> sessions;
+    std::lock_guard lock(_sessionsMutex);
+    for (const auto &[token, session]: _sessions)
+        sessions.emplace_back(token, session.username);
+    return sessions;
+}
+
+void SessionRegistry::restore(const std::string &token, const std::string &username,
+                              std::unique_ptr<IRequestHandler> handler, std::chrono::milliseconds gracePeriod) {
+    {
+        std::lock_guard lock(_sessionsMutex);
+        if (_sessions.find(token) != _sessions.end())
+            return;
+
+        const auto expiresAt = std::chrono::steady_clock::now() + gracePeriod;
+        _sessions[token] = Session{username, std::move(handler), expiresAt};
+        _userTokens[username] = token;
+        _deadlines.emplace(expiresAt, token);
+    }
+    _deadlinesChanged.notify_one();
+}
+
+void SessionRegistry::handOver() {
+    std::vector<std::unique_ptr<IRequestHandler>> parkedHandlers;     // destroyed once unlocked
+    std::lock_guard lock(_sessionsMutex);
+    _isClosed = true;
+    for (auto &[token, session]: _sessions) {
+        if (session.parkedHandler != nullptr)
+            parkedHandlers.push_back(std::move(session.parkedHandler));
+    }
+    _sessions.clear();
+    _userTokens.clear();
+    _deadlines.clear();
+}
+
+std::unique_ptr<IRequestHandler>
+SessionRegistry::eraseSession(std::unordered_map<std::string, Session>::iterator session) {
+    auto parkedHandler = std::move(session->second.parkedHandler);
+    if (parkedHandler != nullptr)
+        eraseDeadline(session->second.expiresAt, session->first);
+
+    _userTokens.erase(session->second.username);
+    _sessions.erase(session);
+    return parkedHandler;
+}
+
+void SessionRegistry::eraseDeadline(std::chrono::steady_clock::time_point expiresAt, const std::string &token) {
+    const auto [first, last] = _deadlines.equal_range(expiresAt);
+    for (auto deadline = first; deadline != last; ++deadline) {
+        if (deadline->second == token) {
+            _deadlines.erase(deadline);
+            return;
+        }
+    }
+}
+
+std::string SessionRegistry::generateToken() {
+    unsigned char randomBytes[TOKEN_SIZE];
+    // RAND_bytes only fails when the OS has no entropy to seed from, nothing to continue with
+    if (RAND_bytes(randomBytes, sizeof(randomBytes)) != 1)
+        throw std::runtime_error("Failed to generate a session token");
+
+    std::string token;
+    token.reserve(TOKEN_SIZE * 2);
+    for (const auto randomByte: randomBytes)
+        token += fmt::format("{:02x}", randomByte);
+    return token;
+}
+
+void SessionRegistry::reaperLoop() {
+    std::unique_lock lock(_sessionsMutex);
+    while (!_isStopping) {
+        if (_deadlines.empty()) {
+            _deadlinesChanged.wait(lock);
+            continue;
+        }
+
+        const auto deadline = _deadlines.begin();
+        if (deadline->first > std::chrono::steady_clock::now()) {
+            _deadlinesChanged.wait_until(lock, deadline->first);
+            continue;
+        }
+
+        auto expiredHandler = eraseSession(_sessions.find(deadline->second));
+
+        // the logout chain the dropped connection skipped, it takes the room / game locks so not under ours
+        lock.unlock();
+        expiredHandler->handleRequest({RequestId::EXIT, {}});
+        expiredHandler.reset();
+        lock.lock();
+    }
+}
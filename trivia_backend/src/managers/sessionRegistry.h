@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../requestHandlers/IRequestHandler.h"
+
+// the session tokens given at login. when a logged in connection drops, its handler (menu, room or game) is parked
+// under the token instead of getting EXIT, and a new connection that resumes the token within the grace period
+// continues from it. a parked handler that isn't resumed in time gets the EXIT it skipped, from the reaper thread
+class SessionRegistry {
+public:
+    explicit SessionRegistry(std::chrono::milliseconds gracePeriod);
+
+    ~SessionRegistry();  // drops the parked handlers without EXIT, the server is going down
+
+    SessionRegistry(const SessionRegistry &) = delete;
+    SessionRegistry &operator=(const SessionRegistry &) = delete;
+
+    // a new token for a user who just logged in, replacing their previous one
+    std::string open(const std::string &username);
+
+    // the token can't be resumed anymore, a parked handler gets its EXIT. closeUser is for logouts, which don't
+    // know the token
+    void close(const std::string &token);
+    void closeUser(const std::string &username);
+
+    // on shutdown: the parked handlers get their EXIT and nothing can be parked anymore. returns how many were parked
+    std::size_t closeAll();
+
+    // true when the token is open and its user is connected
+    [[nodiscard]] bool isConnected(const std::string &token) const;
+
+    // takes the handler of a dropped connection, false (and the handler is left) when the token isn't open
+    bool park(const std::string &token, std::unique_ptr<IRequestHandler> &handler);
+
+    // the parked handler and its user, nullptr when the token is unknown, expired or connected
+    std::unique_ptr<IRequestHandler> resume(const std::string &token, std::string &username);
+
+    [[nodiscard]] std::size_t getParkedCount() const;
+
+    // for a handoff: every open session, token -> username
+    [[nodiscard]] std::vector<std::pair<std::string, std::string>> getSessions() const;
+    // a session of the server this one took over from, parked with its handler here until its connection is handed
+    // over too or gracePeriod passes
+    void restore(const std::string &token, const std::string &username, std::unique_ptr<IRequestHandler> handler,
+                 std::chrono::milliseconds gracePeriod);
+    // the new server holds the sessions now: they are dropped without EXIT and nothing can be parked anymore
+    void handOver();
+
+private:
+    struct Session {
+        std::string username;
+        std::unique_ptr<IRequestHandler> parkedHandler;     // nullptr while connected
+        std::chrono::steady_clock::time_point expiresAt;
+    };
+
+    // removes the session and its deadline, returns its parked handler. called with _sessionsMutex held
+    std::unique_ptr<IRequestHandler> eraseSession(std::unordered_map<std::string, Session>::iterator session);
+    void eraseDeadline(std::chrono::steady_clock::time_point expiresAt, const std::string &token);
+
+    static std::string generateToken();
+
+    // expires the parked sessions at their deadline
+    void reaperLoop();
+
+    const std::chrono::milliseconds _gracePeriod;
+    std::unordered_map<std::string, Session> _sessions;     // token -> session
+    std::unordered_map<std::string, std::string> _userTokens;   // username -> token
+    std::multimap<std::chrono::steady_clock::time_point, std::string> _deadlines;   // parked tokens, soonest first
+    // a plain mutex, the reaper waits on it with a condition variable
+    mutable std::mutex _sessionsMutex;
+    std::condition_variable _deadlinesChanged;
+    bool _isStopping = false;
+    bool _isClosed = false;     // by closeAll
+    std::thread _reaper;
+};
@@ -1,5 +1,6 @@
 #include "usersManager.h"
 #include "../utils/validator/validator.h"
+#include "../utils/passwordHasher/passwordHasher.h"
 
 Result<UserData> usersManager::getUserData(const std::string &username) const {
     const auto db_ptr = _database.lock();
@@ -18,7 +19,16 @@ std::optional<Error> usersManager::updateUserData(const UpdateUserDataRequest &u
     if (db_ptr == nullptr)
         return Error(ErrorType::Database, "Database Not Initialized");
 
-    return db_ptr->updateUser(userData, username);
+    if (!userData.password.has_value())
+        return db_ptr->updateUser(userData, username);
+
+    const auto passwordHash = PasswordHasher::hash(userData.password.value());
+    if (passwordHash.isError())
+        return passwordHash.error();
+
+    auto hashedUserData = userData;
+    hashedUserData.password = passwordHash.value();
+    return db_ptr->updateUser(hashedUserData, username);
 }
 
 std::pair<bool, std::string> usersManager::isValidUserData(const UpdateUserDataRequest &userData) {
@@ -50,16 +60,16 @@ Result<Player> usersManager::getPlayerByName(const std::string &username) const
 }
 
 Result<std::vector<Player>> usersManager::transformLoggedUsersToPlayers(const std::vector<LoggedUser> &users) const {
-    std::vector<Player> players;
-    for (const auto &user: users) {
-        auto player = getPlayerByName(user.username);
-        if (player.isError())
-            return player.error();
+    const auto db_ptr = _database.lock();
+    if (db_ptr == nullptr)
+        return Error(ErrorType::Database, "Database Not Initialized");
 
-        players.push_back(player.value());
-    }
+    std::vector<std::string> usernames;
+    usernames.reserve(users.size());
+    for (const auto &user: users)
+        usernames.push_back(user.username);
 
-    return players;
+    return db_ptr->getPlayersByNames(usernames);
 }
 
 void usersManager::removeUserUnverifiedUser(const std::string &username) {
@@ -0,0 +1,5 @@
+#include "IRequestHandler.h"
+
+RequestPriority IRequestHandler::getPriority(const RequestInfo &request) {
+    return getRequestPriority(request.requestId);
+}
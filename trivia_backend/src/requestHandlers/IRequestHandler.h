@@ -7,6 +7,8 @@
 
 struct RequestInfo;
 struct RequestResult;
+enum class RequestPriority;
+enum class ConnectionState;
 
 // Interface for request handlers
 class IRequestHandler {
@@ -17,4 +19,10 @@ public:
 
     virtual RequestResult handleRequest(const RequestInfo &request) = 0;
 
+    // the scheduling class of the request in this handler's state, by request id unless overridden
+    virtual RequestPriority getPriority(const RequestInfo &request);
+
+    // picks the idle timeout of the connection while it waits for its next request
+    [[nodiscard]] virtual ConnectionState getConnectionState() const = 0;
+
 };
\ No newline at end of file
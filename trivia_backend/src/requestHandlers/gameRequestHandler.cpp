@@ -9,54 +9,74 @@ bool GameRequestHandler::isRequestRelevant(const RequestInfo &request) {
            request.requestId == RequestId::EXIT;
 }
 
+ConnectionState GameRequestHandler::getConnectionState() const {
+    return ConnectionState::GAME;
+}
+
+RequestPriority GameRequestHandler::getPriority(const RequestInfo &request) {
+    // an answer is held until its question closes, a slot held meanwhile would leave the other requests waiting
+    if (request.requestId == RequestId::EXIT || request.requestId == RequestId::SUBMIT_ANSWER_REQUEST)
+        return RequestPriority::UNSCHEDULED;
+    return RequestPriority::GAME;
+}
+
 RequestResult GameRequestHandler::handleRequest(const RequestInfo &request) {
     if (!isRequestRelevant(request))
         return Error(ErrorType::InvalidRequest, "Request is not relevant").toRequestResult<GameRequestHandler>(__func__,
                                                                                                           _userEndpoint);
 
+    // held until the request is handled, even if the game is removed meanwhile
+    const auto gameRes = _requestHandlerFactory.getGameManager().getGame(_gameHandle);
+    if (gameRes.isError()) {
+        // nothing is left to play, send the player back to the menu
+        if (request.requestId == RequestId::EXIT)
+            _requestHandlerFactory.getLoginManager().logout(_user.username);
+
+        auto result = gameRes.error().toRequestResult<GameRequestHandler>(__func__, _userEndpoint);
+        result.newHandler = _requestHandlerFactory.createMenuRequestHandler(_user, _userEndpoint);
+        return result;
+    }
+
+    auto &game = *gameRes.value();
     switch (request.requestId) {
         case RequestId::LEAVE_GAME_REQUEST:
-            return leaveGame();
+            return leaveGame(game);
         case RequestId::GET_QUESTION_REQUEST:
-            return getQuestion();
+            return getQuestion(game);
         case RequestId::SUBMIT_ANSWER_REQUEST:
-            return submitAnswer(request);
+            return submitAnswer(game, request);
         case RequestId::GET_GAME_RESULTS_REQUEST:
-            return getGameResults();
+            return getGameResults(game);
         case RequestId::EXIT:
-            return leaveGameAndExit();
+            return leaveGameAndExit(game);
         default:
             return Error(ErrorType::InvalidRequest, "Request is not relevant").toRequestResult<GameRequestHandler>(__func__,
                                                                                                               _userEndpoint);
     }
 }
 
-RequestResult GameRequestHandler::getQuestion() {
-    if (_game.isFinished())
+RequestResult GameRequestHandler::getQuestion(Game &game) {
+    if (game.isFinished())
         return Error(ErrorType::InvalidRequest, "Game is already finished").toRequestResult<GameRequestHandler>(__func__, _userEndpoint);
 
-    const auto question = _game.getCurrentQuestion();
-
-    const auto possibleAnswers = question.second.getPossibleAnswers();
-    std::map<unsigned int, std::string> answersMap;
-
-    for (unsigned int i = 0; i < possibleAnswers.size(); i++)
-        answersMap[i] = possibleAnswers[i];
+    // the last question can end between the check above and here
+    auto questionFrame = game.getCurrentQuestionFrame();
+    if (questionFrame == nullptr)
+        return Error(ErrorType::InvalidRequest, "Game is already finished").toRequestResult<GameRequestHandler>(__func__, _userEndpoint);
 
     log<GameRequestHandler>(__func__, "Player '" + _user.username + "' got question", true, _userEndpoint);
-    const auto response = GetQuestionResponse{true, question.first,question.second.getQuestion(), answersMap};
-    return RequestResult{JsonSerializer::serializeResponse(response), nullptr};
+    return RequestResult{{}, nullptr, std::move(questionFrame)};
 }
 
-RequestResult GameRequestHandler::submitAnswer(const RequestInfo &request) {
+RequestResult GameRequestHandler::submitAnswer(Game &game, const RequestInfo &request) {
     const auto submitAnswerRequest = JsonDeserializer::deserializeSubmitAnswerRequest(request.buffer);
     if (submitAnswerRequest.isError())
         return submitAnswerRequest.error().toRequestResult<GameRequestHandler>(__func__, _userEndpoint);
 
-    if (_game.isFinished())
+    if (game.isFinished())
         return Error(ErrorType::InvalidRequest, "Game is already finished").toRequestResult<GameRequestHandler>(__func__, _userEndpoint);
 
-    const auto correctAnswer = _game.submitAnswer(_user, submitAnswerRequest.value().answerId, submitAnswerRequest.value().questionId);
+    const auto correctAnswer = game.submitAnswer(_user, submitAnswerRequest.value().answerId, submitAnswerRequest.value().questionId);
     if (correctAnswer.isError())
         return correctAnswer.error().toRequestResult<GameRequestHandler>(__func__, _userEndpoint);
 
@@ -64,35 +84,29 @@ RequestResult GameRequestHandler::submitAnswer(const RequestInfo &request) {
     return RequestResult{JsonSerializer::serializeResponse(SubmitAnswerResponse{true, correctAnswer.value()}), nullptr};
 }
 
-RequestResult GameRequestHandler::getGameResults() {
-    if (!_game.isFinished())
+RequestResult GameRequestHandler::getGameResults(Game &game) {
+    if (!game.isFinished())
         return Error(ErrorType::InvalidRequest, "Game is not yet finished").toRequestResult<GameRequestHandler>(__func__, _userEndpoint);
 
-    const auto usersMap = _game.getPlayersResults();
-    const auto onlinePlayers = _game.getOnlinePlayers();
-    std::vector<LoggedUser> users;
-    for (const auto& user : usersMap)
-        users.push_back(user.first);
-
-    auto players = _requestHandlerFactory.getUsersManager().transformLoggedUsersToPlayers(users);
-    if (players.isError())
-        return players.error().toRequestResult<GameRequestHandler>(__func__, _userEndpoint);
-
-    std::vector<PlayerResult> playerResults;
-    for (const auto& player : players.value()) {
-        const auto playerGameData = usersMap.at(LoggedUser{player.username});
-        const auto doesPlayerOnline = std::find_if(onlinePlayers.begin(), onlinePlayers.end(), [&player](const auto& onlinePlayer) { return onlinePlayer.username == player.username; }) != onlinePlayers.end();
-        playerResults.push_back(PlayerResult{player.username, player.avatar_color, doesPlayerOnline, static_cast<int>(playerGameData.scoreChange()), playerGameData.getNumOfCorrectAnswers(), playerGameData.getNumOfWrongAnswers(), playerGameData.getAverageAnswerTime()});
-    }
+    const auto finalResults = game.getFinalResults([this](const std::vector<LoggedUser> &users) {
+        return _requestHandlerFactory.getUsersManager().transformLoggedUsersToPlayers(users);
+    });
+    if (finalResults.isError())
+        return finalResults.error().toRequestResult<GameRequestHandler>(__func__, _userEndpoint);
+
+    auto playerResults = *finalResults.value();
+    const auto onlinePlayers = game.getOnlinePlayers();
+    for (auto &playerResult: playerResults)
+        playerResult.isOnline = std::find_if(onlinePlayers.begin(), onlinePlayers.end(), [&playerResult](const auto& onlinePlayer) { return onlinePlayer.username == playerResult.username; }) != onlinePlayers.end();
 
-    const auto response = GetGameResultsResponse{true, usersMap.at(_user).answers, playerResults};
+    const auto response = GetGameResultsResponse{true, game.getPlayerGameData(_user).answers, playerResults};
     return RequestResult{JsonSerializer::serializeResponse(response), nullptr};
 }
 
-RequestResult GameRequestHandler::leaveGame() {
-    const std::string& roomUuid = _game.getUuid();
-    if (_game.isFinished()) {
-        const auto result = _requestHandlerFactory.getGameManager().removePlayerFromGame(_game, _user);
+RequestResult GameRequestHandler::leaveGame(Game &game) {
+    const std::string& roomUuid = game.getUuid();
+    if (game.isFinished()) {
+        const auto result = _requestHandlerFactory.getGameManager().removePlayerFromGame(_gameHandle, _user);
         if (result.has_value()) {
             log<GameRequestHandler>(__func__, "Player '" + _user.username + "' left the game", true,
                                     _userEndpoint);
@@ -106,7 +120,7 @@ RequestResult GameRequestHandler::leaveGame() {
                                 _userEndpoint);
         return RequestResult{JsonSerializer::serializeResponse(LeaveGameResponse{true}), _requestHandlerFactory.createMenuRequestHandler(_user, _userEndpoint)};
     } else {
-        const auto result = _requestHandlerFactory.getGameManager().removePlayerFromGame(_game, _user);
+        const auto result = _requestHandlerFactory.getGameManager().removePlayerFromGame(_gameHandle, _user);
 
         if (result.has_value()) {
             log<GameRequestHandler>(__func__, "Player '" + _user.username + "' left the game, but failed to get punished", true,
@@ -123,9 +137,9 @@ RequestResult GameRequestHandler::leaveGame() {
     }
 }
 
-RequestResult GameRequestHandler::leaveGameAndExit() {
+RequestResult GameRequestHandler::leaveGameAndExit(Game &game) {
     _requestHandlerFactory.getLoginManager().logout(_user.username);
     log<GameRequestHandler>(__func__, "Player '" + _user.username + "' has disconnected, logging him out", true,
                        _userEndpoint);
-    return leaveGame();
+    return leaveGame(game);
 }
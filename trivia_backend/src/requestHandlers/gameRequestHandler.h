@@ -7,9 +7,9 @@
 
 class GameRequestHandler : public IRequestHandler {
 public:
-    explicit GameRequestHandler(Game &game, RequestHandlerFactory &requestHandlerFactory, LoggedUser user,
+    explicit GameRequestHandler(GameHandle gameHandle, RequestHandlerFactory &requestHandlerFactory, LoggedUser user,
                                 Endpoint userEndpoint)
-            : _game(game), _requestHandlerFactory(requestHandlerFactory), _user(std::move(user)),
+            : _gameHandle(gameHandle), _requestHandlerFactory(requestHandlerFactory), _user(std::move(user)),
               _userEndpoint(std::move(userEndpoint)) {}
 
     ~GameRequestHandler() override = default;
@@ -18,15 +18,20 @@ public:
 
     RequestResult handleRequest(const RequestInfo &request) override;
 
+    [[nodiscard]] ConnectionState getConnectionState() const override;
+
+    // whatever a player sends mid game is answered first, but answers wait for their question to close unscheduled
+    RequestPriority getPriority(const RequestInfo &request) override;
+
 private:
-    RequestResult getQuestion();
-    RequestResult submitAnswer(const RequestInfo &request);
-    RequestResult getGameResults();
-    RequestResult leaveGame();
-    RequestResult leaveGameAndExit();
+    RequestResult getQuestion(Game &game);
+    RequestResult submitAnswer(Game &game, const RequestInfo &request);
+    RequestResult getGameResults(Game &game);
+    RequestResult leaveGame(Game &game);
+    RequestResult leaveGameAndExit(Game &game);
 
 
-    Game &_game;
+    GameHandle _gameHandle;
     Endpoint _userEndpoint;
     LoggedUser _user;
     RequestHandlerFactory &_requestHandlerFactory;
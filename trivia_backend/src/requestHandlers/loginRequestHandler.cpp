@@ -4,7 +4,12 @@
 
 bool LoginRequestHandler::isRequestRelevant(const RequestInfo &requestInfo) {
     return requestInfo.requestId == RequestId::LOGIN_REQUEST || requestInfo.requestId == RequestId::SIGNUP_REQUEST ||
-           requestInfo.requestId == RequestId::EXIT || requestInfo.requestId == RequestId::FORGOT_PASSWORD_REQUEST;
+           requestInfo.requestId == RequestId::EXIT || requestInfo.requestId == RequestId::FORGOT_PASSWORD_REQUEST ||
+           requestInfo.requestId == RequestId::RESET_PASSWORD_REQUEST;
+}
+
+ConnectionState LoginRequestHandler::getConnectionState() const {
+    return ConnectionState::LOGIN;
 }
 
 RequestResult LoginRequestHandler::handleRequest(const RequestInfo &requestInfo) {
@@ -21,6 +26,9 @@ RequestResult LoginRequestHandler::handleRequest(const RequestInfo &requestInfo)
     if (requestInfo.requestId == RequestId::FORGOT_PASSWORD_REQUEST)
         return forgotPassword(requestInfo);
 
+    if (requestInfo.requestId == RequestId::RESET_PASSWORD_REQUEST)
+        return resetPassword(requestInfo);
+
     // no need to do something, if the User has exited.
     // because we are still in the login phase
     if (requestInfo.requestId == RequestId::EXIT)
@@ -40,7 +48,7 @@ RequestResult LoginRequestHandler::login(const RequestInfo &request_info) {
     const LoginRequest &request = deserializedRequestRes.value();
     auto &loginManager = _requestHandlerFactory.getLoginManager();
 
-    const auto loginRes = loginManager.login(request.username, request.password);
+    const auto loginRes = loginManager.login(request.username, request.password, _userEndpoint);
     if (loginRes.isError())
         return loginRes.error().toRequestResult<LoginRequestHandler>(__func__, _userEndpoint);
 
@@ -49,6 +57,7 @@ RequestResult LoginRequestHandler::login(const RequestInfo &request_info) {
     std::unique_ptr<IRequestHandler> request_handler;
 
     if (loginRes.value().first) {
+        response.sessionToken = _requestHandlerFactory.getSessionRegistry().open(request.username);
         request_handler = _requestHandlerFactory.createMenuRequestHandler({request.username}, _userEndpoint);
         log<LoginRequestHandler>(__func__, "User '" + request.username + "' logged in", true, _userEndpoint);
     } else {
@@ -59,7 +68,9 @@ RequestResult LoginRequestHandler::login(const RequestInfo &request_info) {
     }
 
     const auto buffer = JsonSerializer::serializeResponse(response);
-    return RequestResult{buffer, std::move(request_handler)};
+    RequestResult requestResult{buffer, std::move(request_handler)};
+    requestResult.sessionToken = response.sessionToken;
+    return requestResult;
 }
 
 RequestResult LoginRequestHandler::signup(const RequestInfo &request_info) {
@@ -72,7 +83,7 @@ RequestResult LoginRequestHandler::signup(const RequestInfo &request_info) {
 
     auto &loginManager = _requestHandlerFactory.getLoginManager();
     const auto signupRes = loginManager.signup(request.username, request.password, request.email, request.address,
-                                               request.phoneNumber, request.birthday);
+                                               request.phoneNumber, request.birthday, _userEndpoint);
     if (signupRes.isError())
         return signupRes.error().toRequestResult<LoginRequestHandler>(__func__, _userEndpoint);
 
@@ -122,8 +133,26 @@ RequestResult LoginRequestHandler::forgotPassword(const RequestInfo &request) {
         log<LoginRequestHandler>(__func__, "Password Recovery email sent successfully to user '" + requestInfo.email + "'",
                                  true, _userEndpoint);
     else
-        log<LoginRequestHandler>(__func__,
-                                 "User tried to recover email that does not exist: '" + requestInfo.email + "'", false,
-                                 _userEndpoint);
+        log<LoginRequestHandler>(__func__, "No password recovery email sent to '" + requestInfo.email +
+                                           "' (unknown or just sent)", false, _userEndpoint);
     return RequestResult{JsonSerializer::serializeResponse(ForgotPasswordResponse{forgotPasswordRes.value()}), nullptr};
 }
+
+RequestResult LoginRequestHandler::resetPassword(const RequestInfo &request) {
+    const auto deserializedRequestRes = JsonDeserializer::deserializeResetPasswordRequest(request.buffer);
+    if (deserializedRequestRes.isError())
+        return deserializedRequestRes.error().toRequestResult<LoginRequestHandler>(__func__, _userEndpoint);
+
+    const ResetPasswordRequest &requestInfo = deserializedRequestRes.value();
+    auto &loginManager = _requestHandlerFactory.getLoginManager();
+    const auto resetPasswordRes = loginManager.resetPassword(requestInfo.email, requestInfo.resetCode,
+                                                             requestInfo.password);
+    if (resetPasswordRes.isError())
+        return resetPasswordRes.error().toRequestResult<LoginRequestHandler>(__func__, _userEndpoint);
+
+    const auto &[isReset, message] = resetPasswordRes.value();
+    log<LoginRequestHandler>(__func__, isReset ? "Password reset for '" + requestInfo.email + "'"
+                                               : "Password reset refused for '" + requestInfo.email + "': " + message,
+                             isReset, _userEndpoint);
+    return RequestResult{JsonSerializer::serializeResponse(ResetPasswordResponse{isReset, message}), nullptr};
+}
@@ -19,6 +19,8 @@ public:
 
     RequestResult handleRequest(const RequestInfo &request) override;
 
+    [[nodiscard]] ConnectionState getConnectionState() const override;
+
 private:
 
     RequestResult login(const RequestInfo &request);
@@ -27,6 +29,8 @@ private:
 
     RequestResult forgotPassword(const RequestInfo &request);
 
+    RequestResult resetPassword(const RequestInfo &request);
+
     Endpoint _userEndpoint;
     RequestHandlerFactory &_requestHandlerFactory;
 };
\ No newline at end of file
@@ -14,6 +14,10 @@ bool MenuRequestHandler::isRequestRelevant(const RequestInfo &request) {
            request.requestId == RequestId::UPDATE_USER_DATA_REQUEST;
 }
 
+ConnectionState MenuRequestHandler::getConnectionState() const {
+    return ConnectionState::MENU;
+}
+
 RequestResult MenuRequestHandler::handleRequest(const RequestInfo &request) {
     if (!isRequestRelevant(request))
         return Error(ErrorType::InvalidRequest, "Request is not relevant").toRequestResult<MenuRequestHandler>(__func__,
@@ -23,7 +27,7 @@ RequestResult MenuRequestHandler::handleRequest(const RequestInfo &request) {
         case RequestId::LOGOUT_REQUEST:
             return logout();
         case RequestId::GET_ROOMS_REQUEST:
-            return getRooms();
+            return getRooms(request);
         case RequestId::GET_PLAYERS_IN_ROOM_REQUEST:
             return getPlayersInRoom(request);
         case RequestId::GET_HIGHSCORES_REQUEST:
@@ -51,6 +55,7 @@ RequestResult MenuRequestHandler::handleRequest(const RequestInfo &request) {
 RequestResult MenuRequestHandler::logout() {
     auto &loginManager = _requestHandlerFactory.getLoginManager();
     loginManager.logout(_user.username);
+    _requestHandlerFactory.getSessionRegistry().closeUser(_user.username);
 
     LogoutResponse response{true};
     log<MenuRequestHandler>(__func__, "User '" + _user.username + "' logged out", true, _userEndpoint);
@@ -58,27 +63,12 @@ RequestResult MenuRequestHandler::logout() {
     return RequestResult{JsonSerializer::serializeResponse(response), std::move(newHandler)};
 }
 
-RequestResult MenuRequestHandler::getRooms() {
-    auto &roomManager = _requestHandlerFactory.getRoomManager();
-    auto roomsData = roomManager.getRooms();
-    std::vector<RoomDataResponse> rooms;
-    for (auto &room: roomsData) {
-        const auto &roomRes = roomManager.getRoom(room.uuid);
-        if (roomRes.isError()) {
-            log<MenuRequestHandler>(__func__, "User '" + _user.username + "' failed to get rooms", false, _userEndpoint);
-            continue;
-        }
-        const auto playersInRoom = _requestHandlerFactory.getUsersManager().transformLoggedUsersToPlayers(
-                roomRes.value().get().getAllUsers());
-        if (playersInRoom.isError()) {
-            log<MenuRequestHandler>(__func__, "User '" + _user.username + "' failed to get rooms", false,
-                               _userEndpoint);
-            continue;
-        }
-
-        rooms.push_back(RoomDataResponse{room, room.isActive && _requestHandlerFactory.getGameManager().getGameById(room.uuid).isFinished(), playersInRoom.value()});
-    }
-    GetRoomsResponse response{true, std::move(rooms)};
+RequestResult MenuRequestHandler::getRooms(const RequestInfo &request) {
+    const auto getRoomsRequest = JsonDeserializer::deserializeGetRoomsRequest(request.buffer);
+    if (getRoomsRequest.isError())
+        return getRoomsRequest.error().toRequestResult<MenuRequestHandler>(__func__, _userEndpoint);
+
+    const auto response = _requestHandlerFactory.getLobbyDirectory().getRooms(getRoomsRequest.value());
     return RequestResult{JsonSerializer::serializeResponse(response), nullptr};
 }
 
@@ -96,7 +86,7 @@ RequestResult MenuRequestHandler::getPlayersInRoom(const RequestInfo &request) {
         return RequestResult{JsonSerializer::serializeResponse(response), nullptr};
     }
 
-    const auto users = roomRes.value().get().getAllUsers();
+    const auto users = roomRes.value()->getAllUsers();
 
     const auto players = _requestHandlerFactory.getUsersManager().transformLoggedUsersToPlayers(users);
     if (players.isError()) {
@@ -144,8 +134,8 @@ RequestResult MenuRequestHandler::joinRoom(const RequestInfo &request) {
     if (roomRes.isError())
         return roomRes.error().toRequestResult<MenuRequestHandler>(__func__, _userEndpoint);
 
-    auto &room = roomRes.value().get();
-    auto joinRes = room.addUser(_user);
+    const auto room = roomRes.value();
+    auto joinRes = room->addUser(_user);
     JoinRoomResponse response{};
 
     if (joinRes.has_value()) {
@@ -187,7 +177,7 @@ RequestResult MenuRequestHandler::createRoom(const RequestInfo &request) {
                            false, _userEndpoint);
         return RequestResult{JsonSerializer::serializeResponse(response), nullptr};
     }
-    Room &room = roomManager.createRoom(_user, roomData);
+    const auto room = roomManager.createRoom(_user, roomData);
     response.status = true;
     log<MenuRequestHandler>(__func__, "User '" + _user.username + "' created room '" + roomData.name + "'",
                        true, _userEndpoint);
@@ -17,9 +17,11 @@ public:
     bool isRequestRelevant(const RequestInfo &request) override;
     RequestResult handleRequest(const RequestInfo &request) override;
 
+    [[nodiscard]] ConnectionState getConnectionState() const override;
+
 private:
     RequestResult logout();
-    RequestResult getRooms();
+    RequestResult getRooms(const RequestInfo &request);
     RequestResult getPlayersInRoom(const RequestInfo &request);
     RequestResult getPersonalStatistics();
     RequestResult getHighScores();
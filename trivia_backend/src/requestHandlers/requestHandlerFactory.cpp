@@ -13,6 +13,8 @@ std::unique_ptr<IRequestHandler> RequestHandlerFactory::createLoginRequestHandle
 
 std::unique_ptr<IRequestHandler>
 RequestHandlerFactory::createMenuRequestHandler(const LoggedUser &user, const Endpoint &endpoint) {
+    // every move between the menu, a room and a game goes through these, so they keep the user's presence
+    _loginManager.getPresenceRegistry().setLocation(user.username, PresenceLocation::MENU);
     return std::make_unique<MenuRequestHandler>(*this, user, endpoint);
 }
 
@@ -36,20 +38,33 @@ GameManager &RequestHandlerFactory::getGameManager() {
     return _gameManager;
 }
 
+LobbyDirectory &RequestHandlerFactory::getLobbyDirectory() {
+    return _lobbyDirectory;
+}
+
+SessionRegistry &RequestHandlerFactory::getSessionRegistry() {
+    return _sessionRegistry;
+}
+
 std::unique_ptr<IRequestHandler>
-RequestHandlerFactory::createRoomMemberRequestHandler(Room &room, const LoggedUser &user,
+RequestHandlerFactory::createRoomMemberRequestHandler(const std::shared_ptr<Room> &room, const LoggedUser &user,
                                                       const Endpoint &endpoint) {
+    _loginManager.getPresenceRegistry().setLocation(user.username, PresenceLocation::ROOM, room->getMetadata().uuid);
     return std::make_unique<RoomMemberRequestHandler>(room, user, *this, endpoint);
 }
 
 std::unique_ptr<IRequestHandler>
-RequestHandlerFactory::createRoomAdminRequestHandler(Room &room, const LoggedUser &user, const Endpoint &endpoint) {
+RequestHandlerFactory::createRoomAdminRequestHandler(const std::shared_ptr<Room> &room, const LoggedUser &user, const Endpoint &endpoint) {
+    _loginManager.getPresenceRegistry().setLocation(user.username, PresenceLocation::ROOM, room->getMetadata().uuid);
     return std::make_unique<RoomAdminRequestHandler>(*this, user, room, endpoint);
 }
 
 std::unique_ptr<IRequestHandler>
-RequestHandlerFactory::createGameRequestHandler(Game &game, const LoggedUser &user, const Endpoint &endpoint) {
-    return std::make_unique<GameRequestHandler>(game, *this, user, endpoint);
+RequestHandlerFactory::createGameRequestHandler(GameHandle gameHandle, const LoggedUser &user, const Endpoint &endpoint) {
+    const auto game = _gameManager.getGame(gameHandle);
+    _loginManager.getPresenceRegistry().setLocation(user.username, PresenceLocation::GAME,
+                                                   game.isError() ? "" : game.value()->getUuid());
+    return std::make_unique<GameRequestHandler>(gameHandle, *this, user, endpoint);
 }
 
 std::unique_ptr<IRequestHandler>
@@ -59,4 +74,21 @@ RequestHandlerFactory::createVerificationRequestHandler(const std::string &email
     return std::make_unique<VerificationRequestHandler>(*this, email, verificationCode, username, endpoint);
 }
 
-
+std::unique_ptr<IRequestHandler>
+RequestHandlerFactory::createHandlerForPresence(const LoggedUser &user, const Presence &presence) {
+    if (presence.location == PresenceLocation::ROOM) {
+        const auto room = _roomManager.getRoom(presence.locationId);
+        if (!room.isError()) {
+            // the admin is the room's first user, the others join after them
+            const auto users = room.value()->getAllUsers();
+            if (!users.empty() && users.front() == user)
+                return createRoomAdminRequestHandler(room.value(), user, presence.endpoint);
+            return createRoomMemberRequestHandler(room.value(), user, presence.endpoint);
+        }
+    } else if (presence.location == PresenceLocation::GAME) {
+        const auto gameHandle = _gameManager.getGameHandle(presence.locationId);
+        if (!gameHandle.isError())
+            return createGameRequestHandler(gameHandle.value(), user, presence.endpoint);
+    }
+    return createMenuRequestHandler(user, presence.endpoint);
+}
@@ -6,34 +6,46 @@
 #include "../managers/statisticsManager.h"
 #include "../managers/usersManager.h"
 #include "../managers/gameManager.h"
+#include "../managers/lobbyDirectory.h"
+#include "../managers/sessionRegistry.h"
 
 class RequestHandlerFactory {
 public:
-    explicit RequestHandlerFactory(const std::shared_ptr<IDatabase> &database) : _database(database),
+    explicit RequestHandlerFactory(const std::shared_ptr<IDatabase> &database) : _lobbyDirectory(database),
                                                                                  _loginManager(database),
+                                                                                 _roomManager(_lobbyDirectory),
                                                                                  _statisticsManager(database),
                                                                                  _usersManager(database),
-                                                                                 _gameManager(database) {}
+                                                                                 _gameManager(database, _lobbyDirectory),
+                                                                                 _database(database),
+                                                                                 _sessionRegistry(std::chrono::milliseconds(SESSION_RESUME_GRACE_PERIOD_MS)) {}
 
     ~RequestHandlerFactory() = default;
 
     std::unique_ptr<IRequestHandler> createLoginRequestHandler(const Endpoint& endpoint);
     std::unique_ptr<IRequestHandler> createMenuRequestHandler(const LoggedUser& user, const Endpoint& endpoint);
-    std::unique_ptr<IRequestHandler> createRoomMemberRequestHandler(Room& room, const LoggedUser& user, const Endpoint& endpoint);
-    std::unique_ptr<IRequestHandler> createRoomAdminRequestHandler(Room& room, const LoggedUser& user, const Endpoint& endpoint);
-    std::unique_ptr<IRequestHandler> createGameRequestHandler(Game& game, const LoggedUser& user, const Endpoint& endpoint);
+    std::unique_ptr<IRequestHandler> createRoomMemberRequestHandler(const std::shared_ptr<Room>& room, const LoggedUser& user, const Endpoint& endpoint);
+    std::unique_ptr<IRequestHandler> createRoomAdminRequestHandler(const std::shared_ptr<Room>& room, const LoggedUser& user, const Endpoint& endpoint);
+    std::unique_ptr<IRequestHandler> createGameRequestHandler(GameHandle gameHandle, const LoggedUser& user, const Endpoint& endpoint);
     std::unique_ptr<IRequestHandler> createVerificationRequestHandler(const std::string& email, const std::string& verificationCode, const std::string &username, const Endpoint& endpoint);
+    // the handler of a user handed over by the server this one took over from, by where they are. the menu when
+    // their room or game is gone
+    std::unique_ptr<IRequestHandler> createHandlerForPresence(const LoggedUser& user, const Presence& presence);
 
     LoginManager &getLoginManager();
     RoomManager &getRoomManager();
     StatisticsManager &getStatisticsManager();
     usersManager &getUsersManager();
     GameManager &getGameManager();
+    LobbyDirectory &getLobbyDirectory();
+    SessionRegistry &getSessionRegistry();
 private:
+    LobbyDirectory _lobbyDirectory;     // updated by the rooms and games, so it is built first
     LoginManager _loginManager;
     RoomManager _roomManager;
     StatisticsManager _statisticsManager;
     usersManager _usersManager;
     GameManager _gameManager;
     std::weak_ptr<IDatabase> _database;
+    SessionRegistry _sessionRegistry;   // its reaper runs the parked handlers' EXIT, so it is stopped first
 };
\ No newline at end of file
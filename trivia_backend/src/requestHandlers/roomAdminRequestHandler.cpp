@@ -1,5 +1,6 @@
 #include <iostream>
 #include "roomAdminRequestHandler.h"
+#include "../utils/marshaling/jsonDeserializer.h"
 
 bool RoomAdminRequestHandler::isRequestRelevant(const RequestInfo &request) {
     return request.requestId == RequestId::CLOSE_ROOM_REQUEST ||
@@ -8,6 +9,10 @@ bool RoomAdminRequestHandler::isRequestRelevant(const RequestInfo &request) {
            request.requestId == RequestId::EXIT;
 }
 
+ConnectionState RoomAdminRequestHandler::getConnectionState() const {
+    return ConnectionState::ROOM;
+}
+
 RequestResult RoomAdminRequestHandler::handleRequest(const RequestInfo &request) {
 
     if (!isRequestRelevant(request))
@@ -20,7 +25,7 @@ RequestResult RoomAdminRequestHandler::handleRequest(const RequestInfo &request)
         case RequestId::START_GAME_REQUEST:
             return startGame();
         case RequestId::GET_ROOM_STATE_REQUEST:
-            return getRoomState();
+            return getRoomState(request);
         case RequestId::EXIT:
             return closeRoomAndExit();
         default:
@@ -33,48 +38,58 @@ RequestResult RoomAdminRequestHandler::closeRoom() {
     auto &roomManager = _requestHandlerFactory.getRoomManager();
 
     log<RoomAdminRequestHandler>(__func__,
-                                 "Admin '" + _user.username + "' closed room '" + _room.getMetadata().name + "' with uuid '" + _room.getMetadata().uuid + "'", true,
+                                 "Admin '" + _user.username + "' closed room '" + _room->getMetadata().name + "' with uuid '" + _room->getMetadata().uuid + "'", true,
                                  _userEndpoint);
 
-    roomManager.deleteRoom(_room.getMetadata().uuid);
+    roomManager.deleteRoom(_room->getMetadata().uuid);
 
     return RequestResult{JsonSerializer::serializeResponse(CloseRoomResponse{true}),
                          _requestHandlerFactory.createMenuRequestHandler(_user, _userEndpoint)};
 }
 
 RequestResult RoomAdminRequestHandler::startGame() {
-    if (_room.getAllUsers().size() <= 1)
+    if (_room->getAllUsers().size() <= 1)
         return Error(ErrorType::NotEnoughPlayers).toRequestResult<RoomAdminRequestHandler>(__func__, _userEndpoint);
 
-    const auto res = _requestHandlerFactory.getGameManager().createGame(_room);
+    const auto res = _requestHandlerFactory.getGameManager().createGame(*_room);
     if (res.isError())
         return res.error().toRequestResult<RoomAdminRequestHandler>(__func__, _userEndpoint);
 
-    _room.setIsActive(true);    // set the room as active only after the game has been created
+    _room->setIsActive(true);    // set the room as active only after the game has been created
     log<RoomAdminRequestHandler>(__func__,
-                                 "Admin '" + _user.username + "' started game '" + _room.getMetadata().name + "' with uuid '" + _room.getMetadata().uuid + "'", true,
+                                 "Admin '" + _user.username + "' started game '" + _room->getMetadata().name + "' with uuid '" + _room->getMetadata().uuid + "'", true,
                                  _userEndpoint);
     return RequestResult{JsonSerializer::serializeResponse(StartGameResponse{true}), _requestHandlerFactory.createGameRequestHandler(res.value(), _user, _userEndpoint)};
 }
 
-RequestResult RoomAdminRequestHandler::getRoomState() {
-    // because the admin got the state of the room, the room mus be present, thus we can use roomState without checking it
-    const auto &roomState = _requestHandlerFactory.getRoomManager().getRoomState(_room.getMetadata().uuid);
+RequestResult RoomAdminRequestHandler::getRoomState(const RequestInfo &request) {
+    const auto getRoomStateRequestRes = JsonDeserializer::deserializeGetRoomStateRequest(request.buffer);
+    if (getRoomStateRequestRes.isError())
+        return getRoomStateRequestRes.error().toRequestResult<RoomAdminRequestHandler>(__func__, _userEndpoint);
+
+    // the admin's room stays in the manager until the admin closes it, so its own snapshot is current
+    const auto getRoomStateRequest = getRoomStateRequestRes.value();
+    auto roomState = _room->getState();
+    if (getRoomStateRequest.lastSeenVersion == roomState->version) {
+        roomState = _room->waitForChange(roomState->version, std::chrono::milliseconds(getRoomStateRequest.maxWaitMs));
+        if (getRoomStateRequest.lastSeenVersion == roomState->version)
+            return RequestResult{JsonSerializer::serializeResponse(RoomStateNotModifiedResponse{true, roomState->version}), nullptr};
+    }
 
-    const auto players = _requestHandlerFactory.getUsersManager().transformLoggedUsersToPlayers(_room.getAllUsers());
+    const auto players = _requestHandlerFactory.getUsersManager().transformLoggedUsersToPlayers(roomState->users);
     if (players.isError())
         return players.error().toRequestResult<RoomAdminRequestHandler>(__func__, _userEndpoint);
 
-    const auto response = GetRoomStateResponse{true, roomState.value().roomData.isActive, players.value(),
-                                               roomState.value().roomData.questionCount,
-                                               roomState.value().roomData.timePerQuestion,
-                                               roomState.value().roomData.maxPlayers,
-                                               false};
+    const auto response = GetRoomStateResponse{true, roomState->roomData.isActive, players.value(),
+                                               roomState->roomData.questionCount,
+                                               roomState->roomData.timePerQuestion,
+                                               roomState->roomData.maxPlayers,
+                                               false, roomState->version};
     return RequestResult{JsonSerializer::serializeResponse(response)};
 }
 
 RequestResult RoomAdminRequestHandler::closeRoomAndExit() {
-    log<RoomAdminRequestHandler>(__func__, "Admin '" + _user.username + "' has disconnected, closing room '" + _room.getMetadata().name + "' with uuid '" + _room.getMetadata().uuid + "', logging him out",
+    log<RoomAdminRequestHandler>(__func__, "Admin '" + _user.username + "' has disconnected, closing room '" + _room->getMetadata().name + "' with uuid '" + _room->getMetadata().uuid + "', logging him out",
                        false, _userEndpoint);
     _requestHandlerFactory.getLoginManager().logout(_user.username);
     return closeRoom();
@@ -6,9 +6,9 @@
 
 class RoomAdminRequestHandler : public IRequestHandler {
 public:
-    explicit RoomAdminRequestHandler(RequestHandlerFactory &requestHandlerFactory, LoggedUser user, Room &room,
+    explicit RoomAdminRequestHandler(RequestHandlerFactory &requestHandlerFactory, LoggedUser user, std::shared_ptr<Room> room,
                                      Endpoint userEndpoint)
-            : _requestHandlerFactory(requestHandlerFactory), _user(std::move(user)), _room(room),
+            : _requestHandlerFactory(requestHandlerFactory), _user(std::move(user)), _room(std::move(room)),
               _userEndpoint(std::move(userEndpoint)) {}
     ~RoomAdminRequestHandler() override = default;
 
@@ -16,14 +16,16 @@ public:
 
     RequestResult handleRequest(const RequestInfo &request) override;
 
+    [[nodiscard]] ConnectionState getConnectionState() const override;
+
 private:
 
     RequestResult closeRoom();
     RequestResult startGame();
-    RequestResult getRoomState();
+    RequestResult getRoomState(const RequestInfo &request);
     RequestResult closeRoomAndExit();
 
-    Room &_room;
+    std::shared_ptr<Room> _room;
     LoggedUser _user;
     Endpoint _userEndpoint;
     RequestHandlerFactory &_requestHandlerFactory;
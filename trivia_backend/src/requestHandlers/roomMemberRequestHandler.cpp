@@ -1,4 +1,5 @@
 #include "roomMemberRequestHandler.h"
+#include "../utils/marshaling/jsonDeserializer.h"
 
 bool RoomMemberRequestHandler::isRequestRelevant(const RequestInfo &request) {
     return request.requestId == RequestId::LEAVE_ROOM_REQUEST ||
@@ -6,6 +7,10 @@ bool RoomMemberRequestHandler::isRequestRelevant(const RequestInfo &request) {
            request.requestId == RequestId::EXIT;
 }
 
+ConnectionState RoomMemberRequestHandler::getConnectionState() const {
+    return ConnectionState::ROOM;
+}
+
 RequestResult RoomMemberRequestHandler::handleRequest(const RequestInfo &request) {
     if (!isRequestRelevant(request))
         return Error(ErrorType::InvalidRequest, "Request is not relevant").toRequestResult<RoomMemberRequestHandler>(__func__,
@@ -14,7 +19,7 @@ RequestResult RoomMemberRequestHandler::handleRequest(const RequestInfo &request
     if (request.requestId == RequestId::LEAVE_ROOM_REQUEST) {
         return leaveRoom();
     } else if (request.requestId == RequestId::GET_ROOM_STATE_REQUEST) {
-        return getRoomState();
+        return getRoomState(request);
     } else if (request.requestId == RequestId::EXIT) {
         return leaveRoomAndExit();
     }
@@ -24,7 +29,7 @@ RequestResult RoomMemberRequestHandler::handleRequest(const RequestInfo &request
 RequestResult RoomMemberRequestHandler::leaveRoom() {
     const auto &roomState = _requestHandlerFactory.getRoomManager().getRoomState(_roomUuid);
 
-    if (!roomState.has_value()) {
+    if (roomState == nullptr) {
         log<RoomMemberRequestHandler>(__func__, "Room '" + _roomName + "' was closed. Member '" + _user.username + "' is transferred back to menu", true,
                            _userEndpoint);
         return RequestResult{JsonSerializer::serializeResponse(LeaveRoomResponse{false}),
@@ -34,13 +39,13 @@ RequestResult RoomMemberRequestHandler::leaveRoom() {
     }
 
     // if the game has already started, remove the player from the room and game.
-    if (roomState.value().roomData.isActive) {
+    if (roomState->roomData.isActive) {
         _requestHandlerFactory.getGameManager().removePlayerFromGame(_roomUuid, _user);
         log<RoomMemberRequestHandler>(__func__, "Member '" + _user.username + "' left room '" + _roomName + "' after the game has started, punishing him.",
                            true,
                            _userEndpoint);
 
-        _room.removeUser(_user);
+        _room->removeUser(_user);
         return RequestResult{JsonSerializer::serializeResponse(LeaveRoomResponse{true}),
                              _requestHandlerFactory.createMenuRequestHandler(
                                      _user, _userEndpoint
@@ -49,10 +54,10 @@ RequestResult RoomMemberRequestHandler::leaveRoom() {
     }
 
     // at last remove the player from the room regularly
-    _room.removeUser(_user);
+    _room->removeUser(_user);
 
     log<RoomMemberRequestHandler>(__func__,
-                       "Member '" + _user.username + "' left room '" + _roomName + "' with uuid: '" + _room.getMetadata().uuid + "'", true,
+                       "Member '" + _user.username + "' left room '" + _roomName + "' with uuid: '" + _room->getMetadata().uuid + "'", true,
                        _userEndpoint);
     const auto response = LeaveRoomResponse{true};
     return RequestResult{JsonSerializer::serializeResponse(response), _requestHandlerFactory.createMenuRequestHandler(
@@ -60,37 +65,50 @@ RequestResult RoomMemberRequestHandler::leaveRoom() {
     )};
 }
 
-RequestResult RoomMemberRequestHandler::getRoomState() {
-    const auto &roomState = _requestHandlerFactory.getRoomManager().getRoomState(_roomUuid);
+RequestResult RoomMemberRequestHandler::getRoomState(const RequestInfo &request) {
+    const auto getRoomStateRequestRes = JsonDeserializer::deserializeGetRoomStateRequest(request.buffer);
+    if (getRoomStateRequestRes.isError())
+        return getRoomStateRequestRes.error().toRequestResult<RoomMemberRequestHandler>(__func__, _userEndpoint);
 
-    if (!roomState.has_value()) {
+    const auto getRoomStateRequest = getRoomStateRequestRes.value();
+    auto roomState = _requestHandlerFactory.getRoomManager().getRoomState(_roomUuid);
+    if (roomState != nullptr && getRoomStateRequest.lastSeenVersion == roomState->version)
+        roomState = _room->waitForChange(roomState->version, std::chrono::milliseconds(getRoomStateRequest.maxWaitMs));
+
+    if (roomState == nullptr || roomState->isClosed) {
         log<RoomMemberRequestHandler>(__func__, "Room '" + _roomName + "' was closed. Member '" + _user.username + "' is transferred back to menu", true,
                            _userEndpoint);
         return RequestResult{JsonSerializer::serializeResponse(
-                GetRoomStateResponse{true, false, std::vector<Player>(), 0, 0, 0, true}),
+                GetRoomStateResponse{true, false, std::vector<Player>(), 0, 0, 0, true, 0}),
                              _requestHandlerFactory.createMenuRequestHandler(
                                      _user, _userEndpoint
                              )};
     }
 
+    if (getRoomStateRequest.lastSeenVersion == roomState->version)
+        return RequestResult{JsonSerializer::serializeResponse(RoomStateNotModifiedResponse{true, roomState->version}), nullptr};
+
     const auto players = _requestHandlerFactory.getUsersManager().transformLoggedUsersToPlayers(
-            roomState.value().users);
+            roomState->users);
     if (players.isError())
         return players.error().toRequestResult<RoomMemberRequestHandler>(__func__, _userEndpoint);
-    const auto response = GetRoomStateResponse{true, roomState.value().roomData.isActive, players.value(),
-                                               roomState.value().roomData.questionCount,
-                                               roomState.value().roomData.timePerQuestion,
-                                               roomState.value().roomData.maxPlayers,
-                                               false};
+    const auto response = GetRoomStateResponse{true, roomState->roomData.isActive, players.value(),
+                                               roomState->roomData.questionCount,
+                                               roomState->roomData.timePerQuestion,
+                                               roomState->roomData.maxPlayers,
+                                               false, roomState->version};
     if (response.hasGameBegun) {
         log<RoomMemberRequestHandler>(__func__, "Game '" + _roomName + "' has already started. Member '" + _user.username + "' is transferred to game", true,
                            _userEndpoint);
 
         // retrieve the game for this room (game id and room id are identical)
-        auto &game = _requestHandlerFactory.getGameManager().getGameById(_roomUuid);
+        const auto gameHandle = _requestHandlerFactory.getGameManager().getGameHandle(_roomUuid);
+        if (gameHandle.isError())
+            return gameHandle.error().toRequestResult<RoomMemberRequestHandler>(__func__, _userEndpoint);
+
         return RequestResult{JsonSerializer::serializeResponse(response),
                              _requestHandlerFactory.createGameRequestHandler(
-                                     game, _user, _userEndpoint
+                                     gameHandle.value(), _user, _userEndpoint
                              )};
     }
 
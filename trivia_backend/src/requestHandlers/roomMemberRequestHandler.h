@@ -8,10 +8,10 @@
 
 class RoomMemberRequestHandler : public IRequestHandler {
 public:
-    RoomMemberRequestHandler(Room &room, LoggedUser user, RequestHandlerFactory &requestHandlerFactory,
-                             Endpoint userEndpoint) : _room(room),
-                                                      _roomUuid(room.getMetadata().uuid),
-                                                      _roomName(room.getMetadata().name),
+    RoomMemberRequestHandler(std::shared_ptr<Room> room, LoggedUser user, RequestHandlerFactory &requestHandlerFactory,
+                             Endpoint userEndpoint) : _room(std::move(room)),
+                                                      _roomUuid(_room->getMetadata().uuid),
+                                                      _roomName(_room->getMetadata().name),
                                                       _user(std::move(user)),
                                                       _requestHandlerFactory(
                                                               requestHandlerFactory),
@@ -22,14 +22,16 @@ public:
 
     RequestResult handleRequest(const RequestInfo &request) override;
 
+    [[nodiscard]] ConnectionState getConnectionState() const override;
+
     bool isRequestRelevant(const RequestInfo &request) override;
 
 private:
     RequestResult leaveRoom();
-    RequestResult getRoomState();
+    RequestResult getRoomState(const RequestInfo &request);
     RequestResult leaveRoomAndExit();
 
-    Room &_room;
+    std::shared_ptr<Room> _room;   // kept alive after the admin closes the room
     std::string _roomUuid;
     std::string _roomName;
     LoggedUser _user;
@@ -8,6 +8,10 @@ bool VerificationRequestHandler::isRequestRelevant(const RequestInfo &request) {
            RequestId::RESEND_VERIFICATION_CODE_REQUEST == request.requestId;
 }
 
+ConnectionState VerificationRequestHandler::getConnectionState() const {
+    return ConnectionState::LOGIN;
+}
+
 RequestResult VerificationRequestHandler::handleRequest(const RequestInfo &requestInfo) {
     if (!isRequestRelevant(requestInfo))
         return Error(ErrorType::InvalidRequest, "User not authorized").toRequestResult<VerificationRequestHandler>(
@@ -34,9 +38,12 @@ RequestResult VerificationRequestHandler::submitVerificationCode(const RequestIn
     if (requestJson.value().code == _currentVerificationCode) {
         log<VerificationRequestHandler>(__func__, "User submitted correct verification code, logging him in", true,
                                         _userEndpoint);
-        return RequestResult{JsonSerializer::serializeResponse(SubmitVerificationCodeResponse{true, true}),
-                             _requestHandlerFactory.createMenuRequestHandler(
-                                     {_username}, _userEndpoint)};
+        const auto sessionToken = _requestHandlerFactory.getSessionRegistry().open(_username);
+        RequestResult requestResult{
+                JsonSerializer::serializeResponse(SubmitVerificationCodeResponse{true, true, sessionToken}),
+                _requestHandlerFactory.createMenuRequestHandler({_username}, _userEndpoint)};
+        requestResult.sessionToken = sessionToken;
+        return requestResult;
     }
 
     if (_tries >= 5)
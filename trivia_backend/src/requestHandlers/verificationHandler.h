@@ -21,6 +21,8 @@ public:
 
     RequestResult handleRequest(const RequestInfo &request) override;
 
+    [[nodiscard]] ConnectionState getConnectionState() const override;
+
 private:
 
     RequestResult submitVerificationCode(const RequestInfo &request);
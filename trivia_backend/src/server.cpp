@@ -1,15 +1,47 @@
 #include "server.h"
 #include <iostream>
+#include <sstream>
 #include <thread>
+#include "utils/tracer/tracer.h"
+#include "utils/lockProfiler/lockProfiler.h"
+#include "utils/trafficCapture/trafficCapture.h"
+#include "utils/passwordHasher/passwordHasher.h"
+#include "utils/admissionControl/admissionController.h"
+#include "utils/requestScheduler/requestScheduler.h"
+#include "utils/rateLimiter/rateLimiter.h"
+#include "utils/connectionMonitor/connectionMonitor.h"
+#include "utils/socketHandoff/socketHandoff.h"
+#include "utils/gameJournal/gameJournal.h"
+#include "constants.h"
 
-void Server::run()
+bool Server::run()
 {
     logServerProgress<Server>( __func__, "Starting server on (" + _server_endpoint.toString() + ")...");
     logServerResult(true);
 
+    logServerProgress<Server>(__func__, "Submitting the statistics of the games the last run left unfinished...");
+    const auto journaledGamesCount = _requestHandlerFactory.getGameManager().finalizeJournaledGames();
+    logServerResult(true);
+    if (journaledGamesCount > 0)
+        log<Server>(__func__, "Recovered " + std::to_string(journaledGamesCount) + " games from the journal", true,
+                    _server_endpoint);
+
+    if (_handoffSnapshot.has_value()) {
+        // the sessions wait for their connections at least as long as the old server may take to send them
+        logServerProgress<Server>(__func__, "Restoring the state of the server taken over...");
+        _handoffSnapshot->restore(_requestHandlerFactory,
+                                  std::chrono::duration_cast<std::chrono::milliseconds>(_shutdownDeadline) +
+                                  std::chrono::milliseconds(SESSION_RESUME_GRACE_PERIOD_MS));
+        logServerResult(true);
+        log<Server>(__func__, "Restored " + std::to_string(_handoffSnapshot->sessions.size()) + " sessions, " +
+                              std::to_string(_handoffSnapshot->rooms.size()) + " rooms and " +
+                              std::to_string(_handoffSnapshot->games.size()) + " games", true, _server_endpoint);
+        _handoffSnapshot.reset();
+        _handoffThread = std::thread(&Server::receiveConnections, this);
+    }
+
     logServerProgress<Server>( __func__, "Starting Communicator thread...");
-    std::thread t_communicator(&Communicator::startHandleRequests, &_communicator);
-    t_communicator.detach();
+    _communicatorThread = std::thread(&Communicator::startHandleRequests, &_communicator);
     logServerResult(true);
 
     std::string input;
@@ -17,8 +49,491 @@ void Server::run()
         std::getline(std::cin, input);
         if (input == "clear" || input == "CLEAR")
             std::cout << "\033[2J\033[1;1H";
+        else if (input.rfind("trace", 0) == 0)
+            handleTraceCommand(input);
+        else if (input.rfind("locks", 0) == 0)
+            handleLocksCommand(input);
+        else if (input.rfind("capture", 0) == 0)
+            handleCaptureCommand(input);
+        else if (input == "online")
+            printOnlineUsers();
+        else if (input.rfind("hasher", 0) == 0)
+            handleHasherCommand(input);
+        else if (input == "admission")
+            printAdmission();
+        else if (input.rfind("scheduler", 0) == 0)
+            handleSchedulerCommand(input);
+        else if (input.rfind("ratelimit", 0) == 0)
+            handleRateLimitCommand(input);
+        else if (input.rfind("connections", 0) == 0)
+            handleConnectionsCommand(input);
+        else if (input.rfind("journal", 0) == 0)
+            handleJournalCommand(input);
+        else if (input.rfind("handoff", 0) == 0 && handleHandoffCommand(input))
+            input = "exit";     // the new server accepts the clients now, this one drains its own
 
     } while (input != "EXIT" && input != "exit");
 
+    if (TrafficRecorder::isRecording())
+        handleCaptureCommand("capture stop");
+
     log<Server>(__func__, "Shutting down server...", true, _server_endpoint);
+    return shutdown();
+}
+
+bool Server::shutdown()
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto deadline = startTime + _shutdownDeadline;
+    // the end of the deadline is kept for closing the connections left once the games are over or saved
+    const auto gamesDeadline = deadline - std::chrono::seconds(SHUTDOWN_CLOSING_SECONDS);
+    auto &gameManager = _requestHandlerFactory.getGameManager();
+
+    // already stopped when the listening socket was handed over
+    if (_communicatorThread.joinable()) {
+        logServerProgress<Server>(__func__, "Stopping accepting clients...");
+        _communicator.stopAccepting();
+        _communicatorThread.join();
+        logServerResult(true);
+    }
+
+    // the connections handed over are no longer taken
+    if (_handoffThread.joinable()) {
+        _handoff.interrupt();
+        _handoffThread.join();
+        _handoff.close();
+    }
+
+    if (_isHandedOver)
+        return finishHandoff(startTime, deadline);
+
+    logServerProgress<Server>(__func__, "Closing the connections out of games...");
+    _communicator.closeConnections(false);
+    logServerResult(true);
+
+    // the connections in rooms may be in a long poll, they are closed once it is answered
+    logServerProgress<Server>(__func__, "Waiting for " + std::to_string(gameManager.getRunningGamesCount()) +
+                                        " running games to finish...");
+    while ((gameManager.getRunningGamesCount() != 0 || ConnectionMonitor::getWatchedCount(false) != 0) &&
+           std::chrono::steady_clock::now() < gamesDeadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(SHUTDOWN_POLL_INTERVAL_MS));
+    logServerResult(gameManager.getRunningGamesCount() == 0, false, false);
+
+    logServerProgress<Server>(__func__, "Saving the statistics of the unfinished games...");
+    const auto checkpointedGames = gameManager.checkpointRunningGames();
+    logServerResult(true);
+    if (checkpointedGames != 0)
+        log<Server>(__func__, "Saved " + std::to_string(checkpointedGames) + " unfinished games", true,
+                    _server_endpoint);
+
+    logServerProgress<Server>(__func__, "Logging out the disconnected users...");
+    _requestHandlerFactory.getSessionRegistry().closeAll();
+    logServerResult(true);
+
+    logServerProgress<Server>(__func__, "Closing the remaining " + std::to_string(_communicator.getConnectionsCount()) +
+                                        " connections...");
+    _communicator.closeConnections(true);
+    while (_communicator.getConnectionsCount() != 0 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(SHUTDOWN_POLL_INTERVAL_MS));
+    const bool isDrained = _communicator.getConnectionsCount() == 0;
+    logServerResult(isDrained, false, false);
+
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime).count();
+    log<Server>(__func__, isDrained ? "Shut down in " + std::to_string(elapsedMs) + "ms"
+                                    : std::to_string(_communicator.getConnectionsCount()) +
+                                      " connections still open at the deadline", isDrained, _server_endpoint);
+    return isDrained;
+}
+
+bool Server::finishHandoff(std::chrono::steady_clock::time_point startTime,
+                           std::chrono::steady_clock::time_point deadline)
+{
+    // the games, the rooms and the sessions are the new server's, a connection is sent once its request is answered
+    logServerProgress<Server>(__func__, "Waiting for the " + std::to_string(_communicator.getConnectionsCount()) +
+                                        " connections still in a request...");
+    while (_communicator.getConnectionsCount() != 0 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(SHUTDOWN_POLL_INTERVAL_MS));
+    const bool isDrained = _communicator.getConnectionsCount() == 0;
+    _communicator.finishHandoff();
+    _handoff.close();
+    logServerResult(isDrained, false, false);
+
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime).count();
+    log<Server>(__func__, isDrained ? "Handed over in " + std::to_string(elapsedMs) + "ms"
+                                    : std::to_string(_communicator.getConnectionsCount()) +
+                                      " connections still in a request at the deadline", isDrained, _server_endpoint);
+    return isDrained;
+}
+
+bool Server::takeOver(const std::string &handoffPath)
+{
+    logServerProgress<Server>(__func__, "Waiting for the running server on '" + handoffPath +
+                                        "' (run 'handoff' on its console)...");
+    auto takeOverRes = _handoff.accept(handoffPath);
+    std::optional<kissnet::SOCKET> listeningSocket;
+    if (!takeOverRes.has_value()) {
+        const auto snapshotMessageRes = _handoff.receive(listeningSocket);
+        if (snapshotMessageRes.isError()) {
+            takeOverRes = snapshotMessageRes.error();
+        } else if (!listeningSocket.has_value()) {
+            takeOverRes = Error(ErrorType::InvalidRequest, "The snapshot came without the listening socket");
+        } else {
+            const auto snapshotRes = HandoffSnapshot::deserialize(snapshotMessageRes.value());
+            if (snapshotRes.isError()) {
+                takeOverRes = snapshotRes.error();
+            } else {
+                _handoffSnapshot = snapshotRes.value();
+                // from the acknowledgement on, the running server sends its connections instead of serving them
+                takeOverRes = _handoff.send({1});
+            }
+        }
+    }
+
+    logServerResult(!takeOverRes.has_value(), false, false);
+    if (takeOverRes.has_value()) {
+        logError<Server>(__func__, takeOverRes.value().message, _server_endpoint);
+        if (listeningSocket.has_value())
+            kissnet::tcp_socket(listeningSocket.value(), _server_endpoint).close();
+        _handoffSnapshot.reset();
+        _handoff.close();
+        return false;
+    }
+
+    _communicator.takeOverListeningSocket(listeningSocket.value());
+    return true;
+}
+
+void Server::receiveConnections()
+{
+    auto &sessionRegistry = _requestHandlerFactory.getSessionRegistry();
+    std::size_t connectionsCount = 0;
+    while (true) {
+        std::optional<kissnet::SOCKET> socket;
+        const auto messageRes = _handoff.receive(socket);
+        if (messageRes.isError()) {
+            log<Server>(__func__, "The handoff was cut: " + messageRes.error().message, false, _server_endpoint);
+            break;
+        }
+        // the old server has sent every connection
+        if (messageRes.value().empty())
+            break;
+
+        const auto connectionRes = HandedOverConnection::deserialize(messageRes.value());
+        if (connectionRes.isError() || !socket.has_value()) {
+            logError<Server>(__func__, connectionRes.isError() ? connectionRes.error().message
+                                                               : "A connection came without its socket",
+                             _server_endpoint);
+            if (socket.has_value())
+                kissnet::tcp_socket(socket.value(), _server_endpoint).close();
+            continue;
+        }
+
+        // the handler its session was parked with, a connection out of a session starts over at the login
+        auto connection = connectionRes.value();
+        std::unique_ptr<IRequestHandler> handler;
+        if (!connection.sessionToken.empty()) {
+            std::string username;
+            handler = sessionRegistry.resume(connection.sessionToken, username);
+        }
+        if (handler == nullptr) {
+            connection.sessionToken.clear();
+            handler = _requestHandlerFactory.createLoginRequestHandler(connection.endpoint);
+        }
+
+        _communicator.adoptConnection(kissnet::tcp_socket(socket.value(), connection.endpoint), connection.endpoint,
+                                      std::move(handler), connection.sessionToken, connection.encoding);
+        connectionsCount++;
+    }
+
+    log<Server>(__func__, "Took over " + std::to_string(connectionsCount) + " connections", true, _server_endpoint);
+}
+
+// handoff [path]
+bool Server::handleHandoffCommand(const std::string &command)
+{
+    std::istringstream commandStream(command);
+    std::string commandName, handoffPath;
+    commandStream >> commandName >> handoffPath;
+    if (handoffPath.empty())
+        handoffPath = HANDOFF_SOCKET_PATH;
+
+    logServerProgress<Server>(__func__, "Connecting to the server waiting on '" + handoffPath + "'...");
+    const auto connectRes = _handoff.connect(handoffPath);
+    logServerResult(!connectRes.has_value(), false, false);
+    if (connectRes.has_value()) {
+        logError<Server>(__func__, connectRes.value().message, _server_endpoint);
+        return false;
+    }
+
+    logServerProgress<Server>(__func__, "Stopping accepting clients...");
+    _communicator.stopAccepting();
+    _communicatorThread.join();
+    logServerResult(true);
+
+    // the new server starts a journal of its own at the usual path, this one keeps writing its games aside
+    auto handoffRes = GameJournal::setDraining(true);
+    if (!handoffRes.has_value()) {
+        handoffRes = handOver();
+        if (handoffRes.has_value())
+            GameJournal::setDraining(false);
+    }
+    if (!handoffRes.has_value()) {
+        _isHandedOver = true;
+        return true;
+    }
+
+    // the new server didn't take over, keep serving
+    logError<Server>(__func__, handoffRes.value().message, _server_endpoint);
+    _handoff.close();
+    _communicatorThread = std::thread(&Communicator::startHandleRequests, &_communicator);
+    return false;
+}
+
+std::optional<Error> Server::handOver()
+{
+    // the long polls are answered right away, so the connections in rooms reach their next request too
+    logServerProgress<Server>(__func__, "Setting the connections aside between their requests...");
+    const auto collectDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(HANDOFF_COLLECT_MS);
+    _communicator.beginHandoff();
+    _requestHandlerFactory.getRoomManager().interruptWaits();
+    const auto busyConnectionsCount = _communicator.collectConnections(collectDeadline);
+    logServerResult(busyConnectionsCount == 0, false, false);
+    if (busyConnectionsCount != 0)
+        log<Server>(__func__, std::to_string(busyConnectionsCount) + " connections are still in a request, they are "
+                              "sent once it is answered", false, _server_endpoint);
+
+    logServerProgress<Server>(__func__, "Sending the listening socket and the state of the server...");
+    const auto snapshot = HandoffSnapshot::capture(_requestHandlerFactory);
+    auto handoffRes = _handoff.send(snapshot.serialize(), _communicator.getListeningSocket());
+    if (!handoffRes.has_value()) {
+        // until the new server holds the state, this one can still go on serving
+        std::optional<kissnet::SOCKET> socket;
+        const auto acknowledgementRes = _handoff.receive(socket);
+        if (acknowledgementRes.isError())
+            handoffRes = acknowledgementRes.error();
+    }
+    logServerResult(!handoffRes.has_value(), false, false);
+    if (handoffRes.has_value()) {
+        _communicator.cancelHandoff();
+        return handoffRes;
+    }
+
+    logServerProgress<Server>(__func__, "Handing the connections over...");
+    _requestHandlerFactory.getSessionRegistry().handOver();
+    // the new server journals them from now on, they aren't left unfinished in this one's journal
+    for (const auto &game: snapshot.games)
+        GameJournal::recordGameFinalized(game->getUuid());
+    _communicator.commitHandoff(_handoff);
+    logServerResult(true);
+    return std::nullopt;
+}
+
+// journal | journal reset
+void Server::handleJournalCommand(const std::string &command)
+{
+    std::istringstream commandStream(command);
+    std::string commandName, action;
+    commandStream >> commandName >> action;
+
+    if (action.empty()) {
+        const auto report = GameJournal::report();
+        std::lock_guard lock(logMutex);
+        std::cout << report << std::flush;
+    } else if (action == "reset") {
+        logServerProgress<Server>(__func__, "Resetting game journal statistics...");
+        GameJournal::resetStats();
+        logServerResult(true);
+    } else {
+        logServerProgress<Server>(__func__, "Unknown journal command, use: journal | journal reset");
+        logServerResult(false, false, false);
+    }
+}
+
+// trace start | trace stop | trace dump [file]
+void Server::handleTraceCommand(const std::string &command)
+{
+    std::istringstream commandStream(command);
+    std::string action, filePath;
+    commandStream >> action >> action >> filePath;
+
+    if (action == "start") {
+        logServerProgress<Server>(__func__, "Starting request tracing...");
+        Tracer::setEnabled(true);
+        logServerResult(true);
+    } else if (action == "stop") {
+        logServerProgress<Server>(__func__, "Stopping request tracing...");
+        Tracer::setEnabled(false);
+        logServerResult(true);
+    } else if (action == "dump") {
+        if (filePath.empty())
+            filePath = TRACE_FILE_PATH;
+
+        logServerProgress<Server>(__func__, "Dumping trace spans to '" + filePath + "'...");
+        const auto dumpRes = Tracer::dumpChromeTrace(filePath);
+        logServerResult(!dumpRes.isError(), false, false);
+    } else {
+        logServerProgress<Server>(__func__, "Unknown trace command, use: trace start | trace stop | trace dump [file]");
+        logServerResult(false, false, false);
+    }
+}
+
+// locks | locks on | locks off | locks reset
+void Server::handleLocksCommand(const std::string &command)
+{
+    std::istringstream commandStream(command);
+    std::string commandName, action;
+    commandStream >> commandName >> action;
+
+    if (action.empty()) {
+        const auto report = LockProfiler::report();
+        std::lock_guard lock(logMutex);
+        std::cout << report << std::flush;
+    } else if (action == "on") {
+        logServerProgress<Server>(__func__, "Starting lock profiling...");
+        LockProfiler::setEnabled(true);
+        logServerResult(true);
+    } else if (action == "off") {
+        logServerProgress<Server>(__func__, "Stopping lock profiling...");
+        LockProfiler::setEnabled(false);
+        logServerResult(true);
+    } else if (action == "reset") {
+        logServerProgress<Server>(__func__, "Resetting lock statistics...");
+        LockProfiler::reset();
+        logServerResult(true);
+    } else {
+        logServerProgress<Server>(__func__, "Unknown locks command, use: locks | locks on | locks off | locks reset");
+        logServerResult(false, false, false);
+    }
+}
+
+// hasher | hasher reset
+void Server::handleHasherCommand(const std::string &command)
+{
+    std::istringstream commandStream(command);
+    std::string commandName, action;
+    commandStream >> commandName >> action;
+
+    if (action.empty()) {
+        const auto report = PasswordHasher::report();
+        std::lock_guard lock(logMutex);
+        std::cout << report << std::flush;
+    } else if (action == "reset") {
+        logServerProgress<Server>(__func__, "Resetting password hashing statistics...");
+        PasswordHasher::resetStats();
+        logServerResult(true);
+    } else {
+        logServerProgress<Server>(__func__, "Unknown hasher command, use: hasher | hasher reset");
+        logServerResult(false, false, false);
+    }
+}
+
+// scheduler | scheduler reset
+void Server::handleSchedulerCommand(const std::string &command)
+{
+    std::istringstream commandStream(command);
+    std::string commandName, action;
+    commandStream >> commandName >> action;
+
+    if (action.empty()) {
+        const auto report = RequestScheduler::report();
+        std::lock_guard lock(logMutex);
+        std::cout << report << std::flush;
+    } else if (action == "reset") {
+        logServerProgress<Server>(__func__, "Resetting request scheduling statistics...");
+        RequestScheduler::resetStats();
+        logServerResult(true);
+    } else {
+        logServerProgress<Server>(__func__, "Unknown scheduler command, use: scheduler | scheduler reset");
+        logServerResult(false, false, false);
+    }
+}
+
+// ratelimit | ratelimit reset
+void Server::handleRateLimitCommand(const std::string &command)
+{
+    std::istringstream commandStream(command);
+    std::string commandName, action;
+    commandStream >> commandName >> action;
+
+    if (action.empty()) {
+        const auto report = RateLimiter::report();
+        std::lock_guard lock(logMutex);
+        std::cout << report << std::flush;
+    } else if (action == "reset") {
+        logServerProgress<Server>(__func__, "Resetting rate limiting statistics...");
+        RateLimiter::resetStats();
+        logServerResult(true);
+    } else {
+        logServerProgress<Server>(__func__, "Unknown ratelimit command, use: ratelimit | ratelimit reset");
+        logServerResult(false, false, false);
+    }
+}
+
+// connections | connections reset
+void Server::handleConnectionsCommand(const std::string &command)
+{
+    std::istringstream commandStream(command);
+    std::string commandName, action;
+    commandStream >> commandName >> action;
+
+    if (action.empty()) {
+        const auto report = ConnectionMonitor::report();
+        std::lock_guard lock(logMutex);
+        std::cout << report << std::flush;
+    } else if (action == "reset") {
+        logServerProgress<Server>(__func__, "Resetting idle connections and round trip statistics...");
+        ConnectionMonitor::resetStats();
+        logServerResult(true);
+    } else {
+        logServerProgress<Server>(__func__, "Unknown connections command, use: connections | connections reset");
+        logServerResult(false, false, false);
+    }
+}
+
+// capture start [file] | capture stop
+void Server::handleCaptureCommand(const std::string &command)
+{
+    std::istringstream commandStream(command);
+    std::string commandName, action, filePath;
+    commandStream >> commandName >> action >> filePath;
+
+    if (action == "start") {
+        if (filePath.empty())
+            filePath = CAPTURE_FILE_PATH;
+
+        logServerProgress<Server>(__func__, "Capturing client traffic to '" + filePath + "'...");
+        const auto startRes = TrafficRecorder::start(filePath);
+        logServerResult(!startRes.has_value(), false, false);
+    } else if (action == "stop") {
+        logServerProgress<Server>(__func__, "Stopping traffic capture...");
+        const auto stopRes = TrafficRecorder::stop();
+        logServerResult(!stopRes.isError(), false, false);
+        if (!stopRes.isError())
+            log<Server>(__func__, "Captured " + std::to_string(stopRes.value()) + " requests", true, _server_endpoint);
+    } else {
+        logServerProgress<Server>(__func__, "Unknown capture command, use: capture start [file] | capture stop");
+        logServerResult(false, false, false);
+    }
+}
+
+// online
+void Server::printOnlineUsers()
+{
+    const auto &presenceRegistry = _requestHandlerFactory.getLoginManager().getPresenceRegistry();
+    std::lock_guard lock(logMutex);
+    std::cout << presenceRegistry.getOnlineCount() << " users online ("
+              << presenceRegistry.getOnlineCount(PresenceLocation::MENU) << " in the menu, "
+              << presenceRegistry.getOnlineCount(PresenceLocation::ROOM) << " in rooms, "
+              << presenceRegistry.getOnlineCount(PresenceLocation::GAME) << " in games), "
+              << _requestHandlerFactory.getSessionRegistry().getParkedCount() << " of them disconnected" << std::endl;
+}
+
+// admission
+void Server::printAdmission()
+{
+    const auto report = AdmissionController::report();
+    std::lock_guard lock(logMutex);
+    std::cout << report << std::flush;
 }
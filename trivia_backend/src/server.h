@@ -1,7 +1,12 @@
 #pragma once
 
+#include <chrono>
+#include <optional>
 #include <string>
+#include <thread>
 #include "utils/communicator/communicator.h"
+#include "utils/socketHandoff/socketHandoff.h"
+#include "utils/socketHandoff/handoffSnapshot.h"
 #include "utils/databaseAccess/IDatabasae.h"
 #include "utils/databaseAccess/sqliteDatabase.h"
 #include "requestHandlers/requestHandlerFactory.h"
@@ -9,20 +14,61 @@
 
 class Server {
 public:
-    explicit Server(const Endpoint &endpoint) : _server_endpoint(endpoint),
-                                                _database(std::make_shared<SqliteDatabase>()),
-                                                _requestHandlerFactory(_database),
-                                                _communicator(endpoint, _requestHandlerFactory) {}
+    explicit Server(const Endpoint &endpoint, std::chrono::seconds shutdownDeadline, const std::string &databasePath)
+            : _server_endpoint(endpoint), _shutdownDeadline(shutdownDeadline),
+              _database(std::make_shared<SqliteDatabase>(databasePath)),
+              _requestHandlerFactory(_database),
+              _communicator(endpoint, _requestHandlerFactory) {}
 
     ~Server() = default;
 
-    void run();
+    // until "exit", then shuts down. false when connections were still open at the shutdown deadline, their threads
+    // use the server so it must not be destroyed
+    bool run();
+
+    // before run: takes a running server over once it runs the "handoff" console command. accepts on its listening
+    // socket instead of binding, restores its sessions, rooms and games (in run) and serves its connections as they
+    // are handed over. false when the handoff failed, the running server then keeps serving
+    bool takeOver(const std::string &handoffPath);
 
 private:
+    // stops accepting clients, closes the connections out of games, waits for the games to finish (or saves their
+    // statistics as they are) and closes the rest, within _shutdownDeadline
+    bool shutdown();
+    // once handed over: waits for the connections still in a request to follow the others, within the deadline
+    bool finishHandoff(std::chrono::steady_clock::time_point startTime, std::chrono::steady_clock::time_point deadline);
+
+    void handleTraceCommand(const std::string &command);
+    void handleLocksCommand(const std::string &command);
+    void handleCaptureCommand(const std::string &command);
+    void printOnlineUsers();
+    void handleHasherCommand(const std::string &command);
+    void printAdmission();
+    void handleSchedulerCommand(const std::string &command);
+    void handleRateLimitCommand(const std::string &command);
+    void handleConnectionsCommand(const std::string &command);
+    void handleJournalCommand(const std::string &command);
+    // true when a new server took the listening socket, the state and the connections, this one then shuts down
+    bool handleHandoffCommand(const std::string &command);
+    // sets the connections aside, sends the listening socket with the snapshot and, once the new server acknowledges
+    // it, the connections. an error (the connections are served again) when the new server didn't take over
+    std::optional<Error> handOver();
+    // the new server's side: adopts the connections until the old server ends the handoff
+    void receiveConnections();
+
     Endpoint _server_endpoint;
-    Communicator _communicator;
+    std::chrono::seconds _shutdownDeadline;
+    // in the order they are constructed, the communicator uses the factory which uses the database
     std::shared_ptr<IDatabase> _database;
     RequestHandlerFactory _requestHandlerFactory;
+    // to the server taking over from this one, or from the one this server took over. before the communicator, whose
+    // connection threads may still send over it
+    SocketHandoff _handoff;
+    Communicator _communicator;
+    std::thread _communicatorThread;
+    std::optional<HandoffSnapshot> _handoffSnapshot;    // taken over, restored by run
+    std::thread _handoffThread;     // runs receiveConnections
+    bool _isHandedOver = false;
 };
 
 
@@ -0,0 +1,101 @@
+#include "admissionController.h"
+#include <algorithm>
+#include <mutex>
+#include <fmt/format.h>
+
+void AdmissionController::configure(const AdmissionLimits &limits) {
+    std::lock_guard lock(_connectionsMutex);
+    _limits = limits;
+}
+
+std::optional<Error> AdmissionController::admitConnection(const std::string &address) {
+    std::lock_guard lock(_connectionsMutex);
+    if (_connections >= _limits.maxConnections) {
+        _refusedConnections.fetch_add(1, std::memory_order_relaxed);
+        return Error(ErrorType::ServerBusy);
+    }
+
+    auto &addressConnections = _connectionsPerIp[address];
+    if (addressConnections >= _limits.maxConnectionsPerIp) {
+        _refusedPerIpConnections.fetch_add(1, std::memory_order_relaxed);
+        return Error(ErrorType::ServerBusy, "Too many connections from this address");
+    }
+
+    addressConnections++;
+    _connections++;
+    return std::nullopt;
+}
+
+void AdmissionController::adoptConnection(const std::string &address) {
+    std::lock_guard lock(_connectionsMutex);
+    _connectionsPerIp[address]++;
+    _connections++;
+}
+
+void AdmissionController::releaseConnection(const std::string &address) {
+    std::lock_guard lock(_connectionsMutex);
+    const auto addressConnections = _connectionsPerIp.find(address);
+    if (addressConnections == _connectionsPerIp.end())
+        return;
+
+    if (--addressConnections->second == 0)
+        _connectionsPerIp.erase(addressConnections);
+    _connections--;
+}
+
+std::optional<Error> AdmissionController::checkFrame(RequestId requestId, std::uint32_t length) {
+    if (length <= getMaxFrameSize(requestId))
+        return std::nullopt;
+
+    _rejectedFrames.fetch_add(1, std::memory_order_relaxed);
+    return Error(ErrorType::InvalidRequest, "Request too large (" + std::to_string(length) + " bytes, at most " +
+                                            std::to_string(getMaxFrameSize(requestId)) + ")");
+}
+
+std::uint32_t AdmissionController::getMaxFrameSize(RequestId requestId) {
+    std::uint32_t maxFrameSize;
+    switch (requestId) {
+        // no fields, the body is empty or {}
+        case RequestId::LOGOUT_REQUEST:
+        case RequestId::GET_HIGHSCORES_REQUEST:
+        case RequestId::GET_PERSONAL_STATS_REQUEST:
+        case RequestId::GET_USER_DATA_REQUEST:
+        case RequestId::CLOSE_ROOM_REQUEST:
+        case RequestId::START_GAME_REQUEST:
+        case RequestId::LEAVE_ROOM_REQUEST:
+        case RequestId::LEAVE_GAME_REQUEST:
+        case RequestId::GET_QUESTION_REQUEST:
+        case RequestId::GET_GAME_RESULTS_REQUEST:
+        case RequestId::RESEND_VERIFICATION_CODE_REQUEST:
+        case RequestId::EXIT:
+            maxFrameSize = MAX_EMPTY_REQUEST_SIZE;
+            break;
+        case RequestId::SIGNUP_REQUEST:
+        case RequestId::UPDATE_USER_DATA_REQUEST:
+            maxFrameSize = _limits.maxFrameSize;
+            break;
+        default:    // a few short fields
+            maxFrameSize = MAX_SMALL_REQUEST_SIZE;
+    }
+
+    // the limits are only changed before the server starts, reading them unlocked is fine
+    return std::min({maxFrameSize, _limits.maxFrameSize, _limits.maxConnectionBytes});
+}
+
+std::string AdmissionController::report() {
+    unsigned int connections;
+    std::size_t addresses;
+    AdmissionLimits limits{};
+    {
+        std::lock_guard lock(_connectionsMutex);
+        connections = _connections;
+        addresses = _connectionsPerIp.size();
+        limits = _limits;
+    }
+
+    std::string report = fmt::format("{:>14}{:>12}{:>14}{:>16}{:>18}\n", "connections", "addresses", "refused",
+                                     "refused per ip", "rejected frames");
+    report += fmt::format("{:>8}/{:<5}{:>12}{:>14}{:>16}{:>18}\n", connections, limits.maxConnections, addresses,
+                          _refusedConnections.load(), _refusedPerIpConnections.load(), _rejectedFrames.load());
+    return report;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "../requests/requests.h"
+#include "../../constants.h"
+#include "../../errors/error.h"
+#include "../lockProfiler/lockProfiler.h"
+
+struct AdmissionLimits {
+    unsigned int maxConnections;        // connections served at once, the ones above are refused on accept
+    unsigned int maxConnectionsPerIp;
+    unsigned int maxFrameSize;          // bytes of a request body, the signup and profile requests get all of it
+    // bytes of requests a connection has read and not answered yet. a connection reads its next request only after
+    // answering the last, so this bounds the one body it holds, whatever its request id
+    unsigned int maxConnectionBytes;
+};
+
+// caps what a client can make the server hold: connections (in total and per source address) are checked when
+// accepted, frame lengths before their body is read and allocated
+class AdmissionController {
+public:
+    AdmissionController() = delete;  // Prevent construction
+    ~AdmissionController() = delete;  // Prevent destruction
+
+    // before the server accepts clients
+    static void configure(const AdmissionLimits &limits);
+
+    // an error when the connection is refused, otherwise it is counted until releaseConnection
+    static std::optional<Error> admitConnection(const std::string &address);
+
+    // a connection already open, handed over by another server, is counted without the limits
+    static void adoptConnection(const std::string &address);
+
+    static void releaseConnection(const std::string &address);
+
+    // an error when a frame of this length must not be read
+    static std::optional<Error> checkFrame(RequestId requestId, std::uint32_t length);
+
+    // the biggest body accepted for the request id
+    static std::uint32_t getMaxFrameSize(RequestId requestId);
+
+    // connections and refusals so far
+    static std::string report();
+
+private:
+    static inline AdmissionLimits _limits{DEFAULT_MAX_CONNECTIONS, DEFAULT_MAX_CONNECTIONS_PER_IP,
+                                          DEFAULT_MAX_FRAME_SIZE, DEFAULT_MAX_CONNECTION_BYTES};
+
+    static inline std::unordered_map<std::string, unsigned int> _connectionsPerIp;
+    static inline ProfiledMutex _connectionsMutex{"AdmissionController::_connectionsMutex"};
+    static inline unsigned int _connections = 0;    // guarded by _connectionsMutex
+
+    static inline std::atomic<std::uint64_t> _refusedConnections{0};
+    static inline std::atomic<std::uint64_t> _refusedPerIpConnections{0};
+    static inline std::atomic<std::uint64_t> _rejectedFrames{0};
+};
@@ -6,6 +6,15 @@
 #include <thread>
 #include <utility>
 #include "../socketHelper/socketHelper.h"
+#include "../tracer/tracer.h"
+#include "../trafficCapture/trafficCapture.h"
+#include "../admissionControl/admissionController.h"
+#include "../requestScheduler/requestScheduler.h"
+#include "../rateLimiter/rateLimiter.h"
+#include "../connectionMonitor/connectionMonitor.h"
+#include "../marshaling/jsonDeserializer.h"
+#include "../marshaling/jsonSerializer.h"
+#include "../marshaling/payloadEncoding.h"
 
 
 Communicator::~Communicator() {
@@ -14,9 +23,12 @@ Communicator::~Communicator() {
 
 
 void Communicator::startHandleRequests() {
-    bindAndListen();
+    if (!_isListening)
+        bindAndListen();
+    _isListening = true;
+    _isAccepting = true;
 
-    while (true) {
+    while (_isAccepting) {
         kissnet::tcp_socket client_socket;
 
         try {
@@ -27,8 +39,17 @@ void Communicator::startHandleRequests() {
             continue;
         }
 
-        const auto client_uuid = generateUUID();
         const auto userEndpoint = Endpoint(client_socket);
+        const auto admission = AdmissionController::admitConnection(userEndpoint.address);
+        if (admission.has_value()) {
+            log<Communicator>(__func__, "Refused client (" + admission.value().message + ")", false, userEndpoint);
+            const auto _ = SocketHelper::sendData(client_socket, JsonSerializer::serializeResponse(
+                    ErrorResponse{admission.value().message}));
+            client_socket.close();
+            continue;
+        }
+
+        const auto client_uuid = generateUUID();
         log<Communicator>( __func__, "Accepted new client, generated UUID: " + client_uuid , true, userEndpoint);
 
         std::unique_ptr<IRequestHandler> request_handler = _requestHandlerFactory.createLoginRequestHandler(userEndpoint);
@@ -38,11 +59,160 @@ void Communicator::startHandleRequests() {
             _clients[client_uuid] = {std::move(client_socket), std::move(request_handler)};
         }
 
-        std::thread client_thread = std::thread(&Communicator::handleClient, this, client_uuid, userEndpoint);
+        std::thread client_thread = std::thread(&Communicator::handleClient, this, client_uuid, userEndpoint,
+                                                std::string(), PayloadEncoding::JSON);
         client_thread.detach();
     }
 }
 
+void Communicator::takeOverListeningSocket(kissnet::SOCKET listeningSocket) {
+    _server_socket = kissnet::tcp_socket(listeningSocket, _server_endpoint);
+    _isListening = true;
+}
+
+kissnet::SOCKET Communicator::getListeningSocket() const {
+    return _server_socket.get_underlying_socket();
+}
+
+void Communicator::stopAccepting() {
+    if (!_isAccepting.exchange(false))
+        return;
+
+    // shutting the listening socket down would also stop the server it may be handed over to, shutdown acts on the
+    // socket both processes share rather than on this process' descriptor. so the accept call is woken by a
+    // connection of our own instead, it is served like any client and closes right away
+    const auto wakeAddress = _server_endpoint.address == "0.0.0.0" ? std::string("127.0.0.1")
+                                                                    : _server_endpoint.address;
+    for (unsigned int attempt = 0; attempt < ACCEPT_WAKE_ATTEMPTS; attempt++) {
+        try {
+            kissnet::tcp_socket wakeSocket(kissnet::endpoint(wakeAddress, _server_endpoint.port));
+            if (wakeSocket.connect())
+                return;
+        } catch (const std::exception &e) {}
+        std::this_thread::sleep_for(std::chrono::milliseconds(ACCEPT_WAKE_RETRY_INTERVAL_MS));
+    }
+
+    logError<Communicator>(__func__, "Failed to wake the accepting thread, it stops after the next client connects",
+                           _server_endpoint);
+}
+
+void Communicator::closeConnections(bool isClosingGames) {
+    if (!_isShuttingDown) {
+        // built once for every encoding, the connections are closed from the monitor's thread which has none
+        const auto serverEncoding = PayloadCodec::getEncoding();
+        for (std::size_t i = 0; i < PAYLOAD_ENCODINGS_COUNT; i++) {
+            PayloadCodec::setEncoding(static_cast<PayloadEncoding>(i));
+            _shuttingDownFrames[i] = JsonSerializer::serializeResponse(ErrorResponse{"Server is shutting down"});
+        }
+        PayloadCodec::setEncoding(serverEncoding);
+    }
+    _isShuttingDown = true;
+    ConnectionMonitor::closeWaiting(isClosingGames);
+}
+
+std::size_t Communicator::getConnectionsCount() const {
+    std::shared_lock lock(_clientsMutex);
+    return _clients.size();
+}
+
+void Communicator::beginHandoff() {
+    {
+        std::lock_guard lock(_handoffMutex);
+        _handoffState = HandoffState::COLLECTING;
+    }
+    _handoffSignal.raise();
+}
+
+std::size_t Communicator::collectConnections(std::chrono::steady_clock::time_point deadline) {
+    // every set aside connection's thread removes it from _clients
+    while (getConnectionsCount() != 0 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(SHUTDOWN_POLL_INTERVAL_MS));
+    return getConnectionsCount();
+}
+
+void Communicator::commitHandoff(SocketHandoff &handoff) {
+    std::lock_guard lock(_handoffMutex);
+    _handoffState = HandoffState::HANDED_OVER;
+    _handoff = &handoff;
+    // their handlers are dropped without EXIT, the new server holds their sessions
+    for (auto &setAsideConnection: _setAsideConnections)
+        sendConnection(setAsideConnection.socket, setAsideConnection.connection);
+    _setAsideConnections.clear();
+}
+
+void Communicator::cancelHandoff() {
+    std::vector<SetAsideConnection> setAsideConnections;
+    {
+        std::lock_guard lock(_handoffMutex);
+        // lowered first, so a connection finding no handoff waits for its request again instead of spinning
+        _handoffSignal.lower();
+        _handoffState = HandoffState::NONE;
+        setAsideConnections.swap(_setAsideConnections);
+    }
+
+    for (auto &setAsideConnection: setAsideConnections) {
+        auto &connection = setAsideConnection.connection;
+        adoptConnection(std::move(setAsideConnection.socket), connection.endpoint,
+                        std::move(setAsideConnection.handler), connection.sessionToken, connection.encoding);
+    }
+}
+
+void Communicator::finishHandoff() {
+    std::lock_guard lock(_handoffMutex);
+    if (_handoff == nullptr)
+        return;
+
+    const auto endRes = _handoff->send({});
+    if (endRes.has_value())
+        logError<Communicator>(__func__, "Failed to end the handoff: " + endRes.value().message, _server_endpoint);
+    _handoff = nullptr;
+}
+
+void Communicator::adoptConnection(kissnet::tcp_socket socket, const Endpoint &endpoint,
+                                   std::unique_ptr<IRequestHandler> handler, const std::string &sessionToken,
+                                   PayloadEncoding encoding) {
+    AdmissionController::adoptConnection(endpoint.address);
+    const auto client_uuid = generateUUID();
+    log<Communicator>(__func__, "Adopted client, generated UUID: " + client_uuid, true, endpoint);
+
+    {
+        std::lock_guard lock(_clientsMutex);
+        _clients[client_uuid] = {std::move(socket), std::move(handler)};
+    }
+
+    std::thread client_thread = std::thread(&Communicator::handleClient, this, client_uuid, endpoint, sessionToken,
+                                            encoding);
+    client_thread.detach();
+}
+
+bool Communicator::handOverConnection(kissnet::tcp_socket &socket, std::unique_ptr<IRequestHandler> &handler,
+                                      const HandedOverConnection &connection) {
+    std::lock_guard lock(_handoffMutex);
+    if (_handoffState == HandoffState::NONE)
+        return false;
+
+    if (_handoffState == HandoffState::COLLECTING) {
+        _setAsideConnections.push_back(SetAsideConnection{std::move(socket), std::move(handler), connection});
+        return true;
+    }
+
+    // its request was still running when the snapshot was taken, its session waits for it in the new server
+    sendConnection(socket, connection);
+    return true;
+}
+
+void Communicator::sendConnection(kissnet::tcp_socket &socket, const HandedOverConnection &connection) {
+    // past the shutdown deadline, the client resumes its session on a new connection
+    const auto sendRes = _handoff == nullptr ? std::optional<Error>(Error(ErrorType::Socket, "The handoff has ended"))
+                                             : _handoff->send(connection.serialize(), socket.get_underlying_socket());
+    if (sendRes.has_value())
+        logError<Communicator>(__func__, "Failed to hand the connection over: " + sendRes.value().message,
+                               connection.endpoint);
+
+    // the new server has a descriptor of its own
+    socket.close();
+}
+
 void Communicator::bindAndListen() {
     // create server socket
     try {
@@ -74,43 +244,224 @@ void Communicator::bindAndListen() {
     }
 }
 
-void Communicator::handleClient(const std::string &client_uuid, const Endpoint &userEndpoint) {
+void Communicator::handleClient(const std::string &client_uuid, const Endpoint &userEndpoint, std::string sessionToken,
+                                PayloadEncoding encoding) {
     std::shared_lock sharedLock(_clientsMutex);
     auto &[client_socket, request_handler] = _clients[client_uuid];
     sharedLock.unlock();
+    Tracer::setThreadName("client " + userEndpoint.toString());
+    const auto connectionId = TrafficRecorder::openConnection();
+    PayloadCodec::setEncoding(encoding);
 
     RequestInfo reqInfo;
     RequestResult reqResult;
+    // sessionToken is of the last login / resumed session on this connection
+    bool isParked = false;
+    bool isHandedOver = false;
+    RateLimiter::Connection rateLimiter(userEndpoint.address);
+    std::atomic<PayloadEncoding> connectionEncoding = encoding;   // read by the monitor's thread
+    // a connection waiting too long for its next request is shut down, the read fails and it is handled as a drop
+    const auto idleTimer = ConnectionMonitor::watch([this, &client_socket, &userEndpoint, &connectionEncoding]() {
+        if (_isShuttingDown) {
+            // the connection is waiting for a request, so its thread doesn't write to the socket meanwhile. the
+            // monitor's thread doesn't wait for a peer that isn't reading, the goodbye is dropped instead
+            const auto _ = SocketHelper::trySendData(
+                    client_socket, _shuttingDownFrames[static_cast<std::size_t>(connectionEncoding.load())]);
+            log<Communicator>("handleClient", "Closing connection, server is shutting down", true, userEndpoint);
+        } else {
+            log<Communicator>("handleClient", "Closing idle connection", false, userEndpoint);
+        }
+        client_socket.shutdown();
+    });
     do {
+        connectionEncoding = PayloadCodec::getEncoding();
+        ConnectionMonitor::arm(idleTimer, request_handler->getConnectionState());
+        // a handoff stops the connection between two requests and sends it to the new server as it is. once a
+        // cancelled handoff lowers the signal, the connection waits for its request again
+        while (!_handoffSignal.waitForData(client_socket.get_underlying_socket())) {
+            ConnectionMonitor::disarm(idleTimer);
+            isHandedOver = handOverConnection(client_socket, request_handler,
+                                              HandedOverConnection{userEndpoint, sessionToken,
+                                                                   PayloadCodec::getEncoding()});
+            if (isHandedOver)
+                break;
+            ConnectionMonitor::arm(idleTimer, request_handler->getConnectionState());
+        }
+        if (isHandedOver)
+            break;
+
         reqInfo = SocketHelper::getRequestInfo(client_socket);
-        reqResult = request_handler->handleRequest(reqInfo);
+        ConnectionMonitor::disarm(idleTimer);
+        // a dropped connection keeps the user's menu / room / game for a while instead of logging them out
+        if (reqInfo.isDisconnection && parkSession(sessionToken, request_handler, userEndpoint)) {
+            isParked = true;
+            break;
+        }
+
+        // EXIT is also what a disconnection looks like, the replay closes the connection instead of sending it
+        if (reqInfo.requestId != RequestId::EXIT)
+            TrafficRecorder::recordRequest(connectionId, reqInfo);
+        if (reqInfo.requestId != RequestId::EXIT && !rateLimiter.tryTake(getRequestPriority(reqInfo.requestId))) {
+            reqResult = RequestResult{{}, nullptr, RateLimiter::getThrottledFrame()};
+        } else if (reqInfo.requestId == RequestId::CLIENT_HELLO_REQUEST) {
+            reqResult = handleClientHello(reqInfo, userEndpoint);
+        } else if (reqInfo.requestId == RequestId::RESUME_SESSION_REQUEST) {
+            reqResult = handleResumeSession(reqInfo, *request_handler, sessionToken, userEndpoint);
+        } else if (reqInfo.requestId == RequestId::PING_REQUEST) {
+            reqResult = handlePing(reqInfo, userEndpoint);
+        } else {
+            // game requests get a free slot before room and lobby ones, lobby requests waiting too long are shed
+            const RequestScheduler::Slot slot(request_handler->getPriority(reqInfo));
+            if (slot.isAcquired()) {
+                const TraceSpan span("handler", requestIdToString(reqInfo.requestId));
+                reqResult = request_handler->handleRequest(reqInfo);
+            } else {
+                const RetryLaterResponse retryLaterResponse{false, RequestScheduler::getRetryAfterMs()};
+                reqResult = RequestResult{JsonSerializer::serializeResponse(retryLaterResponse), nullptr};
+                log<Communicator>(__func__, std::string("Shed ") + requestIdToString(reqInfo.requestId), false,
+                                  userEndpoint);
+            }
+        }
 
         // Update request handler if necessary
         if (reqResult.newHandler != nullptr) {
             request_handler = std::move(reqResult.newHandler);
         }
+        if (!reqResult.sessionToken.empty())
+            sessionToken = reqResult.sessionToken;
 
         // if we handled a request that is not EXIT, send the response to the client
         if (reqInfo.requestId != RequestId::EXIT) {
-            const auto res = SocketHelper::sendData(client_socket, reqResult.buffer);
+            TrafficRecorder::recordResponse(connectionId, reqInfo.requestId, reqResult.frame());
+            const auto res = SocketHelper::sendData(client_socket, reqResult.frame());
 
-            // if we couldn't send data, the client has disconnected, so pass exit request to the handler
-            // to start the chain of logout
+            // if we couldn't send data, the client has disconnected, so park the session or, when not logged in,
+            // pass exit request to the handler to start the chain of logout
             if (res.has_value()) {
-                request_handler->handleRequest({RequestId::EXIT, {}});
+                isParked = parkSession(sessionToken, request_handler, userEndpoint);
+                if (!isParked)
+                    request_handler->handleRequest({RequestId::EXIT, {}});
                 reqInfo.requestId = RequestId::EXIT;
             }
         }
 
     } while (reqInfo.requestId != RequestId::EXIT);
 
-    log<Communicator>( __func__, "Closing connection with client, UUID: " + client_uuid,  true, userEndpoint);
-    client_socket.close();
+    // the user has logged out, the token is of no use anymore
+    if (!isParked && !isHandedOver && !sessionToken.empty())
+        _requestHandlerFactory.getSessionRegistry().close(sessionToken);
+
+    ConnectionMonitor::unwatch(idleTimer);
+    TrafficRecorder::closeConnection(connectionId);
+    log<Communicator>( __func__, (isHandedOver ? "Handed the connection over to the new server, UUID: "
+                                               : "Closing connection with client, UUID: ") + client_uuid,  true,
+                      userEndpoint);
+    client_socket.close();  // already taken when handed over
+    AdmissionController::releaseConnection(userEndpoint.address);
 
     std::lock_guard lockGuard(_clientsMutex);
     _clients.erase(client_uuid);
 }
 
+RequestResult Communicator::handleClientHello(const RequestInfo &requestInfo, const Endpoint &client_endpoint) {
+    const TraceSpan span("handler", requestIdToString(requestInfo.requestId));
+    PayloadCodec::setEncoding(PayloadEncoding::JSON);
+
+    const auto clientHelloRes = JsonDeserializer::deserializeClientHelloRequest(requestInfo.buffer);
+    if (clientHelloRes.isError())
+        return clientHelloRes.error().toRequestResult<Communicator>(__func__, client_endpoint);
+
+    // the first encoding of the client's list that the server knows, JSON when there is none
+    auto encoding = PayloadEncoding::JSON;
+    for (const auto &encodingName: clientHelloRes.value().encodings) {
+        const auto knownEncoding = payloadEncodingFromString(encodingName);
+        if (knownEncoding.has_value()) {
+            encoding = knownEncoding.value();
+            break;
+        }
+    }
+
+    const ClientHelloResponse clientHelloResponse{true, payloadEncodingToString(encoding)};
+    RequestResult requestResult{JsonSerializer::serializeResponse(clientHelloResponse), nullptr};
+    PayloadCodec::setEncoding(encoding);
+    log<Communicator>(__func__, std::string("Switched payload encoding to ") + payloadEncodingToString(encoding), true,
+                      client_endpoint);
+    return requestResult;
+}
+
+RequestResult Communicator::handlePing(const RequestInfo &requestInfo, const Endpoint &client_endpoint) {
+    const TraceSpan span("handler", requestIdToString(requestInfo.requestId));
+    const auto pingRes = JsonDeserializer::deserializePingRequest(requestInfo.buffer);
+    if (pingRes.isError())
+        return pingRes.error().toRequestResult<Communicator>(__func__, client_endpoint);
+
+    if (pingRes.value().lastRttUs.has_value())
+        ConnectionMonitor::recordRtt(pingRes.value().lastRttUs.value());
+    return RequestResult{JsonSerializer::serializeResponse(PongResponse{true}), nullptr};
+}
+
+RequestResult Communicator::handleResumeSession(const RequestInfo &requestInfo, IRequestHandler &currentHandler,
+                                               const std::string &sessionToken, const Endpoint &client_endpoint) {
+    const TraceSpan span("handler", requestIdToString(requestInfo.requestId));
+    auto &sessionRegistry = _requestHandlerFactory.getSessionRegistry();
+
+    const auto resumeSessionRes = JsonDeserializer::deserializeResumeSessionRequest(requestInfo.buffer);
+    if (resumeSessionRes.isError())
+        return resumeSessionRes.error().toRequestResult<Communicator>(__func__, client_endpoint);
+
+    // the user logged in on this connection would be left behind
+    if (!sessionToken.empty() && sessionRegistry.isConnected(sessionToken))
+        return Error(ErrorType::InvalidRequest, "User already logged in").toRequestResult<Communicator>(__func__,
+                                                                                                        client_endpoint);
+
+    std::string username;
+    auto parkedHandler = sessionRegistry.resume(resumeSessionRes.value().sessionToken, username);
+    if (parkedHandler == nullptr) {
+        log<Communicator>(__func__, "Failed to resume session (unknown or expired token)", false, client_endpoint);
+        const ResumeSessionResponse response{false, "Session expired", "", ""};
+        return RequestResult{JsonSerializer::serializeResponse(response), nullptr};
+    }
+
+    // e.g. a signup waiting for its verification code, dropped like on a disconnection
+    currentHandler.handleRequest({RequestId::EXIT, {}});
+
+    auto &presenceRegistry = _requestHandlerFactory.getLoginManager().getPresenceRegistry();
+    presenceRegistry.setEndpoint(username, client_endpoint);
+    const auto presence = presenceRegistry.get(username);
+
+    ResumeSessionResponse response{true, "", "menu", ""};
+    if (presence.has_value()) {
+        response.location = presenceLocationToString(presence->location);
+        response.roomId = presence->locationId;
+    }
+    log<Communicator>(__func__, "User '" + username + "' resumed their session in the " + response.location, true,
+                      client_endpoint);
+
+    RequestResult requestResult{JsonSerializer::serializeResponse(response), std::move(parkedHandler)};
+    requestResult.sessionToken = resumeSessionRes.value().sessionToken;
+    return requestResult;
+}
+
+bool Communicator::parkSession(const std::string &sessionToken, std::unique_ptr<IRequestHandler> &handler,
+                               const Endpoint &client_endpoint) {
+    // the new server holds the session already, parked until the connection comes over
+    if (_handoffState == HandoffState::HANDED_OVER)
+        return true;
+
+    // nothing to resume on a server going down, except a game's state: it is kept until the games are checkpointed,
+    // so the player isn't punished for leaving
+    if (_isShuttingDown && handler->getConnectionState() != ConnectionState::GAME)
+        return false;
+
+    if (sessionToken.empty() || !_requestHandlerFactory.getSessionRegistry().park(sessionToken, handler))
+        return false;
+
+    log<Communicator>(__func__, "Connection lost, session kept for " +
+                                std::to_string(SESSION_RESUME_GRACE_PERIOD_MS / 1000) + " seconds", true,
+                      client_endpoint);
+    return true;
+}
+
 std::string Communicator::generateUUID() {
     boost::uuids::uuid uuid{};
 
@@ -1,14 +1,21 @@
 #pragma once
 
+#include <array>
 #include <string>
+#include <vector>
 #include <kissnet.hpp>
 #include <utility>
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <shared_mutex>
 #include "../../requestHandlers/IRequestHandler.h"
 #include "../../errors/error.h"
 #include "../../requestHandlers/requestHandlerFactory.h"
+#include "../lockProfiler/lockProfiler.h"
+#include "../marshaling/payloadEncoding.h"
+#include "../socketHandoff/socketHandoff.h"
+#include "../socketHandoff/handoffSnapshot.h"
 
 class Communicator {
 public:
@@ -18,13 +25,90 @@ public:
 
     ~Communicator();
 
+    // accepts clients until stopAccepting, binds the server socket unless one was taken over
     void startHandleRequests();
 
+    // accepts on the listening socket of the server this one replaces, instead of binding its own
+    void takeOverListeningSocket(kissnet::SOCKET listeningSocket);
+
+    [[nodiscard]] kissnet::SOCKET getListeningSocket() const;
+
+    // makes startHandleRequests return. the listening socket stays open, it may be handed over to a new server
+    void stopAccepting();
+
+    // shutdown stages, see Server::shutdown
+
+    // tells the clients waiting for a request (out of games unless isClosingGames) that the server is shutting down
+    // and closes their connection, which logs them out
+    void closeConnections(bool isClosingGames);
+
+    [[nodiscard]] std::size_t getConnectionsCount() const;
+
+    // handoff stages, see Server::handOver
+
+    // the connections stop at their next request boundary and are set aside with their handler and session
+    void beginHandoff();
+
+    // waits until every connection is set aside, or the deadline. returns how many are still handling a request
+    std::size_t collectConnections(std::chrono::steady_clock::time_point deadline);
+
+    // the new server has the snapshot: the connections set aside are sent over the handoff, the others as soon as
+    // they finish their request. handoff is used until finishHandoff
+    void commitHandoff(SocketHandoff &handoff);
+
+    // the new server failed, the connections set aside are served again
+    void cancelHandoff();
+
+    // once every connection was sent, ends the handoff
+    void finishHandoff();
+
+    // serves a connection of the server this one took over from, with the handler its session was parked with
+    void adoptConnection(kissnet::tcp_socket socket, const Endpoint &endpoint, std::unique_ptr<IRequestHandler> handler,
+                         const std::string &sessionToken, PayloadEncoding encoding);
+
 private:
+    enum class HandoffState {
+        NONE,
+        COLLECTING,     // the connections reaching their request boundary are set aside
+        HANDED_OVER     // the new server has the state, the connections reaching their boundary are sent right away
+    };
+
+    // a connection stopped at its request boundary, its thread is gone
+    struct SetAsideConnection {
+        kissnet::tcp_socket socket;
+        std::unique_ptr<IRequestHandler> handler;
+        HandedOverConnection connection;
+    };
+
     // SocketHelper method
     void bindAndListen();
 
-    void handleClient(const std::string &client_uuid, const Endpoint &client_endpoint);
+    // sessionToken and encoding are those of an adopted connection
+    void handleClient(const std::string &client_uuid, const Endpoint &client_endpoint, std::string sessionToken,
+                      PayloadEncoding encoding);
+
+    // by a connection's thread stopped by the handoff signal. true when the socket and handler were taken, the thread
+    // then ends without logging out, false when the handoff was cancelled meanwhile
+    bool handOverConnection(kissnet::tcp_socket &socket, std::unique_ptr<IRequestHandler> &handler,
+                            const HandedOverConnection &connection);
+
+    // with _handoffMutex held. the socket is closed here once it is sent
+    void sendConnection(kissnet::tcp_socket &socket, const HandedOverConnection &connection);
+
+    // picks the payload encoding of the connection, the hello and its response are always JSON
+    static RequestResult handleClientHello(const RequestInfo &requestInfo, const Endpoint &client_endpoint);
+
+    // answers a heartbeat right away, keeping the round trip the client measured on its previous one
+    static RequestResult handlePing(const RequestInfo &requestInfo, const Endpoint &client_endpoint);
+
+    // moves the parked handler of a dropped connection to this one, replacing its current handler (which gets EXIT)
+    RequestResult handleResumeSession(const RequestInfo &requestInfo, IRequestHandler &currentHandler,
+                                      const std::string &sessionToken, const Endpoint &client_endpoint);
+
+    // parks the handler of a dropped connection under its session token, false when it isn't logged in or, on
+    // shutdown, out of a game
+    bool parkSession(const std::string &sessionToken, std::unique_ptr<IRequestHandler> &handler,
+                     const Endpoint &client_endpoint);
 
     std::string generateUUID();
 
@@ -32,9 +116,21 @@ private:
     Endpoint _server_endpoint;
     kissnet::tcp_socket _server_socket;
     RequestHandlerFactory &_requestHandlerFactory;
+    bool _isListening = false;
+    std::atomic<bool> _isAccepting = true;
+    std::atomic<bool> _isShuttingDown = false;
+    // the ERROR_RESPONSE sent to the connections closed on shutdown, by encoding. set before _isShuttingDown
+    std::array<std::vector<unsigned char>, PAYLOAD_ENCODINGS_COUNT> _shuttingDownFrames;
+
+    // handoff related members
+    HandoffSignal _handoffSignal;
+    std::atomic<HandoffState> _handoffState = HandoffState::NONE;   // changed with _handoffMutex held
+    std::vector<SetAsideConnection> _setAsideConnections;
+    SocketHandoff *_handoff = nullptr;  // from commitHandoff to finishHandoff
+    ProfiledMutex _handoffMutex{"Communicator::_handoffMutex"};
 
     // clients related members
     // map of clients: UUID -> (socket, handler)
     std::map<std::string, std::pair<kissnet::tcp_socket, std::unique_ptr<IRequestHandler>>> _clients;
-    mutable std::shared_mutex _clientsMutex;
+    mutable ProfiledSharedMutex _clientsMutex{"Communicator::_clientsMutex"};
 };
\ No newline at end of file
@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <iostream>
 #include <regex>
+#include <thread>
 #include "configLoader.h"
 #include "../../constants.h"
 #include "../../log.h"
@@ -7,7 +9,7 @@
 
 using Json = nlohmann::json;
 
-Endpoint ConfigLoader::loadConfig(const std::string &config_path) {
+ServerConfig ConfigLoader::loadConfig(const std::string &config_path) {
 
     std::string ip = DEFAULT_IP;
     int port = DEFAULT_PORT;
@@ -19,7 +21,9 @@ Endpoint ConfigLoader::loadConfig(const std::string &config_path) {
         logServerResult(false, false, false);
         logServerProgress<ConfigLoader>( __func__, "Using default values: " + ip + ":" + std::to_string(port));
         logServerResult(true);
-        return Endpoint(ip, port);
+        return ServerConfig{Endpoint(ip, port), false, getDefaultPasswordHashingConfig(), getDefaultAdmissionLimits(),
+                            getDefaultSchedulerConfig(), getDefaultRateLimits(), getDefaultIdleTimeouts(),
+                            DEFAULT_SHUTDOWN_DEADLINE_SECONDS, DEFAULT_JOURNAL_SYNC_INTERVAL_MS};
     }
     logServerResult(true);
 
@@ -32,7 +36,9 @@ Endpoint ConfigLoader::loadConfig(const std::string &config_path) {
         logServerResult(false, false);
         logServerProgress<ConfigLoader>( __func__, "Using default values: " + ip + ":" + std::to_string(port));
         logServerResult(true);
-        return Endpoint(ip, port);
+        return ServerConfig{Endpoint(ip, port), false, getDefaultPasswordHashingConfig(), getDefaultAdmissionLimits(),
+                            getDefaultSchedulerConfig(), getDefaultRateLimits(), getDefaultIdleTimeouts(),
+                            DEFAULT_SHUTDOWN_DEADLINE_SECONDS, DEFAULT_JOURNAL_SYNC_INTERVAL_MS};
     }
 
     logServerProgress<ConfigLoader>( __func__, "Validating ip address...");
@@ -58,9 +64,220 @@ Endpoint ConfigLoader::loadConfig(const std::string &config_path) {
         logServerResult(true);
     }
 
+    bool useStandIns = false;
+    if (root.contains("standIns")) {
+        logServerProgress<ConfigLoader>( __func__, "Validating stand-ins flag...");
+        if (root["standIns"].is_boolean()) {
+            useStandIns = root["standIns"].get<bool>();
+            logServerResult(true);
+        }
+        else {
+            logServerResult(false, false);
+            logServerProgress<ConfigLoader>( __func__, "Using real email and questions services");
+            logServerResult(true);
+        }
+    }
+
+    const auto passwordHashing = loadPasswordHashingConfig(root);
+    const auto admissionLimits = loadAdmissionLimits(root);
+    const auto scheduler = loadSchedulerConfig(root);
+    const auto rateLimits = loadRateLimits(root);
+    const auto idleTimeouts = loadIdleTimeouts(root);
+
+    unsigned int shutdownDeadlineSeconds = DEFAULT_SHUTDOWN_DEADLINE_SECONDS;
+    if (root.contains("shutdownDeadlineSeconds")) {
+        logServerProgress<ConfigLoader>( __func__, "Validating shutdown deadline...");
+        // at least the closing part of the deadline, and some time for the games
+        if (readUnsignedSetting(root, "shutdownDeadlineSeconds", shutdownDeadlineSeconds, SHUTDOWN_CLOSING_SECONDS + 5,
+                                3600)) {
+            logServerResult(true);
+        } else {
+            logServerResult(false, false);
+            logServerProgress<ConfigLoader>( __func__, "Using default shutdown deadline: " +
+                                                       std::to_string(shutdownDeadlineSeconds) + " seconds");
+            logServerResult(true);
+        }
+    }
+
+    unsigned int journalSyncIntervalMs = DEFAULT_JOURNAL_SYNC_INTERVAL_MS;
+    if (root.contains("journalSyncIntervalMs")) {
+        logServerProgress<ConfigLoader>( __func__, "Validating game journal sync interval...");
+        if (readUnsignedSetting(root, "journalSyncIntervalMs", journalSyncIntervalMs, 1, 1000)) {
+            logServerResult(true);
+        } else {
+            logServerResult(false, false);
+            logServerProgress<ConfigLoader>( __func__, "Using default game journal sync interval: " +
+                                                       std::to_string(journalSyncIntervalMs) + "ms");
+            logServerResult(true);
+        }
+    }
+
     file.close();
 
-    return Endpoint(ip, port);
+    return ServerConfig{Endpoint(ip, port), useStandIns, passwordHashing, admissionLimits, scheduler,
+                        rateLimits, idleTimeouts, shutdownDeadlineSeconds, journalSyncIntervalMs};
+}
+
+PasswordHashingConfig ConfigLoader::loadPasswordHashingConfig(const Json &root) {
+    auto passwordHashing = getDefaultPasswordHashingConfig();
+    if (!root.contains("passwordHashWorkers") && !root.contains("passwordHashCost") &&
+        !root.contains("passwordHashQueueLimit"))
+        return passwordHashing;
+
+    logServerProgress<ConfigLoader>( __func__, "Validating password hashing settings...");
+    bool isValid = readUnsignedSetting(root, "passwordHashWorkers", passwordHashing.workers, 1, 64);
+    isValid &= readUnsignedSetting(root, "passwordHashCost", passwordHashing.costLog2, 10, 20);
+    isValid &= readUnsignedSetting(root, "passwordHashQueueLimit", passwordHashing.queueLimit, 1, 100000);
+
+    if (isValid) {
+        logServerResult(true);
+    } else {
+        logServerResult(false, false);
+        logServerProgress<ConfigLoader>( __func__, "Using default values for the invalid password hashing settings");
+        logServerResult(true);
+    }
+    return passwordHashing;
+}
+
+PasswordHashingConfig ConfigLoader::getDefaultPasswordHashingConfig() {
+    // half of the cores, the rest is left to the clients' threads
+    const unsigned int workers = std::max(1u, std::thread::hardware_concurrency() / 2);
+    return PasswordHashingConfig{workers, DEFAULT_PASSWORD_HASH_COST, DEFAULT_PASSWORD_HASH_QUEUE_LIMIT};
+}
+
+AdmissionLimits ConfigLoader::loadAdmissionLimits(const Json &root) {
+    auto admissionLimits = getDefaultAdmissionLimits();
+    if (!root.contains("maxConnections") && !root.contains("maxConnectionsPerIp") &&
+        !root.contains("maxFrameBytes") && !root.contains("maxConnectionBytes"))
+        return admissionLimits;
+
+    logServerProgress<ConfigLoader>( __func__, "Validating connection limits...");
+    bool isValid = readUnsignedSetting(root, "maxConnections", admissionLimits.maxConnections, 1, 1000000);
+    isValid &= readUnsignedSetting(root, "maxConnectionsPerIp", admissionLimits.maxConnectionsPerIp, 1, 1000000);
+    // below MAX_EMPTY_REQUEST_SIZE even the requests without fields would be refused
+    isValid &= readUnsignedSetting(root, "maxFrameBytes", admissionLimits.maxFrameSize, MAX_EMPTY_REQUEST_SIZE,
+                                   64 * 1024 * 1024);
+    isValid &= readUnsignedSetting(root, "maxConnectionBytes", admissionLimits.maxConnectionBytes,
+                                   MAX_EMPTY_REQUEST_SIZE, 64 * 1024 * 1024);
+
+    if (isValid) {
+        logServerResult(true);
+    } else {
+        logServerResult(false, false);
+        logServerProgress<ConfigLoader>( __func__, "Using default values for the invalid connection limits");
+        logServerResult(true);
+    }
+    return admissionLimits;
+}
+
+AdmissionLimits ConfigLoader::getDefaultAdmissionLimits() {
+    return AdmissionLimits{DEFAULT_MAX_CONNECTIONS, DEFAULT_MAX_CONNECTIONS_PER_IP, DEFAULT_MAX_FRAME_SIZE,
+                           DEFAULT_MAX_CONNECTION_BYTES};
+}
+
+SchedulerConfig ConfigLoader::loadSchedulerConfig(const Json &root) {
+    auto scheduler = getDefaultSchedulerConfig();
+    if (!root.contains("schedulerConcurrency") && !root.contains("shedAfterMs"))
+        return scheduler;
+
+    logServerProgress<ConfigLoader>( __func__, "Validating request scheduling settings...");
+    bool isValid = readUnsignedSetting(root, "schedulerConcurrency", scheduler.concurrency, 1, 4096);
+    isValid &= readUnsignedSetting(root, "shedAfterMs", scheduler.shedAfterMs, 1, 60000);
+
+    if (isValid) {
+        logServerResult(true);
+    } else {
+        logServerResult(false, false);
+        logServerProgress<ConfigLoader>( __func__, "Using default values for the invalid request scheduling settings");
+        logServerResult(true);
+    }
+    return scheduler;
+}
+
+SchedulerConfig ConfigLoader::getDefaultSchedulerConfig() {
+    return SchedulerConfig{DEFAULT_SCHEDULER_CONCURRENCY, DEFAULT_SHED_AFTER_MS};
+}
+
+RateLimits ConfigLoader::loadRateLimits(const Json &root) {
+    auto rateLimits = getDefaultRateLimits();
+    bool isValid = true;
+    bool hasRateLimits = false;
+    for (std::size_t i = 0; i < REQUEST_PRIORITIES_COUNT; i++) {
+        const std::string requestClass = RateLimiter::requestClassToString(i);
+        const auto perSecondKey = requestClass + "RequestsPerSecond";
+        const auto burstKey = requestClass + "RequestsBurst";
+        if (!root.contains(perSecondKey) && !root.contains(burstKey))
+            continue;
+
+        if (!hasRateLimits)
+            logServerProgress<ConfigLoader>( __func__, "Validating rate limits...");
+        hasRateLimits = true;
+        isValid &= readUnsignedSetting(root, perSecondKey.c_str(), rateLimits[i].requestsPerSecond, 1, 100000);
+        isValid &= readUnsignedSetting(root, burstKey.c_str(), rateLimits[i].burst, 1, 100000);
+    }
+    if (!hasRateLimits)
+        return rateLimits;
+
+    if (isValid) {
+        logServerResult(true);
+    } else {
+        logServerResult(false, false);
+        logServerProgress<ConfigLoader>( __func__, "Using default values for the invalid rate limits");
+        logServerResult(true);
+    }
+    return rateLimits;
+}
+
+RateLimits ConfigLoader::getDefaultRateLimits() {
+    return RateLimits{{{DEFAULT_GAME_REQUESTS_PER_SECOND, DEFAULT_GAME_REQUESTS_BURST},
+                       {DEFAULT_ROOM_REQUESTS_PER_SECOND, DEFAULT_ROOM_REQUESTS_BURST},
+                       {DEFAULT_LOBBY_REQUESTS_PER_SECOND, DEFAULT_LOBBY_REQUESTS_BURST},
+                       {DEFAULT_OTHER_REQUESTS_PER_SECOND, DEFAULT_OTHER_REQUESTS_BURST}}};
+}
+
+IdleTimeouts ConfigLoader::loadIdleTimeouts(const Json &root) {
+    auto idleTimeouts = getDefaultIdleTimeouts();
+    bool isValid = true;
+    bool hasIdleTimeouts = false;
+    for (std::size_t i = 0; i < CONNECTION_STATES_COUNT; i++) {
+        const auto key = std::string(connectionStateToString(static_cast<ConnectionState>(i))) + "IdleTimeoutSeconds";
+        if (!root.contains(key))
+            continue;
+
+        if (!hasIdleTimeouts)
+            logServerProgress<ConfigLoader>( __func__, "Validating idle timeouts...");
+        hasIdleTimeouts = true;
+        // above a day the connection is as good as never timed out
+        isValid &= readUnsignedSetting(root, key.c_str(), idleTimeouts[i], 5, 86400);
+    }
+    if (!hasIdleTimeouts)
+        return idleTimeouts;
+
+    if (isValid) {
+        logServerResult(true);
+    } else {
+        logServerResult(false, false);
+        logServerProgress<ConfigLoader>( __func__, "Using default values for the invalid idle timeouts");
+        logServerResult(true);
+    }
+    return idleTimeouts;
+}
+
+IdleTimeouts ConfigLoader::getDefaultIdleTimeouts() {
+    return IdleTimeouts{DEFAULT_LOGIN_IDLE_TIMEOUT_SECONDS, DEFAULT_MENU_IDLE_TIMEOUT_SECONDS,
+                        DEFAULT_ROOM_IDLE_TIMEOUT_SECONDS, DEFAULT_GAME_IDLE_TIMEOUT_SECONDS};
+}
+
+bool ConfigLoader::readUnsignedSetting(const Json &root, const char *key, unsigned int &value, unsigned int min,
+                                       unsigned int max) {
+    if (!root.contains(key))
+        return true;
+
+    if (!root[key].is_number_unsigned() || root[key].get<std::uint64_t>() < min || root[key].get<std::uint64_t>() > max)
+        return false;
+
+    value = root[key].get<unsigned int>();
+    return true;
 }
 
 bool ConfigLoader::isValidIP(const std::string &ip) {
@@ -3,14 +3,63 @@
 #include <string>
 #include <fstream>
 #include <kissnet.hpp>
+#include <nlohmann/json.hpp>
 #include "../communicator/endpoint.h"
+#include "../passwordHasher/passwordHasher.h"
+#include "../admissionControl/admissionController.h"
+#include "../requestScheduler/requestScheduler.h"
+#include "../rateLimiter/rateLimiter.h"
+#include "../connectionMonitor/connectionMonitor.h"
+
+struct ServerConfig {
+    Endpoint endpoint;
+    bool useStandIns;   // replace Mailjet and OpenTDB with local stand-ins (load testing)
+    PasswordHashingConfig passwordHashing;
+    AdmissionLimits admissionLimits;
+    SchedulerConfig scheduler;
+    RateLimits rateLimits;
+    IdleTimeouts idleTimeouts;
+    unsigned int shutdownDeadlineSeconds;  // to let the games finish and close the connections
+    unsigned int journalSyncIntervalMs;    // the game events of the last interval are lost on a crash
+};
 
 class ConfigLoader {
 public:
-    static Endpoint loadConfig(const std::string &config_path);
+    static ServerConfig loadConfig(const std::string &config_path);
 
 private:
     static bool isValidIP(const std::string &ip);
 
     static bool isValidPort(const int &port);
+
+    // "passwordHashWorkers", "passwordHashCost" and "passwordHashQueueLimit", the defaults for missing or invalid ones
+    static PasswordHashingConfig loadPasswordHashingConfig(const nlohmann::json &root);
+
+    static PasswordHashingConfig getDefaultPasswordHashingConfig();
+
+    // "maxConnections", "maxConnectionsPerIp", "maxFrameBytes" and "maxConnectionBytes", the defaults for missing or
+    // invalid ones
+    static AdmissionLimits loadAdmissionLimits(const nlohmann::json &root);
+
+    static AdmissionLimits getDefaultAdmissionLimits();
+
+    // "schedulerConcurrency" and "shedAfterMs", the defaults for missing or invalid ones
+    static SchedulerConfig loadSchedulerConfig(const nlohmann::json &root);
+
+    static SchedulerConfig getDefaultSchedulerConfig();
+
+    // "<class>RequestsPerSecond" and "<class>RequestsBurst" of the game, room, lobby and other request classes, the
+    // defaults for missing or invalid ones
+    static RateLimits loadRateLimits(const nlohmann::json &root);
+
+    static RateLimits getDefaultRateLimits();
+
+    // "<state>IdleTimeoutSeconds" of the login, menu, room and game states, the defaults for missing or invalid ones
+    static IdleTimeouts loadIdleTimeouts(const nlohmann::json &root);
+
+    static IdleTimeouts getDefaultIdleTimeouts();
+
+    // leaves value as is when key is missing, false when it is there but not a number in [min, max]
+    static bool readUnsignedSetting(const nlohmann::json &root, const char *key, unsigned int &value,
+                                    unsigned int min, unsigned int max);
 };
@@ -0,0 +1,181 @@
+#include "connectionMonitor.h"
+#include <algorithm>
+#include <chrono>
+#include <fmt/format.h>
+
+namespace {
+    constexpr auto TICK = std::chrono::seconds(1);
+}
+
+void ConnectionMonitor::start(const IdleTimeouts &idleTimeouts) {
+    std::lock_guard lock(_timersMutex);
+    _idleTimeouts = idleTimeouts;
+    _isStopping = false;
+    _ticker = std::thread(&ConnectionMonitor::tickLoop);
+}
+
+void ConnectionMonitor::stop() {
+    {
+        std::lock_guard lock(_timersMutex);
+        _isStopping = true;
+    }
+    _stopping.notify_all();
+    if (_ticker.joinable())
+        _ticker.join();
+}
+
+ConnectionMonitor::TimerId ConnectionMonitor::watch(std::function<void()> onIdle) {
+    std::lock_guard lock(_timersMutex);
+    const auto timerId = _nextTimerId++;
+    _timers.emplace(timerId, IdleTimer{std::move(onIdle), ConnectionState::LOGIN, 0, false});
+    return timerId;
+}
+
+void ConnectionMonitor::arm(TimerId timer, ConnectionState state) {
+    std::unique_lock lock(_timersMutex);
+    auto &idleTimer = _timers.at(timer);
+    unlink(timer, idleTimer);
+    if (_isClosing[static_cast<std::size_t>(state)]) {
+        // on the connection's own thread, which is the one to unwatch the timer, so it can't be erased meanwhile
+        idleTimer.state = state;
+        const auto onIdle = idleTimer.onIdle;
+        lock.unlock();
+        onIdle();
+        return;
+    }
+
+    // the current tick is partly over, one more keeps the connection at least its whole timeout
+    const auto timeoutTicks = std::chrono::seconds(_idleTimeouts[static_cast<std::size_t>(state)]) / TICK;
+    idleTimer.state = state;
+    idleTimer.expiresAtTick = _currentTick + static_cast<std::uint64_t>(timeoutTicks) + 1;
+    idleTimer.isArmed = true;
+    _wheel[idleTimer.expiresAtTick % WHEEL_SLOTS_COUNT].insert(timer);
+}
+
+void ConnectionMonitor::disarm(TimerId timer) {
+    std::unique_lock lock(_timersMutex);
+    auto &idleTimer = _timers.at(timer);
+    _callbacksDone.wait(lock, [&idleTimer]() { return !idleTimer.isRunning; });
+    unlink(timer, idleTimer);
+}
+
+void ConnectionMonitor::unwatch(TimerId timer) {
+    // onIdle is either done or won't start once the timer is unlinked with no callback running
+    std::unique_lock lock(_timersMutex);
+    const auto idleTimer = _timers.find(timer);
+    _callbacksDone.wait(lock, [&idleTimer]() { return !idleTimer->second.isRunning; });
+    unlink(timer, idleTimer->second);
+    _timers.erase(idleTimer);
+}
+
+void ConnectionMonitor::closeWaiting(bool isClosingGames) {
+    std::unique_lock lock(_timersMutex);
+    for (std::size_t i = 0; i < CONNECTION_STATES_COUNT; i++)
+        _isClosing[i] = isClosingGames || static_cast<ConnectionState>(i) != ConnectionState::GAME;
+
+    std::vector<TimerId> closedTimers;
+    for (auto &[timerId, timer]: _timers) {
+        if (!timer.isArmed || !_isClosing[static_cast<std::size_t>(timer.state)])
+            continue;
+        unlink(timerId, timer);
+        closedTimers.push_back(timerId);
+    }
+    runIdleCallbacks(lock, closedTimers);
+}
+
+std::size_t ConnectionMonitor::getWatchedCount(bool isCountingGames) {
+    std::lock_guard lock(_timersMutex);
+    return static_cast<std::size_t>(std::count_if(_timers.cbegin(), _timers.cend(), [isCountingGames](const auto &timer) {
+        return isCountingGames || timer.second.state != ConnectionState::GAME;
+    }));
+}
+
+void ConnectionMonitor::recordRtt(std::uint64_t rttUs) {
+    _rtt.record(rttUs);
+}
+
+std::string ConnectionMonitor::report() {
+    std::size_t watchedConnections;
+    IdleTimeouts idleTimeouts{};
+    {
+        std::lock_guard lock(_timersMutex);
+        watchedConnections = _timers.size();
+        idleTimeouts = _idleTimeouts;
+    }
+
+    std::string report = fmt::format("{} connections watched\n{:<8}{:>14}{:>14}\n", watchedConnections, "state",
+                                     "idle timeout", "closed idle");
+    for (std::size_t i = 0; i < CONNECTION_STATES_COUNT; i++) {
+        report += fmt::format("{:<8}{:>13}s{:>14}\n", connectionStateToString(static_cast<ConnectionState>(i)),
+                              idleTimeouts[i], _idleConnections[i].load());
+    }
+    report += fmt::format("round trip: {} pings, p50 {:.1f}ms, p90 {:.1f}ms, p99 {:.1f}ms, max {:.1f}ms\n", _rtt.count(),
+                          static_cast<double>(_rtt.percentile(50)) / 1000.0,
+                          static_cast<double>(_rtt.percentile(90)) / 1000.0,
+                          static_cast<double>(_rtt.percentile(99)) / 1000.0,
+                          static_cast<double>(_rtt.max()) / 1000.0);
+    return report;
+}
+
+void ConnectionMonitor::resetStats() {
+    for (auto &idleConnections: _idleConnections)
+        idleConnections = 0;
+    _rtt.reset();
+}
+
+void ConnectionMonitor::unlink(TimerId timerId, IdleTimer &timer) {
+    if (!timer.isArmed)
+        return;
+
+    _wheel[timer.expiresAtTick % WHEEL_SLOTS_COUNT].erase(timerId);
+    timer.isArmed = false;
+}
+
+void ConnectionMonitor::runIdleCallbacks(std::unique_lock<std::mutex> &lock, const std::vector<TimerId> &timerIds) {
+    if (timerIds.empty())
+        return;
+
+    // copied, _timers may rehash while the lock is released
+    std::vector<std::function<void()>> callbacks;
+    callbacks.reserve(timerIds.size());
+    for (const auto timerId: timerIds) {
+        auto &timer = _timers.at(timerId);
+        timer.isRunning = true;
+        callbacks.push_back(timer.onIdle);
+    }
+
+    lock.unlock();
+    for (const auto &callback: callbacks)
+        callback();
+    lock.lock();
+
+    for (const auto timerId: timerIds)
+        _timers.at(timerId).isRunning = false;
+    _callbacksDone.notify_all();
+}
+
+void ConnectionMonitor::tickLoop() {
+    std::unique_lock lock(_timersMutex);
+    auto nextTick = std::chrono::steady_clock::now() + TICK;
+    while (!_stopping.wait_until(lock, nextTick, []() { return _isStopping; })) {
+        nextTick += TICK;
+        _currentTick++;
+
+        std::vector<TimerId> expiredTimers;
+        // the slot also holds timers of the next turns of the wheel, they stay
+        auto &slot = _wheel[_currentTick % WHEEL_SLOTS_COUNT];
+        for (auto timerId = slot.begin(); timerId != slot.end();) {
+            auto &timer = _timers.at(*timerId);
+            if (timer.expiresAtTick > _currentTick) {
+                ++timerId;
+                continue;
+            }
+
+            expiredTimers.push_back(*timerId);
+            timerId = slot.erase(timerId);
+            timer.isArmed = false;
+            _idleConnections[static_cast<std::size_t>(timer.state)].fetch_add(1, std::memory_order_relaxed);
+        }
+        runIdleCallbacks(lock, expiredTimers);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "../requests/requests.h"
+#include "../../constants.h"
+#include "../metrics/latencyHistogram.h"
+
+// seconds a connection may wait for its next request, by ConnectionState
+using IdleTimeouts = std::array<unsigned int, CONNECTION_STATES_COUNT>;
+
+// detects dead and idle peers. every connection has an idle timer, armed while it waits for a request: a single
+// thread advances a timer wheel (one slot per tick, a timer sits in the slot of its deadline) and runs the callback
+// of the expired timers, which closes their socket. a blocked read then fails as if the peer dropped. the callbacks
+// run without the timers lock, so a slow one doesn't hold up the connections arming and disarming their timers.
+// also keeps the round trip times the clients report with their pings
+class ConnectionMonitor {
+public:
+    ConnectionMonitor() = delete;  // Prevent construction
+    ~ConnectionMonitor() = delete;  // Prevent destruction
+
+    using TimerId = std::uint64_t;
+
+    // before the server accepts clients
+    static void start(const IdleTimeouts &idleTimeouts);
+
+    static void stop();
+
+    // a disarmed timer, onIdle runs on the wheel's thread (or closeWaiting's) and must not block
+    static TimerId watch(std::function<void()> onIdle);
+
+    // (re)starts the timer with the timeout of the state
+    static void arm(TimerId timer, ConnectionState state);
+
+    // waits for a running onIdle of the timer, so the connection's socket is the thread's own once it returns
+    static void disarm(TimerId timer);
+
+    // once it returns, onIdle doesn't run anymore. waits for a running onIdle of the timer
+    static void unwatch(TimerId timer);
+
+    // on shutdown: runs onIdle of the connections waiting for a request now, out of games unless isClosingGames,
+    // and of the others as soon as they wait for their next one
+    static void closeWaiting(bool isClosingGames);
+
+    // by the state they last waited in
+    static std::size_t getWatchedCount(bool isCountingGames);
+
+    static void recordRtt(std::uint64_t rttUs);
+
+    // idle timeouts, the connections closed by them and the reported round trip times
+    static std::string report();
+
+    static void resetStats();
+
+private:
+    struct IdleTimer {
+        std::function<void()> onIdle;
+        ConnectionState state;
+        std::uint64_t expiresAtTick;
+        bool isArmed;
+        bool isRunning = false;     // onIdle was called and hasn't returned yet
+    };
+
+    // takes an armed timer out of its slot, called with _timersMutex held
+    static void unlink(TimerId timerId, IdleTimer &timer);
+
+    // calls onIdle of the timers with the lock released, the lock is held again when it returns
+    static void runIdleCallbacks(std::unique_lock<std::mutex> &lock, const std::vector<TimerId> &timerIds);
+
+    static void tickLoop();
+
+    static constexpr std::size_t WHEEL_SLOTS_COUNT = 512;
+
+    static inline IdleTimeouts _idleTimeouts{DEFAULT_LOGIN_IDLE_TIMEOUT_SECONDS, DEFAULT_MENU_IDLE_TIMEOUT_SECONDS,
+                                             DEFAULT_ROOM_IDLE_TIMEOUT_SECONDS, DEFAULT_GAME_IDLE_TIMEOUT_SECONDS};
+    static inline std::unordered_map<TimerId, IdleTimer> _timers;
+    static inline std::array<std::unordered_set<TimerId>, WHEEL_SLOTS_COUNT> _wheel;   // by expiresAtTick
+    static inline std::uint64_t _currentTick = 0;
+    static inline TimerId _nextTimerId = 0;
+    // a plain mutex, the wheel's thread waits for the next tick on it with a condition variable
+    static inline std::mutex _timersMutex;
+    static inline std::condition_variable _stopping;
+    static inline std::condition_variable _callbacksDone;   // for disarm and unwatch, when an onIdle of their timer runs
+    static inline bool _isStopping = false;
+    static inline std::array<bool, CONNECTION_STATES_COUNT> _isClosing{};   // by closeWaiting
+    static inline std::thread _ticker;
+
+    static inline std::array<std::atomic<std::uint64_t>, CONNECTION_STATES_COUNT> _idleConnections{};
+    static inline LatencyHistogram _rtt;    // us
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string_view>
 #include <vector>
 #include <nlohmann/json.hpp>
 #include "../../managers/roomData.h"
@@ -14,17 +15,83 @@ public:
     ConversionHelper() = delete;  // Prevent construction
     ~ConversionHelper() = delete;  // Prevent destruction
 
-    static std::vector<unsigned char> jsonToSizeBytes(const Json &json);
+    static std::vector<unsigned char> sizeToBytes(std::size_t payloadSize);
 
-    static Json roomDataToJson(const RoomDataResponse &roomData);
+    static std::string avatarColorToString(const uint8_t &avatarColorNumber);
 
-    static Json playerToJson(const Player &player);
+    // the writers below take a JsonWriter or a JsonDomWriter, fields are written in sorted key order
 
-    static Json playerStatsToJson(const UserStatistics &playerStats);
+    template<typename Writer>
+    static void writeRoomData(Writer &writer, const RoomDataResponse &roomData) {
+        writer.beginObject();
+        writer.field("id", roomData.roomData.uuid);
+        writer.field("isActive", roomData.roomData.isActive);
+        writer.field("isFinished", roomData.isFinished);
+        writer.field("maxPlayers", roomData.roomData.maxPlayers);
+        writer.field("name", roomData.roomData.name);
+        writePlayers(writer, "players", roomData.players);
+        writer.field("questionCount", roomData.roomData.questionCount);
+        writer.field("timePerQuestion", roomData.roomData.timePerQuestion);
+        writer.endObject();
+    }
 
-    static std::string avatarColorToString(const uint8_t &avatarColorNumber);
+    template<typename Writer>
+    static void writePlayer(Writer &writer, const Player &player) {
+        writer.beginObject();
+        writer.field("avatarColor", player.avatar_color);
+        writer.field("score", player.score);
+        writer.field("username", player.username);
+        writer.endObject();
+    }
+
+    template<typename Writer>
+    static void writePlayers(Writer &writer, std::string_view key, const std::vector<Player> &players) {
+        writer.beginArray(key);
+        for (const auto &player: players)
+            writePlayer(writer, player);
+        writer.endArray();
+    }
+
+    template<typename Writer>
+    static void writePlayerStats(Writer &writer, std::string_view key, const UserStatistics &playerStats) {
+        writer.beginObject(key);
+        if (playerStats.averageAnswerTime.has_value())
+            writer.field("avgAnswerTime", playerStats.averageAnswerTime.value());
+        else
+            writer.nullField("avgAnswerTime");
+        writer.field("correctAnswers", playerStats.numOfCorrectAnswers);
+        writer.field("score", playerStats.userScore);
+        writer.field("totalAnswers", playerStats.numOfTotalAnswers);
+        writer.field("totalGames", playerStats.numOfTotalGames);
+        writer.field("wrongAnswers", playerStats.numOfWrongAnswers);
+        writer.endObject();
+    }
 
-    static Json playerResultToJson(const PlayerResult &playerResult);
+    template<typename Writer>
+    static void writePlayerResult(Writer &writer, const PlayerResult &playerResult) {
+        writer.beginObject();
+        writer.field("avatarColor", playerResult.avatar_color);
+        writer.field("avgAnswerTime", playerResult.avgAnswerTime);
+        writer.field("correctAnswerCount", playerResult.correctAnswerCount);
+        writer.field("isOnline", playerResult.isOnline);
+        writer.field("scoreChange", playerResult.scoreChange);
+        writer.field("username", playerResult.username);
+        writer.field("wrongAnswerCount", playerResult.wrongAnswerCount);
+        writer.endObject();
+    }
 
-    static Json userAnswerToJson(const std::pair<Question, std::pair<unsigned int, unsigned int>> &userAnswer);
+    template<typename Writer>
+    static void writeUserAnswer(Writer &writer,
+                                const std::pair<Question, std::pair<unsigned int, unsigned int>> &userAnswer) {
+        writer.beginObject();
+        writer.beginArray("answers");
+        for (const auto &answer: userAnswer.first.getPossibleAnswers())
+            writer.value(answer);
+        writer.endArray();
+        writer.field("correctAnswer", userAnswer.first.getCorrectAnswerIndex());
+        writer.field("question", userAnswer.first.getQuestion());
+        writer.field("timeTaken", userAnswer.second.second);
+        writer.field("userAnswer", userAnswer.second.first);
+        writer.endObject();
+    }
 };
\ No newline at end of file
@@ -15,8 +15,8 @@ public:
 
     [[nodiscard]] virtual Result<bool> doesUserExist(const std::string &username) const = 0;
 
-    [[nodiscard]] virtual Result<bool>
-    doesPasswordMatch(const std::string &userName, const std::string &password) const = 0;
+    // NotFound when there is no such user
+    [[nodiscard]] virtual Result<UserCredentials> getUserCredentials(const std::string &username) const = 0;
 
     virtual std::optional<Error>
     addUser(const std::string &userName, const std::string &password, const std::string &email,
@@ -33,9 +33,16 @@ public:
     [[nodiscard]] virtual Result<UserData> getUserData(const std::string& username) const = 0;
     [[nodiscard]] virtual std::optional<Error> updateUser(const UpdateUserDataRequest& user, const std::string& username) = 0;
     [[nodiscard]] virtual Result<Player> getPlayerByName(const std::string& username) const = 0;
+    // in the order of usernames, NotFound if any of them is missing
+    [[nodiscard]] virtual Result<std::vector<Player>> getPlayersByNames(const std::vector<std::string>& usernames) const = 0;
 
-    [[nodiscard]] virtual std::optional<Error> submitGameStatistics(const GameData& gameData, const std::string &user) = 0;
+    // adds the game to the user's statistics once, submitting the same game again for the user does nothing. so the
+    // games replayed from the journal after a crash aren't counted twice
+    [[nodiscard]] virtual std::optional<Error> submitGameStatistics(const GameData& gameData, const std::string &gameId,
+                                                                    const std::string &user) = 0;
 
     [[nodiscard]] virtual std::optional<Error> removeUser(const std::string& username) = 0;
-    [[nodiscard]] virtual Result<std::string> getUserPasswordByEmail(const std::string& email) = 0;
+    // the password column holds a PasswordHasher hash, NotFound when there is no such user
+    [[nodiscard]] virtual std::optional<Error> updateUserPassword(unsigned int userId, const std::string& passwordHash) = 0;
+    [[nodiscard]] virtual std::optional<Error> updateUserPasswordByEmail(const std::string& email, const std::string& passwordHash) = 0;
 };
\ No newline at end of file
@@ -26,3 +26,9 @@ struct User {
     uint8_t avatar_color;
     time_t member_since;
 };
+
+// the part of a user's row a login checks
+struct UserCredentials {
+    unsigned int id = 0;
+    std::string password;
+};
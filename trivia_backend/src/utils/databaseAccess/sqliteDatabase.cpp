@@ -1,11 +1,23 @@
 #include "sqliteDatabase.h"
+#include <unordered_map>
+#include <sqlite3.h>
 #include "../questionsFetcher/questionsFetcher.h"
+#include "../tracer/tracer.h"
 
 using namespace sqlite_orm;
 
-SqliteDatabase::SqliteDatabase() {
+SqliteDatabase::SqliteDatabase(const std::string &filePath) : _db(create_tables_storage(filePath)) {
+    // during a handoff both servers write: readers don't block the writer in WAL mode, and a write waits for the
+    // other's instead of failing with SQLITE_BUSY
+    _db.on_open = [](sqlite3 *db) {
+        sqlite3_busy_timeout(db, DATABASE_BUSY_TIMEOUT_MS);
+        sqlite3_exec(db, "PRAGMA journal_mode=WAL", nullptr, nullptr, nullptr);
+    };
+
     try {
-        std::lock_guard guard(_dbMutex);
+        const auto guard = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
+        _db.open_forever(); // on_open runs once, not on every query
         _db.sync_schema();  // sync schema and create tables if they don't exist
     } catch (const std::exception &e) {
         return;
@@ -18,7 +30,8 @@ SqliteDatabase::SqliteDatabase() {
     if (questionsCount.value() >= MIN_QUESTIONS_COUNT)
         return;
 
-    const auto questions = QuestionsFetcher::fetchQuestions(MIN_QUESTIONS_COUNT - questionsCount.value());
+    const auto questions = QuestionsFetcher::fetchQuestions(MIN_QUESTIONS_COUNT - questionsCount.value(),
+                                                            questionsCount.value());
 
     if (questions.isError())
         return;
@@ -29,7 +42,8 @@ SqliteDatabase::SqliteDatabase() {
 
 SqliteDatabase::~SqliteDatabase() {
     try {
-        std::lock_guard guard(_dbMutex);
+        const auto guard = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
         _db.sync_schema();  // save all changes to disk before exiting
     } catch (const std::exception &e) {
         return;
@@ -37,9 +51,16 @@ SqliteDatabase::~SqliteDatabase() {
 }
 
 
+std::unique_lock<ProfiledMutex> SqliteDatabase::lockDatabase() const {
+    // traced separately from the query itself, so lock contention is visible in the timeline
+    const TraceSpan span("sqlite", "_dbMutex wait");
+    return std::unique_lock(_dbMutex);
+}
+
 Result<bool> SqliteDatabase::doesUserExist(const std::string &username) const {
     try {
-        std::lock_guard sharedLock(_dbMutex);
+        const auto sharedLock = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
         const auto users = _db.select(&User::id, where(c(&User::username) == username));
         return !users.empty();
     } catch (const std::exception &e) {
@@ -48,18 +69,24 @@ Result<bool> SqliteDatabase::doesUserExist(const std::string &username) const {
 }
 
 
-Result<bool> SqliteDatabase::doesPasswordMatch(const std::string &userName, const std::string &password) const {
-    const auto user = getUser(userName);
-
-    if (user.isError())
-        return user.error();
-
-    return user.value().password == password;
+Result<UserCredentials> SqliteDatabase::getUserCredentials(const std::string &username) const {
+    try {
+        const auto sharedLock = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
+        const auto credentials = _db.select(columns(&User::id, &User::password),
+                                            where(c(&User::username) == username), limit(1));
+        if (credentials.empty())
+            return Error(ErrorType::NotFound, "User not found");
+        return UserCredentials{get<0>(credentials.front()), get<1>(credentials.front())};
+    } catch (const std::exception &e) {
+        return Error(ErrorType::Database, "Failed to get User credentials");
+    }
 }
 
 Result<User> SqliteDatabase::getUser(const std::string &username) const {
     try {
-        std::lock_guard sharedLock(_dbMutex);
+        const auto sharedLock = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
         const auto user = _db.get_all<User>(where(c(&User::username) == username), limit(1));
         if (user.empty())
             return Error(ErrorType::NotFound, "User not found");
@@ -83,39 +110,46 @@ SqliteDatabase::addUser(const std::string &userName, const std::string &password
     user.avatar_color = (uint8_t) avatarColor;
     user.member_since = std::time(nullptr);
 
-    const auto doesUserExistRes = doesUserExist(userName);
+    // the UNIQUE username and email columns do the existence checks, in the same insert
+    {
+        const auto guard = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
+        try {
+            _db.begin_transaction();  // start transaction
+            unsigned int id = _db.insert(user);   // insert new User
+            _db.insert(Statistics{id, 0,0,0,0}); // insert new Statistics
+            _db.commit();         // commit transaction
+            return std::nullopt;
+        } catch (const std::system_error &e) {
+            _db.rollback();  // rollback transaction (if user was inserted and statistics was not inserted)
+            const std::string message = e.what();
+            if ((e.code().value() & 0xff) != SQLITE_CONSTRAINT)
+                return Error(ErrorType::Database, "Could not add User to database");
+            if (message.find("users.username") != std::string::npos)
+                return Error(ErrorType::AlreadyExists, "User already exists");
+            if (message.find("users.email") == std::string::npos)
+                return Error(ErrorType::Database, "Could not add User to database");
+        } catch (const std::exception &e) {
+            _db.rollback();
+            return Error(ErrorType::Database, "Could not add User to database");
+        }
+    }
 
+    // sqlite reports the email before the username when both are taken, a taken username is still reported first
+    const auto doesUserExistRes = doesUserExist(userName);
     if (doesUserExistRes.isError())
         return doesUserExistRes.error();
 
     if (doesUserExistRes.value())
         return Error(ErrorType::AlreadyExists, "User already exists");
 
-    const auto doesEmailExistRes = doesEmailExist(email);
-    if (doesEmailExistRes.isError())
-        return doesEmailExistRes.error();
-
-    if (doesEmailExistRes.value())
-        return Error(ErrorType::AlreadyExists, "Email already taken");
-
-
-    std::lock_guard guard(_dbMutex);
-    try {
-        _db.begin_transaction();  // start transaction
-        unsigned int id = _db.insert(user);   // insert new User
-        _db.insert(Statistics{id, 0,0,0,0}); // insert new Statistics
-        _db.commit();         // commit transaction
-        _db.sync_schema();     // save all changes to disk
-        return std::nullopt;
-    } catch (const std::exception &e) {
-        _db.rollback();  // rollback transaction (if user was inserted and statistics was not inserted)
-        return Error(ErrorType::Database, "Could not add User to database");
-    }
+    return Error(ErrorType::AlreadyExists, "Email already taken");
 }
 
 Result<bool> SqliteDatabase::doesEmailExist(const std::string &email) const {
     try {
-        std::lock_guard sharedLock(_dbMutex);
+        const auto sharedLock = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
         const auto usersWithEmail = _db.select(&User::id, where(c(&User::email) == email));
         return !usersWithEmail.empty();
     } catch (const std::exception &e) {
@@ -133,7 +167,8 @@ Result<std::list<QuestionDb>> SqliteDatabase::getQuestions(unsigned int amount)
     // always make sure that there are at least 20 questions more than amount to ensure randomness
     if (amount <= questionsCount.value() - minExtraQuestions) {
         try {
-            std::lock_guard sharedLock(_dbMutex);
+            const auto sharedLock = lockDatabase();
+            const TraceSpan querySpan("sqlite", __func__);
             const auto questions = _db.get_all<QuestionDb>(order_by(sqlite_orm::random()), limit(amount));
             if (questions.size() != amount)
                 return Error(ErrorType::Database, "Failed to get questions");
@@ -146,7 +181,7 @@ Result<std::list<QuestionDb>> SqliteDatabase::getQuestions(unsigned int amount)
 
     // if there are not enough questions in the database
     const unsigned int questionsToAdd = amount - (questionsCount.value() - minExtraQuestions);
-    const auto questions = QuestionsFetcher::fetchQuestions(questionsToAdd);  // +10 extra questions
+    const auto questions = QuestionsFetcher::fetchQuestions(questionsToAdd, questionsCount.value());
     if (questions.isError())
         return questions.error();
 
@@ -156,7 +191,8 @@ Result<std::list<QuestionDb>> SqliteDatabase::getQuestions(unsigned int amount)
     // try one more time to get enough questions
     // this function could have been recursively called, but to ensure fast responses we try just one more time
     try {
-        std::lock_guard sharedLock(_dbMutex);
+        const auto sharedLock = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
         const auto random_questions = _db.get_all<QuestionDb>(order_by(sqlite_orm::random()), limit(amount));
         if (random_questions.size() != amount)
             return Error(ErrorType::Database, "Failed to get questions");
@@ -169,7 +205,8 @@ Result<std::list<QuestionDb>> SqliteDatabase::getQuestions(unsigned int amount)
 
 Result<unsigned int> SqliteDatabase::getQuestionsCount() const {
     try {
-        std::lock_guard sharedLock(_dbMutex);
+        const auto sharedLock = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
         return static_cast<unsigned int>(_db.count(&QuestionDb::id));
     } catch (const std::exception &e) {
         return Error(ErrorType::Database, "Failed to get questions count");
@@ -178,7 +215,8 @@ Result<unsigned int> SqliteDatabase::getQuestionsCount() const {
 
 std::optional<Error> SqliteDatabase::addQuestion(const QuestionDb &question) {
     try {
-        std::lock_guard guard(_dbMutex);
+        const auto guard = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
         _db.insert(question);
         _db.sync_schema();
         return std::nullopt;
@@ -190,7 +228,8 @@ std::optional<Error> SqliteDatabase::addQuestion(const QuestionDb &question) {
 
 Result<std::vector<Player>> SqliteDatabase::getHighScores() const {
     try {
-        std::lock_guard sharedLock(_dbMutex);
+        const auto sharedLock = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
 
         // Retrieve all usernames
         const auto players = _db.select(columns(&User::username, &User::avatar_color, &Statistics::score),
@@ -254,7 +293,8 @@ std::optional<Error> SqliteDatabase::updateUser(const UpdateUserDataRequest &use
     };
 
     try {
-        std::lock_guard guard(_dbMutex);
+        const auto guard = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
         update_user_data();
         _db.sync_schema();
     } catch (const std::exception &e) {
@@ -266,7 +306,8 @@ std::optional<Error> SqliteDatabase::updateUser(const UpdateUserDataRequest &use
 
 Result<UserData> SqliteDatabase::getUserData(const std::string &username) const {
     try {
-        std::lock_guard sharedLock(_dbMutex);
+        const auto sharedLock = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
         const auto userRes = _db.select(columns(&User::username, &User::email, &User::address, &User::phone_number,
                                                 &User::birthday, &User::avatar_color, &User::member_since),
                                         where(c(&User::username) == username));
@@ -287,7 +328,8 @@ Result<Player> SqliteDatabase::getPlayerByName(const std::string &username) cons
     if (user.isError())
         return user.error();
     try {
-        std::lock_guard sharedLock(_dbMutex);
+        const auto sharedLock = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
         const auto playerRes = _db.select(columns(&User::username, &User::avatar_color, &Statistics::score),
                                           inner_join<Statistics>(on(c(&Statistics::user_id) == &User::id)),
                                           where(c(&User::id) == user.value().id), limit(1));
@@ -303,9 +345,41 @@ Result<Player> SqliteDatabase::getPlayerByName(const std::string &username) cons
     }
 }
 
+Result<std::vector<Player>> SqliteDatabase::getPlayersByNames(const std::vector<std::string> &usernames) const {
+    try {
+        const auto sharedLock = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
+        const auto playersRes = _db.select(columns(&User::username, &User::avatar_color, &Statistics::score),
+                                           inner_join<Statistics>(on(c(&Statistics::user_id) == &User::id)),
+                                           where(in(&User::username, usernames)));
+
+        std::unordered_map<std::string, Player> playersByName;
+        for (const auto &player: playersRes) {
+            const auto colorName = ConversionHelper::avatarColorToString(get<1>(player));
+            playersByName.emplace(get<0>(player), Player{get<0>(player), colorName, get<2>(player)});
+        }
+
+        // the rows come in the table's order
+        std::vector<Player> players;
+        players.reserve(usernames.size());
+        for (const auto &username: usernames) {
+            const auto player = playersByName.find(username);
+            if (player == playersByName.end())
+                return Error(ErrorType::NotFound, "Player not found");
+
+            players.push_back(player->second);
+        }
+        return players;
+
+    } catch (const std::exception &e) {
+        return Error(ErrorType::Database, "Failed to get players by names");
+    }
+}
+
 Result<std::pair<unsigned int, UserStatistics>> SqliteDatabase::getUserStatistics(const std::string &username) const {
     try {
-        std::lock_guard sharedLock(_dbMutex);
+        const auto sharedLock = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
         const auto &userStatsRes = _db.select(
                 columns(&Statistics::total_games, &Statistics::correct_answers, &Statistics::wrong_answers,
                         &Statistics::avg_answer_time, &Statistics::score, &User::id),
@@ -328,7 +402,7 @@ Result<std::pair<unsigned int, UserStatistics>> SqliteDatabase::getUserStatistic
 }
 
 std::optional<Error>
-SqliteDatabase::submitGameStatistics(const GameData &gameData,
+SqliteDatabase::submitGameStatistics(const GameData &gameData, const std::string &gameId,
                                      const std::string &user) {
     const auto userStats = getUserStatistics(user);
     if (userStats.isError())
@@ -352,9 +426,18 @@ SqliteDatabase::submitGameStatistics(const GameData &gameData,
     if ((static_cast<long long int>(userStats.value().second.userScore) + scoreChange) >= 0)
         newScore = static_cast<unsigned int>(userStats.value().second.userScore + scoreChange);
 
+    const auto guard = lockDatabase();
+    const TraceSpan querySpan("sqlite", __func__);
     try {
-        std::lock_guard guard(_dbMutex);
+        // the game is recorded in the same transaction, so it is either counted and recorded or neither
+        _db.begin_transaction();
+        if (_db.count<SubmittedGame>(where(c(&SubmittedGame::game_id) == gameId &&
+                                           c(&SubmittedGame::user_id) == userStats.value().first)) > 0) {
+            _db.rollback();
+            return std::nullopt;    // submitted already, before the server crashed
+        }
 
+        _db.replace(SubmittedGame{gameId, userStats.value().first});
         _db.update_all(set(c(&Statistics::total_games) = userStats.value().second.numOfTotalGames + 1,
                            c(&Statistics::correct_answers) =
                                    userStats.value().second.numOfCorrectAnswers + gameData.getNumOfCorrectAnswers(),
@@ -364,9 +447,10 @@ SqliteDatabase::submitGameStatistics(const GameData &gameData,
                                    avgAnswerTime,
                            c(&Statistics::score) = newScore),
                        where(c(&Statistics::user_id) == userStats.value().first));
-        _db.sync_schema();
+        _db.commit();
     }
     catch (const std::exception &e) {
+        _db.rollback();
         return Error(ErrorType::Database, "Failed to submit game statistics");
     }
     return std::nullopt;
@@ -375,7 +459,8 @@ SqliteDatabase::submitGameStatistics(const GameData &gameData,
 std::optional<Error> SqliteDatabase::removeUser(const std::string &username) {
     const auto user = getUser(username);
     try {
-        std::lock_guard guard(_dbMutex);
+        const auto guard = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
         _db.remove<User>(user.value().id);
         _db.sync_schema();
         return std::nullopt;
@@ -385,15 +470,29 @@ std::optional<Error> SqliteDatabase::removeUser(const std::string &username) {
     }
 }
 
-Result<std::string> SqliteDatabase::getUserPasswordByEmail(const std::string &email) {
+std::optional<Error> SqliteDatabase::updateUserPassword(unsigned int userId, const std::string &passwordHash) {
     try {
-        std::lock_guard guard(_dbMutex);
-        const auto user = _db.get_all<User>(where(c(&User::email) == email), limit(1));
-        if (user.empty())
+        const auto guard = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
+        _db.update_all(set(c(&User::password) = passwordHash), where(c(&User::id) == userId));
+        return std::nullopt;
+    } catch (const std::exception &e) {
+        return Error(ErrorType::Database, "Failed to update user password");
+    }
+}
+
+std::optional<Error> SqliteDatabase::updateUserPasswordByEmail(const std::string &email, const std::string &passwordHash) {
+    try {
+        const auto guard = lockDatabase();
+        const TraceSpan querySpan("sqlite", __func__);
+        const auto userIds = _db.select(&User::id, where(c(&User::email) == email), limit(1));
+        if (userIds.empty())
             return Error(ErrorType::NotFound, "User not found");
-        return user.front().password;
+
+        _db.update_all(set(c(&User::password) = passwordHash), where(c(&User::id) == userIds.front()));
+        return std::nullopt;
     } catch (const std::exception &e) {
-        return Error(ErrorType::Database, "Failed to get user password");
+        return Error(ErrorType::Database, "Failed to update user password");
     }
 }
 
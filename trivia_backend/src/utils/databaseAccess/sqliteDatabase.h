@@ -6,6 +6,7 @@
 #include "IDatabasae.h"
 #include "../../constants.h"
 #include "User.h"
+#include "../lockProfiler/lockProfiler.h"
 
 
 struct Statistics {
@@ -17,6 +18,12 @@ struct Statistics {
     unsigned int score;              // total score the User achieved
 };
 
+// a game whose statistics were added to the User's, so a game is never counted twice for the same User
+struct SubmittedGame {
+    std::string game_id;             // the uuid of the game's room
+    unsigned int user_id;            // foreign key to User
+};
+
 inline auto create_tables_storage(const std::string &db_name) {
     return sqlite_orm::make_storage(db_name,
                         sqlite_orm::make_table("users",
@@ -48,6 +55,13 @@ inline auto create_tables_storage(const std::string &db_name) {
                                                 sqlite_orm::make_column("total_games", &Statistics::total_games),
                                                 sqlite_orm::make_column("score", &Statistics::score),
                                                 sqlite_orm::foreign_key(&Statistics::user_id).references(&User::id).on_delete.cascade()
+                                                ),
+
+                        sqlite_orm::make_table("submitted_games",
+                                                sqlite_orm::make_column("game_id", &SubmittedGame::game_id),
+                                                sqlite_orm::make_column("user_id", &SubmittedGame::user_id),
+                                                sqlite_orm::primary_key(&SubmittedGame::game_id, &SubmittedGame::user_id),
+                                                sqlite_orm::foreign_key(&SubmittedGame::user_id).references(&User::id).on_delete.cascade()
                                                 )
     );
 }
@@ -58,11 +72,11 @@ using DB = decltype(create_tables_storage(""));
 class SqliteDatabase : public IDatabase
 {
 public:
-    SqliteDatabase();
+    explicit SqliteDatabase(const std::string &filePath = DATABASE_FILE_PATH);
     ~SqliteDatabase() override;
 
     Result<bool> doesUserExist(const std::string& username) const override;
-    Result<bool> doesPasswordMatch(const std::string& userName, const std::string& password) const override;
+    Result<UserCredentials> getUserCredentials(const std::string& username) const override;
     std::optional<Error> addUser(const std::string& userName, const std::string& password, const std::string& email, const std::string& address, const std::string& phoneNumber, const std::string& birthday, const AvatarColor& avatarColor) override;
     Result<bool> doesEmailExist(const std::string& email) const override;
 
@@ -72,18 +86,21 @@ public:
     Result<UserData> getUserData(const std::string& username) const override;
     std::optional<Error> updateUser(const UpdateUserDataRequest& userData, const std::string& username) override;
     Result<Player> getPlayerByName(const std::string& username) const override;
-    std::optional<Error> submitGameStatistics(const GameData& gameData, const std::string &user) override;
+    Result<std::vector<Player>> getPlayersByNames(const std::vector<std::string>& usernames) const override;
+    std::optional<Error> submitGameStatistics(const GameData& gameData, const std::string &gameId, const std::string &user) override;
 
     std::optional<Error> removeUser(const std::string &username) override;
-    Result<std::string> getUserPasswordByEmail(const std::string &email) override;
+    std::optional<Error> updateUserPassword(unsigned int userId, const std::string &passwordHash) override;
+    std::optional<Error> updateUserPasswordByEmail(const std::string &email, const std::string &passwordHash) override;
 private:
     // helper functions
     Result<unsigned int> getQuestionsCount() const;
     std::optional<Error> addQuestion(const QuestionDb& question);
     Result<User> getUser(const std::string& username) const;
+    std::unique_lock<ProfiledMutex> lockDatabase() const;
 
     // member variables
-    mutable DB _db = create_tables_storage(DATABASE_FILE_PATH);
-    mutable std::mutex _dbMutex;
+    mutable DB _db;
+    mutable ProfiledMutex _dbMutex{"SqliteDatabase::_dbMutex"};
 
 };
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "emailSender.h"
 #include <httplib.h>
+#include "../../constants.h"
+#include "../passwordHasher/passwordHasher.h"
 
 std::string EmailSender::createEmailVerificationHtml(const std::string &verificationCode, const std::string &username) {
     return "<!DOCTYPE html>\n"
@@ -82,6 +84,9 @@ std::string EmailSender::createEmailVerificationHtml(const std::string &verifica
 
 
 std::optional<Error> EmailSender::sendEmailVerification(const std::string& recipientEmail, const std::string& verificationCode, const std::string& username) {
+    if (_useStandIn)
+        return std::nullopt;
+
     httplib::Result res;
     try {
         // Create a client and Authenticate with Basic Auth (apiKey:secretKey)
@@ -134,6 +139,9 @@ Json EmailSender::serializeVerificationEmailPayload(const std::string &recipient
 }
 
 std::string EmailSender::generateRandom6DigitCode() {
+    if (_useStandIn)
+        return STAND_IN_VERIFICATION_CODE;
+
     std::random_device rd;  // Obtain a random number from hardware
     std::mt19937 gen(rd()); // Seed the generator
     std::uniform_int_distribution dis(0, 999999); // Define the range
@@ -146,8 +154,16 @@ std::string EmailSender::generateRandom6DigitCode() {
     return ss.str();
 }
 
+std::string EmailSender::generatePasswordResetCode() {
+    // random with the stand-in too, a known code would let anyone reset any password
+    return PasswordHasher::generatePassword(PASSWORD_RESET_CODE_LENGTH);
+}
+
 std::optional<Error>
-EmailSender::sendEmailPasswordRecovery(const std::string &recipientEmail, const std::string &password) {
+EmailSender::sendEmailPasswordRecovery(const std::string &recipientEmail, const std::string &resetCode) {
+    if (_useStandIn)
+        return std::nullopt;
+
     httplib::Result res;
     try {
         // Create a client and Authenticate with Basic Auth (apiKey:secretKey)
@@ -155,7 +171,7 @@ EmailSender::sendEmailPasswordRecovery(const std::string &recipientEmail, const
         client.set_basic_auth(std::getenv("MAILJET_APIKEY"), std::getenv("MAILJET_SECRETKEY"));
 
         // Send the request
-        res = client.Post(MAIL_JET_SEND_PATH, serializePasswordRecoveryEmailPayload(recipientEmail, password).dump(), "application/json");
+        res = client.Post(MAIL_JET_SEND_PATH, serializePasswordRecoveryEmailPayload(recipientEmail, resetCode).dump(), "application/json");
     } catch (const std::exception& e) {
         return Error("Error occurred while sending email" + std::string(e.what()));
     }
@@ -179,7 +195,7 @@ EmailSender::sendEmailPasswordRecovery(const std::string &recipientEmail, const
     }
 }
 
-std::string EmailSender::createEmailPasswordRecoveryHtml(const std::string &password) {
+std::string EmailSender::createEmailPasswordRecoveryHtml(const std::string &resetCode) {
     return "<!DOCTYPE html>\n"
            "<html lang=\"en\">\n"
            "<head>\n"
@@ -236,8 +252,8 @@ std::string EmailSender::createEmailPasswordRecoveryHtml(const std::string &pass
            "<body>\n"
            "    <div class=\"container\">\n"
            "        <h2>Password Recovery</h2>\n"
-           "        <p>It looks like you requested to recover your password. Please find your password below.</p>\n"
-           "        <div class=\"recovery-password\">" + password + "</div>\n"
+           "        <p>It looks like you requested to recover your password. Enter the code below in the game to choose a new password, it expires in 15 minutes. Your current password keeps working until then.</p>\n"
+           "        <div class=\"recovery-password\">" + resetCode + "</div>\n"
                                                                             "        <p>If you did not request this, please contact our support team immediately.</p>\n"
                                                                             "        <div class=\"footer\">\n"
                                                                             "            Thank you,<br>\n"
@@ -248,7 +264,7 @@ std::string EmailSender::createEmailPasswordRecoveryHtml(const std::string &pass
                                                                             "</html>";
 }
 
-Json EmailSender::serializePasswordRecoveryEmailPayload(const std::string &recipientEmail, const std::string &password) {
+Json EmailSender::serializePasswordRecoveryEmailPayload(const std::string &recipientEmail, const std::string &resetCode) {
     Json payload;
     payload["Messages"] = Json::array();
     Json message;
@@ -260,7 +276,7 @@ Json EmailSender::serializePasswordRecoveryEmailPayload(const std::string &recip
     message["To"][0]["Email"] = recipientEmail;
     message["To"][0]["Name"] ="";
     message["Subject"] = "Password Recovery for Trivia Magshimim";
-    message["HTMLPart"] = createEmailPasswordRecoveryHtml(password);
+    message["HTMLPart"] = createEmailPasswordRecoveryHtml(resetCode);
     payload["Messages"].push_back(message);
 
     return payload;
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <optional>
+#include <atomic>
 #include "../../errors/error.h"
 #include <nlohmann/json.hpp>
 
@@ -13,11 +14,19 @@ public:
     ~EmailSender() = delete;
 
     static std::optional<Error> sendEmailVerification(const std::string& recipientEmail, const std::string& verificationCode, const std::string& username);
-    static std::optional<Error> sendEmailPasswordRecovery(const std::string& recipientEmail, const std::string& password);
+    static std::optional<Error> sendEmailPasswordRecovery(const std::string& recipientEmail, const std::string& resetCode);
     static std::string generateRandom6DigitCode();
+    // for RESET_PASSWORD_REQUEST, PASSWORD_RESET_CODE_LENGTH letters and digits
+    static std::string generatePasswordResetCode();
+
+    // the stand-in sends nothing and always hands out STAND_IN_VERIFICATION_CODE. the reset codes stay random, so
+    // with the stand-in a password can't be reset
+    static void setUseStandIn(bool useStandIn) { _useStandIn = useStandIn; }
 private:
     static std::string createEmailVerificationHtml(const std::string & verificationCode, const std::string& username);
-    static std::string createEmailPasswordRecoveryHtml(const std::string & password);
-    static Json serializePasswordRecoveryEmailPayload(const std::string& recipientEmail, const std::string& password);
+    static std::string createEmailPasswordRecoveryHtml(const std::string & resetCode);
+    static Json serializePasswordRecoveryEmailPayload(const std::string& recipientEmail, const std::string& resetCode);
     static Json serializeVerificationEmailPayload(const std::string& recipientEmail, const std::string& verificationCode, const std::string& username);
+
+    static inline std::atomic<bool> _useStandIn{false};
 };
\ No newline at end of file
@@ -0,0 +1,490 @@
+#include "gameJournal.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <fmt/format.h>
+#include "../../constants.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr std::size_t RECORD_HEADER_SIZE = 9;   // length, CRC32 and type
+
+    constexpr std::array<std::uint32_t, 256> CRC32_TABLE = [] {
+        std::array<std::uint32_t, 256> table{};
+        for (std::uint32_t i = 0; i < 256; i++) {
+            std::uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc & 1) != 0 ? 0xEDB88320 ^ (crc >> 1) : crc >> 1;
+            table[i] = crc;
+        }
+        return table;
+    }();
+
+    // CRC-32 (IEEE), the one of zlib
+    std::uint32_t crc32(const unsigned char *data, std::size_t size) {
+        std::uint32_t crc = 0xFFFFFFFF;
+        for (std::size_t i = 0; i < size; i++)
+            crc = CRC32_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return crc ^ 0xFFFFFFFF;
+    }
+
+    void writeBigEndian(std::vector<unsigned char> &buffer, std::uint64_t value, unsigned int bytesCount) {
+        for (int i = static_cast<int>(bytesCount) - 1; i >= 0; i--)
+            buffer.push_back(static_cast<unsigned char>((value >> (i * 8)) & 0xFF));
+    }
+
+    void writeString(std::vector<unsigned char> &buffer, const std::string &value) {
+        const auto size = std::min<std::size_t>(value.size(), UINT16_MAX);
+        writeBigEndian(buffer, size, 2);
+        buffer.insert(buffer.end(), value.begin(), value.begin() + static_cast<std::ptrdiff_t>(size));
+    }
+
+    std::uint64_t readBigEndian(const unsigned char *data, unsigned int bytesCount) {
+        std::uint64_t value = 0;
+        for (unsigned int i = 0; i < bytesCount; i++)
+            value = value << 8 | data[i];
+        return value;
+    }
+
+    // reads the fields of one record's payload, isValid turns false when one is cut
+    class PayloadReader {
+    public:
+        PayloadReader(const unsigned char *data, std::size_t size) : _data(data), _size(size) {}
+
+        std::uint64_t readNumber(unsigned int bytesCount) {
+            if (!isValid || _size - _position < bytesCount) {
+                isValid = false;
+                return 0;
+            }
+            const auto value = readBigEndian(_data + _position, bytesCount);
+            _position += bytesCount;
+            return value;
+        }
+
+        std::string readString() {
+            const auto size = static_cast<std::size_t>(readNumber(2));
+            if (!isValid || _size - _position < size) {
+                isValid = false;
+                return {};
+            }
+            std::string value(reinterpret_cast<const char *>(_data + _position), size);
+            _position += size;
+            return value;
+        }
+
+        bool isValid = true;
+
+    private:
+        const unsigned char *_data;
+        std::size_t _size;
+        std::size_t _position = 0;
+    };
+
+    std::uint64_t microsecondsSince(const std::chrono::steady_clock::time_point &start) {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+std::optional<Error> GameJournal::start(const std::string &filePath, std::chrono::milliseconds syncInterval,
+                                        bool isTakingOver) {
+    std::lock_guard lock(_pendingMutex);
+    if (_isRunning)
+        return Error(ErrorType::AlreadyExists, "The game journal is already started");
+
+    // the server this one took over from is still draining with its journal there
+    const auto drainingPath = filePath + GAME_JOURNAL_DRAINING_SUFFIX;
+    std::vector<unsigned char> records;
+    bool isTailDropped = false;
+    if (!isTakingOver) {
+        const auto drainingRecords = readRecords(drainingPath, isTailDropped);
+        if (drainingRecords.isError())
+            return drainingRecords.error();
+        records = drainingRecords.value();
+    }
+
+    const auto ownRecords = readRecords(filePath, isTailDropped);
+    if (ownRecords.isError())
+        return ownRecords.error();
+    const auto &ownRecordsValue = ownRecords.value();
+    records.insert(records.end(), ownRecordsValue.begin(), ownRecordsValue.end());
+
+    std::map<std::string, ReplayedGame> games;
+    replay(records, games);
+
+    // both journals are merged into a new one without the dropped tail, appending after a torn record would hide
+    // every record that follows it
+    _file = createFile(filePath, records);
+    if (_file == nullptr)
+        return Error(ErrorType::Unknown, "Failed to write the game journal '" + filePath + "'");
+    if (!isTakingOver)
+        std::remove(drainingPath.c_str());
+
+    _filePath = filePath;
+    _fileSize = std::strlen(JOURNAL_MAGIC) + records.size();
+    _syncInterval = syncInterval;
+    _isStopping = false;
+    _isRunning = true;
+    _openGames.clear();
+    _unfinishedGames.clear();
+    for (auto &[gameId, game]: games) {
+        _openGames.insert(gameId);
+
+        JournaledGame unfinishedGame{gameId, {}};
+        for (auto &[username, gameData]: game.players) {
+            if (game.submittedPlayers.count(username) != 0)
+                continue;
+            // the questions the crash came before were never asked, they don't count as wrong
+            const auto askedCount = std::min(gameData.answers.size(), game.releasedQuestionsCount);
+            gameData.answers.erase(gameData.answers.begin() + static_cast<std::ptrdiff_t>(askedCount),
+                                   gameData.answers.end());
+            unfinishedGame.players.emplace(username, std::move(gameData));
+        }
+        _unfinishedGames.push_back(std::move(unfinishedGame));
+    }
+
+    _writer = std::thread(&GameJournal::writerLoop);
+    return std::nullopt;
+}
+
+void GameJournal::stop() {
+    {
+        std::lock_guard lock(_pendingMutex);
+        if (!_isRunning)
+            return;
+        _isStopping = true;
+    }
+    _pendingChanged.notify_all();
+    _writer.join();
+
+    std::lock_guard lock(_pendingMutex);
+    _isRunning = false;
+    if (_file != nullptr)
+        std::fclose(_file);
+    _file = nullptr;
+    // every game was finalized, nothing left to recover
+    if (_openGames.empty())
+        std::remove(_filePath.c_str());
+}
+
+std::optional<Error> GameJournal::setDraining(bool isDraining) {
+    std::lock_guard lock(_pendingMutex);
+    if (!_isRunning)
+        return std::nullopt;
+
+    const auto suffixSize = std::strlen(GAME_JOURNAL_DRAINING_SUFFIX);
+    const bool isDrainingPath = _filePath.size() > suffixSize &&
+                                _filePath.compare(_filePath.size() - suffixSize, suffixSize,
+                                                  GAME_JOURNAL_DRAINING_SUFFIX) == 0;
+    if (isDraining == isDrainingPath)
+        return std::nullopt;
+
+    const auto newPath = isDraining ? _filePath + GAME_JOURNAL_DRAINING_SUFFIX
+                                    : _filePath.substr(0, _filePath.size() - suffixSize);
+    std::error_code error;
+    std::filesystem::rename(_filePath, newPath, error);
+    if (error)
+        return Error(ErrorType::Unknown, "Failed to rename the game journal to '" + newPath + "': " +
+                                         error.message());
+
+    _filePath = newPath;
+    return std::nullopt;
+}
+
+std::vector<JournaledGame> GameJournal::takeUnfinishedGames() {
+    std::lock_guard lock(_pendingMutex);
+    return std::move(_unfinishedGames);
+}
+
+void GameJournal::recordGameCreated(const std::string &gameId, unsigned int timePerQuestion,
+                                    const std::vector<LoggedUser> &players, const std::vector<Question> &questions) {
+    std::vector<unsigned char> fields;
+    writeBigEndian(fields, timePerQuestion, 4);
+    writeBigEndian(fields, players.size(), 2);
+    for (const auto &player: players)
+        writeString(fields, player.username);
+    writeBigEndian(fields, questions.size(), 2);
+    for (const auto &question: questions)
+        fields.push_back(static_cast<unsigned char>(question.getCorrectAnswerIndex()));
+    enqueue(JournalRecordType::GAME_CREATED, gameId, fields);
+}
+
+void GameJournal::recordQuestionReleased(const std::string &gameId, unsigned int questionIndex) {
+    std::vector<unsigned char> fields;
+    writeBigEndian(fields, questionIndex, 2);
+    enqueue(JournalRecordType::QUESTION_RELEASED, gameId, fields);
+}
+
+void GameJournal::recordAnswer(const std::string &gameId, const std::string &username, unsigned int questionIndex,
+                               unsigned int answerIndex, unsigned int answerTime) {
+    std::vector<unsigned char> fields;
+    writeString(fields, username);
+    writeBigEndian(fields, questionIndex, 2);
+    fields.push_back(static_cast<unsigned char>(answerIndex));
+    writeBigEndian(fields, answerTime, 4);
+    enqueue(JournalRecordType::ANSWER_SUBMITTED, gameId, fields);
+}
+
+void GameJournal::recordPlayerLeft(const std::string &gameId, const std::string &username, bool isPunished) {
+    std::vector<unsigned char> fields;
+    writeString(fields, username);
+    fields.push_back(isPunished ? 1 : 0);
+    enqueue(JournalRecordType::PLAYER_LEFT, gameId, fields);
+}
+
+void GameJournal::recordStatsSubmitted(const std::string &gameId, const std::string &username) {
+    std::vector<unsigned char> fields;
+    writeString(fields, username);
+    enqueue(JournalRecordType::STATS_SUBMITTED, gameId, fields);
+}
+
+void GameJournal::recordGameFinalized(const std::string &gameId) {
+    enqueue(JournalRecordType::GAME_FINALIZED, gameId, {});
+}
+
+std::string GameJournal::report() {
+    std::size_t openGamesCount, pendingBytes;
+    {
+        std::lock_guard lock(_pendingMutex);
+        openGamesCount = _openGames.size();
+        pendingBytes = _pendingRecords.size();
+    }
+
+    std::string report = fmt::format("{:>10}{:>10}{:>10}{:>12}{:>12}{:>12}{:>12}{:>10}{:>12}\n",
+                                     "records", "batches", "failed", "batch avg", "sync avg", "sync p99",
+                                     "sync max", "games", "file");
+    report += fmt::format("{:>10}{:>10}{:>10}{:>11}B{:>10.1f}ms{:>10.1f}ms{:>10.1f}ms{:>10}{:>10}KB\n",
+                          _recordsCount.load(), _batchesCount.load(), _failedWrites.load(), _batchSize.average(),
+                          static_cast<double>(_syncTime.average()) / 1000.0,
+                          static_cast<double>(_syncTime.percentile(99)) / 1000.0,
+                          static_cast<double>(_syncTime.max()) / 1000.0,
+                          openGamesCount, (_fileSize.load() + pendingBytes) / 1024);
+    return report;
+}
+
+void GameJournal::resetStats() {
+    _recordsCount = 0;
+    _batchesCount = 0;
+    _failedWrites = 0;
+    _syncTime.reset();
+    _batchSize.reset();
+}
+
+Result<std::vector<unsigned char>> GameJournal::readRecords(const std::string &filePath, bool &isTailDropped) {
+    std::ifstream input(filePath, std::ios_base::binary);
+    if (!input.is_open())
+        return std::vector<unsigned char>();    // no journal, nothing to recover
+
+    const std::vector<unsigned char> content((std::istreambuf_iterator<char>(input)),
+                                             std::istreambuf_iterator<char>());
+    const auto magicSize = std::strlen(JOURNAL_MAGIC);
+    // the server crashed while creating the file
+    if (content.size() < magicSize) {
+        isTailDropped = isTailDropped || !content.empty();
+        return std::vector<unsigned char>();
+    }
+    if (std::memcmp(content.data(), JOURNAL_MAGIC, magicSize) != 0)
+        return Error(ErrorType::DeserializationError, "'" + filePath + "' is not a trivia game journal");
+
+    std::size_t position = magicSize;
+    while (content.size() - position >= RECORD_HEADER_SIZE) {
+        const auto payloadSize = static_cast<std::size_t>(readBigEndian(content.data() + position, 4));
+        const auto checksum = static_cast<std::uint32_t>(readBigEndian(content.data() + position + 4, 4));
+        // the type and payload, cut or not matching their checksum when the crash came in the middle of a write
+        if (content.size() - position - RECORD_HEADER_SIZE < payloadSize ||
+            crc32(content.data() + position + 8, payloadSize + 1) != checksum)
+            break;
+        position += RECORD_HEADER_SIZE + payloadSize;
+    }
+
+    isTailDropped = isTailDropped || position != content.size();
+    return std::vector<unsigned char>(content.begin() + static_cast<std::ptrdiff_t>(magicSize),
+                                      content.begin() + static_cast<std::ptrdiff_t>(position));
+}
+
+void GameJournal::replay(const std::vector<unsigned char> &records, std::map<std::string, ReplayedGame> &games) {
+    std::size_t position = 0;
+    while (position < records.size()) {
+        const auto payloadSize = static_cast<std::size_t>(readBigEndian(records.data() + position, 4));
+        const auto type = static_cast<JournalRecordType>(records[position + 8]);
+        PayloadReader reader(records.data() + position + RECORD_HEADER_SIZE, payloadSize);
+        position += RECORD_HEADER_SIZE + payloadSize;
+
+        const auto gameId = reader.readString();
+        if (type == JournalRecordType::GAME_CREATED) {
+            ReplayedGame game;
+            game.timePerQuestion = static_cast<unsigned int>(reader.readNumber(4));
+            std::vector<std::string> usernames(static_cast<std::size_t>(reader.readNumber(2)));
+            for (auto &username: usernames)
+                username = reader.readString();
+            const auto questionsCount = static_cast<std::size_t>(reader.readNumber(2));
+            for (std::size_t i = 0; i < questionsCount && reader.isValid; i++)
+                game.questions.emplace_back(static_cast<unsigned int>(reader.readNumber(1)));
+            if (!reader.isValid)
+                continue;
+
+            for (const auto &username: usernames)
+                game.players.emplace(username, GameData(game.questions, game.timePerQuestion));
+            games[gameId] = std::move(game);
+            continue;
+        }
+
+        const auto game = games.find(gameId);
+        if (game == games.end())
+            continue;   // finalized already
+        if (type == JournalRecordType::GAME_FINALIZED) {
+            games.erase(game);
+            continue;
+        }
+        if (type == JournalRecordType::QUESTION_RELEASED) {
+            const auto questionIndex = static_cast<std::size_t>(reader.readNumber(2));
+            if (reader.isValid)
+                game->second.releasedQuestionsCount = std::max(game->second.releasedQuestionsCount, questionIndex + 1);
+            continue;
+        }
+
+        const auto username = reader.readString();
+        const auto player = game->second.players.find(username);
+        if (player == game->second.players.end())
+            continue;
+
+        if (type == JournalRecordType::ANSWER_SUBMITTED) {
+            const auto questionIndex = static_cast<unsigned int>(reader.readNumber(2));
+            const auto answerIndex = static_cast<unsigned int>(reader.readNumber(1));
+            const auto answerTime = static_cast<unsigned int>(reader.readNumber(4));
+            if (reader.isValid && questionIndex < player->second.answers.size()) {
+                player->second.submitAnswer(answerIndex, questionIndex, answerTime);
+                // released before it was answered, even when the release record was lost
+                game->second.releasedQuestionsCount = std::max(game->second.releasedQuestionsCount,
+                                                               static_cast<std::size_t>(questionIndex) + 1);
+            }
+        } else if (type == JournalRecordType::PLAYER_LEFT) {
+            const bool isPunished = reader.readNumber(1) != 0;
+            if (reader.isValid)
+                player->second.isPunished = isPunished;
+        } else if (type == JournalRecordType::STATS_SUBMITTED && reader.isValid) {
+            game->second.submittedPlayers.insert(username);
+        }
+    }
+}
+
+void GameJournal::enqueue(JournalRecordType type, const std::string &gameId,
+                          const std::vector<unsigned char> &fields) {
+    std::vector<unsigned char> record(8);
+    record.push_back(static_cast<unsigned char>(type));
+    writeString(record, gameId);
+    record.insert(record.end(), fields.begin(), fields.end());
+
+    const auto payloadSize = record.size() - RECORD_HEADER_SIZE;
+    const auto checksum = crc32(record.data() + 8, payloadSize + 1);
+    for (unsigned int i = 0; i < 4; i++) {
+        record[i] = static_cast<unsigned char>((payloadSize >> ((3 - i) * 8)) & 0xFF);
+        record[4 + i] = static_cast<unsigned char>((checksum >> ((3 - i) * 8)) & 0xFF);
+    }
+
+    bool isBatchFull;
+    {
+        std::lock_guard lock(_pendingMutex);
+        if (!_isRunning || _isStopping)
+            return;
+
+        if (type == JournalRecordType::GAME_CREATED)
+            _openGames.insert(gameId);
+        else if (type == JournalRecordType::GAME_FINALIZED)
+            _openGames.erase(gameId);
+
+        _pendingRecords.insert(_pendingRecords.end(), record.begin(), record.end());
+        isBatchFull = _pendingRecords.size() >= JOURNAL_MAX_BATCH_BYTES;
+    }
+    _recordsCount.fetch_add(1, std::memory_order_relaxed);
+    if (isBatchFull)
+        _pendingChanged.notify_one();
+}
+
+std::FILE *GameJournal::createFile(const std::string &filePath, const std::vector<unsigned char> &records) {
+    // written aside and renamed over the journal once synced, so a crash meanwhile leaves the previous one whole
+    const auto tempPath = filePath + ".tmp";
+    std::FILE *tempFile = std::fopen(tempPath.c_str(), "wb");
+    if (tempFile == nullptr)
+        return nullptr;
+
+    const bool isWritten = std::fwrite(JOURNAL_MAGIC, 1, std::strlen(JOURNAL_MAGIC), tempFile) ==
+                           std::strlen(JOURNAL_MAGIC) &&
+                           std::fwrite(records.data(), 1, records.size(), tempFile) == records.size() &&
+                           syncFile(tempFile);
+    std::fclose(tempFile);
+
+    std::error_code error;
+    if (isWritten)
+        std::filesystem::rename(tempPath, filePath, error);
+    if (!isWritten || error) {
+        std::remove(tempPath.c_str());
+        return nullptr;
+    }
+
+    return std::fopen(filePath.c_str(), "ab");
+}
+
+bool GameJournal::syncFile(std::FILE *file) {
+    if (std::fflush(file) != 0)
+        return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fdatasync(fileno(file)) == 0;
+#endif
+}
+
+void GameJournal::writerLoop() {
+    std::unique_lock lock(_pendingMutex);
+    while (true) {
+        _pendingChanged.wait_for(lock, _syncInterval, [] {
+            return _isStopping || _pendingRecords.size() >= JOURNAL_MAX_BATCH_BYTES;
+        });
+        if (_pendingRecords.empty()) {
+            if (_isStopping)
+                return;
+            continue;
+        }
+
+        std::vector<unsigned char> batch;
+        batch.swap(_pendingRecords);
+        // every game in the file is finalized once this batch is written, the next records can start a new file
+        const bool isCompacting = _openGames.empty() && _fileSize + batch.size() >= JOURNAL_COMPACT_SIZE;
+        // a failed compaction left no file open, the journal is reopened where it is now
+        if (_file == nullptr)
+            _file = std::fopen(_filePath.c_str(), "ab");
+        std::FILE *file = _file;
+        lock.unlock();
+
+        const auto syncStart = std::chrono::steady_clock::now();
+        const bool isWritten = file != nullptr && std::fwrite(batch.data(), 1, batch.size(), file) == batch.size() &&
+                               syncFile(file);
+        _syncTime.record(microsecondsSince(syncStart));
+        _batchSize.record(batch.size());
+        _batchesCount.fetch_add(1, std::memory_order_relaxed);
+        if (isWritten)
+            _fileSize += batch.size();
+        else
+            _failedWrites.fetch_add(1, std::memory_order_relaxed);
+
+        lock.lock();
+        // under the lock, so setDraining can't move the journal in the middle
+        if (isCompacting && file != nullptr) {
+            std::fclose(_file);
+            _file = createFile(_filePath, {});
+            if (_file != nullptr)
+                _fileSize = std::strlen(JOURNAL_MAGIC);
+            else
+                _file = std::fopen(_filePath.c_str(), "ab");     // keeps growing until the next try, or reopened then
+        }
+    }
+}
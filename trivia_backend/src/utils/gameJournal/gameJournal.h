@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "../../errors/result.h"
+#include "../../managers/game.h"
+#include "../metrics/latencyHistogram.h"
+
+// journal file layout, every integer is big endian like the wire protocol:
+//   header: JOURNAL_MAGIC (8 bytes)
+//   record: [4 bytes payload length][4 bytes CRC32 of the type and payload][1 byte type][payload]
+// strings are [2 bytes length][bytes], a game id is its room's uuid
+enum class JournalRecordType : unsigned char {
+    // [game id][4 bytes time per question][2 bytes players count][usernames]
+    // [2 bytes questions count][1 byte correct answer index of each question]
+    GAME_CREATED = 1,
+    // [game id][username][2 bytes question index][1 byte answer index][4 bytes answer time]
+    ANSWER_SUBMITTED = 2,
+    // [game id][username][1 byte is punished]
+    PLAYER_LEFT = 3,
+    // [game id][username], once the player's statistics are in the database
+    STATS_SUBMITTED = 4,
+    // [game id], the game is removed and every statistics submitted
+    GAME_FINALIZED = 5,
+    // [game id][2 bytes question index], once the question is first sent to a player
+    QUESTION_RELEASED = 6
+};
+
+// a game the last run didn't finalize, with the players whose statistics weren't submitted
+struct JournaledGame {
+    std::string gameId;
+    std::map<std::string, GameData> players;    // username -> the answers journaled, up to the last question released
+};
+
+// append-only log of the games' events, so the statistics of the games running when the server crashed can still be
+// submitted on the next start. the events are queued in memory by the players' threads and written, then synced, in
+// batches by a writer thread every sync interval. a crash loses at most the last interval. the file is emptied
+// whenever it is big and no journaled game is running
+class GameJournal {
+public:
+    GameJournal() = delete;  // Prevent construction
+    ~GameJournal() = delete;  // Prevent destruction
+
+    // before the server accepts clients. reads the journal of the last run (and of a server that crashed while
+    // draining after a handoff, unless isTakingOver), drops a torn or corrupted tail, and keeps appending to it.
+    // the games it left unfinished are kept for takeUnfinishedGames
+    static std::optional<Error> start(const std::string &filePath, std::chrono::milliseconds syncInterval,
+                                      bool isTakingOver);
+
+    // writes and syncs the queued events. the file is removed when no journaled game is left
+    static void stop();
+
+    // renames the journal between its path and its draining path (GAME_JOURNAL_DRAINING_SUFFIX), it is still written
+    // to. on handoff, so the new server starts a journal of its own while this one drains
+    static std::optional<Error> setDraining(bool isDraining);
+
+    // the games left unfinished by the last run, once
+    static std::vector<JournaledGame> takeUnfinishedGames();
+
+    static void recordGameCreated(const std::string &gameId, unsigned int timePerQuestion,
+                                  const std::vector<LoggedUser> &players, const std::vector<Question> &questions);
+    static void recordQuestionReleased(const std::string &gameId, unsigned int questionIndex);
+    static void recordAnswer(const std::string &gameId, const std::string &username, unsigned int questionIndex,
+                             unsigned int answerIndex, unsigned int answerTime);
+    static void recordPlayerLeft(const std::string &gameId, const std::string &username, bool isPunished);
+    static void recordStatsSubmitted(const std::string &gameId, const std::string &username);
+    static void recordGameFinalized(const std::string &gameId);
+
+    // records and syncs so far, and the games the journal holds
+    static std::string report();
+
+    static void resetStats();
+
+private:
+    // the games read from a journal, with the players whose statistics were submitted already
+    struct ReplayedGame {
+        unsigned int timePerQuestion = 0;
+        std::vector<Question> questions;
+        std::size_t releasedQuestionsCount = 0;
+        std::map<std::string, GameData> players;
+        std::unordered_set<std::string> submittedPlayers;
+    };
+
+    // the valid records of the file, without its header, and whether a torn or corrupted tail was dropped
+    static Result<std::vector<unsigned char>> readRecords(const std::string &filePath, bool &isTailDropped);
+
+    // applies every record to games, the finalized ones are erased
+    static void replay(const std::vector<unsigned char> &records, std::map<std::string, ReplayedGame> &games);
+
+    // fields is the payload after the game id
+    static void enqueue(JournalRecordType type, const std::string &gameId, const std::vector<unsigned char> &fields);
+
+    // creates (or empties) the file at filePath with the header and records, and syncs it
+    static std::FILE *createFile(const std::string &filePath, const std::vector<unsigned char> &records);
+
+    // flushes the file to the disk
+    static bool syncFile(std::FILE *file);
+
+    static void writerLoop();
+
+    static inline std::string _filePath;        // guarded by _pendingMutex
+    static inline std::FILE *_file = nullptr;   // written by the writer thread, swapped with _pendingMutex held
+    static inline std::atomic<std::uintmax_t> _fileSize{0};
+    static inline std::chrono::milliseconds _syncInterval{0};
+
+    static inline std::vector<unsigned char> _pendingRecords;
+    static inline std::unordered_set<std::string> _openGames;  // created and not finalized yet, in the journal
+    static inline std::vector<JournaledGame> _unfinishedGames;
+    static inline std::mutex _pendingMutex;   // a plain mutex, the writer waits on it with a condition variable
+    static inline std::condition_variable _pendingChanged;
+    static inline bool _isStopping = false;
+    static inline bool _isRunning = false;      // from start to stop
+    static inline std::thread _writer;
+
+    static inline std::atomic<std::uint64_t> _recordsCount{0};
+    static inline std::atomic<std::uint64_t> _batchesCount{0};
+    static inline std::atomic<std::uint64_t> _failedWrites{0};
+    static inline LatencyHistogram _syncTime;   // us
+    static inline LatencyHistogram _batchSize;  // bytes
+};
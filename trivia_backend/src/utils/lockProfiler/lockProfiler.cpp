@@ -0,0 +1,69 @@
+#include "lockProfiler.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+#include <fmt/format.h>
+
+namespace {
+    // stats are never removed, so references handed out stay valid
+    std::mutex &getLockStatsMutex() {
+        static std::mutex lockStatsMutex;
+        return lockStatsMutex;
+    }
+
+    // function local so global profiled mutexes (logMutex) can register during static initialization
+    std::map<std::string, std::unique_ptr<LockStats>> &getLockStatsRegistry() {
+        static std::map<std::string, std::unique_ptr<LockStats>> lockStatsRegistry;
+        return lockStatsRegistry;
+    }
+
+    double toMicroseconds(std::uint64_t nanoseconds) {
+        return static_cast<double>(nanoseconds) / 1000.0;
+    }
+}
+
+LockStats &LockProfiler::getLockStats(const std::string &lockName) {
+    std::lock_guard lock(getLockStatsMutex());
+    auto &stats = getLockStatsRegistry()[lockName];
+    if (stats == nullptr)
+        stats = std::make_unique<LockStats>(lockName);
+    return *stats;
+}
+
+void LockProfiler::reset() {
+    std::lock_guard lock(getLockStatsMutex());
+    for (auto &[lockName, stats]: getLockStatsRegistry())
+        stats->reset();
+}
+
+std::string LockProfiler::report() {
+    std::vector<const LockStats *> sortedStats;
+    {
+        std::lock_guard lock(getLockStatsMutex());
+        for (const auto &[lockName, stats]: getLockStatsRegistry())
+            sortedStats.push_back(stats.get());
+    }
+
+    std::sort(sortedStats.begin(), sortedStats.end(), [](const LockStats *first, const LockStats *second) {
+        return first->waitTime.sum() > second->waitTime.sum();
+    });
+
+    std::string report = fmt::format("{:<36}{:>12}{:>10}{:>12}{:>14}{:>12}{:>12}{:>14}{:>12}\n",
+                                     "lock", "acquired", "shared", "contended", "wait total", "wait p50",
+                                     "wait p99", "hold avg", "hold p99");
+    for (const auto *stats: sortedStats) {
+        const auto acquisitions = stats->acquisitions.load();
+        const auto contentions = stats->contentions.load();
+        report += fmt::format("{:<36}{:>12}{:>10}{:>11.1f}%{:>12.1f}ms{:>10.1f}us{:>10.1f}us{:>12.1f}us{:>10.1f}us\n",
+                              stats->name, acquisitions, stats->sharedAcquisitions.load(),
+                              acquisitions == 0 ? 0.0 : 100.0 * static_cast<double>(contentions) /
+                                                        static_cast<double>(acquisitions),
+                              toMicroseconds(stats->waitTime.sum()) / 1000.0,
+                              toMicroseconds(stats->waitTime.percentile(50)),
+                              toMicroseconds(stats->waitTime.percentile(99)),
+                              toMicroseconds(stats->holdTime.average()),
+                              toMicroseconds(stats->holdTime.percentile(99)));
+    }
+    return report;
+}
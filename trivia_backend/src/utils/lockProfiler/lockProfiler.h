@@ -0,0 +1,229 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include "../metrics/latencyHistogram.h"
+
+// counters of every lock sharing a name (e.g. all the Room::_usersMutex instances)
+struct LockStats {
+    explicit LockStats(std::string name) : name(std::move(name)) {}
+
+    void recordAcquisition(bool isShared, bool isContended, std::uint64_t waitNanoseconds) {
+        acquisitions.fetch_add(1, std::memory_order_relaxed);
+        if (isShared)
+            sharedAcquisitions.fetch_add(1, std::memory_order_relaxed);
+        if (isContended)
+            contentions.fetch_add(1, std::memory_order_relaxed);
+        waitTime.record(waitNanoseconds);
+    }
+
+    void reset() {
+        acquisitions = 0;
+        sharedAcquisitions = 0;
+        contentions = 0;
+        waitTime.reset();
+        holdTime.reset();
+    }
+
+    const std::string name;
+    std::atomic<std::uint64_t> acquisitions{0};
+    std::atomic<std::uint64_t> sharedAcquisitions{0};
+    std::atomic<std::uint64_t> contentions{0};  // acquisitions that had to block
+    LatencyHistogram waitTime;  // ns
+    LatencyHistogram holdTime;  // ns, exclusive holds and periods the lock was held in shared mode
+};
+
+class LockProfiler {
+public:
+    LockProfiler() = delete;  // Prevent construction
+    ~LockProfiler() = delete;  // Prevent destruction
+
+    [[nodiscard]] static bool isEnabled() noexcept { return _isEnabled.load(std::memory_order_relaxed); }
+
+    static void setEnabled(bool isEnabled) { _isEnabled.store(isEnabled, std::memory_order_relaxed); }
+
+    // the returned stats live for the whole program
+    static LockStats &getLockStats(const std::string &lockName);
+
+    static void reset();
+
+    // table of all named locks, the most waited on first
+    static std::string report();
+
+    static std::uint64_t nanosecondsSince(const std::chrono::steady_clock::time_point &start) {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    static inline std::atomic<bool> _isEnabled{false};
+};
+
+// drop-in std::mutex replacement, when profiling is off it only adds a branch on each lock / unlock
+class ProfiledMutex {
+public:
+    explicit ProfiledMutex(const std::string &name) : _stats(LockProfiler::getLockStats(name)) {}
+
+    ProfiledMutex(const ProfiledMutex &) = delete;
+    ProfiledMutex &operator=(const ProfiledMutex &) = delete;
+
+    void lock() {
+        if (!LockProfiler::isEnabled()) {
+            _mutex.lock();
+            return;
+        }
+
+        const auto waitStart = std::chrono::steady_clock::now();
+        const bool isContended = !_mutex.try_lock();
+        if (isContended)
+            _mutex.lock();
+
+        _stats.recordAcquisition(false, isContended, isContended ? LockProfiler::nanosecondsSince(waitStart) : 0);
+        _acquiredAt = std::chrono::steady_clock::now();
+        _isHoldProfiled = true;
+    }
+
+    bool try_lock() {
+        if (!_mutex.try_lock())
+            return false;
+
+        if (LockProfiler::isEnabled()) {
+            _stats.recordAcquisition(false, false, 0);
+            _acquiredAt = std::chrono::steady_clock::now();
+            _isHoldProfiled = true;
+        }
+        return true;
+    }
+
+    void unlock() {
+        // only the holder touches these, so they need no synchronization
+        if (_isHoldProfiled) {
+            _isHoldProfiled = false;
+            _stats.holdTime.record(LockProfiler::nanosecondsSince(_acquiredAt));
+        }
+        _mutex.unlock();
+    }
+
+private:
+    std::mutex _mutex;
+    LockStats &_stats;
+    std::chrono::steady_clock::time_point _acquiredAt;
+    bool _isHoldProfiled = false;
+};
+
+// drop-in std::shared_mutex replacement, shared holds are measured from the first reader in until the last one out
+class ProfiledSharedMutex {
+public:
+    explicit ProfiledSharedMutex(const std::string &name) : _stats(LockProfiler::getLockStats(name)) {}
+
+    ProfiledSharedMutex(const ProfiledSharedMutex &) = delete;
+    ProfiledSharedMutex &operator=(const ProfiledSharedMutex &) = delete;
+
+    void lock() {
+        if (!LockProfiler::isEnabled()) {
+            _mutex.lock();
+            return;
+        }
+
+        const auto waitStart = std::chrono::steady_clock::now();
+        const bool isContended = !_mutex.try_lock();
+        if (isContended)
+            _mutex.lock();
+
+        _stats.recordAcquisition(false, isContended, isContended ? LockProfiler::nanosecondsSince(waitStart) : 0);
+        _acquiredAt = std::chrono::steady_clock::now();
+        _isHoldProfiled = true;
+    }
+
+    bool try_lock() {
+        if (!_mutex.try_lock())
+            return false;
+
+        if (LockProfiler::isEnabled()) {
+            _stats.recordAcquisition(false, false, 0);
+            _acquiredAt = std::chrono::steady_clock::now();
+            _isHoldProfiled = true;
+        }
+        return true;
+    }
+
+    void unlock() {
+        if (_isHoldProfiled) {
+            _isHoldProfiled = false;
+            _stats.holdTime.record(LockProfiler::nanosecondsSince(_acquiredAt));
+        }
+        _mutex.unlock();
+    }
+
+    void lock_shared() {
+        if (!LockProfiler::isEnabled()) {
+            _mutex.lock_shared();
+            return;
+        }
+
+        const auto waitStart = std::chrono::steady_clock::now();
+        const bool isContended = !_mutex.try_lock_shared();
+        if (isContended)
+            _mutex.lock_shared();
+
+        _stats.recordAcquisition(true, isContended, isContended ? LockProfiler::nanosecondsSince(waitStart) : 0);
+        onSharedAcquired();
+    }
+
+    bool try_lock_shared() {
+        if (!_mutex.try_lock_shared())
+            return false;
+
+        if (LockProfiler::isEnabled()) {
+            _stats.recordAcquisition(true, false, 0);
+            onSharedAcquired();
+        }
+        return true;
+    }
+
+    void unlock_shared() {
+        onSharedReleased();
+        _mutex.unlock_shared();
+    }
+
+private:
+    // the readers are counted without a lock. the reader taking the count from 0 to 1 starts the shared period, the
+    // one taking it from 1 to 0 reads the start before its CAS, while no other reader can start a new period
+    void onSharedAcquired() {
+        const auto now = std::chrono::steady_clock::now();
+        auto readers = _profiledReaders.load(std::memory_order_relaxed);
+        while (!_profiledReaders.compare_exchange_weak(readers, readers + 1, std::memory_order_acq_rel,
+                                                       std::memory_order_relaxed));
+        if (readers == 0)
+            _sharedSince.store(now.time_since_epoch().count(), std::memory_order_release);
+    }
+
+    void onSharedReleased() {
+        auto readers = _profiledReaders.load(std::memory_order_acquire);
+        std::chrono::steady_clock::rep sharedSince = 0;
+        do {
+            // readers that got in while profiling was off are not counted, so the counter may already be 0
+            if (readers == 0)
+                return;
+            if (readers == 1)
+                sharedSince = _sharedSince.load(std::memory_order_acquire);
+        } while (!_profiledReaders.compare_exchange_weak(readers, readers - 1, std::memory_order_acq_rel,
+                                                         std::memory_order_acquire));
+        if (readers > 1)
+            return;
+
+        // the last reader out ends the shared period
+        _stats.holdTime.record(LockProfiler::nanosecondsSince(
+                std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(sharedSince))));
+    }
+
+    std::shared_mutex _mutex;
+    LockStats &_stats;
+    std::chrono::steady_clock::time_point _acquiredAt;
+    bool _isHoldProfiled = false;
+    std::atomic<unsigned int> _profiledReaders{0};
+    std::atomic<std::chrono::steady_clock::rep> _sharedSince{0};  // steady clock ticks, of the current shared period
+};
@@ -1,176 +1,323 @@
 #include "jsonDeserializer.h"
-#include <nlohmann/json.hpp>
-
-using Json = nlohmann::json;
+#include <algorithm>
+#include <limits>
+#include "../tracer/tracer.h"
+#include "requestFieldReader.h"
+#include "../../constants.h"
 
 Result<LoginRequest>
 JsonDeserializer::deserializeLoginRequest(const std::vector<unsigned char> &buffer) {
-    Json j = Json::parse(buffer, nullptr, false);
-    if (j.is_discarded())
+    const TraceSpan span("deserialize", __func__);
+    std::array<RequestField, 2> fields{RequestField("username"), RequestField("password")};
+    if (!RequestFieldReader::readFields(buffer, fields))
         return Error(ErrorType::DeserializationError, "Invalid JSON");
 
-
-    if (!j.contains("username") || !j.contains("password"))
+    auto &[username, password] = fields;
+    if (username.isMissing() || password.isMissing())
         return Error(ErrorType::DeserializationError, "JSON is missing field 'username' or 'password'");
-    else if (!j["username"].is_string() || !j["password"].is_string())
+    else if (!username.isString() || !password.isString())
         return Error(ErrorType::DeserializationError, "Invalid JSON. 'username' or 'password' is not a string");
 
     LoginRequest loginRequest;
-    loginRequest.username = j["username"];
-    loginRequest.password = j["password"];
+    loginRequest.username = std::move(username.string);
+    loginRequest.password = std::move(password.string);
 
     return loginRequest;
 }
 
 Result<SignupRequest>
 JsonDeserializer::deserializeSignupRequest(const std::vector<unsigned char> &buffer) {
-    Json j = Json::parse(buffer, nullptr, false);
-    if (j.is_discarded())
+    const TraceSpan span("deserialize", __func__);
+    std::array<RequestField, 6> fields{RequestField("username"), RequestField("password"), RequestField("email"),
+                                       RequestField("address"), RequestField("phoneNumber"), RequestField("birthday")};
+    if (!RequestFieldReader::readFields(buffer, fields))
         return Error(ErrorType::DeserializationError, "Invalid JSON");
 
-    // Create a LoginRequest object and populate it
-    if (!j.contains("username") || !j.contains("password") || !j.contains("email") || !j.contains("address") ||
-        !j.contains("phoneNumber") || !j.contains("birthday"))
+    auto &[username, password, email, address, phoneNumber, birthday] = fields;
+    if (username.isMissing() || password.isMissing() || email.isMissing() || address.isMissing() ||
+        phoneNumber.isMissing() || birthday.isMissing())
         return Error(ErrorType::DeserializationError, "JSON is missing field 'username', 'password', 'email', 'address', 'phoneNumber', or 'birthday'");
-    else if (!j["username"].is_string() || !j["password"].is_string() || !j["email"].is_string() ||
-             !j["address"].is_string() || !j["phoneNumber"].is_string() || !j["birthday"].is_string())
+    else if (!username.isString() || !password.isString() || !email.isString() || !address.isString() ||
+             !phoneNumber.isString() || !birthday.isString())
         return Error(ErrorType::DeserializationError,
                      "Invalid JSON. 'username', 'password', 'email', 'address', 'phoneNumber', or 'birthday' is not a string");
 
     SignupRequest signupRequest;
-    signupRequest.username = j["username"];
-    signupRequest.password = j["password"];
-    signupRequest.email = j["email"];
-    signupRequest.address = j["address"];
-    signupRequest.phoneNumber = j["phoneNumber"];
-    signupRequest.birthday = j["birthday"];
+    signupRequest.username = std::move(username.string);
+    signupRequest.password = std::move(password.string);
+    signupRequest.email = std::move(email.string);
+    signupRequest.address = std::move(address.string);
+    signupRequest.phoneNumber = std::move(phoneNumber.string);
+    signupRequest.birthday = std::move(birthday.string);
 
     return signupRequest;
 }
 
+Result<GetRoomsRequest> JsonDeserializer::deserializeGetRoomsRequest(const std::vector<unsigned char> &buffer) {
+    const TraceSpan span("deserialize", __func__);
+    std::array<RequestField, 4> fields{RequestField("offset"), RequestField("limit"), RequestField("notActive"),
+                                       RequestField("notFull")};
+    if (!RequestFieldReader::readFields(buffer, fields))
+        return Error(ErrorType::DeserializationError, "Invalid JSON");
+
+    const auto &[offset, limit, notActive, notFull] = fields;
+    if ((!offset.isMissing() && !offset.isUnsigned()) || (!limit.isMissing() && !limit.isUnsigned()))
+        return Error(ErrorType::DeserializationError, "Invalid JSON. 'offset' or 'limit' is not a number");
+
+    if ((!notActive.isMissing() && !notActive.isBoolean()) || (!notFull.isMissing() && !notFull.isBoolean()))
+        return Error(ErrorType::DeserializationError, "Invalid JSON. 'notActive' or 'notFull' is not a boolean");
+
+    GetRoomsRequest getRoomsRequest;
+    getRoomsRequest.offset = static_cast<unsigned int>(std::min<std::uint64_t>(offset.number, std::numeric_limits<unsigned int>::max()));
+    getRoomsRequest.limit = static_cast<unsigned int>(std::min<std::uint64_t>(limit.number, std::numeric_limits<unsigned int>::max()));
+    getRoomsRequest.notActive = notActive.boolean;
+    getRoomsRequest.notFull = notFull.boolean;
+
+    return getRoomsRequest;
+}
+
 Result<GetPlayersInRoomRequest>
 JsonDeserializer::deserializeGetPlayersInRoomRequest(const std::vector<unsigned char> &buffer) {
-    Json j = Json::parse(buffer, nullptr, false);
-    if (j.is_discarded())
+    const TraceSpan span("deserialize", __func__);
+    std::array<RequestField, 1> fields{RequestField("roomId")};
+    if (!RequestFieldReader::readFields(buffer, fields))
         return Error(ErrorType::DeserializationError, "Invalid JSON");
 
-    if (!j.contains("roomId"))
+    auto &[roomId] = fields;
+    if (roomId.isMissing())
         return Error(ErrorType::DeserializationError, "JSON is missing field 'roomId'");
 
-    if (!j["roomId"].is_string())
+    if (!roomId.isString())
         return Error(ErrorType::DeserializationError, "Invalid JSON. 'roomId' is not a uuid string");
 
-    GetPlayersInRoomRequest getPlayersInRoomRequest{j["roomId"]};
+    GetPlayersInRoomRequest getPlayersInRoomRequest{std::move(roomId.string)};
 
     return getPlayersInRoomRequest;
 
 }
 
 Result<JoinRoomRequest> JsonDeserializer::deserializeJoinRoomRequest(const std::vector<unsigned char> &buffer) {
-    Json j = Json::parse(buffer, nullptr, false);
-    if (j.is_discarded())
+    const TraceSpan span("deserialize", __func__);
+    std::array<RequestField, 1> fields{RequestField("roomId")};
+    if (!RequestFieldReader::readFields(buffer, fields))
         return Error(ErrorType::DeserializationError, "Invalid JSON");
 
-    if (!j.contains("roomId"))
+    auto &[roomId] = fields;
+    if (roomId.isMissing())
         return Error(ErrorType::DeserializationError, "JSON is missing field 'roomId'");
 
-    if (!j["roomId"].is_string())
+    if (!roomId.isString())
         return Error(ErrorType::DeserializationError, "Invalid JSON. 'roomId' is not a uuid string");
 
-    JoinRoomRequest joinRoomRequest{j["roomId"]};
+    JoinRoomRequest joinRoomRequest{std::move(roomId.string)};
 
     return joinRoomRequest;
 }
 
 Result<CreateRoomRequest> JsonDeserializer::deserializeCreateRoomRequest(const std::vector<unsigned char> &buffer) {
-    Json j = Json::parse(buffer, nullptr, false);
-    if (j.is_discarded())
+    const TraceSpan span("deserialize", __func__);
+    std::array<RequestField, 4> fields{RequestField("name"), RequestField("maxPlayers"), RequestField("questionCount"),
+                                       RequestField("timePerQuestion")};
+    if (!RequestFieldReader::readFields(buffer, fields))
         return Error(ErrorType::DeserializationError, "Invalid JSON");
 
-    if (!j.contains("name") || !j.contains("maxPlayers") || !j.contains("questionCount") || !j.contains("timePerQuestion"))
+    auto &[name, maxPlayers, questionCount, timePerQuestion] = fields;
+    if (name.isMissing() || maxPlayers.isMissing() || questionCount.isMissing() || timePerQuestion.isMissing())
         return Error(ErrorType::DeserializationError, "JSON is missing field 'name', 'maxPlayers', 'questionCount', or 'timePerQuestion'");
 
-    if (!j["name"].is_string() || !j["maxPlayers"].is_number_unsigned() || !j["questionCount"].is_number_unsigned() || !j["timePerQuestion"].is_number_unsigned())
+    if (!name.isString() || !maxPlayers.isUnsigned() || !questionCount.isUnsigned() || !timePerQuestion.isUnsigned())
         return Error(ErrorType::DeserializationError, "Invalid JSON. 'name', 'maxPlayers', 'questionCount', or 'timePerQuestion' is not a string or number");
 
     CreateRoomRequest createRoomRequest;
-    createRoomRequest.roomName = j["name"];
-    createRoomRequest.maxPlayers = j["maxPlayers"];
-    createRoomRequest.questionCount = j["questionCount"];
-    createRoomRequest.timePerQuestion = j["timePerQuestion"];
+    createRoomRequest.roomName = std::move(name.string);
+    createRoomRequest.maxPlayers = static_cast<unsigned int>(maxPlayers.number);
+    createRoomRequest.questionCount = static_cast<unsigned int>(questionCount.number);
+    createRoomRequest.timePerQuestion = static_cast<unsigned int>(timePerQuestion.number);
 
     return createRoomRequest;
 }
 
 Result<UpdateUserDataRequest>
 JsonDeserializer::deserializeUpdateUserDataRequest(const std::vector<unsigned char> &buffer) {
-    Json j = Json::parse(buffer, nullptr, false);
-    if (j.is_discarded())
+    const TraceSpan span("deserialize", __func__);
+    std::array<RequestField, 4> fields{RequestField("password"), RequestField("address"), RequestField("phoneNumber"),
+                                       RequestField("avatarColor")};
+    if (!RequestFieldReader::readFields(buffer, fields))
         return Error(ErrorType::DeserializationError, "Invalid JSON");
 
-    if (!j.contains("password") || !j.contains("address") || !j.contains("phoneNumber") || !j.contains("avatarColor"))
+    auto &[password, address, phoneNumber, avatarColor] = fields;
+    if (password.isMissing() || address.isMissing() || phoneNumber.isMissing() || avatarColor.isMissing())
         return Error(ErrorType::DeserializationError, "JSON is missing field 'password', 'email', 'address', 'phoneNumber', or 'avatarColor'");
 
-    if (!(j["password"].is_string() || j["password"].is_null()) || !j["address"].is_string() || !j["phoneNumber"].is_string() || !j["avatarColor"].is_string())
+    if (!(password.isString() || password.isNull()) || !address.isString() || !phoneNumber.isString() || !avatarColor.isString())
         return Error(ErrorType::DeserializationError, "Invalid JSON. 'password', 'email', 'address', 'phoneNumber', or 'avatarColor' is not a string. (password can be null)");
 
     UpdateUserDataRequest updateUserDataRequest;
-    if (j["password"].is_string())
-        updateUserDataRequest.password = j["password"];
+    if (password.isString())
+        updateUserDataRequest.password = std::move(password.string);
     else
         updateUserDataRequest.password = std::nullopt;
 
-    updateUserDataRequest.address = j["address"];
-    updateUserDataRequest.phoneNumber = j["phoneNumber"];
-    updateUserDataRequest.avatarColor = j["avatarColor"];
+    updateUserDataRequest.address = std::move(address.string);
+    updateUserDataRequest.phoneNumber = std::move(phoneNumber.string);
+    updateUserDataRequest.avatarColor = std::move(avatarColor.string);
 
     return updateUserDataRequest;
 }
 
 Result<SubmitAnswerRequest> JsonDeserializer::deserializeSubmitAnswerRequest(const std::vector<unsigned char> &buffer) {
-    Json j = Json::parse(buffer, nullptr, false);
-    if (j.is_discarded())
+    const TraceSpan span("deserialize", __func__);
+    std::array<RequestField, 2> fields{RequestField("answerId"), RequestField("questionId")};
+    if (!RequestFieldReader::readFields(buffer, fields))
         return Error(ErrorType::DeserializationError, "Invalid JSON");
 
-    if (!j.contains("answerId") || !j.contains("questionId"))
+    const auto &[answerId, questionId] = fields;
+    if (answerId.isMissing() || questionId.isMissing())
         return Error(ErrorType::DeserializationError, "JSON is missing field 'answerId' or 'questionId'");
 
-    if (!j["answerId"].is_number_unsigned(), !j["questionId"].is_number_unsigned())
+    if (!answerId.isUnsigned() || !questionId.isUnsigned())
         return Error(ErrorType::DeserializationError, "Invalid JSON. 'answerId' or 'questionId' is not a number");
 
 
-    SubmitAnswerRequest submitAnswerRequest{j["answerId"], j["questionId"]};
+    SubmitAnswerRequest submitAnswerRequest{static_cast<unsigned int>(answerId.number),
+                                            static_cast<unsigned int>(questionId.number)};
     return submitAnswerRequest;
 }
 
 Result<SubmitVerificationCodeRequest>
 JsonDeserializer::deserializeSubmitVerificationCodeRequest(const std::vector<unsigned char> &buffer) {
-    Json j = Json::parse(buffer, nullptr, false);
-    if (j.is_discarded())
+    const TraceSpan span("deserialize", __func__);
+    std::array<RequestField, 1> fields{RequestField("code")};
+    if (!RequestFieldReader::readFields(buffer, fields))
         return Error(ErrorType::DeserializationError, "Invalid JSON");
 
-    if (!j.contains("code"))
+    auto &[code] = fields;
+    if (code.isMissing())
         return Error(ErrorType::DeserializationError, "JSON is missing field 'verificationCode'");
 
-    if (!j["code"].is_string())
+    if (!code.isString())
         return Error(ErrorType::DeserializationError, "Invalid JSON. 'verificationCode' is not a string");
 
-    SubmitVerificationCodeRequest submitVerificationCodeRequest{j["code"]};
+    SubmitVerificationCodeRequest submitVerificationCodeRequest{std::move(code.string)};
     return submitVerificationCodeRequest;
 }
 
 Result<ForgotPasswordRequest>
 JsonDeserializer::deserializeForgotPasswordRequest(const std::vector<unsigned char> &buffer) {
-    Json j = Json::parse(buffer, nullptr, false);
-    if (j.is_discarded())
+    const TraceSpan span("deserialize", __func__);
+    std::array<RequestField, 1> fields{RequestField("email")};
+    if (!RequestFieldReader::readFields(buffer, fields))
         return Error(ErrorType::DeserializationError, "Invalid JSON");
 
-    if (!j.contains("email"))
+    auto &[email] = fields;
+    if (email.isMissing())
         return Error(ErrorType::DeserializationError, "JSON is missing field 'email'");
 
-    if (!j["email"].is_string())
+    if (!email.isString())
         return Error(ErrorType::DeserializationError, "Invalid JSON. 'email' is not a string");
 
-    ForgotPasswordRequest forgotPasswordRequest{j["email"]};
+    ForgotPasswordRequest forgotPasswordRequest{std::move(email.string)};
     return forgotPasswordRequest;
 }
+
+Result<ResetPasswordRequest>
+JsonDeserializer::deserializeResetPasswordRequest(const std::vector<unsigned char> &buffer) {
+    const TraceSpan span("deserialize", __func__);
+    std::array<RequestField, 3> fields{RequestField("email"), RequestField("resetCode"), RequestField("password")};
+    if (!RequestFieldReader::readFields(buffer, fields))
+        return Error(ErrorType::DeserializationError, "Invalid JSON");
+
+    auto &[email, resetCode, password] = fields;
+    if (email.isMissing() || resetCode.isMissing() || password.isMissing())
+        return Error(ErrorType::DeserializationError, "JSON is missing field 'email', 'resetCode' or 'password'");
+    else if (!email.isString() || !resetCode.isString() || !password.isString())
+        return Error(ErrorType::DeserializationError,
+                     "Invalid JSON. 'email', 'resetCode' or 'password' is not a string");
+
+    ResetPasswordRequest resetPasswordRequest;
+    resetPasswordRequest.email = std::move(email.string);
+    resetPasswordRequest.resetCode = std::move(resetCode.string);
+    resetPasswordRequest.password = std::move(password.string);
+
+    return resetPasswordRequest;
+}
+
+Result<ClientHelloRequest>
+JsonDeserializer::deserializeClientHelloRequest(const std::vector<unsigned char> &buffer) {
+    const TraceSpan span("deserialize", __func__);
+    std::array<RequestField, 1> fields{RequestField("encodings")};
+    if (!RequestFieldReader::readFields(buffer, fields))
+        return Error(ErrorType::DeserializationError, "Invalid JSON");
+
+    auto &[encodings] = fields;
+    if (encodings.isMissing())
+        return Error(ErrorType::DeserializationError, "JSON is missing field 'encodings'");
+
+    if (!encodings.isArray())
+        return Error(ErrorType::DeserializationError, "Invalid JSON. 'encodings' is not an array");
+
+    if (encodings.hasNonStringElement)
+        return Error(ErrorType::DeserializationError, "Invalid JSON. 'encodings' contains a non string value");
+
+    ClientHelloRequest clientHelloRequest{std::move(encodings.strings)};
+    return clientHelloRequest;
+}
+
+Result<GetRoomStateRequest>
+JsonDeserializer::deserializeGetRoomStateRequest(const std::vector<unsigned char> &buffer) {
+    const TraceSpan span("deserialize", __func__);
+    // the clients from before the wait was added send no payload at all, a plain poll
+    if (buffer.empty())
+        return GetRoomStateRequest{};
+
+    std::array<RequestField, 2> fields{RequestField("lastSeenVersion"), RequestField("maxWaitMs")};
+    if (!RequestFieldReader::readFields(buffer, fields))
+        return Error(ErrorType::DeserializationError, "Invalid JSON");
+
+    // both fields are optional, plain polls send an empty object
+    const auto &[lastSeenVersion, maxWaitMs] = fields;
+    if ((!lastSeenVersion.isMissing() && !lastSeenVersion.isUnsigned()) || (!maxWaitMs.isMissing() && !maxWaitMs.isUnsigned()))
+        return Error(ErrorType::DeserializationError, "Invalid JSON. 'lastSeenVersion' or 'maxWaitMs' is not a number");
+
+    GetRoomStateRequest getRoomStateRequest;
+    if (lastSeenVersion.isUnsigned())
+        getRoomStateRequest.lastSeenVersion = lastSeenVersion.number;
+    if (maxWaitMs.isUnsigned())
+        getRoomStateRequest.maxWaitMs = static_cast<unsigned int>(std::min<std::uint64_t>(maxWaitMs.number, MAX_ROOM_STATE_WAIT_MS));
+
+    return getRoomStateRequest;
+}
+
+Result<ResumeSessionRequest>
+JsonDeserializer::deserializeResumeSessionRequest(const std::vector<unsigned char> &buffer) {
+    const TraceSpan span("deserialize", __func__);
+    std::array<RequestField, 1> fields{RequestField("sessionToken")};
+    if (!RequestFieldReader::readFields(buffer, fields))
+        return Error(ErrorType::DeserializationError, "Invalid JSON");
+
+    auto &[sessionToken] = fields;
+    if (sessionToken.isMissing())
+        return Error(ErrorType::DeserializationError, "JSON is missing field 'sessionToken'");
+
+    if (!sessionToken.isString())
+        return Error(ErrorType::DeserializationError, "Invalid JSON. 'sessionToken' is not a string");
+
+    ResumeSessionRequest resumeSessionRequest{std::move(sessionToken.string)};
+    return resumeSessionRequest;
+}
+
+Result<PingRequest> JsonDeserializer::deserializePingRequest(const std::vector<unsigned char> &buffer) {
+    const TraceSpan span("deserialize", __func__);
+    std::array<RequestField, 1> fields{RequestField("lastRttUs")};
+    if (!RequestFieldReader::readFields(buffer, fields))
+        return Error(ErrorType::DeserializationError, "Invalid JSON");
+
+    const auto &[lastRttUs] = fields;
+    if (!lastRttUs.isMissing() && !lastRttUs.isUnsigned())
+        return Error(ErrorType::DeserializationError, "Invalid JSON. 'lastRttUs' is not a number");
+
+    PingRequest pingRequest;
+    if (!lastRttUs.isMissing())
+        pingRequest.lastRttUs = lastRttUs.number;
+    return pingRequest;
+}
@@ -15,6 +15,8 @@ public:
 
     static Result<SignupRequest> deserializeSignupRequest(const std::vector<unsigned char> &buffer);
 
+    static Result<GetRoomsRequest> deserializeGetRoomsRequest(const std::vector<unsigned char> &buffer);
+
     static Result<GetPlayersInRoomRequest> deserializeGetPlayersInRoomRequest(const std::vector<unsigned char> &buffer);
 
     static Result<JoinRoomRequest> deserializeJoinRoomRequest(const std::vector<unsigned char> &buffer);
@@ -28,5 +30,15 @@ public:
     static Result<SubmitVerificationCodeRequest> deserializeSubmitVerificationCodeRequest(const std::vector<unsigned char> &buffer);
 
     static Result<ForgotPasswordRequest> deserializeForgotPasswordRequest(const std::vector<unsigned char> &buffer);
+
+    static Result<ResetPasswordRequest> deserializeResetPasswordRequest(const std::vector<unsigned char> &buffer);
+
+    static Result<ClientHelloRequest> deserializeClientHelloRequest(const std::vector<unsigned char> &buffer);
+
+    static Result<GetRoomStateRequest> deserializeGetRoomStateRequest(const std::vector<unsigned char> &buffer);
+
+    static Result<ResumeSessionRequest> deserializeResumeSessionRequest(const std::vector<unsigned char> &buffer);
+
+    static Result<PingRequest> deserializePingRequest(const std::vector<unsigned char> &buffer);
 };
 
@@ -1,437 +1,309 @@
 #include "jsonSerializer.h"
+#include "../tracer/tracer.h"
 #include "../conversionHelper/conversionHelper.h"
-#include <nlohmann/json.hpp>
-#include <iostream>
-
-using Json = nlohmann::json;
+#include "jsonWriter.h"
+
+namespace {
+    // JSON connections get the frame written in place, the binary encodings go through a json tree.
+    // writeFields is called with either writer and writes the fields of the response object
+    template<typename WriteFields>
+    std::vector<unsigned char> writeResponse(ResponseId responseId, std::size_t reservedBytes,
+                                             const WriteFields &writeFields) {
+        if (PayloadCodec::getEncoding() == PayloadEncoding::JSON) {
+            JsonWriter writer(responseId, reservedBytes);
+            writer.beginObject();
+            writeFields(writer);
+            writer.endObject();
+            return writer.finish();
+        }
+
+        JsonDomWriter writer(responseId);
+        writer.beginObject();
+        writeFields(writer);
+        writer.endObject();
+        return writer.finish();
+    }
+
+    // reserved bytes of the responses with only a status and a message
+    constexpr std::size_t SMALL_RESPONSE_SIZE = 64;
+
+    // rough per item sizes, so big responses are written without growing the buffer
+    constexpr std::size_t PLAYER_JSON_SIZE = 64;
+    constexpr std::size_t ROOM_JSON_SIZE = 160;
+    constexpr std::size_t USER_ANSWER_JSON_SIZE = 320;
+    constexpr std::size_t PLAYER_RESULT_JSON_SIZE = 192;
+}
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const LoginResponse &loginResponse) {
-    std::vector<unsigned char> response;
-
-    response.push_back(static_cast<unsigned char>(ResponseId::LOGIN_RESPONSE));
-    Json j;
-    j["status"] = loginResponse.status;
-    j["message"] = loginResponse.message;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "LoginResponse");
+    return writeResponse(ResponseId::LOGIN_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("message", loginResponse.message);
+        writer.field("sessionToken", loginResponse.sessionToken);
+        writer.field("status", loginResponse.status);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const SignupResponse &signupResponse) {
-    std::vector<unsigned char> response;
-
-    response.push_back(static_cast<unsigned char>(ResponseId::SIGNUP_RESPONSE));
-    Json j;
-    j["status"] = signupResponse.status;
-    j["message"] = signupResponse.message;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "SignupResponse");
+    return writeResponse(ResponseId::SIGNUP_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("message", signupResponse.message);
+        writer.field("status", signupResponse.status);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const ErrorResponse &errorResponse) {
-    std::vector<unsigned char> response;
-
-    response.push_back(static_cast<unsigned char>(ResponseId::ERROR_RESPONSE));
-    Json j;
-    j["message"] = errorResponse.errorMessage;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "ErrorResponse");
+    return writeResponse(ResponseId::ERROR_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("message", errorResponse.errorMessage);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const LogoutResponse &logoutResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::LOGOUT_RESPONSE));
-
-    Json j;
-    j["status"] = logoutResponse.status;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "LogoutResponse");
+    return writeResponse(ResponseId::LOGOUT_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("status", logoutResponse.status);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const GetRoomsResponse &getRoomsResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::GET_ROOMS_RESPONSE));
-
-    Json j;
-    j["status"] = getRoomsResponse.status;
-    j["rooms"] = Json::array();
-
+    const TraceSpan span("serialize", "GetRoomsResponse");
+    std::size_t reservedBytes = SMALL_RESPONSE_SIZE;
     for (const auto &room: getRoomsResponse.rooms)
-        j["rooms"].push_back(ConversionHelper::roomDataToJson(room));
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+        reservedBytes += ROOM_JSON_SIZE + room.players.size() * PLAYER_JSON_SIZE;
+
+    return writeResponse(ResponseId::GET_ROOMS_RESPONSE, reservedBytes, [&](auto &writer) {
+        writer.beginArray("rooms");
+        for (const auto &room: getRoomsResponse.rooms)
+            ConversionHelper::writeRoomData(writer, room);
+        writer.endArray();
+        writer.field("status", getRoomsResponse.status);
+        writer.field("totalCount", getRoomsResponse.totalCount);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const GetPlayersInRoomResponse &getPlayersInRoomResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::GET_PLAYERS_IN_ROOM_RESPONSE));
-
-    Json j;
-    j["status"] = getPlayersInRoomResponse.status;
-    j["players"] = Json::array();
-
-    for (const auto &player: getPlayersInRoomResponse.players)
-        j["players"].push_back(ConversionHelper::playerToJson(player));
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "GetPlayersInRoomResponse");
+    const auto reservedBytes = SMALL_RESPONSE_SIZE + getPlayersInRoomResponse.players.size() * PLAYER_JSON_SIZE;
+    return writeResponse(ResponseId::GET_PLAYERS_IN_ROOM_RESPONSE, reservedBytes, [&](auto &writer) {
+        ConversionHelper::writePlayers(writer, "players", getPlayersInRoomResponse.players);
+        writer.field("status", getPlayersInRoomResponse.status);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const GetHighScoresResponse &getHighScoreResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::GET_HIGHSCORES_RESPONSE));
-
-    Json j;
-    j["status"] = getHighScoreResponse.status;
-    j["players"] = Json::array();
-
-    for (const auto &player: getHighScoreResponse.statistics)
-        j["players"].push_back(ConversionHelper::playerToJson(player));
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
-
-
+    const TraceSpan span("serialize", "GetHighScoresResponse");
+    const auto reservedBytes = SMALL_RESPONSE_SIZE + getHighScoreResponse.statistics.size() * PLAYER_JSON_SIZE;
+    return writeResponse(ResponseId::GET_HIGHSCORES_RESPONSE, reservedBytes, [&](auto &writer) {
+        ConversionHelper::writePlayers(writer, "players", getHighScoreResponse.statistics);
+        writer.field("status", getHighScoreResponse.status);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const GetPersonalStatsResponse &getPersonalStatsResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::GET_PERSONAL_STATS_RESPONSE));
-
-    Json j;
-    j["status"] = getPersonalStatsResponse.status;
-    j["statistics"] = ConversionHelper::playerStatsToJson(getPersonalStatsResponse.statistics);
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "GetPersonalStatsResponse");
+    return writeResponse(ResponseId::GET_PERSONAL_STATS_RESPONSE, 2 * SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        ConversionHelper::writePlayerStats(writer, "statistics", getPersonalStatsResponse.statistics);
+        writer.field("status", getPersonalStatsResponse.status);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const JoinRoomResponse &joinRoomResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::JOIN_ROOM_RESPONSE));
-
-    Json j;
-    j["status"] = joinRoomResponse.status;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "JoinRoomResponse");
+    return writeResponse(ResponseId::JOIN_ROOM_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("status", joinRoomResponse.status);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const CreateRoomResponse &createRoomResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::CREATE_ROOM_RESPONSE));
-
-    Json j;
-    j["status"] = createRoomResponse.status;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "CreateRoomResponse");
+    return writeResponse(ResponseId::CREATE_ROOM_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("status", createRoomResponse.status);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const GetUserDataResponse &getUserDataResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::GET_USER_DATA_RESPONSE));
-
-    Json j;
-    j["status"] = getUserDataResponse.status;
-    Json userData;
-    userData["username"] = getUserDataResponse.userData.username;
-    userData["email"] = getUserDataResponse.userData.email;
-    userData["address"] = getUserDataResponse.userData.address;
-    userData["phoneNumber"] = getUserDataResponse.userData.phone_number;
-    userData["birthday"] = getUserDataResponse.userData.birthday;
-    userData["avatarColor"] = getUserDataResponse.userData.avatar_color;
-    userData["memberSince"] = getUserDataResponse.userData.member_since;
-    j["userData"] = userData;
-    j["userStatistics"] = ConversionHelper::playerStatsToJson(getUserDataResponse.statistics);
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "GetUserDataResponse");
+    return writeResponse(ResponseId::GET_USER_DATA_RESPONSE, 6 * SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        const auto &userData = getUserDataResponse.userData;
+        writer.field("status", getUserDataResponse.status);
+        writer.beginObject("userData");
+        writer.field("address", userData.address);
+        writer.field("avatarColor", userData.avatar_color);
+        writer.field("birthday", userData.birthday);
+        writer.field("email", userData.email);
+        writer.field("memberSince", userData.member_since);
+        writer.field("phoneNumber", userData.phone_number);
+        writer.field("username", userData.username);
+        writer.endObject();
+        ConversionHelper::writePlayerStats(writer, "userStatistics", getUserDataResponse.statistics);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const UpdateUserDataResponse &updateUserDataResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::UPDATE_USER_DATA_RESPONSE));
-
-    Json j;
-    j["status"] = updateUserDataResponse.status;
-    j["message"] = updateUserDataResponse.message;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "UpdateUserDataResponse");
+    return writeResponse(ResponseId::UPDATE_USER_DATA_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("message", updateUserDataResponse.message);
+        writer.field("status", updateUserDataResponse.status);
+    });
 }
 
-
 std::vector<unsigned char> JsonSerializer::serializeResponse(const CloseRoomResponse &closeRoomResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::CLOSE_ROOM_RESPONSE));
-
-    Json j;
-    j["status"] = closeRoomResponse.status;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "CloseRoomResponse");
+    return writeResponse(ResponseId::CLOSE_ROOM_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("status", closeRoomResponse.status);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const StartGameResponse &startGameResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::START_GAME_RESPONSE));
-
-    Json j;
-    j["status"] = startGameResponse.status;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "StartGameResponse");
+    return writeResponse(ResponseId::START_GAME_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("status", startGameResponse.status);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const GetRoomStateResponse &roomStateResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::GET_ROOM_STATE_RESPONSE));
-
-    Json j;
-    j["status"] = roomStateResponse.status;
-    j["hasGameBegun"] = roomStateResponse.hasGameBegun;
-    j["players"] = Json::array();
-
-    for (const auto &player: roomStateResponse.players)
-        j["players"].push_back(ConversionHelper::playerToJson(player));
-
-    j["questionCount"] = roomStateResponse.questionCount;
-    j["answerTimeout"] = roomStateResponse.answerTimeout;
-    j["maxPlayers"] = roomStateResponse.maxPlayers;
-    j["isClosed"] = roomStateResponse.isClosed;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "GetRoomStateResponse");
+    const auto reservedBytes = 2 * SMALL_RESPONSE_SIZE + roomStateResponse.players.size() * PLAYER_JSON_SIZE;
+    return writeResponse(ResponseId::GET_ROOM_STATE_RESPONSE, reservedBytes, [&](auto &writer) {
+        writer.field("answerTimeout", roomStateResponse.answerTimeout);
+        writer.field("hasGameBegun", roomStateResponse.hasGameBegun);
+        writer.field("isClosed", roomStateResponse.isClosed);
+        writer.field("maxPlayers", roomStateResponse.maxPlayers);
+        ConversionHelper::writePlayers(writer, "players", roomStateResponse.players);
+        writer.field("questionCount", roomStateResponse.questionCount);
+        writer.field("status", roomStateResponse.status);
+        writer.field("version", roomStateResponse.version);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const LeaveRoomResponse &leaveRoomResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::LEAVE_ROOM_RESPONSE));
-
-    Json j;
-    j["status"] = leaveRoomResponse.status;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "LeaveRoomResponse");
+    return writeResponse(ResponseId::LEAVE_ROOM_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("status", leaveRoomResponse.status);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const GetQuestionResponse &getQuestionResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::GET_QUESTION_RESPONSE));
-
-    Json j;
-    j["status"] = getQuestionResponse.status;
-    j["questionId"] = getQuestionResponse.questionId;
-    j["question"] = getQuestionResponse.question;
-    j["answers"] = Json::array();
-
-    for (const auto &answer: getQuestionResponse.answers)
-        j["answers"].push_back(answer);
-
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "GetQuestionResponse");
+    return writeResponse(ResponseId::GET_QUESTION_RESPONSE, USER_ANSWER_JSON_SIZE, [&](auto &writer) {
+        // every answer is an [id, answer] pair
+        writer.beginArray("answers");
+        for (const auto &[answerId, answer]: getQuestionResponse.answers) {
+            writer.beginArray();
+            writer.value(answerId);
+            writer.value(answer);
+            writer.endArray();
+        }
+        writer.endArray();
+        writer.field("question", getQuestionResponse.question);
+        writer.field("questionId", getQuestionResponse.questionId);
+        writer.field("status", getQuestionResponse.status);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const SubmitAnswerResponse &submitAnswerResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::SUBMIT_ANSWER_RESPONSE));
-
-    Json j;
-    j["status"] = submitAnswerResponse.status;
-    j["correctAnswerId"] = submitAnswerResponse.correctAnswerId;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "SubmitAnswerResponse");
+    return writeResponse(ResponseId::SUBMIT_ANSWER_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("correctAnswerId", submitAnswerResponse.correctAnswerId);
+        writer.field("status", submitAnswerResponse.status);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const GetGameResultsResponse &getGameResultsResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::GET_GAME_RESULTS_RESPONSE));
-
-
-    Json j;
-    j["status"] = getGameResultsResponse.status;
-    j["userAnswers"] = Json::array();
-    for (const auto &userAnswer: getGameResultsResponse.userAnswers)
-        j["userAnswers"].push_back(ConversionHelper::userAnswerToJson(userAnswer));
-
-    j["players"] = Json::array();
-
-    for (const auto &player: getGameResultsResponse.players)
-        j["players"].push_back(ConversionHelper::playerResultToJson(player));
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "GetGameResultsResponse");
+    const auto reservedBytes = SMALL_RESPONSE_SIZE +
+                               getGameResultsResponse.userAnswers.size() * USER_ANSWER_JSON_SIZE +
+                               getGameResultsResponse.players.size() * PLAYER_RESULT_JSON_SIZE;
+    return writeResponse(ResponseId::GET_GAME_RESULTS_RESPONSE, reservedBytes, [&](auto &writer) {
+        writer.beginArray("players");
+        for (const auto &player: getGameResultsResponse.players)
+            ConversionHelper::writePlayerResult(writer, player);
+        writer.endArray();
+        writer.field("status", getGameResultsResponse.status);
+        writer.beginArray("userAnswers");
+        for (const auto &userAnswer: getGameResultsResponse.userAnswers)
+            ConversionHelper::writeUserAnswer(writer, userAnswer);
+        writer.endArray();
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const LeaveGameResponse &LeaveGameResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::LEAVE_GAME_RESPONSE));
-
-    Json j;
-    j["status"] = LeaveGameResponse.status;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "LeaveGameResponse");
+    return writeResponse(ResponseId::LEAVE_GAME_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("status", LeaveGameResponse.status);
+    });
 }
 
 std::vector<unsigned char>
 JsonSerializer::serializeResponse(const SubmitVerificationCodeResponse &submitVerificationCodeRequest) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::SUBMIT_VERIFICATION_CODE_RESPONSE));
-
-    Json j;
-    j["status"] = submitVerificationCodeRequest.status;
-    j["isVerified"] = submitVerificationCodeRequest.isVerified;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "SubmitVerificationCodeResponse");
+    return writeResponse(ResponseId::SUBMIT_VERIFICATION_CODE_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("isVerified", submitVerificationCodeRequest.isVerified);
+        writer.field("sessionToken", submitVerificationCodeRequest.sessionToken);
+        writer.field("status", submitVerificationCodeRequest.status);
+    });
 }
 
 std::vector<unsigned char>
 JsonSerializer::serializeResponse(const ResendVerificationCodeResponse &resendVerificationCodeResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::RESEND_VERIFICATION_CODE_RESPONSE));
-
-    Json j;
-    j["status"] = resendVerificationCodeResponse.status;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
-
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
-
-    return response;
+    const TraceSpan span("serialize", "ResendVerificationCodeResponse");
+    return writeResponse(ResponseId::RESEND_VERIFICATION_CODE_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("status", resendVerificationCodeResponse.status);
+    });
 }
 
 std::vector<unsigned char> JsonSerializer::serializeResponse(const ForgotPasswordResponse &forgotPasswordResponse) {
-    std::vector<unsigned char> response;
-    response.push_back(static_cast<unsigned char>(ResponseId::FORGOT_PASSWORD_RESPONSE));
-
-    Json j;
-    j["status"] = forgotPasswordResponse.status;
-
-    std::vector<unsigned char> sizeBytes = ConversionHelper::jsonToSizeBytes(j);
-    response.insert(response.end(), sizeBytes.begin(), sizeBytes.end());
+    const TraceSpan span("serialize", "ForgotPasswordResponse");
+    return writeResponse(ResponseId::FORGOT_PASSWORD_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("status", forgotPasswordResponse.status);
+    });
+}
 
-    std::string jsonString = j.dump(); // Serialize JSON to a string
-    response.insert(response.end(), jsonString.begin(), jsonString.end());
+std::vector<unsigned char> JsonSerializer::serializeResponse(const ResetPasswordResponse &resetPasswordResponse) {
+    const TraceSpan span("serialize", "ResetPasswordResponse");
+    return writeResponse(ResponseId::RESET_PASSWORD_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("message", resetPasswordResponse.message);
+        writer.field("status", resetPasswordResponse.status);
+    });
+}
 
-    return response;
+std::vector<unsigned char> JsonSerializer::serializeResponse(const ClientHelloResponse &clientHelloResponse) {
+    const TraceSpan span("serialize", "ClientHelloResponse");
+    return writeResponse(ResponseId::CLIENT_HELLO_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("encoding", clientHelloResponse.encoding);
+        writer.field("status", clientHelloResponse.status);
+    });
 }
 
+std::vector<unsigned char> JsonSerializer::serializeResponse(const RoomStateNotModifiedResponse &roomStateNotModifiedResponse) {
+    const TraceSpan span("serialize", "RoomStateNotModifiedResponse");
+    return writeResponse(ResponseId::ROOM_STATE_NOT_MODIFIED_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("status", roomStateNotModifiedResponse.status);
+        writer.field("version", roomStateNotModifiedResponse.version);
+    });
+}
 
+std::vector<unsigned char> JsonSerializer::serializeResponse(const ResumeSessionResponse &resumeSessionResponse) {
+    const TraceSpan span("serialize", "ResumeSessionResponse");
+    return writeResponse(ResponseId::RESUME_SESSION_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("location", resumeSessionResponse.location);
+        writer.field("message", resumeSessionResponse.message);
+        writer.field("roomId", resumeSessionResponse.roomId);
+        writer.field("status", resumeSessionResponse.status);
+    });
+}
 
+std::vector<unsigned char> JsonSerializer::serializeResponse(const RetryLaterResponse &retryLaterResponse) {
+    const TraceSpan span("serialize", "RetryLaterResponse");
+    return writeResponse(ResponseId::RETRY_LATER_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("retryAfterMs", retryLaterResponse.retryAfterMs);
+        writer.field("status", retryLaterResponse.status);
+    });
+}
 
+std::vector<unsigned char> JsonSerializer::serializeResponse(const PongResponse &pongResponse) {
+    const TraceSpan span("serialize", "PongResponse");
+    return writeResponse(ResponseId::PONG_RESPONSE, SMALL_RESPONSE_SIZE, [&](auto &writer) {
+        writer.field("status", pongResponse.status);
+    });
+}
@@ -58,4 +58,16 @@ public:
     static std::vector<unsigned char> serializeResponse(const ResendVerificationCodeResponse& resendVerificationCodeResponse);
 
     static std::vector<unsigned char> serializeResponse(const ForgotPasswordResponse& forgotPasswordResponse);
+
+    static std::vector<unsigned char> serializeResponse(const ResetPasswordResponse& resetPasswordResponse);
+
+    static std::vector<unsigned char> serializeResponse(const ClientHelloResponse& clientHelloResponse);
+
+    static std::vector<unsigned char> serializeResponse(const ResumeSessionResponse& resumeSessionResponse);
+
+    static std::vector<unsigned char> serializeResponse(const RetryLaterResponse& retryLaterResponse);
+
+    static std::vector<unsigned char> serializeResponse(const PongResponse& pongResponse);
+
+    static std::vector<unsigned char> serializeResponse(const RoomStateNotModifiedResponse& roomStateNotModifiedResponse);
 };
\ No newline at end of file
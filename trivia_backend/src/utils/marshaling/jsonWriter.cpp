@@ -0,0 +1,97 @@
+#include "jsonWriter.h"
+#include "../conversionHelper/conversionHelper.h"
+
+namespace {
+    constexpr std::size_t FRAME_HEADER_SIZE = 5;    // [1 byte id][4 bytes length]
+
+    void appendFrameHeader(std::vector<unsigned char> &frame, ResponseId responseId, std::size_t payloadSize) {
+        frame.push_back(static_cast<unsigned char>(responseId));
+        const auto sizeBytes = ConversionHelper::sizeToBytes(payloadSize);
+        frame.insert(frame.end(), sizeBytes.begin(), sizeBytes.end());
+    }
+}
+
+JsonWriter::JsonWriter(ResponseId responseId, std::size_t reservedBytes) {
+    _buffer.reserve(FRAME_HEADER_SIZE + reservedBytes);
+    appendFrameHeader(_buffer, responseId, 0);
+}
+
+std::vector<unsigned char> JsonWriter::finish() {
+    const auto sizeBytes = ConversionHelper::sizeToBytes(_buffer.size() - FRAME_HEADER_SIZE);
+    std::copy(sizeBytes.begin(), sizeBytes.end(), _buffer.begin() + 1);
+    return std::move(_buffer);
+}
+
+void JsonWriter::writeString(std::string_view string) {
+    static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+    _buffer.push_back('"');
+    std::size_t plainStart = 0;
+    for (std::size_t i = 0; i < string.size(); i++) {
+        const auto character = static_cast<unsigned char>(string[i]);
+        if (character >= 0x20 && character != '"' && character != '\\')
+            continue;
+
+        // copy the run of characters that needed no escaping in one go
+        _buffer.insert(_buffer.end(), string.begin() + plainStart, string.begin() + i);
+        plainStart = i + 1;
+
+        _buffer.push_back('\\');
+        switch (character) {
+            case '"':
+            case '\\':
+                _buffer.push_back(character);
+                break;
+            case '\b':
+                _buffer.push_back('b');
+                break;
+            case '\t':
+                _buffer.push_back('t');
+                break;
+            case '\n':
+                _buffer.push_back('n');
+                break;
+            case '\f':
+                _buffer.push_back('f');
+                break;
+            case '\r':
+                _buffer.push_back('r');
+                break;
+            default:
+                writeRaw("u00");
+                _buffer.push_back(HEX_DIGITS[character >> 4]);
+                _buffer.push_back(HEX_DIGITS[character & 0xF]);
+                break;
+        }
+    }
+    _buffer.insert(_buffer.end(), string.begin() + plainStart, string.end());
+    _buffer.push_back('"');
+}
+
+std::vector<unsigned char> JsonDomWriter::finish() {
+    const auto payload = PayloadCodec::encode(_root);
+    std::vector<unsigned char> frame;
+    frame.reserve(FRAME_HEADER_SIZE + payload.size());
+    appendFrameHeader(frame, _responseId, payload.size());
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    return frame;
+}
+
+Json &JsonDomWriter::addValue(Json &&newValue) {
+    Json &parent = *_stack.back();
+    if (parent.is_array()) {
+        parent.push_back(std::move(newValue));
+        return parent.back();
+    }
+
+    // the root starts as null, the first beginObject() makes it the response object
+    if (_stack.size() == 1 && parent.is_null() && _pendingKey.empty()) {
+        parent = std::move(newValue);
+        return parent;
+    }
+
+    Json &child = parent[_pendingKey];
+    child = std::move(newValue);
+    _pendingKey.clear();
+    return child;
+}
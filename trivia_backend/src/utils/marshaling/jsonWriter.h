@@ -0,0 +1,144 @@
+#pragma once
+
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "payloadEncoding.h"
+#include "../responses/responses.h"
+
+// writes a whole response frame ([id][4 bytes length][json]) straight into one buffer, without building a json tree.
+// the length is patched in by finish(). keys must be written in the order nlohmann dumps them (its objects are
+// std::map, so byte-wise sorted keys) to keep the output identical to the tree based serialization
+class JsonWriter {
+public:
+    JsonWriter(ResponseId responseId, std::size_t reservedBytes);
+
+    void beginObject() { beginValue(); _buffer.push_back('{'); _needsComma = false; }
+
+    void beginObject(std::string_view key) { writeKey(key); beginObject(); }
+
+    void endObject() { _buffer.push_back('}'); _needsComma = true; }
+
+    void beginArray() { beginValue(); _buffer.push_back('['); _needsComma = false; }
+
+    void beginArray(std::string_view key) { writeKey(key); beginArray(); }
+
+    void endArray() { _buffer.push_back(']'); _needsComma = true; }
+
+    void value(bool boolean) {
+        beginValue();
+        writeRaw(boolean ? "true" : "false");
+        _needsComma = true;
+    }
+
+    template<typename Integer, std::enable_if_t<std::is_integral_v<Integer> && !std::is_same_v<Integer, bool>, int> = 0>
+    void value(Integer integer) {
+        beginValue();
+        char digits[24];
+        const auto [end, error] = std::to_chars(digits, digits + sizeof(digits), integer);
+        _buffer.insert(_buffer.end(), digits, end);
+        _needsComma = true;
+    }
+
+    void value(std::string_view string) {
+        beginValue();
+        writeString(string);
+        _needsComma = true;
+    }
+
+    void value(const char *string) { value(std::string_view(string)); }
+
+    void value(const std::string &string) { value(std::string_view(string)); }
+
+    void nullValue() {
+        beginValue();
+        writeRaw("null");
+        _needsComma = true;
+    }
+
+    template<typename T>
+    void field(std::string_view key, const T &fieldValue) {
+        writeKey(key);
+        value(fieldValue);
+    }
+
+    void nullField(std::string_view key) {
+        writeKey(key);
+        nullValue();
+    }
+
+    // patches the payload length into the header and hands over the frame
+    std::vector<unsigned char> finish();
+
+private:
+    void beginValue() {
+        if (_needsComma)
+            _buffer.push_back(',');
+    }
+
+    void writeKey(std::string_view key) {
+        beginValue();
+        writeString(key);
+        _buffer.push_back(':');
+        _needsComma = false;
+    }
+
+    void writeRaw(std::string_view raw) { _buffer.insert(_buffer.end(), raw.begin(), raw.end()); }
+
+    // escaped like nlohmann's dump(): the short escapes, \u00xx for the other control characters, utf-8 as is
+    void writeString(std::string_view string);
+
+    std::vector<unsigned char> _buffer;
+    bool _needsComma = false;
+};
+
+// same interface as JsonWriter, builds the json tree for the binary payload encodings (MessagePack / CBOR)
+class JsonDomWriter {
+public:
+    explicit JsonDomWriter(ResponseId responseId) : _responseId(responseId), _stack{&_root} {}
+
+    void beginObject() { _stack.push_back(&addValue(Json::object())); }
+
+    void beginObject(std::string_view key) { writeKey(key); beginObject(); }
+
+    void endObject() { _stack.pop_back(); }
+
+    void beginArray() { _stack.push_back(&addValue(Json::array())); }
+
+    void beginArray(std::string_view key) { writeKey(key); beginArray(); }
+
+    void endArray() { _stack.pop_back(); }
+
+    template<typename T>
+    void value(const T &fieldValue) { addValue(Json(fieldValue)); }
+
+    void nullValue() { addValue(Json(nullptr)); }
+
+    template<typename T>
+    void field(std::string_view key, const T &fieldValue) {
+        writeKey(key);
+        value(fieldValue);
+    }
+
+    void nullField(std::string_view key) {
+        writeKey(key);
+        nullValue();
+    }
+
+    // frame with the payload in the connection's encoding
+    std::vector<unsigned char> finish();
+
+private:
+    void writeKey(std::string_view key) { _pendingKey = key; }
+
+    // into the current object under the pending key, or at the end of the current array.
+    // a nested value stays on top of the stack until it ends, so the parent never reallocates under it
+    Json &addValue(Json &&newValue);
+
+    ResponseId _responseId;
+    Json _root;
+    std::vector<Json *> _stack;
+    std::string _pendingKey;
+};
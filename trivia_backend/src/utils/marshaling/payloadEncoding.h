@@ -0,0 +1,84 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using Json = nlohmann::json;
+
+// encoding of the frame payloads, the [id][length] framing and the field names are the same for all of them
+enum class PayloadEncoding : unsigned char {
+    JSON,
+    MESSAGE_PACK,
+    CBOR
+};
+
+// number of PayloadEncoding values, for tables indexed by encoding
+constexpr std::size_t PAYLOAD_ENCODINGS_COUNT = 3;
+
+inline const char *payloadEncodingToString(PayloadEncoding encoding) {
+    switch (encoding) {
+        case PayloadEncoding::MESSAGE_PACK:
+            return "msgpack";
+        case PayloadEncoding::CBOR:
+            return "cbor";
+        default:
+            return "json";
+    }
+}
+
+inline std::optional<PayloadEncoding> payloadEncodingFromString(const std::string &name) {
+    if (name == "json")
+        return PayloadEncoding::JSON;
+    if (name == "msgpack")
+        return PayloadEncoding::MESSAGE_PACK;
+    if (name == "cbor")
+        return PayloadEncoding::CBOR;
+    return std::nullopt;
+}
+
+// header only, so the tools (which don't link the server sources) speak the same encodings
+class PayloadCodec {
+public:
+    PayloadCodec() = delete;  // Prevent construction
+    ~PayloadCodec() = delete;  // Prevent destruction
+
+    // every client is served by its own thread, so the negotiated encoding of a connection is kept per thread.
+    // JSON until the client asks otherwise with CLIENT_HELLO
+    [[nodiscard]] static PayloadEncoding getEncoding() noexcept { return _encoding; }
+
+    static void setEncoding(PayloadEncoding encoding) noexcept { _encoding = encoding; }
+
+    static std::vector<unsigned char> encode(const Json &j) { return encode(j, _encoding); }
+
+    static std::vector<unsigned char> encode(const Json &j, PayloadEncoding encoding) {
+        switch (encoding) {
+            case PayloadEncoding::MESSAGE_PACK:
+                return Json::to_msgpack(j);
+            case PayloadEncoding::CBOR:
+                return Json::to_cbor(j);
+            default: {
+                const std::string jsonString = j.dump();
+                return {jsonString.begin(), jsonString.end()};
+            }
+        }
+    }
+
+    // discarded json (is_discarded()) when the buffer isn't valid in the encoding, never throws
+    static Json decode(const std::vector<unsigned char> &buffer) { return decode(buffer, _encoding); }
+
+    static Json decode(const std::vector<unsigned char> &buffer, PayloadEncoding encoding) {
+        switch (encoding) {
+            case PayloadEncoding::MESSAGE_PACK:
+                return Json::from_msgpack(buffer, true, false);
+            case PayloadEncoding::CBOR:
+                return Json::from_cbor(buffer, true, false);
+            default:
+                return Json::parse(buffer, nullptr, false);
+        }
+    }
+
+private:
+    static inline thread_local PayloadEncoding _encoding = PayloadEncoding::JSON;
+};
@@ -0,0 +1,175 @@
+#include "requestFieldReader.h"
+#include <cstring>
+#include <simdjson.h>
+#include "payloadEncoding.h"
+
+namespace {
+    RequestField *findField(RequestField *fields, std::size_t fieldsCount, std::string_view key) {
+        for (std::size_t i = 0; i < fieldsCount; i++) {
+            if (fields[i].key == key)
+                return &fields[i];
+        }
+        return nullptr;
+    }
+
+    void clearField(RequestField &field) {
+        field.string.clear();
+        field.strings.clear();
+        field.hasNonStringElement = false;
+    }
+
+    // the value must be fully consumed or left untouched, on-demand values can't be read twice
+    bool readJsonValue(simdjson::ondemand::value value, RequestField &field) {
+        clearField(field);
+
+        simdjson::ondemand::json_type type;
+        if (value.type().get(type) != simdjson::SUCCESS)
+            return false;
+
+        switch (type) {
+            case simdjson::ondemand::json_type::string: {
+                std::string_view string;
+                if (value.get_string().get(string) != simdjson::SUCCESS)
+                    return false;
+                field.type = RequestField::Type::STRING;
+                field.string = string;
+                return true;
+            }
+            case simdjson::ondemand::json_type::number: {
+                // get_uint64() only moves past the number when it succeeds, so floats and negatives are still
+                // parsed by get_double() to tell a malformed number from a number of another kind
+                if (value.get_uint64().get(field.number) == simdjson::SUCCESS) {
+                    field.type = RequestField::Type::UNSIGNED;
+                    return true;
+                }
+
+                double number;
+                field.type = RequestField::Type::OTHER;
+                return value.get_double().get(number) == simdjson::SUCCESS;
+            }
+            case simdjson::ondemand::json_type::null: {
+                bool isNull;
+                field.type = RequestField::Type::NULL_VALUE;
+                return value.is_null().get(isNull) == simdjson::SUCCESS && isNull;
+            }
+            case simdjson::ondemand::json_type::boolean:
+                field.type = RequestField::Type::BOOLEAN;
+                return value.get_bool().get(field.boolean) == simdjson::SUCCESS;
+            case simdjson::ondemand::json_type::array: {
+                simdjson::ondemand::array array;
+                if (value.get_array().get(array) != simdjson::SUCCESS)
+                    return false;
+
+                field.type = RequestField::Type::ARRAY;
+                for (auto element: array) {
+                    if (element.error() != simdjson::SUCCESS)
+                        return false;
+
+                    std::string_view string;
+                    if (element.get_string().get(string) == simdjson::SUCCESS)
+                        field.strings.emplace_back(string);
+                    else
+                        field.hasNonStringElement = true;
+                }
+                return true;
+            }
+            default:
+                // objects are not expected by any request, they are skipped by the next field
+                field.type = RequestField::Type::OTHER;
+                return true;
+        }
+    }
+
+    void readDecodedValue(const Json &value, RequestField &field) {
+        clearField(field);
+        if (value.is_string()) {
+            field.type = RequestField::Type::STRING;
+            field.string = value.get<std::string>();
+        } else if (value.is_number_unsigned()) {
+            field.type = RequestField::Type::UNSIGNED;
+            field.number = value.get<std::uint64_t>();
+        } else if (value.is_null()) {
+            field.type = RequestField::Type::NULL_VALUE;
+        } else if (value.is_boolean()) {
+            field.type = RequestField::Type::BOOLEAN;
+            field.boolean = value.get<bool>();
+        } else if (value.is_array()) {
+            field.type = RequestField::Type::ARRAY;
+            for (const auto &element: value) {
+                if (element.is_string())
+                    field.strings.push_back(element.get<std::string>());
+                else
+                    field.hasNonStringElement = true;
+            }
+        } else {
+            field.type = RequestField::Type::OTHER;
+        }
+    }
+}
+
+bool RequestFieldReader::readFields(const std::vector<unsigned char> &buffer, RequestField *fields,
+                                    std::size_t fieldsCount) {
+    if (PayloadCodec::getEncoding() == PayloadEncoding::JSON)
+        return readJsonFields(buffer, fields, fieldsCount);
+    return readDecodedFields(buffer, fields, fieldsCount);
+}
+
+bool RequestFieldReader::readJsonFields(const std::vector<unsigned char> &buffer, RequestField *fields,
+                                        std::size_t fieldsCount) {
+    // simdjson reads past the end of the input, so the request is copied into a padded buffer. both are reused
+    // by the client's thread, after the first requests no allocation is left
+    thread_local simdjson::ondemand::parser parser;
+    thread_local std::vector<char> paddedBuffer;
+    paddedBuffer.resize(buffer.size() + simdjson::SIMDJSON_PADDING);
+    std::memcpy(paddedBuffer.data(), buffer.data(), buffer.size());
+
+    simdjson::ondemand::document document;
+    if (parser.iterate(paddedBuffer.data(), buffer.size(), paddedBuffer.size()).get(document) != simdjson::SUCCESS)
+        return false;
+
+    simdjson::ondemand::json_type documentType;
+    if (document.type().get(documentType) != simdjson::SUCCESS)
+        return false;
+
+    // valid JSON that is not an object has none of the fields, a rare case left to a full validation
+    if (documentType != simdjson::ondemand::json_type::object)
+        return Json::accept(buffer);
+
+    simdjson::ondemand::object object;
+    if (document.get_object().get(object) != simdjson::SUCCESS)
+        return false;
+
+    for (auto objectField: object) {
+        std::string_view key;
+        if (objectField.unescaped_key().get(key) != simdjson::SUCCESS)
+            return false;
+
+        // values of keys the request doesn't use are skipped, not parsed
+        auto *field = findField(fields, fieldsCount, key);
+        if (field == nullptr)
+            continue;
+
+        simdjson::ondemand::value value;
+        if (objectField.value().get(value) != simdjson::SUCCESS || !readJsonValue(value, *field))
+            return false;
+    }
+
+    return document.at_end();
+}
+
+bool RequestFieldReader::readDecodedFields(const std::vector<unsigned char> &buffer, RequestField *fields,
+                                           std::size_t fieldsCount) {
+    const Json j = PayloadCodec::decode(buffer);
+    if (j.is_discarded())
+        return false;
+
+    if (!j.is_object())
+        return true;
+
+    for (std::size_t i = 0; i < fieldsCount; i++) {
+        const auto value = j.find(fields[i].key);
+        if (value != j.end())
+            readDecodedValue(*value, fields[i]);
+    }
+    return true;
+}
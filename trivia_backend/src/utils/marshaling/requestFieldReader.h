@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// a key a request expects and what the payload held under it
+struct RequestField {
+    enum class Type {
+        MISSING,
+        STRING,
+        UNSIGNED,   // a non negative integer, like nlohmann's is_number_unsigned()
+        NULL_VALUE,
+        BOOLEAN,
+        ARRAY,
+        OTHER
+    };
+
+    explicit RequestField(std::string_view key) : key(key) {}
+
+    [[nodiscard]] bool isMissing() const { return type == Type::MISSING; }
+
+    [[nodiscard]] bool isString() const { return type == Type::STRING; }
+
+    [[nodiscard]] bool isUnsigned() const { return type == Type::UNSIGNED; }
+
+    [[nodiscard]] bool isNull() const { return type == Type::NULL_VALUE; }
+
+    [[nodiscard]] bool isBoolean() const { return type == Type::BOOLEAN; }
+
+    [[nodiscard]] bool isArray() const { return type == Type::ARRAY; }
+
+    std::string_view key;
+    Type type = Type::MISSING;
+    std::string string;
+    std::uint64_t number = 0;
+    bool boolean = false;
+    std::vector<std::string> strings;   // the string elements of an array
+    bool hasNonStringElement = false;   // an array element that is not a string
+};
+
+// reads only the expected keys of a request payload, without building a json tree.
+// JSON payloads are scanned with simdjson's on-demand parser, the binary encodings go through nlohmann
+class RequestFieldReader {
+public:
+    RequestFieldReader() = delete;  // Prevent construction
+    ~RequestFieldReader() = delete;  // Prevent destruction
+
+    // false when the payload is not valid in the connection's encoding. a payload that is not an object leaves
+    // every field missing, and like nlohmann the last of duplicated keys wins
+    template<std::size_t N>
+    static bool readFields(const std::vector<unsigned char> &buffer, std::array<RequestField, N> &fields) {
+        return readFields(buffer, fields.data(), N);
+    }
+
+    static bool readFields(const std::vector<unsigned char> &buffer, RequestField *fields, std::size_t fieldsCount);
+
+private:
+    static bool readJsonFields(const std::vector<unsigned char> &buffer, RequestField *fields, std::size_t fieldsCount);
+
+    static bool readDecodedFields(const std::vector<unsigned char> &buffer, RequestField *fields,
+                                  std::size_t fieldsCount);
+};
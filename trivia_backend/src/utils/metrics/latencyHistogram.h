@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// lock-free histogram with HDR style buckets: each power of two is split in SUB_BUCKETS_COUNT linear sub-buckets, so a
+// percentile is within 1/SUB_BUCKETS_COUNT (6.25%) of the recorded value. values below SUB_BUCKETS_COUNT are exact.
+// the unit of the recorded values is up to the caller (ns for locks, us for requests...)
+class LatencyHistogram {
+public:
+    static constexpr std::size_t SUB_BUCKET_BITS = 4;
+    static constexpr std::size_t SUB_BUCKETS_COUNT = std::size_t{1} << SUB_BUCKET_BITS;
+    // the exact values, then the sub-buckets of each bit width above SUB_BUCKET_BITS
+    static constexpr std::size_t BUCKETS_COUNT = SUB_BUCKETS_COUNT + (64 - SUB_BUCKET_BITS) * SUB_BUCKETS_COUNT;
+
+    void record(std::uint64_t value) {
+        _buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(value, std::memory_order_relaxed);
+
+        auto currentMax = _max.load(std::memory_order_relaxed);
+        while (value > currentMax && !_max.compare_exchange_weak(currentMax, value, std::memory_order_relaxed));
+    }
+
+    [[nodiscard]] std::uint64_t count() const { return _count.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] std::uint64_t sum() const { return _sum.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] std::uint64_t max() const { return _max.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] std::uint64_t average() const {
+        const auto valuesCount = count();
+        return valuesCount == 0 ? 0 : sum() / valuesCount;
+    }
+
+    // upper bound of the sub-bucket holding the requested percentile (0-100), never above the recorded max
+    [[nodiscard]] std::uint64_t percentile(double percent) const {
+        const auto valuesCount = count();
+        if (valuesCount == 0)
+            return 0;
+
+        const auto rank = static_cast<std::uint64_t>(static_cast<double>(valuesCount) * percent / 100.0);
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < BUCKETS_COUNT; i++) {
+            seen += _buckets[i].load(std::memory_order_relaxed);
+            if (seen > rank) {
+                const auto bucketUpperBound = upperBound(i);
+                return bucketUpperBound < max() ? bucketUpperBound : max();
+            }
+        }
+        return max();
+    }
+
+    void reset() {
+        for (auto &bucket: _buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        _count.store(0, std::memory_order_relaxed);
+        _sum.store(0, std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    // the bits after the leading one pick the sub-bucket of the value's bit width
+    static std::size_t bucketIndex(std::uint64_t value) {
+        if (value < SUB_BUCKETS_COUNT)
+            return static_cast<std::size_t>(value);
+
+        const auto shift = 64 - static_cast<std::size_t>(__builtin_clzll(value)) - SUB_BUCKET_BITS - 1;
+        const auto subBucket = static_cast<std::size_t>(value >> shift) & (SUB_BUCKETS_COUNT - 1);
+        return SUB_BUCKETS_COUNT + shift * SUB_BUCKETS_COUNT + subBucket;
+    }
+
+    static std::uint64_t upperBound(std::size_t bucketIndex) {
+        if (bucketIndex < SUB_BUCKETS_COUNT)
+            return bucketIndex;
+
+        const auto shift = (bucketIndex - SUB_BUCKETS_COUNT) / SUB_BUCKETS_COUNT;
+        const auto subBucket = (bucketIndex - SUB_BUCKETS_COUNT) % SUB_BUCKETS_COUNT;
+        const auto lowerBound = static_cast<std::uint64_t>(SUB_BUCKETS_COUNT + subBucket) << shift;
+        return lowerBound + ((std::uint64_t{1} << shift) - 1);
+    }
+
+    std::array<std::atomic<std::uint64_t>, BUCKETS_COUNT> _buckets{};
+    std::atomic<std::uint64_t> _count{0};
+    std::atomic<std::uint64_t> _sum{0};
+    std::atomic<std::uint64_t> _max{0};
+};
@@ -0,0 +1,246 @@
+#include "passwordHasher.h"
+#include <cstdio>
+#include <future>
+#include <optional>
+#include <fmt/format.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include "../tracer/tracer.h"
+
+namespace {
+    constexpr std::string_view SCRYPT_PREFIX = "$scrypt$";
+    constexpr std::uint64_t SCRYPT_BLOCK_SIZE = 8;
+    constexpr std::uint64_t SCRYPT_PARALLELIZATION = 1;
+    constexpr std::size_t SALT_SIZE = 16;
+    constexpr std::size_t HASH_SIZE = 32;
+    constexpr std::string_view PASSWORD_ALPHABET = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+    std::string toHex(const std::string &bytes) {
+        std::string hex;
+        hex.reserve(bytes.size() * 2);
+        for (const auto byte: bytes)
+            hex += fmt::format("{:02x}", static_cast<unsigned char>(byte));
+        return hex;
+    }
+
+    std::optional<std::string> fromHex(std::string_view hex) {
+        if (hex.size() % 2 != 0)
+            return std::nullopt;
+
+        const auto nibble = [](char digit) -> int {
+            if (digit >= '0' && digit <= '9')
+                return digit - '0';
+            if (digit >= 'a' && digit <= 'f')
+                return digit - 'a' + 10;
+            return -1;
+        };
+
+        std::string bytes;
+        bytes.reserve(hex.size() / 2);
+        for (std::size_t i = 0; i < hex.size(); i += 2) {
+            const int high = nibble(hex[i]);
+            const int low = nibble(hex[i + 1]);
+            if (high < 0 || low < 0)
+                return std::nullopt;
+            bytes += static_cast<char>(high * 16 + low);
+        }
+        return bytes;
+    }
+
+    bool constantTimeEquals(const std::string &first, const std::string &second) {
+        return first.size() == second.size() && CRYPTO_memcmp(first.data(), second.data(), first.size()) == 0;
+    }
+
+    std::uint64_t microsecondsSince(const std::chrono::steady_clock::time_point &start) {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+void PasswordHasher::start(const PasswordHashingConfig &config) {
+    std::lock_guard lock(_jobsMutex);
+    if (!_workers.empty())
+        return;
+
+    _config = config;
+    for (unsigned int i = 0; i < _config.workers; i++)
+        _workers.emplace_back(&PasswordHasher::workerLoop);
+}
+
+void PasswordHasher::stop() {
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard lock(_jobsMutex);
+        _isStopping = true;
+        workers.swap(_workers);
+    }
+    _jobsChanged.notify_all();
+
+    for (auto &worker: workers)
+        worker.join();
+}
+
+Result<std::string> PasswordHasher::hash(const std::string &password) {
+    std::string salt(SALT_SIZE, '\0');
+    if (RAND_bytes(reinterpret_cast<unsigned char *>(salt.data()), static_cast<int>(salt.size())) != 1)
+        return Error(ErrorType::Unknown, "Failed to generate a password salt");
+
+    const ScryptParameters parameters{_config.costLog2, SCRYPT_BLOCK_SIZE, SCRYPT_PARALLELIZATION};
+    const auto derivedKey = runOnWorker(password, salt, parameters);
+    if (derivedKey.isError())
+        return derivedKey.error();
+
+    return fmt::format("{}ln={},r={},p={}${}${}", SCRYPT_PREFIX, parameters.costLog2, parameters.blockSize,
+                       parameters.parallelization, toHex(salt), toHex(derivedKey.value()));
+}
+
+Result<PasswordCheck> PasswordHasher::verify(const std::string &password, const std::string &storedPassword) {
+    // accounts from before hashing, they are hashed on their next login
+    if (storedPassword.compare(0, SCRYPT_PREFIX.size(), SCRYPT_PREFIX) != 0)
+        return PasswordCheck{constantTimeEquals(password, storedPassword), true};
+
+    // "$scrypt$ln=15,r=8,p=1$<salt>$<hash>"
+    unsigned long long costLog2 = 0, blockSize = 0, parallelization = 0;
+    int parametersLength = 0;
+    const auto parametersStart = storedPassword.c_str() + SCRYPT_PREFIX.size();
+    if (std::sscanf(parametersStart, "ln=%llu,r=%llu,p=%llu$%n", &costLog2, &blockSize, &parallelization,
+                    &parametersLength) != 3 || parametersLength == 0)
+        return Error(ErrorType::Database, "Invalid stored password hash");
+
+    // also keeps a corrupted row from asking for gigabytes
+    if (costLog2 < 1 || costLog2 > 24 || blockSize < 1 || blockSize > 32 || parallelization < 1 || parallelization > 16)
+        return Error(ErrorType::Database, "Invalid stored password hash");
+    const ScryptParameters parameters{costLog2, blockSize, parallelization};
+
+    const std::string_view saltAndHash(parametersStart + parametersLength);
+    const auto separator = saltAndHash.find('$');
+    if (separator == std::string_view::npos)
+        return Error(ErrorType::Database, "Invalid stored password hash");
+
+    const auto salt = fromHex(saltAndHash.substr(0, separator));
+    const auto expectedHash = fromHex(saltAndHash.substr(separator + 1));
+    if (!salt.has_value() || !expectedHash.has_value() || expectedHash->size() != HASH_SIZE)
+        return Error(ErrorType::Database, "Invalid stored password hash");
+
+    const auto derivedKey = runOnWorker(password, salt.value(), parameters);
+    if (derivedKey.isError())
+        return derivedKey.error();
+
+    const bool needsRehash = parameters.costLog2 != _config.costLog2 || parameters.blockSize != SCRYPT_BLOCK_SIZE ||
+                             parameters.parallelization != SCRYPT_PARALLELIZATION;
+    return PasswordCheck{constantTimeEquals(derivedKey.value(), expectedHash.value()), needsRehash};
+}
+
+std::string PasswordHasher::generatePassword(std::size_t length) {
+    std::string password;
+    while (password.size() < length) {
+        unsigned char randomBytes[32];
+        if (RAND_bytes(randomBytes, sizeof(randomBytes)) != 1)
+            continue;
+
+        for (const auto randomByte: randomBytes) {
+            // 248 is the largest multiple of the alphabet size below 256, higher bytes would favor the first letters
+            if (randomByte >= 248 || password.size() == length)
+                continue;
+            password += PASSWORD_ALPHABET[randomByte % PASSWORD_ALPHABET.size()];
+        }
+    }
+    return password;
+}
+
+std::string PasswordHasher::report() {
+    std::size_t queuedJobs;
+    {
+        std::lock_guard lock(_jobsMutex);
+        queuedJobs = _jobs.size();
+    }
+
+    std::string report = fmt::format("{:>10}{:>10}{:>10}{:>12}{:>12}{:>12}{:>12}{:>12}\n",
+                                     "hashes", "refused", "queued", "wait p50", "wait p99", "wait max",
+                                     "hash avg", "hash p99");
+    report += fmt::format("{:>10}{:>10}{:>10}{:>10.1f}ms{:>10.1f}ms{:>10.1f}ms{:>10.1f}ms{:>10.1f}ms\n",
+                          _hashTime.count(), _refusedJobs.load(), queuedJobs,
+                          static_cast<double>(_queueWait.percentile(50)) / 1000.0,
+                          static_cast<double>(_queueWait.percentile(99)) / 1000.0,
+                          static_cast<double>(_queueWait.max()) / 1000.0,
+                          static_cast<double>(_hashTime.average()) / 1000.0,
+                          static_cast<double>(_hashTime.percentile(99)) / 1000.0);
+    return report;
+}
+
+void PasswordHasher::resetStats() {
+    _queueWait.reset();
+    _hashTime.reset();
+    _refusedJobs = 0;
+}
+
+bool PasswordHasher::enqueue(std::function<void()> job) {
+    {
+        std::lock_guard lock(_jobsMutex);
+        if (_isStopping || _jobs.size() >= _config.queueLimit) {
+            _refusedJobs.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        _jobs.push_back(HashJob{std::move(job), std::chrono::steady_clock::now()});
+    }
+    _jobsChanged.notify_one();
+    return true;
+}
+
+Result<std::string> PasswordHasher::runOnWorker(const std::string &password, const std::string &salt,
+                                                const ScryptParameters &parameters) {
+    {
+        // without start() (tools and benchmarks linking the server code) there is no pool to wait for
+        std::lock_guard lock(_jobsMutex);
+        if (_workers.empty() && !_isStopping)
+            return scrypt(password, salt, parameters);
+    }
+
+    auto promise = std::make_shared<std::promise<Result<std::string>>>();
+    auto derivedKey = promise->get_future();
+    const bool isQueued = enqueue([promise, password, salt, parameters]() {
+        promise->set_value(scrypt(password, salt, parameters));
+    });
+    if (!isQueued)
+        return Error(ErrorType::ServerBusy);
+
+    return derivedKey.get();
+}
+
+Result<std::string> PasswordHasher::scrypt(const std::string &password, const std::string &salt,
+                                           const ScryptParameters &parameters) {
+    const TraceSpan span("password", __func__);
+    const std::uint64_t costFactor = std::uint64_t{1} << parameters.costLog2;
+    // OpenSSL refuses above 32MB by default, this is what the parameters need: 128 * r * (N + p + 2) bytes
+    const std::uint64_t maxMemory = 128 * parameters.blockSize * (costFactor + parameters.parallelization + 2);
+
+    std::string derivedKey(HASH_SIZE, '\0');
+    const int isHashed = EVP_PBE_scrypt(password.data(), password.size(),
+                                        reinterpret_cast<const unsigned char *>(salt.data()), salt.size(),
+                                        costFactor, parameters.blockSize, parameters.parallelization, maxMemory,
+                                        reinterpret_cast<unsigned char *>(derivedKey.data()), derivedKey.size());
+    if (isHashed != 1)
+        return Error(ErrorType::Unknown, "Failed to hash the password");
+
+    return derivedKey;
+}
+
+void PasswordHasher::workerLoop() {
+    while (true) {
+        std::unique_lock lock(_jobsMutex);
+        _jobsChanged.wait(lock, []() { return _isStopping || !_jobs.empty(); });
+        if (_jobs.empty())
+            return;     // stopping, and every queued hash is done
+
+        auto job = std::move(_jobs.front());
+        _jobs.pop_front();
+        lock.unlock();
+
+        _queueWait.record(microsecondsSince(job.queuedAt));
+        const auto hashStart = std::chrono::steady_clock::now();
+        job.run();
+        _hashTime.record(microsecondsSince(hashStart));
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../errors/result.h"
+#include "../metrics/latencyHistogram.h"
+
+struct PasswordHashingConfig {
+    unsigned int workers;       // hashes computed at once, each takes 128 * 2^costLog2 * 8 bytes of memory
+    unsigned int costLog2;      // scrypt N = 2^costLog2
+    unsigned int queueLimit;    // hashes waiting for a worker before new ones are refused
+};
+
+struct PasswordCheck {
+    bool isMatch;
+    bool needsRehash;   // stored in plaintext or with another cost than the configured one
+};
+
+// salted scrypt (OpenSSL) on a small pool of dedicated threads. the hashes are memory hard on purpose, so a burst
+// of logins must not run them all at once on the connections' threads: the callers block until a worker is done,
+// and are refused when the queue is full.
+// stored as "$scrypt$ln=<costLog2>,r=<r>,p=<p>$<hex salt>$<hex hash>"
+class PasswordHasher {
+public:
+    PasswordHasher() = delete;  // Prevent construction
+    ~PasswordHasher() = delete;  // Prevent destruction
+
+    // before the server accepts clients
+    static void start(const PasswordHashingConfig &config);
+
+    // waits for the queued hashes
+    static void stop();
+
+    static Result<std::string> hash(const std::string &password);
+
+    // storedPassword is a hash from hash() or a plaintext password from before hashing
+    static Result<PasswordCheck> verify(const std::string &password, const std::string &storedPassword);
+
+    // random letters and digits, for temporary passwords
+    static std::string generatePassword(std::size_t length);
+
+    // queue wait and hash time of the hashes done so far
+    static std::string report();
+
+    static void resetStats();
+
+private:
+    struct ScryptParameters {
+        std::uint64_t costLog2;
+        std::uint64_t blockSize;
+        std::uint64_t parallelization;
+    };
+
+    struct HashJob {
+        std::function<void()> run;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    // false when the queue is full or the pool is stopped
+    static bool enqueue(std::function<void()> job);
+
+    // runs the hash on a worker and waits for it
+    static Result<std::string> runOnWorker(const std::string &password, const std::string &salt,
+                                           const ScryptParameters &parameters);
+
+    static Result<std::string> scrypt(const std::string &password, const std::string &salt,
+                                      const ScryptParameters &parameters);
+
+    static void workerLoop();
+
+    static inline PasswordHashingConfig _config{1, 15, 256};
+    static inline std::vector<std::thread> _workers;
+    static inline std::deque<HashJob> _jobs;
+    static inline std::mutex _jobsMutex;
+    static inline std::condition_variable _jobsChanged;
+    static inline bool _isStopping = false;
+
+    static inline LatencyHistogram _queueWait;  // us
+    static inline LatencyHistogram _hashTime;   // us
+    static inline std::atomic<std::uint64_t> _refusedJobs{0};
+};
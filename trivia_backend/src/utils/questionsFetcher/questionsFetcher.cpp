@@ -6,7 +6,10 @@
 
 using Json = nlohmann::json;
 
-Result<std::list<QuestionDb>> QuestionsFetcher::fetchQuestions(unsigned int amount) {
+Result<std::list<QuestionDb>> QuestionsFetcher::fetchQuestions(unsigned int amount, unsigned int storedQuestionsCount) {
+    if (_useStandIn)
+        return generateStandInQuestions(amount, storedQuestionsCount);
+
     logServerProgress<QuestionsFetcher>(__func__, "Fetching " + std::to_string(amount) + " questions from OpenTDB...");
 
     httplib::Client client(OPENTDB_BASE_URL);
@@ -80,4 +83,20 @@ Result<QuestionDb> QuestionsFetcher::deserializeQuestion(const Json &question) {
             httplib::detail::decode_url(question["incorrect_answers"][1], false),
             httplib::detail::decode_url(question["incorrect_answers"][2], false)
     );
-}
\ No newline at end of file
+}
+
+std::list<QuestionDb> QuestionsFetcher::generateStandInQuestions(unsigned int amount, unsigned int storedQuestionsCount) {
+    static std::atomic<unsigned int> nextQuestionNumber{1};    // keeps the generated questions distinct across calls
+    // and after the questions of the previous runs
+    auto firstQuestionNumber = nextQuestionNumber.load();
+    while (firstQuestionNumber <= storedQuestionsCount &&
+           !nextQuestionNumber.compare_exchange_weak(firstQuestionNumber, storedQuestionsCount + 1)) {}
+
+    std::list<QuestionDb> questions;
+    for (unsigned int i = 0; i < amount; i++) {
+        const auto questionNumber = std::to_string(nextQuestionNumber++);
+        questions.emplace_back("Stand-in question #" + questionNumber + "?", "Correct " + questionNumber,
+                               "Wrong A " + questionNumber, "Wrong B " + questionNumber, "Wrong C " + questionNumber);
+    }
+    return questions;
+}
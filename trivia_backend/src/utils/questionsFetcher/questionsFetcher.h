@@ -1,5 +1,6 @@
 #pragma once
 #include <list>
+#include <atomic>
 #include "../databaseAccess/QuestionDb.h"
 #include "../../errors/result.h"
 #include "../conversionHelper/conversionHelper.h"
@@ -10,10 +11,19 @@ public:
     QuestionsFetcher() = delete;
     ~QuestionsFetcher() = delete;
 
-    static Result<std::list<QuestionDb>> fetchQuestions(unsigned int amount);
+    // storedQuestionsCount is how many questions the database already holds, the stand-in numbers its questions
+    // after them so they stay distinct across runs
+    static Result<std::list<QuestionDb>> fetchQuestions(unsigned int amount, unsigned int storedQuestionsCount);
+
+    // the stand-in generates the questions locally instead of calling OpenTDB, only ever into the stand-in database
+    static void setUseStandIn(bool useStandIn) { _useStandIn = useStandIn; }
 
 private:
+    static std::list<QuestionDb> generateStandInQuestions(unsigned int amount, unsigned int storedQuestionsCount);
+
     static Result<std::list<QuestionDb>> deserializeQuestions(const Json& json);
 
     static Result<QuestionDb> deserializeQuestion(const Json& json);
+
+    static inline std::atomic<bool> _useStandIn{false};
 };
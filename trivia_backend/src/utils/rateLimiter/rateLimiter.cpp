@@ -0,0 +1,119 @@
+#include "rateLimiter.h"
+#include <algorithm>
+#include <mutex>
+#include <utility>
+#include <fmt/format.h>
+#include "../marshaling/jsonSerializer.h"
+
+namespace {
+    constexpr std::size_t REPORTED_OFFENDERS_COUNT = 10;
+}
+
+RateLimiter::Connection::Connection(std::string address) : _address(std::move(address)) {
+    const auto now = std::chrono::steady_clock::now();
+    // the limits are only changed before the server starts, reading them unlocked is fine
+    for (std::size_t i = 0; i < REQUEST_PRIORITIES_COUNT; i++)
+        _buckets[i] = TokenBucket{static_cast<double>(_limits[i].burst), now};
+}
+
+bool RateLimiter::Connection::tryTake(RequestPriority requestClass) {
+    const auto classIndex = static_cast<std::size_t>(requestClass);
+    const auto &limit = _limits[classIndex];
+    auto &bucket = _buckets[classIndex];
+
+    const auto now = std::chrono::steady_clock::now();
+    const std::chrono::duration<double> elapsed = now - bucket.refilledAt;
+    bucket.tokens = std::min(static_cast<double>(limit.burst),
+                             bucket.tokens + elapsed.count() * static_cast<double>(limit.requestsPerSecond));
+    bucket.refilledAt = now;
+
+    if (bucket.tokens >= 1.0) {
+        bucket.tokens -= 1.0;
+        return true;
+    }
+
+    recordThrottled(_address, classIndex);
+    return false;
+}
+
+void RateLimiter::configure(const RateLimits &limits) {
+    _limits = limits;
+
+    // built once for every encoding, a throttled request costs no serialization
+    const auto connectionEncoding = PayloadCodec::getEncoding();
+    for (std::size_t i = 0; i < PAYLOAD_ENCODINGS_COUNT; i++) {
+        PayloadCodec::setEncoding(static_cast<PayloadEncoding>(i));
+        _throttledFrames[i] = std::make_shared<const std::vector<unsigned char>>(
+                JsonSerializer::serializeResponse(ErrorResponse{"Too many requests, slow down"}));
+    }
+    PayloadCodec::setEncoding(connectionEncoding);
+}
+
+std::shared_ptr<const std::vector<unsigned char>> RateLimiter::getThrottledFrame() {
+    return _throttledFrames[static_cast<std::size_t>(PayloadCodec::getEncoding())];
+}
+
+std::string RateLimiter::report() {
+    std::vector<std::pair<std::string, Offender>> offenders;
+    std::uint64_t untrackedThrottledRequests;
+    {
+        std::lock_guard lock(_offendersMutex);
+        offenders.assign(_offenders.begin(), _offenders.end());
+        untrackedThrottledRequests = _untrackedThrottledRequests;
+    }
+
+    std::string report = fmt::format("{:<8}{:>12}{:>8}{:>12}\n", "class", "per second", "burst", "throttled");
+    for (std::size_t i = 0; i < REQUEST_PRIORITIES_COUNT; i++) {
+        report += fmt::format("{:<8}{:>12}{:>8}{:>12}\n", requestClassToString(i), _limits[i].requestsPerSecond,
+                              _limits[i].burst, _throttledRequests[i].load());
+    }
+
+    const auto reportedCount = std::min(offenders.size(), REPORTED_OFFENDERS_COUNT);
+    std::partial_sort(offenders.begin(), offenders.begin() + static_cast<std::ptrdiff_t>(reportedCount),
+                      offenders.end(), [](const auto &first, const auto &second) {
+                          return first.second.total > second.second.total;
+                      });
+
+    report += fmt::format("\n{:<40}{:>10}{:>8}{:>8}{:>8}{:>8}\n", "address", "throttled", "game", "room", "lobby",
+                          "other");
+    for (std::size_t i = 0; i < reportedCount; i++) {
+        const auto &[address, offender] = offenders[i];
+        report += fmt::format("{:<40}{:>10}{:>8}{:>8}{:>8}{:>8}\n", address, offender.total,
+                              offender.throttledRequests[0], offender.throttledRequests[1],
+                              offender.throttledRequests[2], offender.throttledRequests[3]);
+    }
+    if (untrackedThrottledRequests != 0)
+        report += fmt::format("{:<40}{:>10}\n", "(untracked addresses)", untrackedThrottledRequests);
+    return report;
+}
+
+void RateLimiter::resetStats() {
+    for (auto &throttledRequests: _throttledRequests)
+        throttledRequests = 0;
+
+    std::lock_guard lock(_offendersMutex);
+    _offenders.clear();
+    _untrackedThrottledRequests = 0;
+}
+
+const char *RateLimiter::requestClassToString(std::size_t classIndex) {
+    const auto requestClass = static_cast<RequestPriority>(classIndex);
+    return requestClass == RequestPriority::UNSCHEDULED ? "other" : requestPriorityToString(requestClass);
+}
+
+void RateLimiter::recordThrottled(const std::string &address, std::size_t classIndex) {
+    _throttledRequests[classIndex].fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard lock(_offendersMutex);
+    auto offender = _offenders.find(address);
+    if (offender == _offenders.end()) {
+        if (_offenders.size() >= MAX_TRACKED_RATE_LIMITED_ADDRESSES) {
+            _untrackedThrottledRequests++;
+            return;
+        }
+        offender = _offenders.emplace(address, Offender{}).first;
+    }
+
+    offender->second.throttledRequests[classIndex]++;
+    offender->second.total++;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../requests/requests.h"
+#include "../../constants.h"
+#include "../lockProfiler/lockProfiler.h"
+#include "../marshaling/payloadEncoding.h"
+
+struct RateLimit {
+    unsigned int requestsPerSecond;
+    unsigned int burst;     // requests made at once after being idle
+};
+
+// by RequestPriority, "other" for the unscheduled requests
+using RateLimits = std::array<RateLimit, REQUEST_PRIORITIES_COUNT>;
+
+// token buckets per connection and request class, checked before the request is deserialized or handled. a client
+// looping a request (e.g. the rooms list, which costs database queries) is answered with a prebuilt error frame once
+// its bucket is empty, and its address is counted in the report
+class RateLimiter {
+public:
+    RateLimiter() = delete;  // Prevent construction
+    ~RateLimiter() = delete;  // Prevent destruction
+
+    // the buckets of one connection, used by its thread only
+    class Connection {
+    public:
+        // full buckets
+        explicit Connection(std::string address);
+
+        // false when the class's bucket is empty, the request must be answered with getThrottledFrame
+        bool tryTake(RequestPriority requestClass);
+
+    private:
+        struct TokenBucket {
+            double tokens;
+            std::chrono::steady_clock::time_point refilledAt;
+        };
+
+        std::string _address;
+        std::array<TokenBucket, REQUEST_PRIORITIES_COUNT> _buckets;
+    };
+
+    // before the server accepts clients, also serializes the throttled frames
+    static void configure(const RateLimits &limits);
+
+    // the error frame in the connection's payload encoding
+    static std::shared_ptr<const std::vector<unsigned char>> getThrottledFrame();
+
+    // throttled requests per class and the addresses throttled the most
+    static std::string report();
+
+    static void resetStats();
+
+    static const char *requestClassToString(std::size_t classIndex);
+
+private:
+    struct Offender {
+        std::array<std::uint64_t, REQUEST_PRIORITIES_COUNT> throttledRequests{};
+        std::uint64_t total = 0;
+    };
+
+    static void recordThrottled(const std::string &address, std::size_t classIndex);
+
+    static inline RateLimits _limits{{{DEFAULT_GAME_REQUESTS_PER_SECOND, DEFAULT_GAME_REQUESTS_BURST},
+                                      {DEFAULT_ROOM_REQUESTS_PER_SECOND, DEFAULT_ROOM_REQUESTS_BURST},
+                                      {DEFAULT_LOBBY_REQUESTS_PER_SECOND, DEFAULT_LOBBY_REQUESTS_BURST},
+                                      {DEFAULT_OTHER_REQUESTS_PER_SECOND, DEFAULT_OTHER_REQUESTS_BURST}}};
+    static inline std::array<std::shared_ptr<const std::vector<unsigned char>>, PAYLOAD_ENCODINGS_COUNT> _throttledFrames;
+
+    static inline std::array<std::atomic<std::uint64_t>, REQUEST_PRIORITIES_COUNT> _throttledRequests{};
+    // only written when a request is throttled, so the requests within their limits never take it
+    static inline std::unordered_map<std::string, Offender> _offenders;     // address -> throttled requests
+    static inline std::uint64_t _untrackedThrottledRequests = 0;           // guarded by _offendersMutex
+    static inline ProfiledMutex _offendersMutex{"RateLimiter::_offendersMutex"};
+};
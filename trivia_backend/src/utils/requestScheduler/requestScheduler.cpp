@@ -0,0 +1,120 @@
+#include "requestScheduler.h"
+#include <algorithm>
+#include <fmt/format.h>
+
+namespace {
+    std::uint64_t microsecondsSince(const std::chrono::steady_clock::time_point &start) {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+RequestScheduler::Slot::Slot(RequestPriority priority) : _isScheduled(priority != RequestPriority::UNSCHEDULED) {
+    _isAcquired = !_isScheduled || acquire(priority);
+}
+
+RequestScheduler::Slot::~Slot() {
+    if (_isScheduled && _isAcquired)
+        release();
+}
+
+void RequestScheduler::configure(const SchedulerConfig &config) {
+    std::lock_guard lock(_mutex);
+    _config = config;
+}
+
+unsigned int RequestScheduler::getRetryAfterMs() {
+    std::lock_guard lock(_mutex);
+    return _config.shedAfterMs;
+}
+
+std::string RequestScheduler::report() {
+    unsigned int runningRequests;
+    std::array<std::size_t, SCHEDULED_PRIORITIES_COUNT> waiting{};
+    SchedulerConfig config{};
+    {
+        std::lock_guard lock(_mutex);
+        runningRequests = _runningRequests;
+        config = _config;
+        for (std::size_t i = 0; i < SCHEDULED_PRIORITIES_COUNT; i++)
+            waiting[i] = _waiters[i].size();
+    }
+
+    std::string report = fmt::format("{} of {} slots in use, lobby requests shed after {}ms\n", runningRequests,
+                                     config.concurrency, config.shedAfterMs);
+    report += fmt::format("{:<8}{:>10}{:>10}{:>10}{:>12}{:>12}{:>12}\n", "class", "handled", "waiting", "shed",
+                          "wait p50", "wait p99", "wait max");
+    for (std::size_t i = 0; i < SCHEDULED_PRIORITIES_COUNT; i++) {
+        const auto &queueWait = _queueWait[i];
+        report += fmt::format("{:<8}{:>10}{:>10}{:>10}{:>10.1f}ms{:>10.1f}ms{:>10.1f}ms\n",
+                              requestPriorityToString(static_cast<RequestPriority>(i)), queueWait.count(), waiting[i],
+                              _shedRequests[i].load(), static_cast<double>(queueWait.percentile(50)) / 1000.0,
+                              static_cast<double>(queueWait.percentile(99)) / 1000.0,
+                              static_cast<double>(queueWait.max()) / 1000.0);
+    }
+    return report;
+}
+
+void RequestScheduler::resetStats() {
+    for (std::size_t i = 0; i < SCHEDULED_PRIORITIES_COUNT; i++) {
+        _queueWait[i].reset();
+        _shedRequests[i] = 0;
+    }
+}
+
+bool RequestScheduler::acquire(RequestPriority priority) {
+    const auto priorityIndex = static_cast<std::size_t>(priority);
+    const bool isSheddable = priority == RequestPriority::LOBBY;
+    const auto queuedAt = std::chrono::steady_clock::now();
+
+    std::unique_lock lock(_mutex);
+    auto &waiters = _waiters[priorityIndex];
+    const auto shedAfter = std::chrono::milliseconds(_config.shedAfterMs);
+
+    // the oldest lobby request already waited too long, this one would wait even longer: refused right away
+    if (isSheddable && !waiters.empty() && queuedAt - waiters.front().queuedAt > shedAfter) {
+        _shedRequests[priorityIndex].fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const auto ticket = _nextTicket++;
+    waiters.push_back(Waiter{ticket, queuedAt});
+    const auto isMyTurn = [priorityIndex, ticket]() {
+        return _runningRequests < _config.concurrency && isNextInLine(priorityIndex, ticket);
+    };
+
+    const bool isAcquired = isSheddable ? _slotsChanged.wait_until(lock, queuedAt + shedAfter, isMyTurn)
+                                        : (_slotsChanged.wait(lock, isMyTurn), true);
+    if (!isAcquired) {
+        waiters.erase(std::find_if(waiters.begin(), waiters.end(),
+                                   [ticket](const Waiter &waiter) { return waiter.ticket == ticket; }));
+        _shedRequests[priorityIndex].fetch_add(1, std::memory_order_relaxed);
+        lock.unlock();
+        _slotsChanged.notify_all();     // someone else may be next in line now
+        return false;
+    }
+
+    waiters.pop_front();
+    _runningRequests++;
+    lock.unlock();
+
+    _queueWait[priorityIndex].record(microsecondsSince(queuedAt));
+    _slotsChanged.notify_all();     // the next in line may take another free slot
+    return true;
+}
+
+void RequestScheduler::release() {
+    {
+        std::lock_guard lock(_mutex);
+        _runningRequests--;
+    }
+    _slotsChanged.notify_all();
+}
+
+bool RequestScheduler::isNextInLine(std::size_t priorityIndex, std::uint64_t ticket) {
+    for (std::size_t i = 0; i < priorityIndex; i++) {
+        if (!_waiters[i].empty())
+            return false;
+    }
+    return _waiters[priorityIndex].front().ticket == ticket;
+}
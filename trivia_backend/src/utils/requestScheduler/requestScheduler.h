@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include "../requests/requests.h"
+#include "../../constants.h"
+#include "../metrics/latencyHistogram.h"
+
+struct SchedulerConfig {
+    unsigned int concurrency;   // scheduled requests handled at once, the others wait for their turn
+    unsigned int shedAfterMs;   // lobby requests waiting longer are answered RETRY_LATER
+};
+
+// every connection has its own thread, so under load they all compete for the cores and the database lock at once.
+// the scheduled requests (see RequestPriority) take one of a few slots first: a free slot goes to the longest waiting
+// request of the most urgent class, so game requests don't queue behind lobby browsing. lobby requests that wait too
+// long are shed instead of being handled late
+class RequestScheduler {
+public:
+    RequestScheduler() = delete;  // Prevent construction
+    ~RequestScheduler() = delete;  // Prevent destruction
+
+    // a slot held while a request is handled, waits for its turn on construction
+    class Slot {
+    public:
+        explicit Slot(RequestPriority priority);
+        ~Slot();
+
+        Slot(const Slot &) = delete;
+        Slot &operator=(const Slot &) = delete;
+
+        // false when the request was shed, it is answered with RETRY_LATER without being handled
+        [[nodiscard]] bool isAcquired() const { return _isAcquired; }
+
+    private:
+        bool _isAcquired = false;
+        bool _isScheduled;
+    };
+
+    // before the server accepts clients
+    static void configure(const SchedulerConfig &config);
+
+    [[nodiscard]] static unsigned int getRetryAfterMs();
+
+    // queue wait and shed requests per class
+    static std::string report();
+
+    static void resetStats();
+
+private:
+    struct Waiter {
+        std::uint64_t ticket;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    static bool acquire(RequestPriority priority);
+    static void release();
+
+    // the waiter who gets the next free slot, called with _mutex held
+    static bool isNextInLine(std::size_t priorityIndex, std::uint64_t ticket);
+
+    static inline SchedulerConfig _config{DEFAULT_SCHEDULER_CONCURRENCY, DEFAULT_SHED_AFTER_MS};
+    static inline unsigned int _runningRequests = 0;
+    static inline std::uint64_t _nextTicket = 0;
+    static inline std::array<std::deque<Waiter>, SCHEDULED_PRIORITIES_COUNT> _waiters;    // by priority
+    // a plain mutex, the waiters wait on it with a condition variable
+    static inline std::mutex _mutex;
+    static inline std::condition_variable _slotsChanged;
+
+    static inline std::array<LatencyHistogram, SCHEDULED_PRIORITIES_COUNT> _queueWait;   // us
+    static inline std::array<std::atomic<std::uint64_t>, SCHEDULED_PRIORITIES_COUNT> _shedRequests{};
+};
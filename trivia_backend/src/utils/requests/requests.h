@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 #include <ctime>
 #include <memory>
 #include "../../requestHandlers/IRequestHandler.h"
@@ -33,17 +34,162 @@ enum class RequestId {
     SUBMIT_VERIFICATION_CODE_REQUEST = 20,
     RESEND_VERIFICATION_CODE_REQUEST = 21,
     FORGOT_PASSWORD_REQUEST = 22,
+    CLIENT_HELLO_REQUEST = 23,  // payload encoding handshake, handled by the Communicator in every state
+    RESUME_SESSION_REQUEST = 24,    // continues a dropped connection's session, handled by the Communicator
+    PING_REQUEST = 25,  // heartbeat, handled by the Communicator in every state
+    RESET_PASSWORD_REQUEST = 26,    // the code mailed by FORGOT_PASSWORD_REQUEST and the new password
     EXIT = 99   // for the client Socket Errors / Disconnections
 };
 
+// static name of a request id, safe to keep as a trace span / metric name
+inline const char *requestIdToString(RequestId requestId) {
+    switch (requestId) {
+        case RequestId::LOGIN_REQUEST:
+            return "LOGIN_REQUEST";
+        case RequestId::SIGNUP_REQUEST:
+            return "SIGNUP_REQUEST";
+        case RequestId::LOGOUT_REQUEST:
+            return "LOGOUT_REQUEST";
+        case RequestId::GET_ROOMS_REQUEST:
+            return "GET_ROOMS_REQUEST";
+        case RequestId::GET_PLAYERS_IN_ROOM_REQUEST:
+            return "GET_PLAYERS_IN_ROOM_REQUEST";
+        case RequestId::GET_HIGHSCORES_REQUEST:
+            return "GET_HIGHSCORES_REQUEST";
+        case RequestId::GET_PERSONAL_STATS_REQUEST:
+            return "GET_PERSONAL_STATS_REQUEST";
+        case RequestId::CREATE_ROOM_REQUEST:
+            return "CREATE_ROOM_REQUEST";
+        case RequestId::JOIN_ROOM_REQUEST:
+            return "JOIN_ROOM_REQUEST";
+        case RequestId::GET_USER_DATA_REQUEST:
+            return "GET_USER_DATA_REQUEST";
+        case RequestId::UPDATE_USER_DATA_REQUEST:
+            return "UPDATE_USER_DATA_REQUEST";
+        case RequestId::CLOSE_ROOM_REQUEST:
+            return "CLOSE_ROOM_REQUEST";
+        case RequestId::START_GAME_REQUEST:
+            return "START_GAME_REQUEST";
+        case RequestId::GET_ROOM_STATE_REQUEST:
+            return "GET_ROOM_STATE_REQUEST";
+        case RequestId::LEAVE_ROOM_REQUEST:
+            return "LEAVE_ROOM_REQUEST";
+        case RequestId::LEAVE_GAME_REQUEST:
+            return "LEAVE_GAME_REQUEST";
+        case RequestId::GET_QUESTION_REQUEST:
+            return "GET_QUESTION_REQUEST";
+        case RequestId::SUBMIT_ANSWER_REQUEST:
+            return "SUBMIT_ANSWER_REQUEST";
+        case RequestId::GET_GAME_RESULTS_REQUEST:
+            return "GET_GAME_RESULTS_REQUEST";
+        case RequestId::SUBMIT_VERIFICATION_CODE_REQUEST:
+            return "SUBMIT_VERIFICATION_CODE_REQUEST";
+        case RequestId::RESEND_VERIFICATION_CODE_REQUEST:
+            return "RESEND_VERIFICATION_CODE_REQUEST";
+        case RequestId::FORGOT_PASSWORD_REQUEST:
+            return "FORGOT_PASSWORD_REQUEST";
+        case RequestId::CLIENT_HELLO_REQUEST:
+            return "CLIENT_HELLO_REQUEST";
+        case RequestId::RESUME_SESSION_REQUEST:
+            return "RESUME_SESSION_REQUEST";
+        case RequestId::PING_REQUEST:
+            return "PING_REQUEST";
+        case RequestId::RESET_PASSWORD_REQUEST:
+            return "RESET_PASSWORD_REQUEST";
+        case RequestId::EXIT:
+            return "EXIT";
+        default:
+            return "UNKNOWN_REQUEST";
+    }
+}
+
+// scheduling classes of the requests, the most urgent first (see RequestScheduler)
+enum class RequestPriority {
+    GAME,       // paced by the game clock
+    ROOM,
+    LOBBY,      // browsing, shed first under load
+    UNSCHEDULED // cheap, or waiting on something else than the cpu (email, password hashing, room changes)
+};
+
+constexpr std::size_t SCHEDULED_PRIORITIES_COUNT = 3;
+constexpr std::size_t REQUEST_PRIORITIES_COUNT = 4;     // with UNSCHEDULED
+
+inline RequestPriority getRequestPriority(RequestId requestId) {
+    switch (requestId) {
+        case RequestId::GET_QUESTION_REQUEST:
+        case RequestId::SUBMIT_ANSWER_REQUEST:
+        case RequestId::GET_GAME_RESULTS_REQUEST:
+        case RequestId::LEAVE_GAME_REQUEST:
+            return RequestPriority::GAME;
+        case RequestId::JOIN_ROOM_REQUEST:
+        case RequestId::CREATE_ROOM_REQUEST:
+        case RequestId::CLOSE_ROOM_REQUEST:
+        case RequestId::START_GAME_REQUEST:
+        case RequestId::LEAVE_ROOM_REQUEST:
+        case RequestId::GET_PLAYERS_IN_ROOM_REQUEST:
+            return RequestPriority::ROOM;
+        case RequestId::GET_ROOMS_REQUEST:
+        case RequestId::GET_HIGHSCORES_REQUEST:
+        case RequestId::GET_PERSONAL_STATS_REQUEST:
+        case RequestId::GET_USER_DATA_REQUEST:
+            return RequestPriority::LOBBY;
+        // hashes a new password on the hasher's threads, like the login and signup
+        default:
+            return RequestPriority::UNSCHEDULED;
+    }
+}
+
+inline const char *requestPriorityToString(RequestPriority priority) {
+    switch (priority) {
+        case RequestPriority::GAME:
+            return "game";
+        case RequestPriority::ROOM:
+            return "room";
+        case RequestPriority::LOBBY:
+            return "lobby";
+        default:
+            return "unscheduled";
+    }
+}
+
+// what a connection is doing, by its handler. a connection idle for longer than its state's timeout is closed
+enum class ConnectionState {
+    LOGIN,      // not logged in yet (login and email verification)
+    MENU,
+    ROOM,
+    GAME
+};
+
+constexpr std::size_t CONNECTION_STATES_COUNT = 4;
+
+inline const char *connectionStateToString(ConnectionState state) {
+    switch (state) {
+        case ConnectionState::LOGIN:
+            return "login";
+        case ConnectionState::MENU:
+            return "menu";
+        case ConnectionState::ROOM:
+            return "room";
+        default:
+            return "game";
+    }
+}
+
 struct RequestInfo {
     RequestId requestId;
     std::vector<unsigned char> buffer;
+    bool isDisconnection = false;   // an EXIT made up for a dropped connection, not sent by the client
 };
 
 struct RequestResult {
     std::vector<unsigned char> buffer;
     std::unique_ptr<IRequestHandler> newHandler;
+    // a frame shared by many connections (e.g. a game's question), sent instead of buffer when set
+    std::shared_ptr<const std::vector<unsigned char>> sharedBuffer = nullptr;
+    // set when the request logged the user in, the Communicator parks the handler under it if the connection drops
+    std::string sessionToken;
+
+    [[nodiscard]] const std::vector<unsigned char> &frame() const { return sharedBuffer ? *sharedBuffer : buffer; }
 };
 
 
@@ -61,6 +207,14 @@ struct SignupRequest {
     std::string birthday;
 };
 
+// every field is optional, an empty object lists all the rooms
+struct GetRoomsRequest {
+    unsigned int offset = 0;    // rooms to skip, after filtering
+    unsigned int limit = 0;     // 0 for no limit
+    bool notActive = false;     // leave out the rooms whose game has started
+    bool notFull = false;       // leave out the full rooms
+};
+
 struct GetPlayersInRoomRequest {
     std::string roomId;
 };
@@ -100,4 +254,35 @@ struct SubmitVerificationCodeRequest
 struct ForgotPasswordRequest
 {
     std::string email;
+};
+
+struct ResetPasswordRequest
+{
+    std::string email;
+    std::string resetCode;
+    std::string password;
+};
+
+
+struct ClientHelloRequest
+{
+    std::vector<std::string> encodings;    // supported payload encodings, the preferred first
+};
+
+struct ResumeSessionRequest
+{
+    std::string sessionToken;
+};
+
+struct PingRequest
+{
+    // the round trip of the client's previous ping, missing on the first one
+    std::optional<std::uint64_t> lastRttUs;
+};
+
+struct GetRoomStateRequest
+{
+    // both optional. with lastSeenVersion the server holds the request up to maxWaitMs until the room changes
+    std::optional<std::uint64_t> lastSeenVersion;
+    unsigned int maxWaitMs = 0;
 };
\ No newline at end of file
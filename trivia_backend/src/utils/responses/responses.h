@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include "../../managers/roomData.h"
 #include "../../managers/userStatistics.h"
@@ -31,11 +32,18 @@ enum class ResponseId {
     SUBMIT_VERIFICATION_CODE_RESPONSE = 20,
     RESEND_VERIFICATION_CODE_RESPONSE = 21,
     FORGOT_PASSWORD_RESPONSE = 22,
+    CLIENT_HELLO_RESPONSE = 23,
+    ROOM_STATE_NOT_MODIFIED_RESPONSE = 24,
+    RESUME_SESSION_RESPONSE = 25,
+    RETRY_LATER_RESPONSE = 26,
+    PONG_RESPONSE = 27,
+    RESET_PASSWORD_RESPONSE = 28,
 };
 
 struct LoginResponse {
     bool status;
     std::string message;
+    std::string sessionToken;   // for RESUME_SESSION_REQUEST after a disconnection, empty when the login failed
 };
 
 struct SignupResponse {
@@ -66,6 +74,7 @@ struct RoomDataResponse {
 struct GetRoomsResponse {
     bool status;
     std::vector<RoomDataResponse> rooms;
+    unsigned int totalCount;    // rooms passing the request's filters, before paging
 };
 
 
@@ -130,6 +139,13 @@ struct GetRoomStateResponse {
     unsigned int answerTimeout;
     unsigned int maxPlayers;
     bool isClosed;
+    std::uint64_t version;  // the room's version, sent back as lastSeenVersion
+};
+
+// answers a GET_ROOM_STATE_REQUEST whose lastSeenVersion is still current
+struct RoomStateNotModifiedResponse {
+    bool status;
+    std::uint64_t version;
 };
 
 struct LeaveRoomResponse {
@@ -173,6 +189,7 @@ struct LeaveGameResponse {
 struct SubmitVerificationCodeResponse {
     bool status;
     bool isVerified;
+    std::string sessionToken;   // the user is logged in once verified, empty otherwise
 };
 
 struct ResendVerificationCodeResponse {
@@ -181,4 +198,31 @@ struct ResendVerificationCodeResponse {
 
 struct ForgotPasswordResponse {
     bool status;
-};
\ No newline at end of file
+};
+
+struct ResetPasswordResponse {
+    bool status;
+    std::string message;
+};
+
+struct ClientHelloResponse {
+    bool status;
+    std::string encoding;   // used by both sides from the next frame on
+};
+
+struct ResumeSessionResponse {
+    bool status;
+    std::string message;
+    std::string location;   // "menu", "room" or "game", where the session continues
+    std::string roomId;     // the room's uuid in a room or game, empty in the menu
+};
+
+// the request was shed under load without being handled, it can be sent again
+struct RetryLaterResponse {
+    bool status;
+    unsigned int retryAfterMs;
+};
+
+struct PongResponse {
+    bool status;
+};
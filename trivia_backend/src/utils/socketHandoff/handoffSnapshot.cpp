@@ -0,0 +1,308 @@
+#include "handoffSnapshot.h"
+#include <algorithm>
+#include <cstdint>
+
+// every integer is big endian like the wire protocol, strings are [2 bytes length][bytes]:
+//   snapshot: [4 bytes presences count][presences][4 bytes sessions count][sessions]
+//             [4 bytes rooms count][rooms][4 bytes games count][games]
+//   presence: [username][1 byte location][location id][8 bytes login time, ms since the epoch][address][2 bytes port]
+//   session: [token][username]
+//   room: [uuid][name][4 bytes max players][4 bytes questions count][4 bytes time per question][1 byte is active]
+//         [8 bytes version][2 bytes users count][usernames]
+//   game: [uuid][4 bytes time per question][8 bytes start time, ms since the epoch][2 bytes released questions count]
+//         [2 bytes questions count][questions][2 bytes players count][players]
+//   question: [question][1 byte answers count][answers][1 byte correct answer index]
+//   player: [username][1 byte flags, see PLAYER_*][per question: 1 byte answer index, 4 bytes answer time]
+//   connection: [address][2 bytes port][session token][1 byte payload encoding]
+namespace {
+    constexpr unsigned char PLAYER_PUNISHED = 1;
+    constexpr unsigned char PLAYER_SUBMITTED = 2;
+    constexpr unsigned char PLAYER_ONLINE = 4;
+
+    void writeBigEndian(std::vector<unsigned char> &buffer, std::uint64_t value, unsigned int bytesCount) {
+        for (int i = static_cast<int>(bytesCount) - 1; i >= 0; i--)
+            buffer.push_back(static_cast<unsigned char>((value >> (i * 8)) & 0xFF));
+    }
+
+    void writeString(std::vector<unsigned char> &buffer, const std::string &value) {
+        const auto size = std::min<std::size_t>(value.size(), UINT16_MAX);
+        writeBigEndian(buffer, size, 2);
+        buffer.insert(buffer.end(), value.begin(), value.begin() + static_cast<std::ptrdiff_t>(size));
+    }
+
+    // reads the fields of the snapshot, isValid turns false when one is cut
+    class SnapshotReader {
+    public:
+        explicit SnapshotReader(const std::vector<unsigned char> &buffer) : _buffer(buffer) {}
+
+        std::uint64_t readNumber(unsigned int bytesCount) {
+            if (!isValid || _buffer.size() - _position < bytesCount) {
+                isValid = false;
+                return 0;
+            }
+            std::uint64_t value = 0;
+            for (unsigned int i = 0; i < bytesCount; i++)
+                value = value << 8 | _buffer[_position++];
+            return value;
+        }
+
+        std::string readString() {
+            const auto size = static_cast<std::size_t>(readNumber(2));
+            if (!isValid || _buffer.size() - _position < size) {
+                isValid = false;
+                return {};
+            }
+            std::string value(reinterpret_cast<const char *>(_buffer.data() + _position), size);
+            _position += size;
+            return value;
+        }
+
+        [[nodiscard]] bool isAtEnd() const { return _position == _buffer.size(); }
+
+        bool isValid = true;
+
+    private:
+        const std::vector<unsigned char> &_buffer;
+        std::size_t _position = 0;
+    };
+
+    std::uint64_t toEpochMs(std::chrono::system_clock::time_point time) {
+        return static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count());
+    }
+
+    std::chrono::system_clock::time_point fromEpochMs(std::uint64_t epochMs) {
+        return std::chrono::system_clock::time_point(
+                std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::milliseconds(epochMs)));
+    }
+
+    void writeGame(std::vector<unsigned char> &buffer, const Game &game) {
+        // the steady clocks of two processes may not share an epoch, the system clock is the same for both
+        const auto startTime = std::chrono::system_clock::now() - std::chrono::duration_cast<
+                std::chrono::system_clock::duration>(std::chrono::steady_clock::now() - game.getStartTime());
+        const auto &questions = game.getQuestions();
+        writeString(buffer, game.getUuid());
+        writeBigEndian(buffer, game.getTimePerQuestion(), 4);
+        writeBigEndian(buffer, toEpochMs(startTime), 8);
+        writeBigEndian(buffer, game.getReleasedQuestionsCount(), 2);
+
+        writeBigEndian(buffer, questions.size(), 2);
+        for (const auto &question: questions) {
+            writeString(buffer, question.getQuestion());
+            writeBigEndian(buffer, question.getPossibleAnswers().size(), 1);
+            for (const auto &answer: question.getPossibleAnswers())
+                writeString(buffer, answer);
+            writeBigEndian(buffer, question.getCorrectAnswerIndex(), 1);
+        }
+
+        const auto players = game.getPlayersResults();
+        const auto onlinePlayers = game.getOnlinePlayers();
+        writeBigEndian(buffer, players.size(), 2);
+        for (const auto &[user, gameData]: players) {
+            const bool isOnline = std::find(onlinePlayers.cbegin(), onlinePlayers.cend(), user) != onlinePlayers.cend();
+            writeString(buffer, user.username);
+            writeBigEndian(buffer, (gameData.isPunished ? PLAYER_PUNISHED : 0) |
+                                   (gameData.isScoreSubmittedToDB ? PLAYER_SUBMITTED : 0) |
+                                   (isOnline ? PLAYER_ONLINE : 0), 1);
+            for (const auto &answer: gameData.answers) {
+                writeBigEndian(buffer, answer.second.first, 1);
+                writeBigEndian(buffer, answer.second.second, 4);
+            }
+        }
+    }
+
+    std::shared_ptr<Game> readGame(SnapshotReader &reader) {
+        auto uuid = reader.readString();
+        const auto timePerQuestion = static_cast<unsigned int>(reader.readNumber(4));
+        const auto startTime = fromEpochMs(reader.readNumber(8));
+        const auto releasedQuestionsCount = static_cast<std::size_t>(reader.readNumber(2));
+
+        std::vector<Question> questions;
+        const auto questionsCount = reader.readNumber(2);
+        for (std::uint64_t i = 0; i < questionsCount && reader.isValid; i++) {
+            auto question = reader.readString();
+            std::vector<std::string> answers;
+            const auto answersCount = reader.readNumber(1);
+            for (std::uint64_t j = 0; j < answersCount && reader.isValid; j++)
+                answers.push_back(reader.readString());
+            const auto correctAnswerIndex = static_cast<unsigned int>(reader.readNumber(1));
+            questions.emplace_back(std::move(question), std::move(answers), correctAnswerIndex);
+        }
+
+        std::map<LoggedUser, GameData> players;
+        std::vector<LoggedUser> onlinePlayers;
+        const auto playersCount = reader.readNumber(2);
+        for (std::uint64_t i = 0; i < playersCount && reader.isValid; i++) {
+            const LoggedUser user{reader.readString()};
+            const auto flags = reader.readNumber(1);
+            GameData gameData(questions, timePerQuestion);
+            gameData.isPunished = (flags & PLAYER_PUNISHED) != 0;
+            gameData.isScoreSubmittedToDB = (flags & PLAYER_SUBMITTED) != 0;
+            for (unsigned int questionIndex = 0; questionIndex < questions.size(); questionIndex++) {
+                const auto answerIndex = static_cast<unsigned int>(reader.readNumber(1));
+                const auto answerTime = static_cast<unsigned int>(reader.readNumber(4));
+                gameData.submitAnswer(answerIndex, questionIndex, answerTime);
+            }
+            if ((flags & PLAYER_ONLINE) != 0)
+                onlinePlayers.push_back(user);
+            players.emplace(user, std::move(gameData));
+        }
+        if (!reader.isValid || releasedQuestionsCount > questions.size())
+            return nullptr;
+
+        const auto steadyStartTime = std::chrono::steady_clock::now() - std::chrono::duration_cast<
+                std::chrono::steady_clock::duration>(std::chrono::system_clock::now() - startTime);
+        return std::make_shared<Game>(questions, std::move(players), std::move(onlinePlayers), std::move(uuid),
+                                      timePerQuestion, steadyStartTime, releasedQuestionsCount);
+    }
+}
+
+HandoffSnapshot HandoffSnapshot::capture(RequestHandlerFactory &requestHandlerFactory) {
+    HandoffSnapshot snapshot;
+    snapshot.presences = requestHandlerFactory.getLoginManager().getPresenceRegistry().getAll();
+    snapshot.sessions = requestHandlerFactory.getSessionRegistry().getSessions();
+    snapshot.rooms = requestHandlerFactory.getRoomManager().getRoomStates();
+    snapshot.games = requestHandlerFactory.getGameManager().getGames();
+    return snapshot;
+}
+
+void HandoffSnapshot::restore(RequestHandlerFactory &requestHandlerFactory,
+                              std::chrono::milliseconds sessionsGracePeriod) const {
+    auto &presenceRegistry = requestHandlerFactory.getLoginManager().getPresenceRegistry();
+    for (const auto &[username, presence]: presences)
+        presenceRegistry.restore(username, presence);
+
+    // the handlers below look their room or game up
+    for (const auto &roomState: rooms)
+        requestHandlerFactory.getRoomManager().restoreRoom(*roomState);
+    for (const auto &game: games)
+        requestHandlerFactory.getGameManager().restoreGame(game);
+
+    for (const auto &[token, username]: sessions) {
+        const auto presence = presenceRegistry.get(username);
+        if (!presence.has_value())
+            continue;
+
+        requestHandlerFactory.getSessionRegistry().restore(
+                token, username, requestHandlerFactory.createHandlerForPresence(LoggedUser{username}, presence.value()),
+                sessionsGracePeriod);
+    }
+}
+
+std::vector<unsigned char> HandoffSnapshot::serialize() const {
+    std::vector<unsigned char> buffer;
+
+    writeBigEndian(buffer, presences.size(), 4);
+    for (const auto &[username, presence]: presences) {
+        writeString(buffer, username);
+        writeBigEndian(buffer, static_cast<unsigned char>(presence.location), 1);
+        writeString(buffer, presence.locationId);
+        writeBigEndian(buffer, toEpochMs(presence.loginTime), 8);
+        writeString(buffer, presence.endpoint.address);
+        writeBigEndian(buffer, presence.endpoint.port, 2);
+    }
+
+    writeBigEndian(buffer, sessions.size(), 4);
+    for (const auto &[token, username]: sessions) {
+        writeString(buffer, token);
+        writeString(buffer, username);
+    }
+
+    writeBigEndian(buffer, rooms.size(), 4);
+    for (const auto &roomState: rooms) {
+        const auto &roomData = roomState->roomData;
+        writeString(buffer, roomData.uuid);
+        writeString(buffer, roomData.name);
+        writeBigEndian(buffer, roomData.maxPlayers, 4);
+        writeBigEndian(buffer, roomData.questionCount, 4);
+        writeBigEndian(buffer, roomData.timePerQuestion, 4);
+        writeBigEndian(buffer, roomData.isActive ? 1 : 0, 1);
+        writeBigEndian(buffer, roomState->version, 8);
+        writeBigEndian(buffer, roomState->users.size(), 2);
+        for (const auto &user: roomState->users)
+            writeString(buffer, user.username);
+    }
+
+    writeBigEndian(buffer, games.size(), 4);
+    for (const auto &game: games)
+        writeGame(buffer, *game);
+    return buffer;
+}
+
+Result<HandoffSnapshot> HandoffSnapshot::deserialize(const std::vector<unsigned char> &buffer) {
+    HandoffSnapshot snapshot;
+    SnapshotReader reader(buffer);
+
+    const auto presencesCount = reader.readNumber(4);
+    for (std::uint64_t i = 0; i < presencesCount && reader.isValid; i++) {
+        auto username = reader.readString();
+        const auto location = reader.readNumber(1);
+        auto locationId = reader.readString();
+        const auto loginTime = fromEpochMs(reader.readNumber(8));
+        const auto address = reader.readString();
+        const auto port = static_cast<int>(reader.readNumber(2));
+        if (location >= PRESENCE_LOCATIONS_COUNT)
+            reader.isValid = false;
+        snapshot.presences.emplace_back(std::move(username), Presence{Endpoint(address, port),
+                                                                      static_cast<PresenceLocation>(location),
+                                                                      std::move(locationId), loginTime});
+    }
+
+    const auto sessionsCount = reader.readNumber(4);
+    for (std::uint64_t i = 0; i < sessionsCount && reader.isValid; i++) {
+        auto token = reader.readString();
+        auto username = reader.readString();
+        snapshot.sessions.emplace_back(std::move(token), std::move(username));
+    }
+
+    const auto roomsCount = reader.readNumber(4);
+    for (std::uint64_t i = 0; i < roomsCount && reader.isValid; i++) {
+        auto roomState = std::make_shared<RoomState>();
+        auto &roomData = roomState->roomData;
+        roomData.uuid = reader.readString();
+        roomData.name = reader.readString();
+        roomData.maxPlayers = static_cast<unsigned int>(reader.readNumber(4));
+        roomData.questionCount = static_cast<unsigned int>(reader.readNumber(4));
+        roomData.timePerQuestion = static_cast<unsigned int>(reader.readNumber(4));
+        roomData.isActive = reader.readNumber(1) != 0;
+        roomState->version = reader.readNumber(8);
+        const auto usersCount = reader.readNumber(2);
+        for (std::uint64_t j = 0; j < usersCount && reader.isValid; j++)
+            roomState->users.push_back(LoggedUser{reader.readString()});
+        snapshot.rooms.push_back(std::move(roomState));
+    }
+
+    const auto gamesCount = reader.readNumber(4);
+    for (std::uint64_t i = 0; i < gamesCount && reader.isValid; i++) {
+        auto game = readGame(reader);
+        if (game == nullptr)
+            reader.isValid = false;
+        snapshot.games.push_back(std::move(game));
+    }
+
+    if (!reader.isValid || !reader.isAtEnd())
+        return Error(ErrorType::DeserializationError, "Invalid handoff snapshot");
+    return snapshot;
+}
+
+std::vector<unsigned char> HandedOverConnection::serialize() const {
+    std::vector<unsigned char> buffer;
+    writeString(buffer, endpoint.address);
+    writeBigEndian(buffer, endpoint.port, 2);
+    writeString(buffer, sessionToken);
+    writeBigEndian(buffer, static_cast<unsigned char>(encoding), 1);
+    return buffer;
+}
+
+Result<HandedOverConnection> HandedOverConnection::deserialize(const std::vector<unsigned char> &buffer) {
+    SnapshotReader reader(buffer);
+    const auto address = reader.readString();
+    const auto port = static_cast<int>(reader.readNumber(2));
+    auto sessionToken = reader.readString();
+    const auto encoding = reader.readNumber(1);
+    if (!reader.isValid || !reader.isAtEnd() || encoding >= PAYLOAD_ENCODINGS_COUNT)
+        return Error(ErrorType::DeserializationError, "Invalid handed over connection");
+
+    return HandedOverConnection{Endpoint(address, port), std::move(sessionToken),
+                                static_cast<PayloadEncoding>(encoding)};
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../../errors/result.h"
+#include "../../managers/game.h"
+#include "../../managers/presenceRegistry.h"
+#include "../../managers/room.h"
+#include "../../requestHandlers/requestHandlerFactory.h"
+#include "../communicator/endpoint.h"
+#include "../marshaling/payloadEncoding.h"
+
+// the state a server hands over to the one replacing it, sent with its listening socket. the connections follow it,
+// each resuming its session from the snapshot
+struct HandoffSnapshot {
+    std::vector<std::pair<std::string, Presence>> presences;    // username -> presence
+    std::vector<std::pair<std::string, std::string>> sessions;  // token -> username
+    std::vector<std::shared_ptr<const RoomState>> rooms;
+    std::vector<std::shared_ptr<Game>> games;
+
+    // the state of the server's managers as it is now
+    static HandoffSnapshot capture(RequestHandlerFactory &requestHandlerFactory);
+
+    // puts the state in the new server's managers. every session is parked with the handler of where its user is,
+    // until its connection comes over or sessionsGracePeriod passes
+    void restore(RequestHandlerFactory &requestHandlerFactory, std::chrono::milliseconds sessionsGracePeriod) const;
+
+    [[nodiscard]] std::vector<unsigned char> serialize() const;
+    static Result<HandoffSnapshot> deserialize(const std::vector<unsigned char> &buffer);
+};
+
+// a client connection, sent with its socket after the snapshot
+struct HandedOverConnection {
+    Endpoint endpoint;
+    std::string sessionToken;   // empty when the client isn't logged in
+    PayloadEncoding encoding = PayloadEncoding::JSON;
+
+    [[nodiscard]] std::vector<unsigned char> serialize() const;
+    static Result<HandedOverConnection> deserialize(const std::vector<unsigned char> &buffer);
+};
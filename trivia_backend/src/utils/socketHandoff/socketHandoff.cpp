@@ -0,0 +1,273 @@
+#include "socketHandoff.h"
+#include "../../constants.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    // the first message, so a stray connection isn't taken for a handoff
+    constexpr char HANDOFF_MAGIC[] = "trivia-handoff-2";
+    constexpr std::size_t MESSAGE_HEADER_SIZE = 4;  // the payload length
+
+    // closes the unix socket when going out of scope
+    class UnixSocket {
+    public:
+        UnixSocket() : _fd(::socket(AF_UNIX, SOCK_STREAM, 0)) {}
+        ~UnixSocket() { if (_fd >= 0) ::close(_fd); }
+
+        UnixSocket(const UnixSocket &) = delete;
+        UnixSocket &operator=(const UnixSocket &) = delete;
+
+        [[nodiscard]] int get() const { return _fd; }
+
+        // the caller closes it from now on
+        int release() { const auto fd = _fd; _fd = -1; return fd; }
+
+    private:
+        int _fd;
+    };
+
+    std::optional<sockaddr_un> toAddress(const std::string &path) {
+        sockaddr_un address{};
+        if (path.size() >= sizeof(address.sun_path))
+            return std::nullopt;
+
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        return address;
+    }
+
+    std::vector<unsigned char> toMessage(const char *text) {
+        return {text, text + std::strlen(text)};
+    }
+}
+
+SocketHandoff::~SocketHandoff() {
+    close();
+}
+
+std::optional<Error> SocketHandoff::accept(const std::string &path) {
+    const auto address = toAddress(path);
+    if (!address.has_value())
+        return Error(ErrorType::InvalidRequest, "Handoff path is too long");
+
+    const UnixSocket listener;
+    ::unlink(path.c_str());     // left by a previous handoff that didn't complete
+    if (listener.get() < 0 ||
+        ::bind(listener.get(), reinterpret_cast<const sockaddr *>(&address.value()), sizeof(sockaddr_un)) != 0 ||
+        ::listen(listener.get(), 1) != 0)
+        return Error(ErrorType::Socket, "Failed to listen on '" + path + "': " + std::strerror(errno));
+
+    while (true) {
+        close();
+        _fd = ::accept(listener.get(), nullptr, nullptr);
+        if (_fd < 0)
+            return Error(ErrorType::Socket, std::string("Failed to accept the handoff: ") + std::strerror(errno));
+
+        std::optional<kissnet::SOCKET> socket;
+        const auto magic = receive(socket);
+        if (socket.has_value())
+            ::close(socket.value());
+
+        if (!magic.isError() && magic.value() == toMessage(HANDOFF_MAGIC)) {
+            ::unlink(path.c_str());
+            return std::nullopt;
+        }
+        // not a server handing off, wait for the next connection
+    }
+}
+
+std::optional<Error> SocketHandoff::connect(const std::string &path) {
+    const auto address = toAddress(path);
+    if (!address.has_value())
+        return Error(ErrorType::InvalidRequest, "Handoff path is too long");
+
+    UnixSocket connection;
+    if (connection.get() < 0 ||
+        ::connect(connection.get(), reinterpret_cast<const sockaddr *>(&address.value()), sizeof(sockaddr_un)) != 0)
+        return Error(ErrorType::Socket, "No server waiting on '" + path + "': " + std::strerror(errno));
+
+    close();
+    _fd = connection.release();
+    return send(toMessage(HANDOFF_MAGIC));
+}
+
+std::optional<Error> SocketHandoff::send(const std::vector<unsigned char> &message,
+                                         std::optional<kissnet::SOCKET> socket) {
+    unsigned char header[MESSAGE_HEADER_SIZE];
+    for (std::size_t i = 0; i < MESSAGE_HEADER_SIZE; i++)
+        header[i] = static_cast<unsigned char>((message.size() >> ((MESSAGE_HEADER_SIZE - 1 - i) * 8)) & 0xFF);
+
+    iovec parts[2]{{header, sizeof(header)},
+                   {const_cast<unsigned char *>(message.data()), message.size()}};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+    msghdr msg{};
+    msg.msg_iov = parts;
+    msg.msg_iovlen = 2;
+    if (socket.has_value()) {
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        auto *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), &socket.value(), sizeof(int));
+    }
+
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL;  // a new server gone meanwhile is an error, not a SIGPIPE
+#endif
+    auto sent = ::sendmsg(_fd, &msg, flags);
+    if (sent < 0)
+        return Error(ErrorType::Socket, std::string("Failed to send to the new server: ") + std::strerror(errno));
+
+    // the socket went with the first byte, a big snapshot is left for plain sends
+    std::size_t total = sent;
+    const std::size_t size = sizeof(header) + message.size();
+    while (total < size) {
+        const auto *rest = total < sizeof(header) ? header + total : message.data() + (total - sizeof(header));
+        const auto restSize = total < sizeof(header) ? sizeof(header) - total : size - total;
+        sent = ::send(_fd, rest, restSize, flags);
+        if (sent < 0)
+            return Error(ErrorType::Socket, std::string("Failed to send to the new server: ") + std::strerror(errno));
+        total += sent;
+    }
+    return std::nullopt;
+}
+
+Result<std::vector<unsigned char>> SocketHandoff::receive(std::optional<kissnet::SOCKET> &socket) {
+    socket.reset();
+
+    unsigned char header[MESSAGE_HEADER_SIZE];
+    iovec headerPart{header, sizeof(header)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+    msghdr msg{};
+    msg.msg_iov = &headerPart;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    const auto received = ::recvmsg(_fd, &msg, MSG_WAITALL);
+    const auto *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg != nullptr && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len == CMSG_LEN(sizeof(int))) {
+        int receivedSocket = -1;
+        std::memcpy(&receivedSocket, CMSG_DATA(cmsg), sizeof(int));
+        socket = receivedSocket;
+    }
+    if (received != static_cast<ssize_t>(sizeof(header)))
+        return Error(ErrorType::Socket, received == 0 ? std::string("The other server closed the handoff")
+                                                      : std::string("Failed to receive: ") + std::strerror(errno));
+
+    std::size_t size = 0;
+    for (const auto byte: header)
+        size = size << 8 | byte;
+    if (size > HANDOFF_MAX_MESSAGE_SIZE)
+        return Error(ErrorType::InvalidRequest, "Handoff message is too big");
+
+    std::vector<unsigned char> message(size);
+    std::size_t total = 0;
+    while (total < size) {
+        const auto part = ::recv(_fd, message.data() + total, size - total, MSG_WAITALL);
+        if (part <= 0)
+            return Error(ErrorType::Socket, "The handoff message was cut");
+        total += part;
+    }
+    return message;
+}
+
+void SocketHandoff::interrupt() {
+    if (_fd >= 0)
+        ::shutdown(_fd, SHUT_RDWR);
+}
+
+void SocketHandoff::close() {
+    if (_fd >= 0)
+        ::close(_fd);
+    _fd = -1;
+}
+
+HandoffSignal::HandoffSignal() {
+    if (::pipe(_fds) != 0)
+        _fds[0] = _fds[1] = -1;
+}
+
+HandoffSignal::~HandoffSignal() {
+    for (const auto fd: _fds) {
+        if (fd >= 0)
+            ::close(fd);
+    }
+}
+
+void HandoffSignal::raise() {
+    // a single byte that is never read while raised, every poll on the read end sees it
+    const unsigned char byte = 1;
+    if (_fds[1] >= 0 && !_isRaised.exchange(true)) {
+        const auto _ = ::write(_fds[1], &byte, 1);
+    }
+}
+
+void HandoffSignal::lower() {
+    unsigned char byte;
+    if (_fds[0] >= 0 && _isRaised.exchange(false)) {
+        const auto _ = ::read(_fds[0], &byte, 1);
+    }
+}
+
+bool HandoffSignal::waitForData(kissnet::SOCKET socket) const {
+    pollfd fds[2]{{socket, POLLIN, 0},
+                  {_fds[0], POLLIN, 0}};
+    // the connection's read reports a failed poll
+    while (::poll(fds, _fds[0] >= 0 ? 2 : 1, -1) < 0) {
+        if (errno != EINTR)
+            return true;
+    }
+
+    // checked first, the bytes of a next request already sent go over with the socket
+    return (fds[1].revents & POLLIN) == 0;
+}
+
+#else
+
+SocketHandoff::~SocketHandoff() = default;
+
+std::optional<Error> SocketHandoff::accept(const std::string &path) {
+    return Error(ErrorType::NotImplemented, "Socket handoff needs unix sockets");
+}
+
+std::optional<Error> SocketHandoff::connect(const std::string &path) {
+    return Error(ErrorType::NotImplemented, "Socket handoff needs unix sockets");
+}
+
+std::optional<Error> SocketHandoff::send(const std::vector<unsigned char> &message,
+                                         std::optional<kissnet::SOCKET> socket) {
+    return Error(ErrorType::NotImplemented, "Socket handoff needs unix sockets");
+}
+
+Result<std::vector<unsigned char>> SocketHandoff::receive(std::optional<kissnet::SOCKET> &socket) {
+    return Error(ErrorType::NotImplemented, "Socket handoff needs unix sockets");
+}
+
+void SocketHandoff::interrupt() {}
+
+void SocketHandoff::close() {}
+
+HandoffSignal::HandoffSignal() = default;
+
+HandoffSignal::~HandoffSignal() = default;
+
+void HandoffSignal::raise() {}
+
+void HandoffSignal::lower() {}
+
+bool HandoffSignal::waitForData(kissnet::SOCKET socket) const {
+    return true;    // the connection's read waits
+}
+
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <string>
+#include <vector>
+#include <kissnet.hpp>
+#include "../../errors/result.h"
+
+// the unix socket a running server hands itself over to a new server process on, so a restart doesn't drop anyone.
+// messages are [4 bytes big endian length][payload], each one may carry a socket (SCM_RIGHTS): the listening socket
+// with the snapshot of the server's state, then the client connections one by one. an empty message ends the
+// handoff. the new process waits on the path, the old one connects and sends. posix only
+class SocketHandoff {
+public:
+    SocketHandoff() = default;
+    ~SocketHandoff();
+
+    SocketHandoff(const SocketHandoff &) = delete;
+    SocketHandoff &operator=(const SocketHandoff &) = delete;
+
+    // the new process, blocks until the old one connects
+    std::optional<Error> accept(const std::string &path);
+
+    // the old process, fails right away when no server waits on the path
+    std::optional<Error> connect(const std::string &path);
+
+    // the socket, when given, stays open in this process too
+    std::optional<Error> send(const std::vector<unsigned char> &message,
+                              std::optional<kissnet::SOCKET> socket = std::nullopt);
+
+    // blocks for the next message, socket is set when it carries one
+    Result<std::vector<unsigned char>> receive(std::optional<kissnet::SOCKET> &socket);
+
+    // fails the receive another thread waits in, the channel can only be closed afterwards
+    void interrupt();
+
+    void close();
+
+private:
+    int _fd = -1;
+};
+
+// wakes every connection waiting for its next request at once, so each stops at a request boundary and can be handed
+// over. a pipe whose read end stays readable while the signal is raised. posix only, never raised elsewhere
+class HandoffSignal {
+public:
+    HandoffSignal();
+    ~HandoffSignal();
+
+    HandoffSignal(const HandoffSignal &) = delete;
+    HandoffSignal &operator=(const HandoffSignal &) = delete;
+
+    void raise();
+    void lower();
+
+    // blocks until the socket has something to read, or is closed (true), or the signal is raised (false)
+    [[nodiscard]] bool waitForData(kissnet::SOCKET socket) const;
+
+private:
+    int _fds[2] = {-1, -1};
+    std::atomic<bool> _isRaised = false;
+};
@@ -1,5 +1,11 @@
 #include <iostream>
 #include "socketHelper.h"
+#include "../tracer/tracer.h"
+#include "../admissionControl/admissionController.h"
+#include "../marshaling/jsonSerializer.h"
+#ifndef _WIN32
+#include <sys/socket.h>
+#endif
 
 Result<std::vector<unsigned char>>
 SocketHelper::getPartFromSocket(kissnet::tcp_socket &socket, unsigned int bytesToRead) {
@@ -23,7 +29,8 @@ SocketHelper::getPartFromSocket(kissnet::tcp_socket &socket, unsigned int bytesT
     return Error(ErrorType::Socket);   // unknown socket error
 }
 
-std::optional<Error> SocketHelper::sendData(kissnet::tcp_socket &socket, std::vector<unsigned char> message) {
+std::optional<Error> SocketHelper::sendData(kissnet::tcp_socket &socket, const std::vector<unsigned char> &message) {
+    const TraceSpan span("socket", "send");
     if (auto [size, valid] = socket.send(reinterpret_cast<const std::byte *>(message.data()), message.size()); valid) {
         if (valid.value == kissnet::socket_status::cleanly_disconnected)
             return Error(ErrorType::DisconnectedClient);
@@ -34,6 +41,26 @@ std::optional<Error> SocketHelper::sendData(kissnet::tcp_socket &socket, std::ve
     return Error(ErrorType::Socket);   // unknown socket error
 }
 
+std::optional<Error> SocketHelper::trySendData(kissnet::tcp_socket &socket, const std::vector<unsigned char> &message) {
+    const TraceSpan span("socket", "try send");
+    const auto fd = socket.get_underlying_socket();
+#ifdef _WIN32
+    // windows has no per call flag, a short send timeout bounds the wait instead
+    const DWORD timeoutMs = TRY_SEND_TIMEOUT_MS;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char *>(&timeoutMs), sizeof(timeoutMs));
+    const auto sent = ::send(fd, reinterpret_cast<const char *>(message.data()), static_cast<int>(message.size()), 0);
+#else
+    int flags = MSG_DONTWAIT;
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL;  // a peer gone meanwhile is an error, not a SIGPIPE
+#endif
+    const auto sent = ::send(fd, message.data(), message.size(), flags);
+#endif
+    if (sent < 0 || static_cast<std::size_t>(sent) != message.size())
+        return Error(ErrorType::Socket, "The message didn't fit the socket's send buffer");
+
+    return std::nullopt;
+}
 
 Result<RequestId> SocketHelper::getRequestId(kissnet::tcp_socket &socket) {
     const auto requestIdRes = getPartFromSocket(socket, 1);
@@ -64,6 +91,10 @@ Result<RequestId> SocketHelper::getRequestId(kissnet::tcp_socket &socket) {
         case RequestId::SUBMIT_VERIFICATION_CODE_REQUEST:
         case RequestId::RESEND_VERIFICATION_CODE_REQUEST:
         case RequestId::FORGOT_PASSWORD_REQUEST:
+        case RequestId::RESET_PASSWORD_REQUEST:
+        case RequestId::CLIENT_HELLO_REQUEST:
+        case RequestId::RESUME_SESSION_REQUEST:
+        case RequestId::PING_REQUEST:
         case RequestId::EXIT:
             break;
         default:
@@ -80,21 +111,36 @@ RequestInfo SocketHelper::getRequestInfo(kissnet::tcp_socket &socket) {
     const auto requestId = getRequestId(socket);
     if (requestId.isError()) {
         log<SocketHelper>(__func__, requestId.error().message, false, userEndpoint);
-        return RequestInfo{RequestId::EXIT,  {}};
+        return RequestInfo{RequestId::EXIT, {}, true};
     }
 
+    // the span starts once the request id arrived, so the idle wait for the next request is not counted
+    const TraceSpan span("socket", "read");
     const auto requestLength = getRequestLength(socket);
     if (requestLength.isError()) {
-        log<SocketHelper>(__func__, requestId.error().message, false,
+        log<SocketHelper>(__func__, requestLength.error().message, false,
                           userEndpoint);
-        return RequestInfo{RequestId::EXIT, {}};
+        return RequestInfo{RequestId::EXIT, {}, true};
+    }
+
+    // the body would be allocated at the length the client sent, so it is checked first. the rest of the frame is
+    // never read, the stream can't be followed anymore and the connection is dropped
+    const auto frameError = AdmissionController::checkFrame(requestId.value(), requestLength.value());
+    if (frameError.has_value()) {
+        log<SocketHelper>(__func__, frameError.value().message, false, userEndpoint);
+        const auto _ = sendData(socket, JsonSerializer::serializeResponse(ErrorResponse{frameError.value().message}));
+        return RequestInfo{RequestId::EXIT, {}, true};
     }
 
+    // an empty body (e.g. a poll or a ping) has nothing to read, a recv of 0 bytes would be taken for a disconnection
+    if (requestLength.value() == 0)
+        return RequestInfo{requestId.value(), {}};
+
     const auto buffer = getPartFromSocket(socket, requestLength.value());
     if (buffer.isError()) {
-        log<SocketHelper>(__func__, requestId.error().message, false,
+        log<SocketHelper>(__func__, buffer.error().message, false,
                           userEndpoint);
-        return RequestInfo{RequestId::EXIT,  {}};
+        return RequestInfo{RequestId::EXIT, {}, true};
     }
 
     return RequestInfo{requestId.value(), buffer.value()};
@@ -14,7 +14,11 @@ public:
 
     static RequestInfo getRequestInfo(kissnet::tcp_socket &socket);
 
-    static std::optional<Error> sendData(kissnet::tcp_socket &socket, std::vector<unsigned char> message);
+    static std::optional<Error> sendData(kissnet::tcp_socket &socket, const std::vector<unsigned char> &message);
+
+    // for threads that mustn't wait on a slow peer: the message is dropped when it doesn't fit the socket's send
+    // buffer right away (or, on Windows, within TRY_SEND_TIMEOUT_MS)
+    static std::optional<Error> trySendData(kissnet::tcp_socket &socket, const std::vector<unsigned char> &message);
 
     static Result<std::vector<unsigned char>> getPartFromSocket(kissnet::tcp_socket &socket, unsigned int bytesToRead);
 
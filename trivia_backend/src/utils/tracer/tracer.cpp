@@ -0,0 +1,157 @@
+#include "tracer.h"
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+#include "../../constants.h"
+
+using Json = nlohmann::json;
+
+namespace {
+    // ring buffer owned by a single thread, the mutex is only contended while dumping
+    struct ThreadTraceBuffer {
+        explicit ThreadTraceBuffer(unsigned int threadId) : threadId(threadId) {}
+
+        std::mutex mutex;
+        std::vector<TraceEvent> events;
+        std::size_t nextIndex = 0;  // next slot to overwrite once the ring is full
+        std::string threadName;
+        const unsigned int threadId;
+        std::atomic<bool> isThreadAlive{true};
+    };
+
+    std::mutex buffersMutex;
+    std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers;    // in the order the threads recorded their first span
+    std::size_t exitedBuffersCount = 0;     // guarded by buffersMutex
+    unsigned int nextThreadId = 1;
+    const auto traceEpoch = std::chrono::steady_clock::now();
+
+    // when the owning thread exits, its buffer is dropped right away if empty, otherwise kept for the next dump. with
+    // a thread per connection and no dump, the buffers of the oldest exited threads go past TRACE_MAX_EXITED_BUFFERS
+    struct ThreadTraceBufferHolder {
+        std::shared_ptr<ThreadTraceBuffer> buffer;  // allocated on the first recorded span only
+        std::string threadName;
+
+        ~ThreadTraceBufferHolder() {
+            if (buffer == nullptr)
+                return;
+
+            std::lock_guard buffersLock(buffersMutex);
+            bool isEmpty;
+            {
+                std::lock_guard lock(buffer->mutex);
+                buffer->isThreadAlive = false;
+                isEmpty = buffer->events.empty();
+            }
+            if (isEmpty) {
+                buffers.erase(std::find(buffers.begin(), buffers.end(), buffer));
+                return;
+            }
+
+            exitedBuffersCount++;
+            for (auto it = buffers.begin(); exitedBuffersCount > TRACE_MAX_EXITED_BUFFERS && it != buffers.end();) {
+                if ((*it)->isThreadAlive) {
+                    ++it;
+                    continue;
+                }
+                it = buffers.erase(it);
+                exitedBuffersCount--;
+            }
+        }
+    };
+
+    thread_local ThreadTraceBufferHolder threadBufferHolder;
+
+    ThreadTraceBuffer &getThreadBuffer() {
+        if (threadBufferHolder.buffer == nullptr) {
+            std::lock_guard lock(buffersMutex);
+            threadBufferHolder.buffer = std::make_shared<ThreadTraceBuffer>(nextThreadId++);
+            threadBufferHolder.buffer->threadName = threadBufferHolder.threadName;
+            buffers.push_back(threadBufferHolder.buffer);
+        }
+        return *threadBufferHolder.buffer;
+    }
+
+    long long toTraceMicroseconds(const std::chrono::steady_clock::time_point &timePoint) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(timePoint - traceEpoch).count();
+    }
+}
+
+void Tracer::setEnabled(bool isEnabled) {
+    _isEnabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+void Tracer::setThreadName(const std::string &threadName) {
+    threadBufferHolder.threadName = threadName;
+    if (threadBufferHolder.buffer == nullptr)
+        return;
+
+    std::lock_guard lock(threadBufferHolder.buffer->mutex);
+    threadBufferHolder.buffer->threadName = threadName;
+}
+
+void Tracer::record(const TraceEvent &event) {
+    auto &buffer = getThreadBuffer();
+    std::lock_guard lock(buffer.mutex);
+    if (buffer.events.size() < TRACE_BUFFER_CAPACITY) {
+        buffer.events.push_back(event);
+        return;
+    }
+
+    // the ring is full, overwrite the oldest span
+    buffer.events[buffer.nextIndex] = event;
+    buffer.nextIndex = (buffer.nextIndex + 1) % TRACE_BUFFER_CAPACITY;
+}
+
+Result<std::size_t> Tracer::dumpChromeTrace(const std::string &filePath) {
+    Json root;
+    root["displayTimeUnit"] = "ms";
+    root["traceEvents"] = Json::array();
+    auto &traceEvents = root["traceEvents"];
+    const auto processId = static_cast<int>(::getpid());
+    std::size_t eventsCount = 0;
+
+    // the file is written without holding buffersMutex, threads keep starting and exiting meanwhile
+    std::vector<std::shared_ptr<ThreadTraceBuffer>> dumpedBuffers;
+    {
+        std::lock_guard buffersLock(buffersMutex);
+        dumpedBuffers = buffers;
+        // forget the buffers of threads that already exited (closed connections), they are dumped a last time
+        buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+                                     [](const auto &buffer) { return !buffer->isThreadAlive; }),
+                      buffers.end());
+        exitedBuffersCount = 0;
+    }
+
+    for (const auto &buffer: dumpedBuffers) {
+        std::lock_guard lock(buffer->mutex);
+
+        if (!buffer->threadName.empty())
+            traceEvents.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", processId},
+                                   {"tid", buffer->threadId}, {"args", {{"name", buffer->threadName}}}});
+
+        // walk the ring from the oldest span to the newest
+        for (std::size_t i = 0; i < buffer->events.size(); i++) {
+            const auto &event = buffer->events[(buffer->nextIndex + i) % buffer->events.size()];
+            traceEvents.push_back({{"name", event.name}, {"cat", event.category}, {"ph", "X"},
+                                   {"ts", toTraceMicroseconds(event.start)},
+                                   {"dur", std::chrono::duration_cast<std::chrono::microseconds>(
+                                           event.end - event.start).count()},
+                                   {"pid", processId}, {"tid", buffer->threadId}});
+        }
+
+        eventsCount += buffer->events.size();
+        buffer->events.clear();
+        buffer->nextIndex = 0;
+    }
+
+    std::ofstream outputFile(filePath, std::ios_base::trunc);
+    if (!outputFile.is_open())
+        return Error(ErrorType::Unknown, "Failed to open trace file '" + filePath + "'");
+
+    outputFile << root.dump();
+    return eventsCount;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include "../../errors/result.h"
+
+// a single finished span, names must point to static storage (string literals / __func__)
+struct TraceEvent {
+    const char *category;
+    const char *name;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+};
+
+class Tracer {
+public:
+    Tracer() = delete;  // Prevent construction
+    ~Tracer() = delete;  // Prevent destruction
+
+    [[nodiscard]] static bool isEnabled() noexcept { return _isEnabled.load(std::memory_order_relaxed); }
+
+    static void setEnabled(bool isEnabled);
+
+    // name the calling thread in the exported timeline (e.g. the client endpoint)
+    static void setThreadName(const std::string &threadName);
+
+    static void record(const TraceEvent &event);
+
+    // writes every buffered span as Chrome trace-event JSON and clears the buffers,
+    // returns the number of spans written
+    static Result<std::size_t> dumpChromeTrace(const std::string &filePath);
+
+private:
+    static inline std::atomic<bool> _isEnabled{false};
+};
+
+// RAII span, when tracing is off the only cost is the branch on Tracer::isEnabled()
+class TraceSpan {
+public:
+    TraceSpan(const char *category, const char *name) : _category(category), _name(name),
+                                                        _isActive(Tracer::isEnabled()) {
+        if (_isActive)
+            _start = std::chrono::steady_clock::now();
+    }
+
+    ~TraceSpan() {
+        if (_isActive)
+            Tracer::record({_category, _name, _start, std::chrono::steady_clock::now()});
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *_category;
+    const char *_name;
+    bool _isActive;
+    std::chrono::steady_clock::time_point _start;
+};
@@ -0,0 +1,196 @@
+#include "trafficCapture.h"
+#include <chrono>
+#include <fstream>
+#include <cstring>
+#include "../lockProfiler/lockProfiler.h"
+#include "../marshaling/payloadEncoding.h"
+#include "../../constants.h"
+
+namespace {
+    ProfiledMutex captureFileMutex{"TrafficRecorder::captureFileMutex"};
+    std::ofstream captureFile;
+    std::chrono::steady_clock::time_point captureStartTime;
+    std::uint64_t recordedRequestsCount = 0;
+
+    std::atomic<std::uint32_t> nextConnectionId{1};
+    std::atomic<std::uint32_t> firstRecordedConnectionId{0};  // connections opened before the capture are skipped
+
+    void writeBigEndian(std::uint64_t value, unsigned int bytesCount) {
+        for (int i = static_cast<int>(bytesCount) - 1; i >= 0; i--)
+            captureFile.put(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+
+    std::uint64_t readBigEndian(std::istream &input, unsigned int bytesCount) {
+        std::uint64_t value = 0;
+        for (unsigned int i = 0; i < bytesCount; i++)
+            value = value << 8 | static_cast<unsigned char>(input.get());
+        return value;
+    }
+
+    // must be called with captureFileMutex held
+    void writeRecordHeader(CaptureRecordType type, std::uint32_t connectionId) {
+        const auto timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - captureStartTime).count();
+        captureFile.put(static_cast<char>(type));
+        writeBigEndian(connectionId, 4);
+        writeBigEndian(static_cast<std::uint64_t>(timestamp), 8);
+    }
+
+    // must be called with captureFileMutex held
+    void writeFrame(unsigned char frameId, const unsigned char *payload, std::size_t payloadSize) {
+        captureFile.put(static_cast<char>(frameId));
+        writeBigEndian(payloadSize, 4);
+        captureFile.write(reinterpret_cast<const char *>(payload), static_cast<std::streamsize>(payloadSize));
+    }
+
+    bool hasSecrets(RequestId requestId) {
+        return requestId == RequestId::LOGIN_REQUEST || requestId == RequestId::SIGNUP_REQUEST ||
+               requestId == RequestId::UPDATE_USER_DATA_REQUEST || requestId == RequestId::RESET_PASSWORD_REQUEST ||
+               requestId == RequestId::RESUME_SESSION_REQUEST ||
+               requestId == RequestId::SUBMIT_VERIFICATION_CODE_REQUEST;
+    }
+
+    // runs on the client's thread, so the buffer is decoded with the connection's payload encoding
+    std::vector<unsigned char> redactSecrets(const std::vector<unsigned char> &buffer) {
+        Json j = PayloadCodec::decode(buffer);
+        if (j.is_discarded() || !j.is_object())
+            return buffer;
+
+        if (j.contains("password") && j["password"].is_string())
+            j["password"] = CAPTURE_REDACTED_PASSWORD;
+        for (const auto *field: {"sessionToken", "resetCode", "code"}) {
+            if (j.contains(field) && j[field].is_string())
+                j[field] = CAPTURE_REDACTED_SECRET;
+        }
+        return PayloadCodec::encode(j);
+    }
+}
+
+std::optional<Error> TrafficRecorder::start(const std::string &filePath) {
+    std::lock_guard lock(captureFileMutex);
+    if (isRecording())
+        return Error(ErrorType::AlreadyExists, "A capture is already running");
+
+    captureFile.open(filePath, std::ios_base::binary | std::ios_base::trunc);
+    if (!captureFile.is_open())
+        return Error(ErrorType::Unknown, "Failed to open capture file '" + filePath + "'");
+
+    captureFile.write(CAPTURE_MAGIC, static_cast<std::streamsize>(std::strlen(CAPTURE_MAGIC)));
+    captureStartTime = std::chrono::steady_clock::now();
+    recordedRequestsCount = 0;
+    firstRecordedConnectionId = nextConnectionId.load();
+    _isRecording = true;
+    return std::nullopt;
+}
+
+Result<std::uint64_t> TrafficRecorder::stop() {
+    std::lock_guard lock(captureFileMutex);
+    if (!isRecording())
+        return Error(ErrorType::NotFound, "No capture is running");
+
+    _isRecording = false;
+    captureFile.close();
+    if (captureFile.fail())
+        return Error(ErrorType::Unknown, "Failed to write the capture file");
+
+    return recordedRequestsCount;
+}
+
+std::uint32_t TrafficRecorder::openConnection() {
+    const auto connectionId = nextConnectionId++;
+    if (!isConnectionRecorded(connectionId))
+        return connectionId;
+
+    std::lock_guard lock(captureFileMutex);
+    if (isRecording())
+        writeRecordHeader(CaptureRecordType::CONNECTION_OPENED, connectionId);
+    return connectionId;
+}
+
+void TrafficRecorder::recordRequest(std::uint32_t connectionId, const RequestInfo &requestInfo) {
+    if (!isConnectionRecorded(connectionId))
+        return;
+
+    const auto payload = hasSecrets(requestInfo.requestId) ? redactSecrets(requestInfo.buffer) : requestInfo.buffer;
+
+    std::lock_guard lock(captureFileMutex);
+    if (!isRecording())
+        return;
+
+    writeRecordHeader(CaptureRecordType::REQUEST, connectionId);
+    writeFrame(static_cast<unsigned char>(requestInfo.requestId), payload.data(), payload.size());
+    recordedRequestsCount++;
+}
+
+void TrafficRecorder::recordResponse(std::uint32_t connectionId, RequestId requestId,
+                                     const std::vector<unsigned char> &responseBuffer) {
+    // the buffer is already framed, [1 byte id][4 bytes length][json]
+    if (requestId != RequestId::GET_ROOMS_REQUEST || responseBuffer.size() < 5 || !isConnectionRecorded(connectionId))
+        return;
+
+    // kept as JSON whatever the connection's encoding is, the replay only reads the room ids and names from it
+    const Json j = PayloadCodec::decode(std::vector<unsigned char>(responseBuffer.begin() + 5, responseBuffer.end()));
+    if (j.is_discarded())
+        return;
+    const auto payload = PayloadCodec::encode(j, PayloadEncoding::JSON);
+
+    std::lock_guard lock(captureFileMutex);
+    if (!isRecording())
+        return;
+
+    writeRecordHeader(CaptureRecordType::RESPONSE, connectionId);
+    writeFrame(responseBuffer[0], payload.data(), payload.size());
+}
+
+void TrafficRecorder::closeConnection(std::uint32_t connectionId) {
+    if (!isConnectionRecorded(connectionId))
+        return;
+
+    std::lock_guard lock(captureFileMutex);
+    if (isRecording())
+        writeRecordHeader(CaptureRecordType::CONNECTION_CLOSED, connectionId);
+}
+
+bool TrafficRecorder::isConnectionRecorded(std::uint32_t connectionId) {
+    return isRecording() && connectionId >= firstRecordedConnectionId.load(std::memory_order_relaxed);
+}
+
+Result<std::vector<CaptureRecord>> TrafficCaptureReader::readCapture(const std::string &filePath) {
+    std::ifstream input(filePath, std::ios_base::binary | std::ios_base::ate);
+    if (!input.is_open())
+        return Error(ErrorType::NotFound, "Failed to open capture file '" + filePath + "'");
+    const auto fileSize = static_cast<std::uint64_t>(input.tellg());
+    input.seekg(0);
+
+    std::string magic(std::strlen(CAPTURE_MAGIC), '\0');
+    input.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+    if (!input || magic != CAPTURE_MAGIC)
+        return Error(ErrorType::DeserializationError, "'" + filePath + "' is not a trivia capture file");
+
+    std::vector<CaptureRecord> records;
+    while (input.peek() != std::char_traits<char>::eof()) {
+        CaptureRecord record{};
+        record.type = static_cast<CaptureRecordType>(input.get());
+        record.connectionId = static_cast<std::uint32_t>(readBigEndian(input, 4));
+        record.timestampMicroseconds = readBigEndian(input, 8);
+
+        if (record.type == CaptureRecordType::REQUEST || record.type == CaptureRecordType::RESPONSE) {
+            record.frameId = static_cast<unsigned char>(input.get());
+            // a length past the end of the file is a record cut short, or a corrupted one, not an allocation to make
+            const auto payloadSize = readBigEndian(input, 4);
+            if (!input || payloadSize > fileSize - static_cast<std::uint64_t>(input.tellg()))
+                break;
+            record.payload.resize(payloadSize);
+            input.read(reinterpret_cast<char *>(record.payload.data()), static_cast<std::streamsize>(record.payload.size()));
+        }
+        else if (record.type != CaptureRecordType::CONNECTION_OPENED && record.type != CaptureRecordType::CONNECTION_CLOSED)
+            return Error(ErrorType::DeserializationError, "Unknown record type in capture file");
+
+        // a capture cut short (server killed while recording) keeps every complete record
+        if (!input)
+            break;
+        records.push_back(std::move(record));
+    }
+
+    return records;
+}
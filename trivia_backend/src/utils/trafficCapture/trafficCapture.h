@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "../requests/requests.h"
+#include "../../errors/result.h"
+
+// capture file layout, every integer is big endian like the wire protocol.
+// request payloads are kept as sent, in the connection's payload encoding (see CLIENT_HELLO_REQUEST):
+//   header: CAPTURE_MAGIC (8 bytes)
+//   record: [1 byte type][4 bytes connection id][8 bytes microseconds since the capture started]
+//   REQUEST and RESPONSE records continue with [1 byte request / response id][4 bytes length][payload]
+enum class CaptureRecordType : unsigned char {
+    CONNECTION_OPENED = 1,
+    REQUEST = 2,
+    RESPONSE = 3,   // only GET_ROOMS responses as JSON, the replay maps the captured room ids with them
+    CONNECTION_CLOSED = 4
+};
+
+struct CaptureRecord {
+    CaptureRecordType type;
+    std::uint32_t connectionId;
+    std::uint64_t timestampMicroseconds;
+    unsigned char frameId = 0;
+    std::vector<unsigned char> payload;
+};
+
+// records the framed request stream of every connection accepted while capturing
+class TrafficRecorder {
+public:
+    TrafficRecorder() = delete;  // Prevent construction
+    ~TrafficRecorder() = delete;  // Prevent destruction
+
+    [[nodiscard]] static bool isRecording() noexcept { return _isRecording.load(std::memory_order_relaxed); }
+
+    static std::optional<Error> start(const std::string &filePath);
+
+    // returns the number of recorded requests
+    static Result<std::uint64_t> stop();
+
+    // every connection gets an id, only the ones opened during the current capture are recorded
+    static std::uint32_t openConnection();
+
+    // passwords are replaced with CAPTURE_REDACTED_PASSWORD before they reach the file
+    static void recordRequest(std::uint32_t connectionId, const RequestInfo &requestInfo);
+
+    static void recordResponse(std::uint32_t connectionId, RequestId requestId,
+                               const std::vector<unsigned char> &responseBuffer);
+
+    static void closeConnection(std::uint32_t connectionId);
+
+private:
+    static bool isConnectionRecorded(std::uint32_t connectionId);
+
+    static inline std::atomic<bool> _isRecording{false};
+};
+
+class TrafficCaptureReader {
+public:
+    TrafficCaptureReader() = delete;  // Prevent construction
+    ~TrafficCaptureReader() = delete;  // Prevent destruction
+
+    static Result<std::vector<CaptureRecord>> readCapture(const std::string &filePath);
+};
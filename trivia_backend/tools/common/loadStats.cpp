@@ -0,0 +1,154 @@
+#include "loadStats.h"
+#include <fstream>
+#include <sstream>
+#include <fmt/format.h>
+
+namespace {
+    double toPercent(std::uint64_t part, std::uint64_t total) {
+        return total == 0 ? 0.0 : 100.0 * static_cast<double>(part) / static_cast<double>(total);
+    }
+}
+
+void LoadStats::recordResponse(RequestId requestId, std::uint64_t latencyMicroseconds, bool isErrorResponse,
+                               bool isRejected) {
+    auto &requestStats = _requests[static_cast<unsigned char>(requestId)];
+    requestStats.latency.record(latencyMicroseconds);
+    if (isErrorResponse)
+        requestStats.errorResponses.fetch_add(1, std::memory_order_relaxed);
+    else if (isRejected)
+        requestStats.rejectedResponses.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LoadStats::recordConnectionFailure(RequestId requestId) {
+    _requests[static_cast<unsigned char>(requestId)].connectionFailures.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LoadStats::startRssSampling(int processId, std::chrono::milliseconds interval) {
+    if (processId <= 0 || _isSamplingRss.exchange(true))
+        return;
+
+    _rssSampler = std::thread([this, processId, interval]() {
+        while (_isSamplingRss) {
+            const auto rssKilobytes = readRssKilobytes(processId);
+            if (rssKilobytes >= 0) {
+                std::lock_guard lock(_rssSamplesMutex);
+                _rssSamples.push_back({secondsSinceStart(), rssKilobytes});
+            }
+            std::this_thread::sleep_for(interval);
+        }
+    });
+}
+
+void LoadStats::stopRssSampling() {
+    _isSamplingRss = false;
+    if (_rssSampler.joinable())
+        _rssSampler.join();
+}
+
+double LoadStats::secondsSinceStart() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - _startTime).count();
+}
+
+long LoadStats::readRssKilobytes(int processId) {
+    std::ifstream statusFile("/proc/" + std::to_string(processId) + "/status");
+    std::string line;
+    while (std::getline(statusFile, line)) {
+        if (line.rfind("VmRSS:", 0) != 0)
+            continue;
+
+        std::istringstream lineStream(line.substr(6));
+        long rssKilobytes = -1;
+        lineStream >> rssKilobytes;
+        return rssKilobytes;
+    }
+    return -1;  // no such process or not linux
+}
+
+std::string LoadStats::report() const {
+    const double elapsedSeconds = secondsSinceStart();
+    std::uint64_t totalRequests = 0;
+    std::uint64_t totalErrors = 0;
+
+    std::string report = fmt::format("{:<34}{:>10}{:>10}{:>9}{:>10}{:>7}{:>11}{:>11}{:>11}{:>11}\n",
+                                     "request", "count", "req/s", "errors", "rejected", "lost", "p50 ms", "p90 ms",
+                                     "p99 ms", "max ms");
+    for (std::size_t id = 0; id < _requests.size(); id++) {
+        const auto &requestStats = _requests[id];
+        const auto count = requestStats.latency.count();
+        const auto connectionFailures = requestStats.connectionFailures.load();
+        if (count == 0 && connectionFailures == 0)
+            continue;
+
+        const auto errorResponses = requestStats.errorResponses.load();
+        totalRequests += count;
+        totalErrors += errorResponses;
+        report += fmt::format("{:<34}{:>10}{:>10.1f}{:>8.1f}%{:>9.1f}%{:>7}{:>11.2f}{:>11.2f}{:>11.2f}{:>11.2f}\n",
+                              requestIdToString(static_cast<RequestId>(id)), count,
+                              static_cast<double>(count) / elapsedSeconds,
+                              toPercent(errorResponses, count),
+                              toPercent(requestStats.rejectedResponses.load(), count),
+                              connectionFailures,
+                              static_cast<double>(requestStats.latency.percentile(50)) / 1000.0,
+                              static_cast<double>(requestStats.latency.percentile(90)) / 1000.0,
+                              static_cast<double>(requestStats.latency.percentile(99)) / 1000.0,
+                              static_cast<double>(requestStats.latency.max()) / 1000.0);
+    }
+
+    report += fmt::format("\n{} requests in {:.1f}s ({:.1f} req/s), {} error responses\n", totalRequests,
+                          elapsedSeconds, static_cast<double>(totalRequests) / elapsedSeconds, totalErrors);
+    report += fmt::format("clients: {} connected, {} failed to connect, {} signed up\n", connectedClients.load(),
+                          failedConnections.load(), signups.load());
+    report += fmt::format("journeys: {} completed, {} aborted, {} games played\n", completedJourneys.load(),
+                          abortedJourneys.load(), gamesPlayed.load());
+
+    std::lock_guard lock(_rssSamplesMutex);
+    if (!_rssSamples.empty()) {
+        long peakRssKilobytes = 0;
+        for (const auto &sample: _rssSamples)
+            peakRssKilobytes = std::max(peakRssKilobytes, sample.rssKilobytes);
+        report += fmt::format("server rss: {} KiB at start, {} KiB at end, {} KiB peak\n",
+                              _rssSamples.front().rssKilobytes, _rssSamples.back().rssKilobytes, peakRssKilobytes);
+    }
+    return report;
+}
+
+Json LoadStats::toJson() const {
+    const double elapsedSeconds = secondsSinceStart();
+    Json root;
+    root["elapsedSeconds"] = elapsedSeconds;
+    root["connectedClients"] = connectedClients.load();
+    root["failedConnections"] = failedConnections.load();
+    root["signups"] = signups.load();
+    root["gamesPlayed"] = gamesPlayed.load();
+    root["completedJourneys"] = completedJourneys.load();
+    root["abortedJourneys"] = abortedJourneys.load();
+
+    root["requests"] = Json::object();
+    for (std::size_t id = 0; id < _requests.size(); id++) {
+        const auto &requestStats = _requests[id];
+        const auto count = requestStats.latency.count();
+        if (count == 0 && requestStats.connectionFailures == 0)
+            continue;
+
+        root["requests"][requestIdToString(static_cast<RequestId>(id))] = {
+                {"count", count},
+                {"throughputPerSecond", static_cast<double>(count) / elapsedSeconds},
+                {"errorResponses", requestStats.errorResponses.load()},
+                {"rejectedResponses", requestStats.rejectedResponses.load()},
+                {"connectionFailures", requestStats.connectionFailures.load()},
+                {"latencyMicroseconds", {
+                        {"average", requestStats.latency.average()},
+                        {"p50", requestStats.latency.percentile(50)},
+                        {"p90", requestStats.latency.percentile(90)},
+                        {"p99", requestStats.latency.percentile(99)},
+                        {"max", requestStats.latency.max()}}}
+        };
+    }
+
+    root["serverRss"] = Json::array();
+    std::lock_guard lock(_rssSamplesMutex);
+    for (const auto &sample: _rssSamples)
+        root["serverRss"].push_back({{"seconds", sample.secondsSinceStart}, {"kilobytes", sample.rssKilobytes}});
+
+    return root;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "../../src/utils/metrics/latencyHistogram.h"
+#include "../../src/utils/requests/requests.h"
+
+using Json = nlohmann::json;
+
+struct RequestStats {
+    LatencyHistogram latency;   // us, from sending the request until its response fully arrived
+    std::atomic<std::uint64_t> errorResponses{0};   // answered with ERROR_RESPONSE
+    std::atomic<std::uint64_t> rejectedResponses{0};    // answered with "status": false (room full, wrong password...)
+    std::atomic<std::uint64_t> connectionFailures{0};   // connection lost before the response arrived
+};
+
+struct RssSample {
+    double secondsSinceStart;
+    long rssKilobytes;
+};
+
+// shared by every simulated client, recording is lock free
+class LoadStats {
+public:
+    LoadStats() : _startTime(std::chrono::steady_clock::now()) {}
+
+    ~LoadStats() { stopRssSampling(); }
+
+    void recordResponse(RequestId requestId, std::uint64_t latencyMicroseconds, bool isErrorResponse, bool isRejected);
+
+    void recordConnectionFailure(RequestId requestId);
+
+    std::atomic<std::uint64_t> connectedClients{0};
+    std::atomic<std::uint64_t> failedConnections{0};
+    std::atomic<std::uint64_t> signups{0};
+    std::atomic<std::uint64_t> gamesPlayed{0};
+    std::atomic<std::uint64_t> completedJourneys{0};
+    std::atomic<std::uint64_t> abortedJourneys{0};
+
+    // samples VmRSS of the process from /proc/<pid>/status on a background thread
+    void startRssSampling(int processId, std::chrono::milliseconds interval);
+
+    void stopRssSampling();
+
+    [[nodiscard]] double secondsSinceStart() const;
+
+    [[nodiscard]] std::string report() const;
+
+    [[nodiscard]] Json toJson() const;
+
+private:
+    static long readRssKilobytes(int processId);
+
+    const std::chrono::steady_clock::time_point _startTime;
+    std::array<RequestStats, 256> _requests;    // indexed by the request id byte
+
+    std::thread _rssSampler;
+    std::atomic<bool> _isSamplingRss{false};
+    mutable std::mutex _rssSamplesMutex;
+    std::vector<RssSample> _rssSamples;
+};
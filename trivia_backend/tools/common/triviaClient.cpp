@@ -0,0 +1,109 @@
+#include "triviaClient.h"
+
+bool TriviaClient::connect() {
+    try {
+        _socket = kissnet::tcp_socket(_endpoint);
+        const auto status = _socket.connect();
+        _isConnected = status.value == kissnet::socket_status::valid;
+    }
+    catch (const std::exception &e) {
+        _isConnected = false;
+    }
+    return _isConnected;
+}
+
+void TriviaClient::close() {
+    if (!_isConnected)
+        return;
+
+    _isConnected = false;
+    _socket.close();
+}
+
+bool TriviaClient::negotiateEncoding(PayloadEncoding encoding) {
+    const auto encodingName = payloadEncodingToString(encoding);
+    _encoding = PayloadEncoding::JSON;  // the hello and its response are always JSON
+    const auto hello = request(RequestId::CLIENT_HELLO_REQUEST, {{"encodings", {encodingName}}});
+    if (!hello.has_value() || !hello->isOk() || hello->body.value("encoding", "") != encodingName)
+        return false;
+
+    _encoding = encoding;
+    return true;
+}
+
+std::optional<TriviaResponse> TriviaClient::request(RequestId requestId, const Json &body) {
+    // the server treats an empty read as a disconnection, so body-less requests still send "{}"
+    if (!sendFrame(static_cast<unsigned char>(requestId), PayloadCodec::encode(body, _encoding)))
+        return std::nullopt;
+
+    const auto frame = receiveFrame();
+    if (!frame.has_value())
+        return std::nullopt;
+
+    Json responseBody = PayloadCodec::decode(frame->second, _encoding);
+    if (responseBody.is_discarded())
+        return std::nullopt;
+
+    return TriviaResponse{frame->first, std::move(responseBody)};
+}
+
+bool TriviaClient::sendFrame(unsigned char id, const std::vector<unsigned char> &payload) {
+    if (!_isConnected)
+        return false;
+
+    std::vector<unsigned char> frame;
+    frame.reserve(5 + payload.size());
+    frame.push_back(id);
+
+    const auto length = static_cast<unsigned int>(payload.size());
+    for (int shift = 24; shift >= 0; shift -= 8)
+        frame.push_back(static_cast<unsigned char>((length >> shift) & 0xFF));    // big endian
+    frame.insert(frame.end(), payload.begin(), payload.end());
+
+    try {
+        const auto [size, status] = _socket.send(reinterpret_cast<const std::byte *>(frame.data()), frame.size());
+        if (status.value == kissnet::socket_status::valid && size == frame.size())
+            return true;
+    }
+    catch (const std::exception &e) {}
+
+    close();
+    return false;
+}
+
+std::optional<std::pair<unsigned char, std::vector<unsigned char>>> TriviaClient::receiveFrame() {
+    unsigned char header[5];
+    if (!receiveExact(header, sizeof(header)))
+        return std::nullopt;
+
+    const unsigned int length = header[1] << 24 | header[2] << 16 | header[3] << 8 | header[4];
+    std::vector<unsigned char> payload(length);
+    if (length > 0 && !receiveExact(payload.data(), payload.size()))
+        return std::nullopt;
+
+    return std::make_pair(header[0], std::move(payload));
+}
+
+bool TriviaClient::receiveExact(unsigned char *buffer, std::size_t bytesToRead) {
+    if (!_isConnected)
+        return false;
+
+    std::size_t received = 0;
+    try {
+        // large responses (rooms list, game results) may arrive in several segments
+        while (received < bytesToRead) {
+            const auto [size, status] = _socket.recv(reinterpret_cast<std::byte *>(buffer + received),
+                                                     bytesToRead - received);
+            if (status.value != kissnet::socket_status::valid || size == 0)
+                break;
+            received += size;
+        }
+    }
+    catch (const std::exception &e) {}
+
+    if (received == bytesToRead)
+        return true;
+
+    close();
+    return false;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+#include <kissnet.hpp>
+#include <nlohmann/json.hpp>
+#include "../../src/utils/requests/requests.h"
+#include "../../src/utils/marshaling/payloadEncoding.h"
+
+using Json = nlohmann::json;
+
+constexpr unsigned char ERROR_RESPONSE_ID = 0;  // ResponseId::ERROR_RESPONSE
+constexpr unsigned char ROOM_STATE_NOT_MODIFIED_RESPONSE_ID = 24;  // ResponseId::ROOM_STATE_NOT_MODIFIED_RESPONSE
+
+struct TriviaResponse {
+    unsigned char responseId;
+    Json body;
+
+    [[nodiscard]] bool isError() const { return responseId == ERROR_RESPONSE_ID; }
+
+    // "status" field of the response, false for error responses
+    [[nodiscard]] bool isOk() const { return !isError() && body.value("status", false); }
+};
+
+// blocking client speaking the server framing: [1 byte id][4 bytes big endian length][json]
+class TriviaClient {
+public:
+    TriviaClient(const std::string &host, int port) : _endpoint(host, static_cast<kissnet::port_t>(port)) {}
+
+    TriviaClient(const TriviaClient &) = delete;
+    TriviaClient &operator=(const TriviaClient &) = delete;
+
+    ~TriviaClient() { close(); }
+
+    bool connect();
+
+    void close();
+
+    [[nodiscard]] bool isConnected() const { return _isConnected; }
+
+    // CLIENT_HELLO handshake, returns false when the connection is lost or the server picked another encoding
+    bool negotiateEncoding(PayloadEncoding encoding);
+
+    [[nodiscard]] PayloadEncoding getEncoding() const { return _encoding; }
+
+    // sends a single frame and waits for its response, std::nullopt when the connection is lost
+    std::optional<TriviaResponse> request(RequestId requestId, const Json &body = Json::object());
+
+    // building blocks of request(), exposed for tools that replay raw frames
+    bool sendFrame(unsigned char id, const std::vector<unsigned char> &payload);
+    std::optional<std::pair<unsigned char, std::vector<unsigned char>>> receiveFrame();
+
+private:
+    bool receiveExact(unsigned char *buffer, std::size_t bytesToRead);
+
+    kissnet::endpoint _endpoint;
+    kissnet::tcp_socket _socket;
+    bool _isConnected = false;
+    PayloadEncoding _encoding = PayloadEncoding::JSON;
+};
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "scenario.h"
+#include "../common/loadStats.h"
+#include "simulatedClient.h"
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <scenario.json>" << std::endl;
+        return 1;
+    }
+
+    const auto scenario = loadScenario(argv[1]);
+    if (!scenario.has_value())
+        return 1;
+
+    const auto plans = planClients(scenario.value());
+    const auto hostsCount = std::count_if(plans.begin(), plans.end(),
+                                          [](const ClientPlan &plan) { return plan.role == ClientRole::Host; });
+    const auto browsersCount = std::count_if(plans.begin(), plans.end(),
+                                             [](const ClientPlan &plan) { return plan.role == ClientRole::Browser; });
+    std::cout << "Running " << plans.size() << " clients against " << scenario->host << ":" << scenario->port
+              << " (" << hostsCount << " rooms, " << plans.size() - browsersCount << " players, " << browsersCount
+              << " browsers)" << std::endl;
+
+    LoadStats stats;
+    stats.startRssSampling(scenario->serverPid, std::chrono::milliseconds(scenario->rssSampleIntervalMs));
+
+    // progress line every few seconds, so a stuck run is visible
+    std::atomic<bool> isRunning{true};
+    std::thread progressPrinter([&stats, &isRunning]() {
+        while (isRunning) {
+            std::this_thread::sleep_for(std::chrono::seconds(5));
+            std::cout << "[" << static_cast<int>(stats.secondsSinceStart()) << "s] connected: "
+                      << stats.connectedClients << ", completed: " << stats.completedJourneys << ", aborted: "
+                      << stats.abortedJourneys << std::endl;
+        }
+    });
+
+    std::vector<std::thread> clientThreads;
+    clientThreads.reserve(plans.size());
+    const auto rampStart = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < plans.size(); i++) {
+        std::this_thread::sleep_until(rampStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(scenario->rampUpSeconds * static_cast<double>(i) /
+                                              static_cast<double>(plans.size()))));
+        clientThreads.emplace_back([&scenario, &stats, &plan = plans[i]]() {
+            SimulatedClient(scenario.value(), stats, plan).run();
+        });
+    }
+
+    for (auto &clientThread: clientThreads)
+        clientThread.join();
+
+    isRunning = false;
+    progressPrinter.join();
+    stats.stopRssSampling();
+
+    std::cout << std::endl << stats.report();
+
+    std::ofstream reportFile(scenario->reportPath, std::ios_base::trunc);
+    if (!reportFile.is_open()) {
+        std::cerr << "Failed to write report file '" << scenario->reportPath << "'" << std::endl;
+        return 1;
+    }
+    reportFile << stats.toJson().dump(2);
+    std::cout << "Report written to '" << scenario->reportPath << "'" << std::endl;
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include "scenario.h"
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include "../../src/utils/marshaling/payloadEncoding.h"
+
+using Json = nlohmann::json;
+
+std::optional<Scenario> loadScenario(const std::string &filePath) {
+    std::ifstream file(filePath);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open scenario file '" << filePath << "'" << std::endl;
+        return std::nullopt;
+    }
+
+    Json root = Json::parse(file, nullptr, false);
+    if (root.is_discarded() || !root.is_object()) {
+        std::cerr << "Scenario file '" << filePath << "' is not a JSON object" << std::endl;
+        return std::nullopt;
+    }
+
+    Scenario scenario;
+    try {
+        scenario.host = root.value("host", scenario.host);
+        scenario.port = root.value("port", scenario.port);
+        scenario.clients = root.value("clients", scenario.clients);
+        scenario.rampUpSeconds = root.value("rampUpSeconds", scenario.rampUpSeconds);
+        scenario.browserRatio = root.value("browserRatio", scenario.browserRatio);
+        scenario.playersPerRoom = root.value("playersPerRoom", scenario.playersPerRoom);
+        scenario.questionCount = root.value("questionCount", scenario.questionCount);
+        scenario.timePerQuestion = root.value("timePerQuestion", scenario.timePerQuestion);
+        scenario.lobbyTimeoutSeconds = root.value("lobbyTimeoutSeconds", scenario.lobbyTimeoutSeconds);
+        scenario.answerDelayMinMs = root.value("answerDelayMinMs", scenario.answerDelayMinMs);
+        scenario.answerDelayMaxMs = root.value("answerDelayMaxMs", scenario.answerDelayMaxMs);
+        scenario.thinkTimeMinMs = root.value("thinkTimeMinMs", scenario.thinkTimeMinMs);
+        scenario.thinkTimeMaxMs = root.value("thinkTimeMaxMs", scenario.thinkTimeMaxMs);
+        scenario.pollIntervalMs = root.value("pollIntervalMs", scenario.pollIntervalMs);
+        scenario.roomStateWaitMs = root.value("roomStateWaitMs", scenario.roomStateWaitMs);
+        scenario.browseSeconds = root.value("browseSeconds", scenario.browseSeconds);
+        scenario.userPrefix = root.value("userPrefix", scenario.userPrefix);
+        scenario.password = root.value("password", scenario.password);
+        scenario.payloadEncoding = root.value("payloadEncoding", scenario.payloadEncoding);
+        scenario.serverPid = root.value("serverPid", scenario.serverPid);
+        scenario.rssSampleIntervalMs = root.value("rssSampleIntervalMs", scenario.rssSampleIntervalMs);
+        scenario.reportPath = root.value("reportPath", scenario.reportPath);
+    } catch (const Json::exception &e) {
+        std::cerr << "Invalid scenario file '" << filePath << "': " << e.what() << std::endl;
+        return std::nullopt;
+    }
+
+    if (!payloadEncodingFromString(scenario.payloadEncoding).has_value()) {
+        std::cerr << "Invalid scenario: payloadEncoding must be json, msgpack or cbor" << std::endl;
+        return std::nullopt;
+    }
+
+    // the same limits the server applies to new rooms (MenuRequestHandler::isValidRoomDetails)
+    if (scenario.playersPerRoom < 2 || scenario.questionCount < 2 || scenario.timePerQuestion < 5) {
+        std::cerr << "Invalid scenario: playersPerRoom >= 2, questionCount >= 2 and timePerQuestion >= 5 are required"
+                  << std::endl;
+        return std::nullopt;
+    }
+
+    if (scenario.browserRatio < 0 || scenario.browserRatio > 1 || scenario.clients == 0 ||
+        scenario.answerDelayMinMs > scenario.answerDelayMaxMs || scenario.thinkTimeMinMs > scenario.thinkTimeMaxMs) {
+        std::cerr << "Invalid scenario: check clients, browserRatio and the min / max delays" << std::endl;
+        return std::nullopt;
+    }
+
+    return scenario;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+// load generator settings, every field can be overridden from the scenario JSON file (same key names)
+struct Scenario {
+    std::string host = "127.0.0.1";
+    int port = 8826;
+
+    unsigned int clients = 100;
+    double rampUpSeconds = 10;      // clients are started evenly over this period
+    double browserRatio = 0.2;      // share of clients that only browse the menu, the rest play games
+
+    // games
+    unsigned int playersPerRoom = 4;    // the first player of each room hosts it
+    unsigned int questionCount = 5;
+    unsigned int timePerQuestion = 10;
+    unsigned int lobbyTimeoutSeconds = 60;  // how long a host waits for its room to fill
+
+    // pacing
+    unsigned int answerDelayMinMs = 500;    // time a player "thinks" before submitting an answer
+    unsigned int answerDelayMaxMs = 4000;
+    unsigned int thinkTimeMinMs = 500;      // pause between menu requests
+    unsigned int thinkTimeMaxMs = 2000;
+    unsigned int pollIntervalMs = 500;      // rooms list / room state polling, like the client does
+    unsigned int roomStateWaitMs = 0;       // long-poll the room state for up to this long instead, 0 to poll
+    unsigned int browseSeconds = 60;        // how long browsers stay in the menu
+
+    // accounts are "<userPrefix><client index>", missing ones are signed up (requires a server with stand-ins)
+    std::string userPrefix = "lg";
+    std::string password = "Loadgen#2024";
+    std::string payloadEncoding = "json";   // json, msgpack or cbor, negotiated with CLIENT_HELLO when not json
+
+    // reporting
+    int serverPid = 0;                      // sample the server VmRSS when set (linux only)
+    unsigned int rssSampleIntervalMs = 1000;
+    std::string reportPath = "loadgen_report.json";
+};
+
+// returns std::nullopt (after printing the reason) when the file can't be read or has invalid values
+std::optional<Scenario> loadScenario(const std::string &filePath);
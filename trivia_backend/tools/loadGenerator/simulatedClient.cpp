@@ -0,0 +1,313 @@
+#include "simulatedClient.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "../../src/constants.h"
+
+namespace {
+    // the server reveals the answer for 5 seconds between questions (see Game::submitAnswer)
+    constexpr unsigned int QUESTION_BREAK_MS = 5000;
+    // answers later than this before the question closes risk "Answer already released"
+    constexpr unsigned int ANSWER_SAFETY_MARGIN_MS = 1000;
+    constexpr unsigned int GAME_RESULTS_ATTEMPTS = 20;
+}
+
+std::vector<ClientPlan> planClients(const Scenario &scenario) {
+    std::vector<ClientPlan> plans;
+    std::vector<unsigned int> playerClientIndexes;
+
+    for (unsigned int clientIndex = 0; clientIndex < scenario.clients; clientIndex++) {
+        const bool isBrowser = static_cast<unsigned int>((clientIndex + 1) * scenario.browserRatio) >
+                               static_cast<unsigned int>(clientIndex * scenario.browserRatio);
+        plans.push_back({clientIndex, isBrowser ? ClientRole::Browser : ClientRole::Joiner, 0, 0});
+        if (!isBrowser)
+            playerClientIndexes.push_back(clientIndex);
+    }
+
+    const auto playersCount = static_cast<unsigned int>(playerClientIndexes.size());
+    for (unsigned int playerIndex = 0; playerIndex < playersCount; playerIndex++) {
+        const unsigned int roomIndex = playerIndex / scenario.playersPerRoom;
+        const unsigned int roomFirstPlayer = roomIndex * scenario.playersPerRoom;
+        const unsigned int roomSize = std::min(scenario.playersPerRoom, playersCount - roomFirstPlayer);
+        auto &plan = plans[playerClientIndexes[playerIndex]];
+
+        // a game needs at least two players, a leftover single player just browses
+        if (roomSize < 2) {
+            plan.role = ClientRole::Browser;
+            continue;
+        }
+
+        plan.role = playerIndex == roomFirstPlayer ? ClientRole::Host : ClientRole::Joiner;
+        plan.roomIndex = roomIndex;
+        plan.roomSize = roomSize;
+    }
+
+    return plans;
+}
+
+SimulatedClient::SimulatedClient(const Scenario &scenario, LoadStats &stats, const ClientPlan &plan)
+        : _scenario(scenario), _stats(stats), _plan(plan),
+          _username(scenario.userPrefix + std::to_string(plan.clientIndex)),
+          _client(scenario.host, scenario.port), _random(std::random_device{}()) {}
+
+void SimulatedClient::run() {
+    if (!_client.connect()) {
+        _stats.failedConnections++;
+        _stats.abortedJourneys++;
+        return;
+    }
+    _stats.connectedClients++;
+
+    const auto encoding = payloadEncodingFromString(_scenario.payloadEncoding).value_or(PayloadEncoding::JSON);
+    if (encoding != PayloadEncoding::JSON && !_client.negotiateEncoding(encoding)) {
+        _stats.abortedJourneys++;
+        return;
+    }
+
+    bool isCompleted = authenticate();
+    if (isCompleted) {
+        switch (_plan.role) {
+            case ClientRole::Host:
+                isCompleted = hostRoom();
+                break;
+            case ClientRole::Joiner:
+                isCompleted = joinRoom();
+                break;
+            case ClientRole::Browser:
+                isCompleted = browse();
+                break;
+        }
+    }
+
+    // an aborted journey just disconnects, the server cleans up like for a crashed client
+    if (isCompleted)
+        isCompleted = timedRequest(RequestId::LOGOUT_REQUEST).has_value();
+
+    if (isCompleted)
+        _stats.completedJourneys++;
+    else
+        _stats.abortedJourneys++;
+    _client.close();
+}
+
+std::optional<TriviaResponse> SimulatedClient::timedRequest(RequestId requestId, const Json &body) {
+    const auto start = std::chrono::steady_clock::now();
+    auto response = _client.request(requestId, body);
+    const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+    if (!response.has_value()) {
+        _stats.recordConnectionFailure(requestId);
+        return std::nullopt;
+    }
+
+    const bool isRejected = response->body.contains("status") && !response->body.value("status", false);
+    _stats.recordResponse(requestId, static_cast<std::uint64_t>(latency), response->isError(), isRejected);
+    return response;
+}
+
+bool SimulatedClient::authenticate() {
+    const auto login = timedRequest(RequestId::LOGIN_REQUEST,
+                                    {{"username", _username}, {"password", _scenario.password}});
+    if (!login.has_value())
+        return false;
+
+    if (login->isOk())
+        return true;
+
+    // first run against this database, create the account (the stand-in email sender uses a fixed code)
+    if (login->body.value("message", "") != "User does not exist")
+        return false;
+
+    const auto signup = timedRequest(RequestId::SIGNUP_REQUEST,
+                                     {{"username", _username}, {"password", _scenario.password},
+                                      {"email", _username + "@loadgen.test"},
+                                      {"address", "Load Street, 1, Test City"},
+                                      {"phoneNumber", "0501234567"}, {"birthday", "1.1.1990"}});
+    if (!signup.has_value() || !signup->isOk())
+        return false;
+
+    const auto verification = timedRequest(RequestId::SUBMIT_VERIFICATION_CODE_REQUEST,
+                                           {{"code", STAND_IN_VERIFICATION_CODE}});
+    if (!verification.has_value() || !verification->isOk() || !verification->body.value("isVerified", false))
+        return false;
+
+    _stats.signups++;
+    return true;
+}
+
+std::optional<TriviaResponse> SimulatedClient::getRoomState(std::optional<TriviaResponse> &lastRoomState) {
+    Json body = Json::object();
+    if (_scenario.roomStateWaitMs > 0 && lastRoomState.has_value())
+        body = {{"lastSeenVersion", lastRoomState->body.value("version", std::uint64_t{0})},
+                {"maxWaitMs", _scenario.roomStateWaitMs}};
+
+    const auto roomState = timedRequest(RequestId::GET_ROOM_STATE_REQUEST, body);
+    if (!roomState.has_value() || roomState->isError())
+        return roomState;
+
+    if (roomState->responseId == ROOM_STATE_NOT_MODIFIED_RESPONSE_ID && lastRoomState.has_value())
+        return lastRoomState;
+
+    lastRoomState = roomState;
+    return roomState;
+}
+
+bool SimulatedClient::hostRoom() {
+    const auto createRoom = timedRequest(RequestId::CREATE_ROOM_REQUEST,
+                                         {{"name", getRoomName()}, {"maxPlayers", _plan.roomSize},
+                                          {"questionCount", _scenario.questionCount},
+                                          {"timePerQuestion", _scenario.timePerQuestion}});
+    if (!createRoom.has_value() || !createRoom->isOk())
+        return false;
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(_scenario.lobbyTimeoutSeconds);
+    std::optional<TriviaResponse> lastRoomState;
+    while (true) {
+        const auto roomState = getRoomState(lastRoomState);
+        if (!roomState.has_value() || roomState->isError())
+            return false;
+
+        const auto playersInRoom = roomState->body.value("players", Json::array()).size();
+        if (playersInRoom >= _plan.roomSize)
+            break;
+
+        if (std::chrono::steady_clock::now() > deadline) {
+            if (playersInRoom >= 2)
+                break;  // start with whoever made it
+
+            timedRequest(RequestId::CLOSE_ROOM_REQUEST);
+            return false;
+        }
+        if (_scenario.roomStateWaitMs == 0)
+            sleepForMs(_scenario.pollIntervalMs, _scenario.pollIntervalMs);
+    }
+
+    const auto startGame = timedRequest(RequestId::START_GAME_REQUEST);
+    if (!startGame.has_value() || !startGame->isOk())
+        return false;
+
+    return playGame();
+}
+
+bool SimulatedClient::joinRoom() {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(_scenario.lobbyTimeoutSeconds);
+    bool hasJoined = false;
+    while (!hasJoined) {
+        if (std::chrono::steady_clock::now() > deadline)
+            return false;
+
+        const auto rooms = timedRequest(RequestId::GET_ROOMS_REQUEST, {{"notActive", true}, {"notFull", true}});
+        if (!rooms.has_value())
+            return false;
+
+        for (const auto &room: rooms->body.value("rooms", Json::array())) {
+            if (room.value("name", "") != getRoomName() || room.value("isActive", true))
+                continue;
+
+            const auto joinRoom = timedRequest(RequestId::JOIN_ROOM_REQUEST, {{"roomId", room.value("id", "")}});
+            if (!joinRoom.has_value())
+                return false;
+            hasJoined = joinRoom->isOk();
+            break;
+        }
+
+        if (!hasJoined)
+            sleepForMs(_scenario.pollIntervalMs, _scenario.pollIntervalMs);
+    }
+
+    // the host may wait the whole lobby timeout for late players
+    const auto gameDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(2 * _scenario.lobbyTimeoutSeconds);
+    std::optional<TriviaResponse> lastRoomState;
+    while (std::chrono::steady_clock::now() < gameDeadline) {
+        const auto roomState = getRoomState(lastRoomState);
+        if (!roomState.has_value() || roomState->isError() || roomState->body.value("isClosed", false))
+            return false;
+
+        if (roomState->body.value("hasGameBegun", false))
+            return playGame();
+
+        if (_scenario.roomStateWaitMs == 0)
+            sleepForMs(_scenario.pollIntervalMs, _scenario.pollIntervalMs);
+    }
+
+    timedRequest(RequestId::LEAVE_ROOM_REQUEST);
+    return false;
+}
+
+bool SimulatedClient::playGame() {
+    const unsigned int answerWindowMs = _scenario.timePerQuestion * 1000 - ANSWER_SAFETY_MARGIN_MS;
+    std::uniform_int_distribution<unsigned int> answerDistribution(0, 3);
+    unsigned int questionId = 0;
+
+    while (questionId < _scenario.questionCount) {
+        const auto question = timedRequest(RequestId::GET_QUESTION_REQUEST);
+        if (!question.has_value())
+            return false;
+        if (question->isError())
+            break;  // the game already ended
+
+        const auto currentQuestionId = question->body.value("questionId", 0u);
+        if (currentQuestionId < questionId) {
+            // still in the break after the previous answer
+            sleepForMs(_scenario.pollIntervalMs / 2, _scenario.pollIntervalMs / 2);
+            continue;
+        }
+        questionId = currentQuestionId;
+
+        sleepForMs(std::min(_scenario.answerDelayMinMs, answerWindowMs), std::min(_scenario.answerDelayMaxMs, answerWindowMs));
+
+        // the server holds the response until the question closes, so its latency includes that wait
+        const auto submitAnswer = timedRequest(RequestId::SUBMIT_ANSWER_REQUEST,
+                                               {{"answerId", answerDistribution(_random)}, {"questionId", questionId}});
+        if (!submitAnswer.has_value())
+            return false;
+
+        questionId++;
+        if (!submitAnswer->isError())
+            sleepForMs(QUESTION_BREAK_MS, QUESTION_BREAK_MS);
+    }
+
+    bool hasResults = false;
+    for (unsigned int attempt = 0; attempt < GAME_RESULTS_ATTEMPTS && !hasResults; attempt++) {
+        const auto gameResults = timedRequest(RequestId::GET_GAME_RESULTS_REQUEST);
+        if (!gameResults.has_value())
+            return false;
+
+        hasResults = gameResults->isOk();
+        if (!hasResults)
+            sleepForMs(_scenario.pollIntervalMs, _scenario.pollIntervalMs);
+    }
+
+    const auto leaveGame = timedRequest(RequestId::LEAVE_GAME_REQUEST);
+    if (!leaveGame.has_value() || !hasResults)
+        return false;
+
+    _stats.gamesPlayed++;
+    return true;
+}
+
+bool SimulatedClient::browse() {
+    static constexpr RequestId MENU_REQUESTS[] = {RequestId::GET_ROOMS_REQUEST, RequestId::GET_HIGHSCORES_REQUEST,
+                                                  RequestId::GET_PERSONAL_STATS_REQUEST,
+                                                  RequestId::GET_USER_DATA_REQUEST};
+    std::uniform_int_distribution<std::size_t> requestDistribution(0, std::size(MENU_REQUESTS) - 1);
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(_scenario.browseSeconds);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (!timedRequest(MENU_REQUESTS[requestDistribution(_random)]).has_value())
+            return false;
+
+        sleepForMs(_scenario.thinkTimeMinMs, _scenario.thinkTimeMaxMs);
+    }
+    return true;
+}
+
+void SimulatedClient::sleepForMs(unsigned int minMs, unsigned int maxMs) {
+    std::uniform_int_distribution<unsigned int> delayDistribution(minMs, std::max(minMs, maxMs));
+    std::this_thread::sleep_for(std::chrono::milliseconds(delayDistribution(_random)));
+}
+
+std::string SimulatedClient::getRoomName() const {
+    return _scenario.userPrefix + "_room" + std::to_string(_plan.roomIndex);
+}
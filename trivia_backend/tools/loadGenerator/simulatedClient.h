@@ -0,0 +1,62 @@
+#pragma once
+
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+#include "scenario.h"
+#include "../common/loadStats.h"
+#include "../common/triviaClient.h"
+
+enum class ClientRole {
+    Host,       // creates a room, waits for it to fill and starts the game
+    Joiner,     // finds its host's room in the rooms list and joins it
+    Browser     // stays in the menu (rooms list, high scores, statistics)
+};
+
+struct ClientPlan {
+    unsigned int clientIndex;
+    ClientRole role;
+    unsigned int roomIndex;
+    unsigned int roomSize;  // players expected in the room, host included
+};
+
+// splits the scenario clients into browsers and rooms of players, spreading the browsers over the ramp up
+std::vector<ClientPlan> planClients(const Scenario &scenario);
+
+// a single simulated player running a full journey on its own connection:
+// login (or signup + verification) -> menu / room -> game -> results -> logout
+class SimulatedClient {
+public:
+    SimulatedClient(const Scenario &scenario, LoadStats &stats, const ClientPlan &plan);
+
+    void run();
+
+private:
+    // sends the request and records its latency and outcome, std::nullopt when the connection was lost
+    std::optional<TriviaResponse> timedRequest(RequestId requestId, const Json &body = Json::object());
+
+    // long-polls when the scenario sets roomStateWaitMs, a not modified response is answered with lastRoomState
+    std::optional<TriviaResponse> getRoomState(std::optional<TriviaResponse> &lastRoomState);
+
+    bool authenticate();
+
+    bool hostRoom();
+
+    bool joinRoom();
+
+    bool playGame();
+
+    bool browse();
+
+    void sleepForMs(unsigned int minMs, unsigned int maxMs);
+
+    [[nodiscard]] std::string getRoomName() const;
+
+    const Scenario &_scenario;
+    LoadStats &_stats;
+    const ClientPlan _plan;
+    const std::string _username;
+    TriviaClient _client;
+    std::mt19937 _random;
+};
@@ -0,0 +1,86 @@
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+#include "replayOptions.h"
+#include "replaySession.h"
+
+namespace {
+    // p50 / p99 of every request present in both reports
+    void printComparison(const Json &baseline, const Json &current) {
+        const auto deltaPercent = [](double before, double after) {
+            return before == 0 ? 0.0 : 100.0 * (after - before) / before;
+        };
+
+        std::cout << fmt::format("\n{:<34}{:>12}{:>12}{:>9}{:>12}{:>12}{:>9}\n", "request", "base p50 ms",
+                                 "p50 ms", "delta", "base p99 ms", "p99 ms", "delta");
+        for (const auto &[requestName, currentStats]: current["requests"].items()) {
+            if (!baseline["requests"].contains(requestName))
+                continue;
+
+            const auto &baseLatency = baseline["requests"][requestName]["latencyMicroseconds"];
+            const auto &latency = currentStats["latencyMicroseconds"];
+            const double baseP50 = baseLatency.value("p50", 0.0) / 1000.0, p50 = latency.value("p50", 0.0) / 1000.0;
+            const double baseP99 = baseLatency.value("p99", 0.0) / 1000.0, p99 = latency.value("p99", 0.0) / 1000.0;
+            std::cout << fmt::format("{:<34}{:>12.2f}{:>12.2f}{:>+8.1f}%{:>12.2f}{:>12.2f}{:>+8.1f}%\n", requestName,
+                                     baseP50, p50, deltaPercent(baseP50, p50), baseP99, p99,
+                                     deltaPercent(baseP99, p99));
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const auto options = parseReplayOptions(argc, argv);
+    if (!options.has_value())
+        return 1;
+
+    const auto captureRes = TrafficCaptureReader::readCapture(options->capturePath);
+    if (captureRes.isError()) {
+        std::cerr << captureRes.error().message << std::endl;
+        return 1;
+    }
+
+    RoomIdMapper roomIdMapper;
+    const auto sessions = groupSessions(captureRes.value(), roomIdMapper);
+    std::cout << "Replaying " << sessions.size() << " sessions against " << options->host << ":" << options->port
+              << " at " << (options->speed == 0 ? std::string("max") : fmt::format("{}x", options->speed))
+              << " speed" << std::endl;
+
+    if (options->prepareAccounts)
+        prepareAccounts(sessions, options.value());
+
+    LoadStats stats;
+    std::vector<std::thread> sessionThreads;
+    sessionThreads.reserve(sessions.size());
+    const auto replayStart = std::chrono::steady_clock::now();
+    for (const auto &session: sessions) {
+        sessionThreads.emplace_back([&session, &options, &stats, &roomIdMapper, replayStart]() {
+            ReplaySession(session, options.value(), stats, roomIdMapper, replayStart).run();
+        });
+    }
+
+    for (auto &sessionThread: sessionThreads)
+        sessionThread.join();
+
+    std::cout << std::endl << stats.report();
+
+    const auto report = stats.toJson();
+    if (options->baselinePath.has_value()) {
+        std::ifstream baselineFile(options->baselinePath.value());
+        const Json baseline = Json::parse(baselineFile, nullptr, false);
+        if (baseline.is_discarded() || !baseline.contains("requests"))
+            std::cerr << "Failed to read baseline report '" << options->baselinePath.value() << "'" << std::endl;
+        else
+            printComparison(baseline, report);
+    }
+
+    std::ofstream reportFile(options->reportPath, std::ios_base::trunc);
+    if (!reportFile.is_open()) {
+        std::cerr << "Failed to write report file '" << options->reportPath << "'" << std::endl;
+        return 1;
+    }
+    reportFile << report.dump(2);
+    std::cout << "Report written to '" << options->reportPath << "'" << std::endl;
+    return 0;
+}
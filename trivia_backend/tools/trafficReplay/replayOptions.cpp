@@ -0,0 +1,53 @@
+#include "replayOptions.h"
+#include <iostream>
+
+namespace {
+    void printUsage(const char *programName) {
+        std::cerr << "Usage: " << programName << " <capture.bin> [--host <address>] [--port <port>]"
+                  << " [--speed 1|10|max] [--prepare-accounts] [--report <report.json>] [--compare <baseline.json>]"
+                  << std::endl;
+    }
+}
+
+std::optional<ReplayOptions> parseReplayOptions(int argc, char *argv[]) {
+    ReplayOptions options;
+    for (int i = 1; i < argc; i++) {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        try {
+            if (argument == "--prepare-accounts")
+                options.prepareAccounts = true;
+            else if (argument == "--host" && hasValue)
+                options.host = argv[++i];
+            else if (argument == "--port" && hasValue)
+                options.port = std::stoi(argv[++i]);
+            else if (argument == "--speed" && hasValue) {
+                const std::string speed = argv[++i];
+                options.speed = speed == "max" ? 0.0 : std::stod(speed);
+                if (options.speed < 0)
+                    throw std::invalid_argument("negative speed");
+            }
+            else if (argument == "--report" && hasValue)
+                options.reportPath = argv[++i];
+            else if (argument == "--compare" && hasValue)
+                options.baselinePath = argv[++i];
+            else if (argument.rfind("--", 0) != 0 && options.capturePath.empty())
+                options.capturePath = argument;
+            else {
+                printUsage(argv[0]);
+                return std::nullopt;
+            }
+        }
+        catch (const std::exception &e) {
+            std::cerr << "Invalid value for '" << argument << "'" << std::endl;
+            return std::nullopt;
+        }
+    }
+
+    if (options.capturePath.empty()) {
+        printUsage(argv[0]);
+        return std::nullopt;
+    }
+    return options;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+struct ReplayOptions {
+    std::string capturePath;
+    std::string host = "127.0.0.1";
+    int port = 8826;
+    double speed = 1.0;  // 0 replays every session as fast as the server answers
+    bool prepareAccounts = false;
+    std::string reportPath = "replay_report.json";
+    std::optional<std::string> baselinePath;   // previous report to print the latency deltas against
+};
+
+// prints the usage and returns std::nullopt on invalid arguments
+std::optional<ReplayOptions> parseReplayOptions(int argc, char *argv[]);
@@ -0,0 +1,189 @@
+#include "replaySession.h"
+#include <algorithm>
+#include <map>
+#include <iostream>
+#include <set>
+#include <thread>
+#include "../../src/constants.h"
+
+void RoomIdMapper::learnCapturedRooms(const std::vector<unsigned char> &getRoomsResponse) {
+    // the recorder stores these as JSON whatever the connection's encoding was
+    learnRooms(Json::parse(getRoomsResponse, nullptr, false), _capturedIdToName, true);
+}
+
+void RoomIdMapper::learnLiveRooms(const Json &getRoomsResponse) {
+    learnRooms(getRoomsResponse, _nameToLiveId, false);
+}
+
+std::string RoomIdMapper::toLiveId(const std::string &capturedRoomId) const {
+    std::lock_guard lock(_mutex);
+    const auto name = _capturedIdToName.find(capturedRoomId);
+    if (name == _capturedIdToName.end())
+        return capturedRoomId;
+
+    const auto liveId = _nameToLiveId.find(name->second);
+    return liveId == _nameToLiveId.end() ? capturedRoomId : liveId->second;
+}
+
+void RoomIdMapper::learnRooms(const Json &getRoomsResponse, std::unordered_map<std::string, std::string> &map,
+                              bool isIdToName) {
+    if (getRoomsResponse.is_discarded() || !getRoomsResponse.is_object() || !getRoomsResponse.contains("rooms") ||
+        !getRoomsResponse["rooms"].is_array())
+        return;
+
+    std::lock_guard lock(_mutex);
+    for (const auto &room: getRoomsResponse["rooms"]) {
+        const auto id = room.value("id", "");
+        const auto name = room.value("name", "");
+        if (isIdToName)
+            map[id] = name;
+        else
+            map[name] = id;
+    }
+}
+
+std::vector<CapturedSession> groupSessions(const std::vector<CaptureRecord> &records, RoomIdMapper &roomIdMapper) {
+    std::map<std::uint32_t, CapturedSession> sessions;
+    for (const auto &record: records) {
+        switch (record.type) {
+            case CaptureRecordType::CONNECTION_OPENED:
+                sessions[record.connectionId] = {record.connectionId, record.timestampMicroseconds, {}};
+                break;
+            case CaptureRecordType::REQUEST:
+                // connections opened before the capture started have no OPENED record
+                if (sessions.find(record.connectionId) != sessions.end())
+                    sessions[record.connectionId].requests.push_back(record);
+                break;
+            case CaptureRecordType::RESPONSE:
+                roomIdMapper.learnCapturedRooms(record.payload);
+                break;
+            case CaptureRecordType::CONNECTION_CLOSED:
+                break;
+        }
+    }
+
+    std::vector<CapturedSession> orderedSessions;
+    orderedSessions.reserve(sessions.size());
+    for (auto &[connectionId, session]: sessions)
+        orderedSessions.push_back(std::move(session));
+
+    std::sort(orderedSessions.begin(), orderedSessions.end(), [](const auto &first, const auto &second) {
+        return first.openedAtMicroseconds < second.openedAtMicroseconds;
+    });
+    return orderedSessions;
+}
+
+void prepareAccounts(const std::vector<CapturedSession> &sessions, const ReplayOptions &options) {
+    std::set<std::string> signedUpUsers, loggedInUsers;
+    for (const auto &session: sessions) {
+        for (const auto &request: session.requests) {
+            const auto requestId = static_cast<RequestId>(request.frameId);
+            if (requestId != RequestId::LOGIN_REQUEST && requestId != RequestId::SIGNUP_REQUEST)
+                continue;
+
+            // sessions that negotiated a binary encoding before logging in are skipped
+            const Json j = Json::parse(request.payload, nullptr, false);
+            if (j.is_discarded() || !j.is_object() || !j.contains("username") || !j["username"].is_string())
+                continue;
+            (requestId == RequestId::SIGNUP_REQUEST ? signedUpUsers : loggedInUsers).insert(j["username"]);
+        }
+    }
+
+    unsigned int preparedAccounts = 0;
+    for (const auto &username: loggedInUsers) {
+        if (signedUpUsers.count(username) != 0)
+            continue;
+
+        // accounts that already exist are rejected by the signup, which is fine
+        TriviaClient client(options.host, options.port);
+        if (!client.connect())
+            continue;
+
+        const auto signup = client.request(RequestId::SIGNUP_REQUEST,
+                                           {{"username", username}, {"password", CAPTURE_REDACTED_PASSWORD},
+                                            {"email", username + "@replay.test"},
+                                            {"address", "Replay Street, 1, Test City"},
+                                            {"phoneNumber", "0501234567"}, {"birthday", "1.1.1990"}});
+        if (!signup.has_value() || !signup->isOk())
+            continue;
+
+        const auto verification = client.request(RequestId::SUBMIT_VERIFICATION_CODE_REQUEST,
+                                                 {{"code", STAND_IN_VERIFICATION_CODE}});
+        if (verification.has_value() && verification->isOk())
+            preparedAccounts++;
+    }
+    std::cout << "Prepared " << preparedAccounts << " accounts" << std::endl;
+}
+
+ReplaySession::ReplaySession(const CapturedSession &session, const ReplayOptions &options, LoadStats &stats,
+                             RoomIdMapper &roomIdMapper, std::chrono::steady_clock::time_point replayStart)
+        : _session(session), _options(options), _stats(stats), _roomIdMapper(roomIdMapper),
+          _replayStart(replayStart), _client(options.host, options.port) {}
+
+void ReplaySession::run() {
+    waitForTimestamp(_session.openedAtMicroseconds);
+    if (!_client.connect()) {
+        _stats.failedConnections++;
+        return;
+    }
+    _stats.connectedClients++;
+
+    for (const auto &request: _session.requests) {
+        // a request that blocks on the server (SUBMIT_ANSWER until the question closes) pushes the rest of the
+        // session back, the following requests are then sent right away instead of at their scaled timestamp
+        waitForTimestamp(request.timestampMicroseconds);
+
+        const auto requestId = static_cast<RequestId>(request.frameId);
+        const auto sentAt = std::chrono::steady_clock::now();
+        const auto payload = rewritePayload(requestId, request.payload);
+        const auto response = _client.sendFrame(request.frameId, payload) ? _client.receiveFrame() : std::nullopt;
+        if (!response.has_value()) {
+            _stats.recordConnectionFailure(requestId);
+            _stats.abortedJourneys++;
+            return;
+        }
+
+        const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - sentAt).count();
+        const bool isHello = requestId == RequestId::CLIENT_HELLO_REQUEST;
+        const Json body = PayloadCodec::decode(response->second, isHello ? PayloadEncoding::JSON : _encoding);
+        const bool isErrorResponse = response->first == ERROR_RESPONSE_ID;
+        const bool isRejected = !body.is_discarded() && body.is_object() && !body.value("status", true);
+        _stats.recordResponse(requestId, static_cast<std::uint64_t>(latency), isErrorResponse, isRejected);
+
+        if (isHello && !isErrorResponse && !body.is_discarded())
+            _encoding = payloadEncodingFromString(body.value("encoding", "")).value_or(PayloadEncoding::JSON);
+        else if (requestId == RequestId::GET_ROOMS_REQUEST && !isErrorResponse)
+            _roomIdMapper.learnLiveRooms(body);
+    }
+
+    _client.close();
+    _stats.completedJourneys++;
+}
+
+void ReplaySession::waitForTimestamp(std::uint64_t timestampMicroseconds) const {
+    if (_options.speed == 0)
+        return;
+
+    std::this_thread::sleep_until(_replayStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double, std::micro>(static_cast<double>(timestampMicroseconds) / _options.speed)));
+}
+
+std::vector<unsigned char> ReplaySession::rewritePayload(RequestId requestId,
+                                                         const std::vector<unsigned char> &payload) const {
+    if (requestId != RequestId::JOIN_ROOM_REQUEST && requestId != RequestId::GET_PLAYERS_IN_ROOM_REQUEST &&
+        requestId != RequestId::SUBMIT_VERIFICATION_CODE_REQUEST)
+        return payload;
+
+    Json j = PayloadCodec::decode(payload, _encoding);
+    if (j.is_discarded() || !j.is_object())
+        return payload;
+
+    // the captured codes were sent to real mailboxes, the replayed server is expected to run with stand-ins
+    if (requestId == RequestId::SUBMIT_VERIFICATION_CODE_REQUEST)
+        j["code"] = STAND_IN_VERIFICATION_CODE;
+    else if (j.contains("roomId") && j["roomId"].is_string())
+        j["roomId"] = _roomIdMapper.toLiveId(j["roomId"]);
+
+    return PayloadCodec::encode(j, _encoding);
+}
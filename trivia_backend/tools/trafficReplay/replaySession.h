@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "replayOptions.h"
+#include "../common/loadStats.h"
+#include "../common/triviaClient.h"
+#include "../../src/utils/trafficCapture/trafficCapture.h"
+
+// room ids are generated by the server, so the captured ones are mapped to the live ones through the room names:
+// captured GET_ROOMS responses give captured id -> name, live GET_ROOMS responses give name -> live id
+class RoomIdMapper {
+public:
+    void learnCapturedRooms(const std::vector<unsigned char> &getRoomsResponse);
+
+    void learnLiveRooms(const Json &getRoomsResponse);
+
+    // unknown ids are returned unchanged, the server will answer them like it did in the capture (room not found)
+    std::string toLiveId(const std::string &capturedRoomId) const;
+
+private:
+    void learnRooms(const Json &getRoomsResponse, std::unordered_map<std::string, std::string> &map, bool isIdToName);
+
+    mutable std::mutex _mutex;
+    std::unordered_map<std::string, std::string> _capturedIdToName;
+    std::unordered_map<std::string, std::string> _nameToLiveId;
+};
+
+// a recorded connection, replayed on its own thread and its own socket
+struct CapturedSession {
+    std::uint32_t connectionId;
+    std::uint64_t openedAtMicroseconds = 0;
+    std::vector<CaptureRecord> requests;
+};
+
+// groups the records by connection, in the order the connections were opened
+std::vector<CapturedSession> groupSessions(const std::vector<CaptureRecord> &records, RoomIdMapper &roomIdMapper);
+
+// signs up the users that log in during the capture without signing up in it, using the redacted password
+void prepareAccounts(const std::vector<CapturedSession> &sessions, const ReplayOptions &options);
+
+class ReplaySession {
+public:
+    ReplaySession(const CapturedSession &session, const ReplayOptions &options, LoadStats &stats,
+                  RoomIdMapper &roomIdMapper, std::chrono::steady_clock::time_point replayStart);
+
+    void run();
+
+private:
+    // sleeps until the capture timestamp scaled by the replay speed, no-op at max speed
+    void waitForTimestamp(std::uint64_t timestampMicroseconds) const;
+
+    std::vector<unsigned char> rewritePayload(RequestId requestId, const std::vector<unsigned char> &payload) const;
+
+    const CapturedSession &_session;
+    const ReplayOptions &_options;
+    LoadStats &_stats;
+    RoomIdMapper &_roomIdMapper;
+    const std::chrono::steady_clock::time_point _replayStart;
+    TriviaClient _client;
+    PayloadEncoding _encoding = PayloadEncoding::JSON;  // follows the CLIENT_HELLO frames of the capture
+};